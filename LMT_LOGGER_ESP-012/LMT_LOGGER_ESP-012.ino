@@ -3,6 +3,7 @@
 #include "LoggerBLE.h"
 #include "LoggerOTA.h"
 #include "LoggerHTTP.h"
+#include "LoggerOutput.h"
 
 // ============================================================================
 // HARDWARE PIN MAP (ESP32-C3)
@@ -42,9 +43,18 @@ const uint8_t PIN_FLASH_CS = CS_FL;
 // The .ino owns *policy*, not mechanics.
 // Core implements logging; this file decides *when* to log.
 
-static constexpr uint32_t RECORD_INTERVAL_MS = 100;
+static constexpr uint32_t RECORD_INTERVAL_MS = 1000 / RECORD_RATE_POLLED_HZ;
 static uint32_t lastRecordMs = 0;
 
+// DMP-clocked mode: frames drained per loop pass, and the live USB echo is
+// decimated to roughly the polled rate so Serial never paces acquisition.
+static Frame20 drainBuf[IMU_DRAIN_MAX_FRAMES];
+static uint32_t liveEchoFrames = 0;
+
+// USB CDC TX buffer (driver default 256). Playback paces each transport by
+// its free TX space, so a larger buffer keeps the USB dump at full speed.
+static constexpr size_t USB_TX_BUFFER_BYTES = 2048;
+
 // ============================================================================
 // SETUP
 // ============================================================================
@@ -59,7 +69,9 @@ static uint32_t lastRecordMs = 0;
 // No runtime logic should live here.
 
 void setup() {
+  Serial.setTxBufferSize(USB_TX_BUFFER_BYTES);
   Serial.begin(115200);
+  startOutput();
 
   // LED is shared with charger enable on this board.
   // External pull-up ensures safe default during reset.
@@ -110,9 +122,25 @@ void setup() {
 
       computeFlashLayout();
 
-      scanFlashOnBoot();
-      scanSyncPagesOnBoot();
-      reconstructFrameCounterFromFlash();
+      // Slot storage index (one scan of the tail; migrates the old layout).
+      if (!startStorage()) {
+        Serial.println("# Tail storage unavailable");
+      }
+
+      // All flash programming goes through the background writer from here on.
+      startFlashWriter();
+
+      // Fast path: newest checkpoint confirmed against a few footers.
+      // Slow path: full boot scans, then checkpoint so the next boot is fast.
+      if (!restoreFromCheckpoint()) {
+        scanFlashOnBoot();
+        scanSyncPagesOnBoot();
+        reconstructFrameCounterFromFlash();
+        writeCheckpoint();
+      }
+
+      // Sparse page index for range seeks (one footer read per stride).
+      imuIndexRebuild();
     }
   }
 
@@ -121,13 +149,20 @@ void setup() {
   }
 
   // Boot scan diagnostics
-  Serial.println("Flash scan complete:");
+  Serial.println(bootFromCheckpoint ? "Flash state restored from checkpoint:"
+                                    : "Flash scan complete:");
   Serial.print("  Pages found:   ");
   Serial.println(bootPagesFound);
   Serial.print("  Valid pages:   ");
   Serial.println(bootValidPages);
   Serial.print("  Corrupt pages: ");
   Serial.println(bootCorruptPages);
+  Serial.print("  Verified from: ");
+  Serial.println(bootVerifyStartPage);
+  if (imuRingEnabled()) {
+    Serial.print("  Ring, oldest:  ");
+    Serial.println(imuTailPage());
+  }
 
 #if VERBOSE_LOG
   Serial.print("Flash capacity: ");
@@ -173,6 +208,11 @@ void setup() {
     imuPresent = true;
     Serial.println("IMU ready.");
 
+    // Apply the boot record rate (DMP-clocked in IMU_IRQ_ACQUISITION builds)
+    // and let the INT pin pace recording.
+    imuSetRecordRate(RECORD_RATE_POLLED_HZ);
+    imuAttachInterrupt(PIN_INT);
+
   } else {
     imuSimulated = true;
     emitEvent("# IMU not detected – using simulator");
@@ -192,6 +232,93 @@ void setup() {
   printPrompt();
 }
 
+// ============================================================================
+// RECORDING HELPERS
+// ============================================================================
+
+// Live USB debug output (not part of recorded data)
+static void printLiveFrame(const Frame20 &f) {
+  Serial.print(frameCounter);
+  Serial.print(" ");
+  Serial.print(f.q0);
+  Serial.print(" ");
+  Serial.print(f.q1);
+  Serial.print(" ");
+  Serial.print(f.q2);
+  Serial.print(" ");
+  Serial.print(f.q3);
+  Serial.print(" ");
+  Serial.print(f.ax);
+  Serial.print(" ");
+  Serial.print(f.ay);
+  Serial.print(" ");
+  Serial.print(f.az);
+  Serial.print(" ");
+  Serial.print(f.mx);
+  Serial.print(" ");
+  Serial.print(f.my);
+  Serial.print(" ");
+  Serial.println(f.mz);
+}
+
+// The HTTP service task runs below loop()'s priority while recording or
+// playing back. The IRQ-paced path blocks on the IMU and leaves it room; the
+// polled path gives up a tick while the next sample is at least 2 ms away,
+// and playback gives one up per pass. (With the INT pin not armed the FIFO
+// path spins, stamping from the drain time, and is left alone: exports then
+// wait for idle mode.)
+static void yieldToExport() {
+  if (httpStarted()) {
+    vTaskDelay(1);
+  }
+}
+
+// One DMP-clocked service pass: sleep until the IMU signals a packet (or
+// spin straight through when the INT pin is not armed), then drain every
+// queued sample and log it. The FIFO does not carry times, so samples are
+// stamped back from the INT edge (or the drain time) at the nominal period.
+static void recordFromFifo() {
+  const uint32_t periodUs = imuSamplePeriodUs();
+
+  uint32_t anchorUs = 0;
+  const bool woken = imuWaitForData(2 * periodUs / 1000 + 1, anchorUs);
+  noteRecordLoopPass();
+
+  const uint32_t t0 = micros();
+
+  const uint16_t n = imuDrainFrames(drainBuf, IMU_DRAIN_MAX_FRAMES);
+  if (n == 0) {
+    return;
+  }
+
+  if (!woken) {
+    anchorUs = t0;
+  }
+  noteSampleAnchor(anchorUs, n);
+
+  const uint32_t anchorMs = millis() - (micros() - anchorUs) / 1000;
+  const uint32_t echoEvery = recordRateHz / RECORD_RATE_POLLED_HZ;
+
+  uint16_t logged = 0;
+  for (uint16_t i = 0; i < n && mode == MODE_RECORDING; i++) {
+    const uint32_t sampleMs = anchorMs - ((uint32_t)(n - 1 - i) * periodUs) / 1000;
+
+    if (!logFrame(drainBuf[i], sampleMs)) {
+      continue;
+    }
+
+    frameCounter++;
+    logged++;
+
+    if (++liveEchoFrames >= echoEvery) {
+      liveEchoFrames = 0;
+      printLiveFrame(drainBuf[i]);
+    }
+  }
+
+  noteAcquisitionBatch(logged, micros() - t0);
+}
+
 // ============================================================================
 // MAIN LOOP
 // ============================================================================
@@ -203,7 +330,7 @@ void loop() {
 
   // ===================== MODE_IDLE =====================
   //
-  // CLI, OTA, HTTP, BLE RX, live probes
+  // CLI, OTA, HTTP, BLE RX and bulk offload, live probes
 
   if (mode == MODE_IDLE) {
 
@@ -223,7 +350,8 @@ void loop() {
         if (cmdLen > 0) {
           handleCommand(cmdBuf);
           cmdLen = 0;
-          if (!liveFrameRequestPending()) {
+          // Deferred output (live frame, playback) prints the prompt when done
+          if (!liveFrameRequestPending() && mode != MODE_PLAYBACK) {
             printPrompt();
           }
         }
@@ -233,6 +361,8 @@ void loop() {
     }
 
     serviceLiveFrameRequests();
+    serviceBLEBulk();
+    serviceBLETx();
     return;
   }
 
@@ -242,6 +372,8 @@ void loop() {
 
   if (mode == MODE_PLAYBACK) {
     playbackTask();
+    serviceBLETx();
+    yieldToExport();
     return;
   }
 
@@ -250,54 +382,42 @@ void loop() {
   // Fixed-rate acquisition controlled by policy here,
   // mechanics implemented in LoggerCore.
 
+  if (mode == MODE_RECORDING && imuDmpClocked()) {
+    recordFromFifo();
+    return;
+  }
+
   if (mode == MODE_RECORDING) {
 
+    noteRecordLoopPass();
+
     const uint32_t now = millis();
     if ((uint32_t)(now - lastRecordMs) < RECORD_INTERVAL_MS) {
+      if (RECORD_INTERVAL_MS - (uint32_t)(now - lastRecordMs) > 1) {
+        yieldToExport();
+      }
       return;
     }
 
+    const uint32_t t0 = micros();
+
     Frame20 f;
     if (!imuReadFrame(f)) {
       return;
     }
 
     lastRecordMs = now;
+    noteSampleAnchor(t0, 1);
 
-    if (frameIndexInPage == 0) {
-      pageStartMs = now;
-      pageFirstID = frameCounter + 1;
-    }
-
-    if (!logFrame(f)) {
+    if (!logFrame(f, now)) {
       return;
     }
 
     frameCounter++;
+    noteAcquisitionBatch(1, micros() - t0);
 
-    // Live USB debug output (not part of recorded data)
-    Serial.print(frameCounter);
-    Serial.print(" ");
-    Serial.print(f.q0);
-    Serial.print(" ");
-    Serial.print(f.q1);
-    Serial.print(" ");
-    Serial.print(f.q2);
-    Serial.print(" ");
-    Serial.print(f.q3);
-    Serial.print(" ");
-    Serial.print(f.ax);
-    Serial.print(" ");
-    Serial.print(f.ay);
-    Serial.print(" ");
-    Serial.print(f.az);
-    Serial.print(" ");
-    Serial.print(f.mx);
-    Serial.print(" ");
-    Serial.print(f.my);
-    Serial.print(" ");
-    Serial.println(f.mz);
+    printLiveFrame(f);
 
     return;
   }
-}
\ No newline at end of file
+}
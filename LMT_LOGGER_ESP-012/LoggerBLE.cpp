@@ -4,8 +4,10 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include "LoggerBLE.h"
 #include "LoggerCLI.h"
 #include "LoggerCore.h"
+#include "LoggerHTTP.h"
 
 // ============================================================================
 // BLE UART (Nordic-style)
@@ -15,28 +17,307 @@
 #define NUS_TX_UUID      "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
 #define NUS_RX_UUID      "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
 
+// ATT MTU offered to the client (the client starts the exchange). 247 lets a
+// notification carry 244 bytes, the most one LE data packet holds with data
+// length extension.
+#define BLE_MTU_MAX     247
+#define BLE_MTU_DEFAULT 23
+
+// TX ring: CLI text and playback output waiting for notification. Writes
+// are all-or-nothing (a write that does not fit is dropped and counted) and
+// go out coalesced into notifications of up to MTU - 3 bytes.
+#define BLE_TX_RING_BYTES 4096
+
+// Notifications handed to the stack and not yet reported sent (GATTS CONF
+// event). A completion missing for BLE_TX_CONF_TIMEOUT_MS frees the window
+// (e.g. the client disabled notifications mid-send).
+#define BLE_TX_MAX_IN_FLIGHT   4
+#define BLE_TX_CONF_TIMEOUT_MS 500
+
+// Bulk offload: pages read per flash transaction, notifications per
+// serviceBLEBulk() pass, and how long a session may wait for credits.
+#define BLE_BULK_READ_PAGES 4
+#define BLE_BULK_BURST      6
+#define BLE_BULK_STALL_MS   10000
+
+// Connection interval requested while a bulk session runs (1.25 ms units):
+// 7.5-15 ms, no latency, 4 s supervision timeout.
+#define BLE_BULK_CONN_MIN     6
+#define BLE_BULK_CONN_MAX     12
+#define BLE_BULK_CONN_TIMEOUT 400
+
 // ============================================================================
 // INTERNAL STATE
 // ============================================================================
 
 static BLECharacteristic *g_txChar   = nullptr;
+static BLE2902           *g_txCccd   = nullptr;   // TX notification enable
 static BLEServer         *g_server   = nullptr;
 
 static bool g_bleStarted   = false;   // stack initialized
 static bool g_bleConnected = false;   // active connection
 static bool g_bleEnabled   = false;   // advertising / connectability allowed
 
+static volatile uint16_t g_mtu = BLE_MTU_DEFAULT;  // negotiated ATT MTU
+static esp_bd_addr_t g_peerAddr;                    // for connection updates
+
+// ============================================================================
+// TX RING STATE
+// ============================================================================
+//
+// Producers: loop() (control output, playback) and the BLE stack's task
+// (CLI replies to RX commands). The ring and the send path are guarded by
+// g_txLock; the drain runs from whichever context gets there first (a
+// writer, loop() or a send completion) and simply skips when it is busy.
+//
+// In flight = g_txSent - g_txCompleted, both written only under the lock.
+// The GATTS event handler must not wait for it (the holder may be waiting in
+// notify() for an event on the handler's task), so it only counts send
+// completions in g_txConfs; lock holders fold them into g_txCompleted
+// (txSettle()), capped at what is in flight: a completion for a
+// notification already written off (timeout, reconnect) is dropped there
+// instead of pushing g_txCompleted past g_txSent.
+
+static SemaphoreHandle_t g_txLock = nullptr;
+static uint8_t g_txRing[BLE_TX_RING_BYTES];
+static uint16_t g_txHead = 0;   // next byte written
+static uint16_t g_txTail = 0;   // next byte sent
+static uint16_t g_txUsed = 0;
+static uint8_t g_txPkt[BLE_MTU_MAX - 3];
+
+static uint32_t g_txSent = 0;
+static uint32_t g_txCompleted = 0;
+static volatile uint32_t g_txConfs = 0;  // send completions (GATTS handler only)
+static uint32_t g_txConfsSeen = 0;       // g_txConfs already folded in
+static volatile bool g_txCongested = false;
+static uint32_t g_txLastSendMs = 0;
+
+static BleTxStats g_txStats;
+
+// ============================================================================
+// BULK OFFLOAD STATE
+// ============================================================================
+//
+// Requests and credits arrive in the BLE stack's task (RX callback); the
+// session itself runs only in serviceBLEBulk() (loop()). The RX side posts a
+// start request and counts credits; loop() owns everything else, so no lock
+// is needed:
+//
+//   g_bulkGranted   written by RX only (total credits ever granted)
+//   g_bulkRequest   set by RX, taken by loop()
+//   g_bulkAbort     set by RX, taken by loop()
+
+struct BulkRequest {
+  BleBulkStream stream;
+  uint32_t fromPage;
+  uint16_t credits;
+};
+
+struct BulkSession {
+  bool active;
+  BleBulkStream stream;
+  uint32_t firstPage;       // first page of the session
+  uint32_t endPage;         // region pages at start (snapshot)
+  uint32_t page;            // next page to load
+  uint16_t bufLen;          // record bytes loaded
+  uint16_t bufOff;          // record bytes sent
+  uint8_t seq;              // DATA sequence number (mod 256)
+  uint32_t creditBase;      // g_bulkGranted at start
+  uint32_t credits;         // initial credits
+  uint32_t sent;            // DATA notifications built (credits spent)
+  uint32_t bytesSent;       // record bytes handed to the stack
+  uint32_t lastProgressMs;
+  uint8_t records[BLE_BULK_READ_PAGES * STREAM_RECORD_BYTES];
+};
+
+static BulkSession g_bulk;
+static BulkRequest g_bulkPending;
+static volatile bool g_bulkRequest = false;
+static volatile bool g_bulkAbort = false;
+static volatile uint32_t g_bulkGranted = 0;
+
+// Next DATA notification (kept until the stack takes it), and a BEGIN / END
+// record waiting to go out ahead of it.
+static uint8_t g_bulkPkt[BLE_MTU_MAX - 3];
+static uint16_t g_bulkPktLen = 0;
+static uint8_t g_bulkCtl[sizeof(BleBulkBegin)];
+static uint8_t g_bulkCtlLen = 0;
+
+static_assert(sizeof(BleBulkBegin) <= BLE_MTU_DEFAULT - 3, "BEGIN must fit the default MTU");
+static_assert(sizeof(BleBulkEnd) <= BLE_MTU_DEFAULT - 3, "END must fit the default MTU");
+
+// Bulk control writes from the client (first byte >= BLE_BULK_CTRL_ABORT, so
+// never CLI text).
+static void bulkControl(const uint8_t *p, size_t len) {
+  if (p[0] == BLE_BULK_CTRL_CREDIT && len >= 3) {
+    g_bulkGranted += (uint32_t)p[1] | ((uint32_t)p[2] << 8);
+  } else if (p[0] == BLE_BULK_CTRL_ABORT) {
+    g_bulkAbort = true;
+  }
+}
+
+// ============================================================================
+// TX RING
+// ============================================================================
+
+static bool txLock(TickType_t wait) {
+  return g_txLock && xSemaphoreTake(g_txLock, wait) == pdTRUE;
+}
+
+static void txUnlock() {
+  xSemaphoreGive(g_txLock);
+}
+
+// Fold new send completions into g_txCompleted. Caller holds g_txLock.
+static void txSettle() {
+  const uint32_t confs = g_txConfs;
+  const uint32_t n = confs - g_txConfsSeen;
+  const uint32_t inFlight = g_txSent - g_txCompleted;
+  g_txConfsSeen = confs;
+  g_txCompleted += (n < inFlight) ? n : inFlight;
+}
+
+// Whether the stack takes another notification now. Caller holds g_txLock.
+static bool txSlotFree() {
+  if (!g_bleConnected || !g_txCccd->getNotifications()) {
+    return false;
+  }
+
+  txSettle();
+  if (g_txSent != g_txCompleted && millis() - g_txLastSendMs > BLE_TX_CONF_TIMEOUT_MS) {
+    g_txCompleted = g_txSent;
+    g_txCongested = false;
+    g_txStats.confTimeouts++;
+  }
+
+  return !g_txCongested && g_txSent - g_txCompleted < BLE_TX_MAX_IN_FLIGHT;
+}
+
+static uint16_t txPayloadMax() {
+  const uint16_t n = g_mtu - 3;
+  return n < sizeof(g_txPkt) ? n : sizeof(g_txPkt);
+}
+
+// Hand one notification to the stack. Caller holds g_txLock and has checked
+// txSlotFree().
+static void txNotify(const uint8_t *data, size_t len) {
+  g_txSent++;
+  g_txLastSendMs = millis();
+  g_txChar->setValue((uint8_t *)data, len);
+  g_txChar->notify();
+
+  g_txStats.notifications++;
+  g_txStats.bytes += len;
+}
+
+// Send queued bytes, up to a full MTU per notification, while the stack has
+// room. Never waits: a busy lock means another context is draining.
+static void txDrain() {
+  if (!txLock(0)) return;
+
+  const uint16_t payload = txPayloadMax();
+  while (g_txUsed > 0 && txSlotFree()) {
+    const uint16_t n = g_txUsed < payload ? g_txUsed : payload;
+    const uint16_t first =
+      (n < BLE_TX_RING_BYTES - g_txTail) ? n : (uint16_t)(BLE_TX_RING_BYTES - g_txTail);
+
+    memcpy(g_txPkt, g_txRing + g_txTail, first);
+    memcpy(g_txPkt + first, g_txRing, n - first);
+    g_txTail = (g_txTail + n) % BLE_TX_RING_BYTES;
+    g_txUsed -= n;
+
+    txNotify(g_txPkt, n);
+  }
+
+  txUnlock();
+}
+
+static void txPut(const uint8_t *data, size_t len) {
+  if (len == 0) return;
+  const size_t first =
+    (len < (size_t)(BLE_TX_RING_BYTES - g_txHead)) ? len : BLE_TX_RING_BYTES - g_txHead;
+  memcpy(g_txRing + g_txHead, data, first);
+  memcpy(g_txRing, data + first, len - first);
+  g_txHead = (g_txHead + len) % BLE_TX_RING_BYTES;
+  g_txUsed += len;
+}
+
+// Queue a + b as one write; all or nothing. False if it was dropped.
+static bool txQueue(const uint8_t *a, size_t aLen, const uint8_t *b, size_t bLen) {
+  if (!txLock(portMAX_DELAY)) return false;
+
+  const bool fits = aLen + bLen <= (size_t)(BLE_TX_RING_BYTES - g_txUsed);
+  if (!fits) {
+    g_txStats.droppedWrites++;
+    g_txStats.droppedBytes += aLen + bLen;
+  } else {
+    txPut(a, aLen);
+    txPut(b, bLen);
+    if (g_txUsed > g_txStats.ringPeak) {
+      g_txStats.ringPeak = g_txUsed;
+    }
+  }
+
+  txUnlock();
+  txDrain();
+  return fits;
+}
+
+// Connection change: discard what the old link did not send.
+static void txReset() {
+  if (!txLock(portMAX_DELAY)) return;
+  g_txStats.droppedBytes += g_txUsed;
+  g_txHead = g_txTail = g_txUsed = 0;
+  g_txConfsSeen = g_txConfs;
+  g_txCompleted = g_txSent;
+  g_txCongested = false;
+  txUnlock();
+}
+
+// Send completions and congestion signals from the stack (BLE task).
+static void onGattsEvent(esp_gatts_cb_event_t event, esp_gatt_if_t,
+                         esp_ble_gatts_cb_param_t *param) {
+  if (event == ESP_GATTS_CONF_EVT) {
+    if (!g_txChar || param->conf.handle != g_txChar->getHandle()) return;
+    g_txConfs++;  // settled under g_txLock by the next drain
+    if (param->conf.status == ESP_GATT_CONGESTED) {
+      g_txCongested = true;
+      g_txStats.congestion++;
+    }
+    txDrain();
+  } else if (event == ESP_GATTS_CONGEST_EVT) {
+    g_txCongested = param->congest.congested;
+    if (g_txCongested) {
+      g_txStats.congestion++;
+    } else {
+      txDrain();
+    }
+  }
+}
+
 // ============================================================================
 // SERVER CALLBACKS
 // ============================================================================
 
 class ServerCB : public BLEServerCallbacks {
   void onConnect(BLEServer *) override {
+    g_mtu = BLE_MTU_DEFAULT;
+    txReset();
     g_bleConnected = true;
   }
 
+  void onConnect(BLEServer *, esp_ble_gatts_cb_param_t *param) override {
+    memcpy(g_peerAddr, param->connect.remote_bda, sizeof(g_peerAddr));
+  }
+
+  void onMtuChanged(BLEServer *, esp_ble_gatts_cb_param_t *param) override {
+    g_mtu = param->mtu.mtu;
+  }
+
   void onDisconnect(BLEServer *) override {
     g_bleConnected = false;
+    g_mtu = BLE_MTU_DEFAULT;
+    txReset();
 
     // IMPORTANT:
     // Only resume advertising if BLE is explicitly enabled
@@ -56,6 +337,11 @@ class RxCB : public BLECharacteristicCallbacks {
 
     String v = c->getValue();
 
+    if (v.length() > 0 && (uint8_t)v[0] >= BLE_BULK_CTRL_ABORT) {
+      bulkControl((const uint8_t *)v.c_str(), v.length());
+      return;
+    }
+
     for (size_t i = 0; i < v.length(); i++) {
       char ch = v[i];
 
@@ -64,7 +350,8 @@ class RxCB : public BLECharacteristicCallbacks {
         if (cmdLen > 0) {
           handleCommand(cmdBuf);
           cmdLen = 0;
-          if (!liveFrameRequestPending()) {
+          // Deferred output (live frame, playback) prints the prompt when done
+          if (!liveFrameRequestPending() && mode != MODE_PLAYBACK) {
             printPrompt();
           }
         }
@@ -91,28 +378,41 @@ bool bleConnected() {
 // TX HELPERS
 // ============================================================================
 
-void bleWrite(const uint8_t *buf, size_t len) {
-  if (!g_bleConnected || !g_txChar) return;
-  g_txChar->setValue(buf, len);
-  g_txChar->notify();
+// Output is discarded unless a client listens on TX.
+static bool txOpen() {
+  return g_bleConnected && g_txChar && g_txCccd->getNotifications();
+}
+
+bool bleWrite(const uint8_t *buf, size_t len) {
+  if (!txOpen()) return true;
+  return txQueue(buf, len, nullptr, 0);
 }
 
 void blePrintln(const char *s) {
-  if (!g_bleConnected || !g_txChar) return;
+  if (!txOpen()) return;
 
-  const char *p = s;
-  while (*p) {
-    const char *e = strchr(p, '\n');
-    size_t len = e ? (size_t)(e - p) : strlen(p);
+  const size_t len = strlen(s);
+  const bool hasNewline = len > 0 && s[len - 1] == '\n';
+  txQueue((const uint8_t *)s, len, (const uint8_t *)"\n", hasNewline ? 0 : 1);
+}
 
-    if (len > 0) {
-      g_txChar->setValue((uint8_t *)p, len);
-      g_txChar->notify();
-      delay(2);
-    }
-    if (!e) break;
-    p = e + 1;
-  }
+bool bleTxHasRoom(size_t len) {
+  if (!txOpen()) return true;  // output is discarded anyway
+  if (len <= (size_t)(BLE_TX_RING_BYTES - g_txUsed)) return true;
+
+  g_txStats.backpressure++;
+  txDrain();
+  return false;
+}
+
+void serviceBLETx() {
+  if (!g_bleConnected || !g_txChar) return;
+  txDrain();
+}
+
+void getBleTxStats(BleTxStats &out) {
+  out = g_txStats;
+  out.ringUsed = g_txUsed;
 }
 
 // ============================================================================
@@ -124,8 +424,12 @@ void startBLEUart() {
   // One-time stack init
   if (!g_bleStarted) {
 
+    g_txLock = xSemaphoreCreateMutex();
+
     BLEDevice::init("LMT-LOGGER");
     BLEDevice::setPower(ESP_PWR_LVL_P9);
+    BLEDevice::setMTU(BLE_MTU_MAX);
+    BLEDevice::setCustomGattsHandler(onGattsEvent);
 
     g_server = BLEDevice::createServer();
     g_server->setCallbacks(new ServerCB());
@@ -136,7 +440,8 @@ void startBLEUart() {
       NUS_TX_UUID,
       BLECharacteristic::PROPERTY_NOTIFY
     );
-    g_txChar->addDescriptor(new BLE2902());
+    g_txCccd = new BLE2902();
+    g_txChar->addDescriptor(g_txCccd);
 
     BLECharacteristic *rxChar = svc->createCharacteristic(
       NUS_RX_UUID,
@@ -176,4 +481,232 @@ void stopBLEUart() {
   }
 
   g_bleConnected = false;
-}
\ No newline at end of file
+}
+// ============================================================================
+// BULK OFFLOAD
+// ============================================================================
+
+// Bulk packets keep their own notification boundaries, so they bypass the
+// ring. They share its in-flight window and go out only once queued text has
+// been sent (CLI replies stay ahead of data).
+static bool bulkSend(const uint8_t *data, size_t len) {
+  txDrain();
+  if (!txLock(0)) return false;
+
+  const bool ok = g_txUsed == 0 && txSlotFree();
+  if (ok) {
+    txNotify(data, len);
+  }
+
+  txUnlock();
+  return ok;
+}
+
+// Send a pending BEGIN / END; false while it still waits for the stack.
+static bool bulkFlushControl() {
+  if (g_bulkCtlLen == 0) return true;
+  if (!g_bleConnected) {
+    g_bulkCtlLen = 0;
+    return true;
+  }
+  if (!bulkSend(g_bulkCtl, g_bulkCtlLen)) return false;
+  g_bulkCtlLen = 0;
+  return true;
+}
+
+// Region pages recorded so far (the log only grows between erases).
+static uint32_t bulkRegionPages(BleBulkStream stream) {
+  return stream == BLE_BULK_SYNC ? syncCurrentPage : currentPage;
+}
+
+// Oldest region page on flash (IMU ring mode: pages below were overwritten).
+static uint32_t bulkRegionFirst(BleBulkStream stream) {
+  return stream == BLE_BULK_SYNC ? 0 : imuTailPage();
+}
+
+static void bulkEnd(BleBulkStatus status) {
+  BleBulkEnd end = {};
+  end.type = BLE_BULK_PKT_END;
+  end.status = status;
+  // Records partly sent are not counted: the client resumes at nextPage
+  end.nextPage = g_bulk.firstPage + g_bulk.bytesSent / STREAM_RECORD_BYTES;
+  end.pagesSent = end.nextPage - g_bulk.firstPage;
+
+  memcpy(g_bulkCtl, &end, sizeof(end));
+  g_bulkCtlLen = sizeof(end);
+  g_bulkPktLen = 0;
+  g_bulk.active = false;
+}
+
+static void bulkBegin(const BulkRequest &req) {
+  const uint32_t endPage = bulkRegionPages(req.stream);
+  const uint32_t regionFirst = bulkRegionFirst(req.stream);
+  const bool reset = req.fromPage > endPage;
+
+  g_bulk.active = true;
+  g_bulk.stream = req.stream;
+  g_bulk.endPage = endPage;
+  g_bulk.page = (reset || req.fromPage < regionFirst) ? regionFirst : req.fromPage;
+  g_bulk.firstPage = g_bulk.page;
+  g_bulk.bufLen = 0;
+  g_bulk.bufOff = 0;
+  g_bulk.seq = 0;
+  g_bulk.creditBase = g_bulkGranted;
+  g_bulk.credits = req.credits;
+  g_bulk.sent = 0;
+  g_bulk.bytesSent = 0;
+  g_bulk.lastProgressMs = millis();
+
+  BleBulkBegin begin = {};
+  begin.type = BLE_BULK_PKT_BEGIN;
+  begin.stream = req.stream;
+  begin.flags = reset ? BLE_BULK_FLAG_RESET : 0;
+  begin.dataBytes = (uint16_t)(g_mtu - 3 - 2);
+  begin.recordBytes = STREAM_RECORD_BYTES;
+  begin.firstPage = g_bulk.page;
+  begin.endPage = endPage;
+
+  memcpy(g_bulkCtl, &begin, sizeof(begin));
+  g_bulkCtlLen = sizeof(begin);
+  g_bulkPktLen = 0;
+
+  // Short connection interval while the session runs (the central decides)
+  g_server->updateConnParams(g_peerAddr, BLE_BULK_CONN_MIN, BLE_BULK_CONN_MAX, 0,
+                             BLE_BULK_CONN_TIMEOUT);
+}
+
+// Refill the record buffer; false at the end of the snapshot or on a read
+// error (then *readError is set).
+static bool bulkLoad(bool *readError) {
+  if (g_bulk.page >= g_bulk.endPage) {
+    return false;
+  }
+
+  uint32_t count = g_bulk.endPage - g_bulk.page;
+  if (count > BLE_BULK_READ_PAGES) {
+    count = BLE_BULK_READ_PAGES;
+  }
+
+  if (!loadPageRecords(g_bulk.records, g_bulk.stream == BLE_BULK_SYNC, g_bulk.page, count)) {
+    *readError = true;
+    return false;
+  }
+
+  g_bulk.bufLen = (uint16_t)(count * STREAM_RECORD_BYTES);
+  g_bulk.bufOff = 0;
+  g_bulk.page += count;
+  return true;
+}
+
+bool bleBulkStart(BleBulkStream stream, uint32_t fromPage, uint16_t credits) {
+  if (!g_bleConnected || !g_txChar || !flashPresent) {
+    return false;
+  }
+
+  g_bulkPending.stream = stream;
+  g_bulkPending.fromPage = fromPage;
+  g_bulkPending.credits = credits;
+  g_bulkAbort = false;
+  g_bulkRequest = true;
+  return true;
+}
+
+bool bleBulkActive() {
+  return g_bulk.active || g_bulkRequest;
+}
+
+void serviceBLEBulk() {
+  if (!bulkFlushControl()) {
+    return;
+  }
+
+  if (g_bulkRequest) {
+    if (g_bulk.active) {
+      bulkEnd(BLE_BULK_ABORTED);  // replaced: END now, BEGIN next pass
+      return;
+    }
+    g_bulkRequest = false;
+    if (g_bleConnected) {
+      bulkBegin(g_bulkPending);
+    }
+    if (!bulkFlushControl()) {
+      return;
+    }
+  }
+
+  if (!g_bulk.active) {
+    return;
+  }
+  if (!g_bleConnected) {
+    g_bulk.active = false;  // client resumes from its own cursor
+    g_bulkPktLen = 0;
+    return;
+  }
+  if (g_bulkAbort) {
+    g_bulkAbort = false;
+    bulkEnd(BLE_BULK_ABORTED);
+    return;
+  }
+  if (bulkRegionPages(g_bulk.stream) < g_bulk.endPage) {
+    bulkEnd(BLE_BULK_RESET);  // erased while sending
+    return;
+  }
+
+  uint16_t payload = g_mtu - 3;
+  if (payload > sizeof(g_bulkPkt)) {
+    payload = sizeof(g_bulkPkt);
+  }
+
+  for (uint8_t burst = 0; burst < BLE_BULK_BURST; burst++) {
+
+    if (g_bulkPktLen == 0) {
+      if (g_bulk.bufOff == g_bulk.bufLen && g_bulk.page >= g_bulk.endPage) {
+        bulkEnd(BLE_BULK_COMPLETE);  // END needs no credit
+        return;
+      }
+
+      const uint32_t granted = g_bulk.credits + (g_bulkGranted - g_bulk.creditBase);
+      if (g_bulk.sent == granted) {
+        if (millis() - g_bulk.lastProgressMs > BLE_BULK_STALL_MS) {
+          bulkEnd(BLE_BULK_STALLED);
+        }
+        return;
+      }
+
+      g_bulkPkt[0] = BLE_BULK_PKT_DATA;
+      g_bulkPkt[1] = g_bulk.seq;
+      uint16_t n = 2;
+      bool readError = false;
+
+      while (n < payload) {
+        if (g_bulk.bufOff == g_bulk.bufLen && !bulkLoad(&readError)) {
+          break;
+        }
+        uint16_t take = g_bulk.bufLen - g_bulk.bufOff;
+        if (take > payload - n) {
+          take = payload - n;
+        }
+        memcpy(g_bulkPkt + n, g_bulk.records + g_bulk.bufOff, take);
+        g_bulk.bufOff += take;
+        n += take;
+      }
+
+      if (n == 2) {
+        bulkEnd(readError ? BLE_BULK_READ_ERROR : BLE_BULK_COMPLETE);
+        return;
+      }
+
+      g_bulkPktLen = n;
+      g_bulk.seq++;
+      g_bulk.sent++;  // the credit is spent once the packet is built
+    }
+
+    // Stack busy or CLI text queued: keep the packet for the next pass
+    if (!bulkSend(g_bulkPkt, g_bulkPktLen)) {
+      return;
+    }
+    g_bulk.bytesSent += g_bulkPktLen - 2;
+    g_bulkPktLen = 0;
+    g_bulk.lastProgressMs = millis();
+  }
+}
@@ -14,12 +14,13 @@
 //   - BLE stack initialization and lifecycle control
 //   - Advertising and connection management
 //   - RX path: feeding received text into the CLI
-//   - TX path: best-effort notification-based output
+//   - TX path: ring-buffered notification output, paced by the stack
 //
 // Non-responsibilities:
 //   - No device logic (IMU, flash, recording, playback)
 //   - No state ownership beyond BLE connection state
-//   - No buffering or retry guarantees for TX
+//   - No delivery guarantee for TX text: a write that finds the ring full
+//     is dropped (and counted)
 //
 // Design notes:
 //   - BLE is optional and may be enabled/disabled at runtime
@@ -27,6 +28,9 @@
 //   - The BLE stack is initialized once and never deinitialized
 //   - Disabling BLE stops advertising and disconnects clients,
 //     but leaves the stack resident
+//   - The ATT MTU is negotiated up to 247 (client-initiated)
+//   - Bulk offload (below) streams whole log pages with credit-based flow
+//     control; it is the fast path for pulling a log over BLE
 //
 
 // ============================================================================
@@ -80,18 +84,152 @@ bool bleConnected();
 // (Currently implemented via BLE write callbacks.)
 void serviceBLERx();
 
-// Write raw bytes to the BLE UART TX characteristic.
+// TX ring:
+//   - bleWrite() / blePrintln() copy into a 4 KB ring and return; they never
+//     wait on the radio
+//   - The ring is drained into notifications of up to MTU - 3 bytes, so small
+//     writes are coalesced while the link is busy
+//   - At most 4 notifications are in the stack at once; each GATTS CONF
+//     event (notification sent) frees a slot and drains again, and a
+//     congestion event pauses draining until the stack reports relief
+//   - A write that does not fit is dropped whole and counted
+//   - The stream has no record boundaries (as with a UART): text is
+//     newline-delimited, binary records must be resynchronized by the reader
+
+// Queue raw bytes for the BLE UART TX characteristic.
 //
 // Behavior:
-//   - Best-effort notification
-//   - No internal buffering or retry
+//   - All or nothing: dropped (and counted) if the ring lacks room
 //   - Silently drops data if not connected
-void bleWrite(const uint8_t *buf, size_t len);
+//   - Returns false only when the ring dropped the write
+bool bleWrite(const uint8_t *buf, size_t len);
 
-// Write a newline-delimited ASCII string to BLE UART.
+// Queue an ASCII string for BLE UART, newline-terminated.
 //
 // Behavior:
-//   - Splits on '\n' and sends line-by-line
-//   - Adds small delays to avoid overrunning notifications
+//   - Adds '\n' unless the string already ends with one
+//   - All or nothing, as bleWrite()
 //   - Silently drops output if not connected
-void blePrintln(const char *s);
\ No newline at end of file
+void blePrintln(const char *s);
+
+// Backpressure for streaming producers: true if 'len' bytes fit the ring
+// now (or no client is connected). False counts a backpressure event; the
+// caller retries later instead of having the output dropped.
+bool bleTxHasRoom(size_t len);
+
+// Drain the TX ring from loop() (send completions also drain it).
+void serviceBLETx();
+
+struct BleTxStats {
+  uint32_t notifications;  // notifications handed to the stack (text + bulk)
+  uint32_t bytes;          // payload bytes in them
+  uint32_t droppedWrites;  // writes discarded: ring full
+  uint32_t droppedBytes;   // bytes discarded: full ring, or unsent at disconnect
+  uint32_t backpressure;   // bleTxHasRoom() said "wait"
+  uint32_t congestion;     // congestion signals from the stack
+  uint32_t confTimeouts;   // send completions that never came
+  uint16_t ringUsed;       // bytes queued now
+  uint16_t ringPeak;       // most bytes queued at once
+};
+
+void getBleTxStats(BleTxStats &out);
+
+// ============================================================================
+// BULK OFFLOAD
+// ============================================================================
+//
+// Binary transfer of the IMU or sync log over the NUS characteristics, as
+// the same 272-byte 'LMTP' / 'LMTS' records /imu and /sync send (16-byte page
+// header + raw page). The client:
+//
+//   1. negotiates a large ATT MTU (up to 247) and enables TX notifications
+//   2. writes "bulk imu <from_page> <credits>\n" (or "bulk sync ...")
+//   3. receives BEGIN, then DATA notifications; each DATA notification
+//      consumes one credit, and the session pauses at zero credits
+//   4. grants more credits as it consumes data: write {0xC1, n_lo, n_hi}
+//   5. receives END with the status and the next page cursor
+//
+// Notifications (TX, little-endian), told apart from CLI text by the first
+// byte (>= 0xB0, never ASCII):
+//
+//   BEGIN  BleBulkBegin (16 bytes)
+//   DATA   0xB1, seq (u8, +1 per DATA), record stream bytes (MTU - 5 max)
+//   END    BleBulkEnd (12 bytes)
+//
+// DATA payloads are a continuous byte stream: records span notifications.
+// A skipped seq means a lost notification; the client then ends the session
+// (write {0xC0}) and starts again from the page after its last complete
+// record. The same applies after a disconnect.
+//
+// Resume: <from_page> is a region page index (the pageIndex of the records).
+// A cursor past the end of the log (erased since) restarts at the first page
+// with BLE_BULK_FLAG_RESET in BEGIN; one below the oldest IMU page on flash
+// (ring mode overwrote it) starts there, as BEGIN.firstPage shows.
+// END.nextPage is the cursor for the next session (the end of the log, or
+// where the session stopped).
+//
+// Throughput: up to 242 record bytes per notification and several
+// notifications per loop() pass with a 7.5-15 ms connection interval
+// requested, against one 24-byte frame per pass for binary playback.
+// DATA notifications share the TX ring's in-flight window and wait until
+// queued text has gone out.
+//
+// Bulk runs in MODE_IDLE only; starting another session ends the current
+// one (END status BLE_BULK_ABORTED).
+
+#define BLE_BULK_PKT_BEGIN 0xB0
+#define BLE_BULK_PKT_DATA  0xB1
+#define BLE_BULK_PKT_END   0xB2
+
+#define BLE_BULK_CTRL_ABORT  0xC0  // client -> device: {0xC0}
+#define BLE_BULK_CTRL_CREDIT 0xC1  // client -> device: {0xC1, u16 credits}
+
+#define BLE_BULK_FLAG_RESET 0x01   // BEGIN: cursor was past the log
+
+#define BLE_BULK_DEFAULT_CREDITS 16
+
+enum BleBulkStream : uint8_t {
+  BLE_BULK_IMU  = 0,
+  BLE_BULK_SYNC = 1
+};
+
+enum BleBulkStatus : uint8_t {
+  BLE_BULK_COMPLETE   = 0,  // every page up to endPage sent
+  BLE_BULK_ABORTED    = 1,  // client abort, or replaced by a new session
+  BLE_BULK_READ_ERROR = 2,  // flash read failed at nextPage
+  BLE_BULK_RESET      = 3,  // log erased during the session
+  BLE_BULK_STALLED    = 4   // no credits for 10 s
+};
+
+struct BleBulkBegin {
+  uint8_t type;          // BLE_BULK_PKT_BEGIN
+  uint8_t stream;        // BleBulkStream
+  uint8_t flags;         // BLE_BULK_FLAG_*
+  uint8_t reserved;
+  uint16_t dataBytes;    // record bytes per full DATA notification (MTU - 5)
+  uint16_t recordBytes;  // 272
+  uint32_t firstPage;    // first record's pageIndex
+  uint32_t endPage;      // pages in the log at start (exclusive end)
+};
+
+struct BleBulkEnd {
+  uint8_t type;          // BLE_BULK_PKT_END
+  uint8_t status;        // BleBulkStatus
+  uint16_t reserved;
+  uint32_t nextPage;     // cursor for the next session
+  uint32_t pagesSent;    // complete records sent in this session
+};
+
+static_assert(sizeof(BleBulkBegin) == 16, "BleBulkBegin must be 16 bytes");
+static_assert(sizeof(BleBulkEnd) == 12, "BleBulkEnd must be 12 bytes");
+
+// Queue a bulk session (CLI "bulk" command). Returns false without a
+// connected client or flash. The session starts on the next serviceBLEBulk().
+bool bleBulkStart(BleBulkStream stream, uint32_t fromPage, uint16_t credits);
+
+// True while a session is queued or running.
+bool bleBulkActive();
+
+// Advance the bulk session: up to a few DATA notifications per call, within
+// the client's credits. Call from loop() in MODE_IDLE; never blocks.
+void serviceBLEBulk();
@@ -1,5 +1,6 @@
 #include "LoggerCLI.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,6 +8,8 @@
 #include "LoggerBLE.h"
 #include "LoggerOTA.h"
 #include "LoggerHTTP.h"
+#include "LoggerOutput.h"
+#include "LoggerStorage.h"
 
 // =============================================================================
 // INTERNAL BUFFERS
@@ -32,6 +35,17 @@ static void printCliLine(Stream &out) {
   out.println(g_cliLine);
 }
 
+static void printFlashOpStats(Stream &out, const char *label, const FlashOpStats &st) {
+  out.print(label);
+  out.print(st.count);
+  out.print(" ");
+  out.print(st.minUs);
+  out.print("/");
+  out.print(st.avgUs());
+  out.print("/");
+  out.println(st.maxUs);
+}
+
 // =============================================================================
 // CLI OUTPUT
 // =============================================================================
@@ -46,10 +60,22 @@ void printHelpTo(Stream &out) {
   out.println("  erase        (erase motion log only)");
   out.println("  erase_all    (erase entire flash)");
   out.println("  record [pages] (record IMU data and sync frames)");
+  out.println("  rate <hz>    (10 or 50-225; DMP FIFO, INT-paced when armed)");
+  out.println("  ring [on|off] (when full, overwrite the oldest IMU pages)");
   out.println("  dump [pages] (output IMU frames as ASCII)");
+  out.println("  dump <from> <to>     (frame ID range, via page index)");
+  out.println("  dump ms <from> <to>  (sample time range, ms)");
   out.println("  sdump     (output sync frames as ASCII)");
-  out.println("  store <0-255> <ascii>");
-  out.println("  read <0-255>");
+  out.println("  bdump [imu|sync] [from_page] [pages] (raw page records over USB)");
+  out.println("  verify       (CRC-check every recorded IMU page)");
+  out.println("  flashbench   (measure flash read/program MB/s)");
+  out.println("  flashprofile (measure flash program/erase timing)");
+  out.print("  store <1-");
+  out.print(STORAGE_SLOT_LIMIT - 1);
+  out.println("> <ascii>");
+  out.print("  read <0-");
+  out.print(STORAGE_SLOT_LIMIT - 1);
+  out.println(">");
   out.println("  status");
   out.println("  frame        (emit one live IMU frame in binary + CRC16 little endian)");
   out.println("  aframe       (emit one live IMU frame as ASCII + CRC16)");
@@ -57,6 +83,7 @@ void printHelpTo(Stream &out) {
   out.println("  ota off");
   out.println("  ble on");
   out.println("  ble off");
+  out.println("  bulk imu|sync [from_page] [credits] (BLE binary offload)");
 }
 
 void printPrompt() {
@@ -97,17 +124,140 @@ void printStatusTo(Stream &out) {
   out.print("IMU Pages used: ");
   out.println(currentPage);
 
+  out.print("IMU log mode (oldest page / ring pages): ");
+  if (imuRingEnabled()) {
+    out.print("RING (");
+    out.print(imuTailPage());
+    out.print(" / ");
+    out.print(imuRingPages());
+    out.println(")");
+  } else {
+    out.println("LINEAR");
+  }
+
   out.print("Append start page: ");
   out.println(recordStartPage);
 
   out.print("Default record limit: ");
   out.println(DEFAULT_PAGES_TO_LOG);
 
+  out.print("Session: ");
+  out.println(sessionID);
+
+  AcquisitionStats as;
+  getAcquisitionStats(as);
+
+  out.print("Record rate Hz (target / achieved): ");
+  out.print(recordRateHz);
+  out.print(!imuDmpClocked() ? " polled / "
+             : imuInterruptArmed() ? " INT-paced / " : " batched / ");
+  const uint32_t elapsedMs = as.lastMs - as.startMs;
+  out.println((as.frames > 0 && elapsedMs > 0) ? (float)as.frames * 1000.0f / elapsedMs : 0.0f, 1);
+
+  out.print("Max sustainable rate Hz (us/frame, max batch): ");
+  if (as.frames > 0 && as.busyUs > 0) {
+    out.print((uint32_t)((uint64_t)as.frames * 1000000ULL / as.busyUs));
+    out.print(" (");
+    out.print(as.busyUs / as.frames);
+    out.print(", ");
+    out.print(as.maxBatch);
+    out.println(")");
+  } else {
+    out.println("n/a (record first)");
+  }
+
+  out.print("Sample interval us (mean / sd / min / max): ");
+  if (as.intervals > 1) {
+    out.print(as.intervalMeanUs, 0);
+    out.print(" / ");
+    out.print(sqrtf(as.intervalM2 / (as.intervals - 1)), 0);
+    out.print(" / ");
+    out.print(as.intervalMinUs);
+    out.print(" / ");
+    out.println(as.intervalMaxUs);
+  } else {
+    out.println("n/a (record first)");
+  }
+
+  out.print("Missed samples (gap markers): ");
+  out.print(as.missed);
+  out.print(" (");
+  out.print(as.gaps);
+  out.println(")");
+
+  out.print("Loop passes per frame (IMU INT count): ");
+  out.print(as.frames > 0 ? (float)as.loopPasses / as.frames : 0.0f, 2);
+  out.print(" (");
+  out.print(imuInterruptCount());
+  out.println(")");
+
   out.print("Sync pages used / total: ");
   out.print(syncCurrentPage);
   out.print(" / ");
   out.println(flashSyncPages);
 
+  if (flashPresent && !flash.isEmulated()) {
+    const FlashTimingProfile &fp = flash.profile();
+    out.print("Flash profile us (tPP / tSE / tBE): ");
+    out.print(fp.tPPus);
+    out.print(" / ");
+    out.print(fp.tSEus);
+    out.print(" / ");
+    out.println(fp.tBEus);
+
+    printFlashOpStats(out, "Flash program us (n min/avg/max): ", flash.programStats());
+    printFlashOpStats(out, "Flash erase us (n min/avg/max): ", flash.eraseStats());
+  }
+
+  FlashWriterStats ws;
+  getFlashWriterStats(ws);
+
+  out.print("Flash writer queue (now / max / pool): ");
+  out.print(ws.queued);
+  out.print(" / ");
+  out.print(ws.maxQueued);
+  out.print(" / ");
+  out.println(WRITER_POOL_PAGES);
+
+  out.print("Flash writer latency us (last / max): ");
+  out.print(ws.lastLatencyUs);
+  out.print(" / ");
+  out.println(ws.maxLatencyUs);
+
+  out.print("Flash writer pages / overruns / errors: ");
+  out.print(ws.pagesWritten);
+  out.print(" / ");
+  out.print(ws.overruns);
+  out.print(" / ");
+  out.println(ws.writeErrors);
+
+  StorageStats st;
+  getStorageStats(st);
+
+  out.print("Tail storage: ");
+  if (!st.mounted) {
+    out.println("unavailable");
+  } else {
+    out.print(st.slots);
+    out.print(" slots, ");
+    out.print(st.liveBytes);
+    out.print(" / ");
+    out.print(st.capacityBytes);
+    out.print(" bytes, free sectors ");
+    out.print(st.freeSectors);
+    out.print(" / ");
+    out.println(st.sectors);
+
+    out.print("Tail storage writes / unchanged / reclaims / erases: ");
+    out.print(st.writes);
+    out.print(" / ");
+    out.print(st.unchanged);
+    out.print(" / ");
+    out.print(st.reclaims);
+    out.print(" / ");
+    out.println(st.erases);
+  }
+
   out.print("OTA: ");
   if (!otaStarted()) {
     out.println("OFF");
@@ -132,6 +282,44 @@ void printStatusTo(Stream &out) {
   } else {
     out.println("ON (advertising)");
   }
+
+  for (uint8_t i = 0; i < outputSinkCount(); i++) {
+    OutputSinkStats os;
+    getOutputSinkStats(i, os);
+    out.print("Output ");
+    out.print(os.name);
+    out.print(os.open ? " (open)" : " (closed)");
+    out.print(" bytes / dropped: ");
+    out.print(os.bytes);
+    out.print(" / ");
+    out.println(os.dropped);
+  }
+
+  if (bleStarted()) {
+    BleTxStats ts;
+    getBleTxStats(ts);
+    out.print("BLE TX notifies / bytes: ");
+    out.print(ts.notifications);
+    out.print(" / ");
+    out.println(ts.bytes);
+
+    out.print("BLE TX ring used / peak: ");
+    out.print(ts.ringUsed);
+    out.print(" / ");
+    out.println(ts.ringPeak);
+
+    out.print("BLE TX dropped writes / bytes: ");
+    out.print(ts.droppedWrites);
+    out.print(" / ");
+    out.println(ts.droppedBytes);
+
+    out.print("BLE TX backpressure / congestion / timeouts: ");
+    out.print(ts.backpressure);
+    out.print(" / ");
+    out.print(ts.congestion);
+    out.print(" / ");
+    out.println(ts.confTimeouts);
+  }
 }
 
 // =============================================================================
@@ -155,6 +343,31 @@ void handleCommand(const char *cmd) {
     return;
   }
 
+  if (strcmp(cmd, "verify") == 0) {
+    verifyImuLog();
+    return;
+  }
+
+  if (strcmp(cmd, "flashbench") == 0) {
+    // Drains the writer, then programs and erases a sector past the head
+    if (mode != MODE_IDLE) {
+      emitEvent("# flashbench requires MODE_IDLE");
+      return;
+    }
+    runFlashBenchmark();
+    return;
+  }
+
+  if (strcmp(cmd, "flashprofile") == 0) {
+    // Programs and erases scratch sectors past the head, blocking for seconds
+    if (mode != MODE_IDLE) {
+      emitEvent("# flashprofile requires MODE_IDLE");
+      return;
+    }
+    runFlashCharacterization();
+    return;
+  }
+
   // -------------------- BLE --------------------
 
   if (strcmp(cmd, "ble on") == 0) {
@@ -169,6 +382,28 @@ void handleCommand(const char *cmd) {
     return;
   }
 
+  char bulkWhich[8];
+  uint32_t bulkFrom = 0;
+  uint32_t bulkCredits = BLE_BULK_DEFAULT_CREDITS;
+  if (sscanf(cmd, "bulk %7s %lu %lu", bulkWhich, &bulkFrom, &bulkCredits) >= 1) {
+    const bool sync = strcmp(bulkWhich, "sync") == 0;
+    if (!sync && strcmp(bulkWhich, "imu") != 0) {
+      emitEvent("# bulk: imu|sync [from_page] [credits]");
+      return;
+    }
+    if (mode != MODE_IDLE) {
+      emitEvent("# bulk requires MODE_IDLE");
+      return;
+    }
+    if (bulkCredits < 1 || bulkCredits > 0xFFFF) {
+      bulkCredits = BLE_BULK_DEFAULT_CREDITS;
+    }
+    if (!bleBulkStart(sync ? BLE_BULK_SYNC : BLE_BULK_IMU, bulkFrom, (uint16_t)bulkCredits)) {
+      emitEvent("# bulk: needs a BLE client and flash");
+    }
+    return;
+  }
+
   // -------------------- OTA --------------------
 
   if (strcmp(cmd, "ota on") == 0) {
@@ -208,14 +443,18 @@ void handleCommand(const char *cmd) {
     unsigned long idx = strtoul(p, &endp, 10);
 
     if (endp == p) {
-      emitEvent("Usage: store <0-255> <ascii>");
+      snprintf(g_cliLine, sizeof(g_cliLine), "Usage: store <1-%u> <ascii>",
+               (unsigned)(STORAGE_SLOT_LIMIT - 1));
+      emitEvent(g_cliLine);
       return;
     }
 
     while (*endp == ' ') endp++;
 
-    if (idx >= FLASH_RESERVED_PAGES) {
-      emitEvent("Index out of range (0-255)");
+    if (idx >= STORAGE_SLOT_LIMIT) {
+      snprintf(g_cliLine, sizeof(g_cliLine), "Index out of range (1-%u)",
+               (unsigned)(STORAGE_SLOT_LIMIT - 1));
+      emitEvent(g_cliLine);
       return;
     }
 
@@ -249,12 +488,16 @@ void handleCommand(const char *cmd) {
     unsigned long idx = strtoul(p, &endp, 10);
 
     if (endp == p) {
-      emitEvent("Usage: read <0-255>");
+      snprintf(g_cliLine, sizeof(g_cliLine), "Usage: read <0-%u>",
+               (unsigned)(STORAGE_SLOT_LIMIT - 1));
+      emitEvent(g_cliLine);
       return;
     }
 
-    if (idx >= FLASH_RESERVED_PAGES) {
-      emitEvent("Index out of range (0-255)");
+    if (idx >= STORAGE_SLOT_LIMIT) {
+      snprintf(g_cliLine, sizeof(g_cliLine), "Index out of range (0-%u)",
+               (unsigned)(STORAGE_SLOT_LIMIT - 1));
+      emitEvent(g_cliLine);
       return;
     }
 
@@ -303,6 +546,7 @@ void handleCommand(const char *cmd) {
     }
 
     emitEvent("# Flash erase started");
+    writerDrain();
     flash.chipErase();
 
     currentPage = 0;
@@ -310,6 +554,17 @@ void handleCommand(const char *cmd) {
     frameCounter = 0;
     recordStartPage = 0;
 
+    // The chip erase took the storage journal with it: rebuild its RAM
+    // index and write a fresh format record, or the next boot would
+    // migrate journal bytes as old fixed slots.
+    if (!startStorage()) {
+      emitEvent("# Storage journal unavailable");
+    }
+
+    logEpoch++;  // a since_page cursor into the old log is now stale
+    resetCheckpointJournal();
+    writeCheckpoint();
+
     emitEvent("# Flash erase complete");
     return;
   }
@@ -322,6 +577,7 @@ void handleCommand(const char *cmd) {
     }
 
     emitEvent("# Log erase started");
+    writerDrain();
 
     // Erase IMU + SYNC regions (but NOT reserved tail storage)
     uint32_t pagesToErase = flashImuPages + flashSyncPages;
@@ -354,11 +610,51 @@ void handleCommand(const char *cmd) {
     lastSyncMs = 0;
     memset(syncFrames, 0, sizeof(syncFrames));
 
+    logEpoch++;  // a since_page cursor into the old log is now stale
+    writeCheckpoint();
+
     emitEvent("# Log erase complete");
     return;
   }
   // -------------------- Recording --------------------
 
+  unsigned long rateHz = 0;
+  if (sscanf(cmd, "rate %lu", &rateHz) == 1) {
+    // Reprogramming the DMP resets its FIFO under a running acquisition
+    if (mode != MODE_IDLE) {
+      emitEvent("# rate requires MODE_IDLE");
+      return;
+    }
+    const uint16_t set = (rateHz <= RECORD_RATE_MAX_HZ) ? imuSetRecordRate((uint16_t)rateHz) : 0;
+    if (set == 0) {
+      snprintf(g_cliLine, sizeof(g_cliLine), "# Invalid rate (use %u or %u-%u)",
+               RECORD_RATE_POLLED_HZ, RECORD_RATE_MIN_HZ, RECORD_RATE_MAX_HZ);
+    } else {
+      snprintf(g_cliLine, sizeof(g_cliLine), "# Record rate %u Hz", set);
+    }
+    emitEvent(g_cliLine);
+    return;
+  }
+
+  if (strncmp(cmd, "ring", 4) == 0 && (cmd[4] == 0 || cmd[4] == ' ')) {
+    const char *arg = cmd + 4;
+    while (*arg == ' ') arg++;
+
+    if (*arg && strcmp(arg, "on") != 0 && strcmp(arg, "off") != 0) {
+      emitEvent("# ring: use 'ring on' or 'ring off'");
+      return;
+    }
+    if (*arg && !setImuRingMode(strcmp(arg, "on") == 0)) {
+      emitEvent("# ring: the log has passed the end of the ring; erase it first");
+      return;
+    }
+
+    snprintf(g_cliLine, sizeof(g_cliLine), "# IMU log mode: %s",
+             imuRingEnabled() ? "ring (overwrite oldest)" : "linear (stop when full)");
+    emitEvent(g_cliLine);
+    return;
+  }
+
   uint32_t pages = 0;
   if (sscanf(cmd, "record %lu", &pages) == 1) {
     startNewRecordingSession();
@@ -379,75 +675,68 @@ void handleCommand(const char *cmd) {
     return;
   }
 
-  // uint32_t bpages = 0;
-  // if (sscanf(cmd, "bdump %lu", &bpages) == 1) {
+  // bdump [imu|sync] [from_page] [pages]: page records over USB
+  if (strncmp(cmd, "bdump", 5) == 0 && (cmd[5] == 0 || cmd[5] == ' ')) {
+    const char *args = cmd + 5;
+    while (*args == ' ') args++;
+
+    bool sync = false;
+    if (strncmp(args, "sync", 4) == 0 && (args[4] == 0 || args[4] == ' ')) {
+      sync = true;
+      args += 4;
+    } else if (strncmp(args, "imu", 3) == 0 && (args[3] == 0 || args[3] == ' ')) {
+      args += 3;
+    }
 
-  //   if (bpages < 1 || bpages > currentPage) {
-  //     Serial.println("Invalid page count for bdump");
-  //     return;
-  //   }
+    uint32_t from = 0, pages = 0;
+    sscanf(args, "%lu %lu", &from, &pages);
 
-  //   playbackPage = 0;
-  //   playbackFrameIndex = 0;
-  //   playbackPagesSeen = 0;
-  //   playbackCrcWarnings = 0;
-  //   playbackPageLoaded = false;
-  //   playbackPageLimit = bpages;
+    if (mode != MODE_IDLE) {
+      emitEvent("# bdump requires MODE_IDLE");
+      return;
+    }
+    if (!flashPresent) {
+      emitEvent("# Flash unavailable");
+      return;
+    }
+    if (!startPageDump(sync, from, pages)) {
+      emitEvent("# bdump: needs a USB host");
+    }
+    return;
+  }
 
-  //   playbackFormat = PLAYBACK_BINARY;
-  //   mode = MODE_PLAYBACK;
-  //   return;
-  // }
+  ImuRange range;
+  uint32_t fromKey = 0, toKey = 0;
 
-  // if (strcmp(cmd, "bdump") == 0) {
+  if (sscanf(cmd, "dump ms %lu %lu", &fromKey, &toKey) == 2 ||
+      sscanf(cmd, "dump %lu %lu", &fromKey, &toKey) == 2) {
 
-  //   if (currentPage == 0) {
-  //     emitEvent("No pages recorded");
-  //     return;
-  //   }
+    if (fromKey > toKey) {
+      emitEvent("# dump: <from> must not exceed <to>");
+      return;
+    }
 
-  //   playbackPage = 0;
-  //   playbackFrameIndex = 0;
-  //   playbackPagesSeen = 0;
-  //   playbackCrcWarnings = 0;
-  //   playbackPageLoaded = false;
-  //   playbackPageLimit = 0;
+    const bool byTime = strncmp(cmd, "dump ms", 7) == 0;
+    imuRangeBegin(range, byTime ? IMU_RANGE_MS : IMU_RANGE_FRAMES, fromKey, toKey);
+    startPlayback(PLAYBACK_ASCII, range, 0);
+    return;
+  }
 
-  //   playbackFormat = PLAYBACK_BINARY;
-  //   mode = MODE_PLAYBACK;
-  //   return;
-  // }
+  imuRangeBegin(range, IMU_RANGE_ALL, 0, 0);
 
   uint32_t dumpPages = 0;
   if (sscanf(cmd, "dump %lu", &dumpPages) == 1) {
 
-    if (dumpPages > currentPage) {
-      dumpPages = currentPage;
+    if (dumpPages > currentPage - imuTailPage()) {
+      dumpPages = currentPage - imuTailPage();
     }
 
-    playbackPage = 0;
-    playbackFrameIndex = 0;
-    playbackPagesSeen = 0;
-    playbackCrcWarnings = 0;
-    playbackPageLoaded = false;
-    playbackPageLimit = dumpPages;
-
-    playbackFormat = PLAYBACK_ASCII;
-    mode = MODE_PLAYBACK;
+    startPlayback(PLAYBACK_ASCII, range, dumpPages);
     return;
   }
 
   if (strcmp(cmd, "dump") == 0) {
-
-    playbackPage = 0;
-    playbackFrameIndex = 0;
-    playbackPagesSeen = 0;
-    playbackCrcWarnings = 0;
-    playbackPageLoaded = false;
-    playbackPageLimit = 0;
-
-    playbackFormat = PLAYBACK_ASCII;
-    mode = MODE_PLAYBACK;
+    startPlayback(PLAYBACK_ASCII, range, 0);
     return;
   }
 
@@ -0,0 +1,154 @@
+#include "LoggerCRC.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "esp_rom_crc.h"
+#endif
+
+// =============================================================================
+// TABLES
+// =============================================================================
+//
+// g_crcTable[k][b] is the CRC contribution of byte b followed by k zero bytes.
+// Built lazily; concurrent first calls write identical values.
+
+static uint16_t g_crcTable[4][256];
+static bool g_crcTableReady = false;
+
+#if defined(ARDUINO_ARCH_ESP32)
+// 0 = not probed yet, 1 = ROM matches, -1 = ROM unusable
+static int8_t g_crcRomState = 0;
+#endif
+
+static void buildCrcTables() {
+  for (uint16_t b = 0; b < 256; b++) {
+    uint16_t crc = (uint16_t)(b << 8);
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021)
+                           : (uint16_t)(crc << 1);
+    }
+    g_crcTable[0][b] = crc;
+  }
+
+  for (int k = 1; k < 4; k++) {
+    for (uint16_t b = 0; b < 256; b++) {
+      const uint16_t prev = g_crcTable[k - 1][b];
+      g_crcTable[k][b] = (uint16_t)((prev << 8) ^ g_crcTable[0][prev >> 8]);
+    }
+  }
+
+  g_crcTableReady = true;
+}
+
+static uint16_t crcUpdateTable(uint16_t crc, const uint8_t *p, size_t len) {
+  if (!g_crcTableReady) {
+    buildCrcTables();
+  }
+
+  while (len >= 4) {
+    const uint16_t x = crc ^ (uint16_t)((p[0] << 8) | p[1]);
+    crc = g_crcTable[3][x >> 8] ^
+          g_crcTable[2][x & 0xFF] ^
+          g_crcTable[1][p[2]] ^
+          g_crcTable[0][p[3]];
+    p += 4;
+    len -= 4;
+  }
+
+  while (len--) {
+    crc = (uint16_t)((crc << 8) ^ g_crcTable[0][(crc >> 8) ^ *p++]);
+  }
+
+  return crc;
+}
+
+// =============================================================================
+// ROM BACKEND (ESP32)
+// =============================================================================
+//
+// esp_rom_crc16_be() is the same polynomial, MSB-first, but inverts the CRC on
+// entry and exit. Feeding it ~crc and inverting the result gives our variant.
+// Whether that holds on a given ROM is checked once against the table path.
+
+#if defined(ARDUINO_ARCH_ESP32)
+static uint16_t crcUpdateRom(uint16_t crc, const uint8_t *p, size_t len) {
+  return (uint16_t)~esp_rom_crc16_be((uint16_t)~crc, p, (uint32_t)len);
+}
+
+static bool crcRomUsable() {
+  if (g_crcRomState == 0) {
+    static const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+    const uint16_t viaTable = crcUpdateTable(CRC16_CCITT_INIT, check, sizeof(check));
+    const uint16_t viaRom = crcUpdateRom(
+      crcUpdateRom(CRC16_CCITT_INIT, check, 4), check + 4, sizeof(check) - 4);
+
+    g_crcRomState = (viaTable == 0x29B1 && viaRom == viaTable) ? 1 : -1;
+  }
+
+  return g_crcRomState > 0;
+}
+#endif
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t *data, size_t len) {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (crcRomUsable()) {
+    return crcUpdateRom(crc, data, len);
+  }
+#endif
+  return crcUpdateTable(crc, data, len);
+}
+
+uint16_t crc16_ccitt(const uint8_t *data, size_t len) {
+  return crc16_ccitt_update(CRC16_CCITT_INIT, data, len);
+}
+
+// =============================================================================
+// CRC-32 (gzip)
+// =============================================================================
+
+static uint32_t g_crc32Table[256];
+static bool g_crc32TableReady = false;
+
+#if defined(ARDUINO_ARCH_ESP32)
+static int8_t g_crc32RomState = 0;
+#endif
+
+static uint32_t crc32UpdateTable(uint32_t crc, const uint8_t *p, size_t len) {
+  if (!g_crc32TableReady) {
+    for (uint32_t b = 0; b < 256; b++) {
+      uint32_t c = b;
+      for (int i = 0; i < 8; i++) {
+        c = (c & 1) ? (c >> 1) ^ 0xEDB88320UL : (c >> 1);
+      }
+      g_crc32Table[b] = c;
+    }
+    g_crc32TableReady = true;
+  }
+
+  crc = ~crc;
+  while (len--) {
+    crc = (crc >> 8) ^ g_crc32Table[(crc ^ *p++) & 0xFF];
+  }
+  return ~crc;
+}
+
+uint32_t crc32_ieee_update(uint32_t crc, const uint8_t *data, size_t len) {
+#if defined(ARDUINO_ARCH_ESP32)
+  // esp_rom_crc32_le() follows the zlib convention; confirm once.
+  if (g_crc32RomState == 0) {
+    static const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    const uint32_t viaRom =
+      esp_rom_crc32_le(esp_rom_crc32_le(0, check, 4), check + 4, sizeof(check) - 4);
+    g_crc32RomState =
+      (viaRom == 0xCBF43926UL && crc32UpdateTable(0, check, sizeof(check)) == viaRom) ? 1 : -1;
+  }
+  if (g_crc32RomState > 0) {
+    return esp_rom_crc32_le(crc, data, (uint32_t)len);
+  }
+#endif
+  return crc32UpdateTable(crc, data, len);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// CRC-16-CCITT (poly 0x1021, init 0xFFFF, no reflection, no xorout)
+// =============================================================================
+//
+// Used for every on-flash footer, the live frame probe and the HTTP export
+// flags. It must stay bit-exact with the bit-serial original (check value for
+// "123456789" is 0x29B1); tools/crc16_bench.cpp keeps that reference, tests
+// the one-shot and incremental forms against it and reports throughput.
+//
+// Implementation:
+//   - slice-by-4 tables (4 x 256 x uint16_t, built once on first use)
+//   - on ESP32 the ROM routine is used instead if it matches the check value
+//
+// This file has no Arduino dependency so host tools can build it as-is.
+//
+
+#define CRC16_CCITT_INIT 0xFFFF
+
+// One-shot CRC over a buffer.
+uint16_t crc16_ccitt(const uint8_t *data, size_t len);
+
+// Incremental form: fold 'len' bytes into a running CRC.
+//   crc16_ccitt(a ++ b) == crc16_ccitt_update(crc16_ccitt(a), b)
+// Start from CRC16_CCITT_INIT.
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t *data, size_t len);
+
+// =============================================================================
+// CRC-32 (IEEE 802.3: reflected poly 0xEDB88320, init/xorout 0xFFFFFFFF)
+// =============================================================================
+//
+// The gzip / zlib CRC, used by the compressed HTTP export. Same calling
+// convention as zlib's crc32(): start from 0 and chain the results
+// (check value for "123456789" is 0xCBF43926). Byte-wise table on the host,
+// the ROM routine on ESP32 when it matches.
+
+uint32_t crc32_ieee_update(uint32_t crc, const uint8_t *data, size_t len);
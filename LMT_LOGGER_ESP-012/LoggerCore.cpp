@@ -1,5 +1,7 @@
 #include "LoggerCore.h"
 #include "LoggerCLI.h"
+#include "LoggerOutput.h"
+#include "LoggerHTTP.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,9 +33,6 @@ const uint32_t DEFAULT_PAGES_TO_LOG = 10;
 // GLOBAL OBJECTS / STATE
 // =============================================================================
 
-// Sector scratch buffer for reserved tail storage read-modify-write
-static uint8_t g_sectorBuf[FLASH_SECTOR_SIZE];
-
 // Buffer for one live frame (Frame20 + CRC16)
 static uint8_t g_liveFrameBuf[LIVE_FRAME_BYTES];
 
@@ -54,9 +53,10 @@ uint32_t flashRecordPages = 0;  // computed in .ino (excludes tail)
 uint32_t flashImuPages = 0;
 uint32_t flashSyncPages = 0;
 
-// One sync *page* holds 16 sync frames.
+// One sync *page* holds 15 sync frames.
 // One sync frame is logged every ~50 IMU pages (60s).
-// → One sync page per 800 IMU pages.
+// → One sync page per ~750 IMU pages; the split keeps its original 800 so
+//   the sync region does not move on flash that already holds a log.
 static constexpr uint32_t IMU_PAGES_PER_SYNC_PAGE = 800;
 
 // Hardware presence flags
@@ -77,12 +77,21 @@ uint32_t recordPageLimit = 0;
 uint32_t recordStartPage = 0;
 uint32_t frameCounter = 0;
 
-Frame20 pageFrames[FRAMES_PER_PAGE];
 uint16_t frameIndexInPage = 0;
+
+// Page currently being filled (LoggerWriter pool buffer), nullptr until the
+// first frame of a page acquires one.
+static uint8_t *g_fillPage = nullptr;
+
+// Encoder state for g_fillPage (running CRC included).
+static ImuPageEncoder g_pageEnc;
 uint32_t currentPage = 0;  // IMU pages written
 
 // Recording state (SYNC) — NEW
 SyncFrame syncFrames[SYNC_FRAMES_PER_PAGE];
+static_assert(SYNC_FRAMES_PER_PAGE * sizeof(SyncFrame) + sizeof(SyncPageFooter) <=
+                FLASH_PAGE_SIZE,
+              "a full sync page must leave room for its footer");
 uint16_t syncFrameIndexInPage = 0;
 
 uint32_t syncCurrentPage = 0;   // sync pages written
@@ -90,25 +99,25 @@ uint32_t syncFrameCounter = 0;  // sync frames written (monotonic ID)
 uint32_t lastSyncMs = 0;        // last sample time
 
 // Playback state (IMU pages only for now)
-uint32_t playbackPage = 0;
-uint16_t playbackFrameIndex = 0;
-bool playbackPageLoaded = false;
-
-uint32_t playbackPagesSeen = 0;
-uint32_t playbackCrcWarnings = 0;
-
+//
+// One cursor per output sink (see PLAYBACK below); the decoded page is
+// shared and reloaded when a cursor needs a different one.
 uint8_t playbackPageBuf[FLASH_PAGE_SIZE];
-static uint8_t g_flushRawPage[FLASH_PAGE_SIZE];
 
-Frame20 *playbackFrames = reinterpret_cast<Frame20 *>(playbackPageBuf);
+Frame20 playbackFrames[MAX_FRAMES_PER_PAGE];
+static ImuFrameTime playbackTimes[MAX_FRAMES_PER_PAGE];
+uint16_t playbackFrameCount = 0;
 PageFooter playbackFooter;
 
 uint32_t playbackPageLimit = 0;
+ImuRange playbackRange = { IMU_RANGE_ALL, 0, 0, 0, false };
 
 // Boot scan diagnostics
 uint32_t bootPagesFound = 0;
 uint32_t bootValidPages = 0;
 uint32_t bootCorruptPages = 0;
+uint32_t bootVerifyStartPage = 0;
+bool bootFromCheckpoint = false;
 
 // Command buffer (owned by core; filled by .ino and BLE RX)
 char cmdBuf[CMD_BUF_SIZE];
@@ -149,53 +158,23 @@ static int16_t readDieTempCx100() {
   return (int16_t)lroundf(temp_c * 100.0f);
 }
 
+// All output goes through the output plane (LoggerOutput): rendered once,
+// then copied to USB CDC and, with a client connected, BLE UART.
+
 static void streamWrite(const uint8_t *buf, size_t len) {
-  Serial.write(buf, len);
-  if (bleConnected()) {
-    bleWrite(buf, len);
-  }
+  outputWrite(buf, len);
 }
 
 static void streamPrintln(const char *s) {
-  Serial.println(s);
-  if (bleConnected()) {
-    blePrintln(s);
-  }
+  outputLine(s);
 }
 
 void emitControl(void (*fn)(Stream &)) {
-  fn(Serial);
-
-  if (bleConnected()) {
-    class StringStream : public Stream {
-    public:
-      String s;
-      int available() override {
-        return 0;
-      }
-      int read() override {
-        return -1;
-      }
-      int peek() override {
-        return -1;
-      }
-      size_t write(uint8_t c) override {
-        s += (char)c;
-        return 1;
-      }
-    };
-
-    StringStream tmp;
-    fn(tmp);
-
-    if (tmp.s.length() > 0) {
-      blePrintln(tmp.s.c_str());
-    }
-  }
+  outputRender(fn);
 }
 
 void emitEvent(const char *msg) {
-  streamPrintln(msg);
+  outputLine(msg);
 }
 
 // =============================================================================
@@ -206,13 +185,8 @@ void emitEvent(const char *msg) {
 static float sim_angle = 0.0f;
 static uint32_t sim_lastMs = 0;
 
-static void simStep(Frame20 &f) {
-  const uint32_t now = millis();
-  if (sim_lastMs == 0) sim_lastMs = now;
-
-  const float dt = (now - sim_lastMs) * 0.001f;
-  sim_lastMs = now;
-
+// Advance the model by dt seconds and sample it.
+static void simAdvance(Frame20 &f, float dt) {
   // 45 deg/sec rotation about +Y
   const float omega = 45.0f * (float)M_PI / 180.0f;
   sim_angle += omega * dt;
@@ -243,23 +217,18 @@ static void simStep(Frame20 &f) {
   f.mz = (int16_t)lroundf(-sinf(sim_angle) * B);
 }
 
-bool imuReadFrame(Frame20 &out) {
-  if (imuSimulated) {
-    simStep(out);
-    return true;
-  }
-
-  if (!imuPresent) {
-    return false;
-  }
+static void simStep(Frame20 &f) {
+  const uint32_t now = millis();
+  if (sim_lastMs == 0) sim_lastMs = now;
 
-  icm_20948_DMP_data_t dmpData;
-  myICM.readDMPdataFromFIFO(&dmpData);
+  const float dt = (now - sim_lastMs) * 0.001f;
+  sim_lastMs = now;
 
-  if (!(myICM.status == ICM_20948_Stat_Ok || myICM.status == ICM_20948_Stat_FIFOMoreDataAvail)) {
-    return false;
-  }
+  simAdvance(f, dt);
+}
 
+// Quat9 (Q30 q1..q3) -> Q15 q0..q3, rebuilding q0 from the unit norm.
+static bool quat9ToFrame(const icm_20948_DMP_data_t &dmpData, Frame20 &out) {
   if (!(dmpData.header & DMP_header_bitmap_Quat9)) {
     return false;
   }
@@ -286,6 +255,30 @@ bool imuReadFrame(Frame20 &out) {
   out.q2 = floatToQ15(fq2);
   out.q3 = floatToQ15(fq3);
 
+  return true;
+}
+
+bool imuReadFrame(Frame20 &out) {
+  if (imuSimulated) {
+    simStep(out);
+    return true;
+  }
+
+  if (!imuPresent) {
+    return false;
+  }
+
+  icm_20948_DMP_data_t dmpData;
+  myICM.readDMPdataFromFIFO(&dmpData);
+
+  if (!(myICM.status == ICM_20948_Stat_Ok || myICM.status == ICM_20948_Stat_FIFOMoreDataAvail)) {
+    return false;
+  }
+
+  if (!quat9ToFrame(dmpData, out)) {
+    return false;
+  }
+
   myICM.getAGMT();
   out.ax = myICM.agmt.acc.axes.x;
   out.ay = myICM.agmt.acc.axes.y;
@@ -297,6 +290,316 @@ bool imuReadFrame(Frame20 &out) {
   return true;
 }
 
+// =============================================================================
+// DMP-CLOCKED ACQUISITION (batched FIFO drain, optional INT wake-up)
+// =============================================================================
+
+uint16_t recordRateHz = RECORD_RATE_POLLED_HZ;
+
+// True once imuSetRecordRate() has put the DMP in charge of sample timing.
+static bool g_dmpClocked = false;
+
+// Quat9/accel/compass ODR register value: rate = IMU_DMP_BASE_HZ / (div + 1)
+static uint8_t g_dmpOdrDiv = 0;
+
+// Latest accel/compass FIFO records; a Quat9 packet without them reuses these.
+static int16_t g_dmpAccel[3] = { 0, 0, 0 };
+static int16_t g_dmpCompass[3] = { 0, 0, 0 };
+
+// Simulator pacing for the high-rate path
+static uint32_t g_simNextUs = 0;
+
+static AcquisitionStats g_acqStats;
+static uint32_t g_lastAnchorUs = 0;
+
+// Time of the last logged sample, for gap markers (session-relative).
+static uint32_t g_lastSampleMs = 0;
+static bool g_haveLastSample = false;
+
+// Gyro/accel sample-rate divider for the DMP's internal rate:
+// 1125 / (1 + div) Hz; 4 = 225 Hz, 19 = 56.25 Hz (initializeDMP default).
+#define DMP_SMPLRT_DIV_HIGH 4
+#define DMP_SMPLRT_DIV_BOOT 19
+#define DMP_QUAT9_ODR_BOOT  5
+
+bool imuDmpClocked() {
+  return g_dmpClocked;
+}
+
+uint32_t imuSamplePeriodUs() {
+  if (!g_dmpClocked) {
+    return 1000000UL / RECORD_RATE_POLLED_HZ;
+  }
+  return (1000000UL * (g_dmpOdrDiv + 1)) / IMU_DMP_BASE_HZ;
+}
+
+static void configureDmpRate(uint8_t smplrtDiv, uint8_t odrDiv, bool withAccelCompass) {
+  ICM_20948_smplrt_t smplrt;
+  smplrt.g = smplrtDiv;
+  smplrt.a = smplrtDiv;
+
+  myICM.enableDMP(false);
+  myICM.setSampleRate((ICM_20948_Internal_Acc | ICM_20948_Internal_Gyr), smplrt);
+  myICM.setGyroSF(smplrtDiv, 3);  // 3 = +-2000 dps, as set by initializeDMP()
+
+  myICM.enableDMPSensor(INV_ICM20948_SENSOR_RAW_ACCELEROMETER, withAccelCompass);
+  myICM.enableDMPSensor(INV_ICM20948_SENSOR_MAGNETIC_FIELD_UNCALIBRATED, withAccelCompass);
+
+  myICM.setDMPODRrate(DMP_ODR_Reg_Quat9, odrDiv);
+  if (withAccelCompass) {
+    myICM.setDMPODRrate(DMP_ODR_Reg_Accel, odrDiv);
+    myICM.setDMPODRrate(DMP_ODR_Reg_Cpass, odrDiv);
+  }
+
+  myICM.enableDMP();
+  myICM.resetDMP();
+  myICM.resetFIFO();
+}
+
+uint16_t imuSetRecordRate(uint16_t hz) {
+  if (hz != RECORD_RATE_POLLED_HZ &&
+      (hz < RECORD_RATE_MIN_HZ || hz > RECORD_RATE_MAX_HZ)) {
+    return 0;
+  }
+
+#if defined(IMU_IRQ_ACQUISITION)
+  // Every rate is clocked by the DMP so the INT pin can pace acquisition.
+  const bool clocked = true;
+#else
+  const bool clocked = (hz != RECORD_RATE_POLLED_HZ);
+#endif
+
+  if (!clocked) {
+    if (imuPresent && g_dmpClocked) {
+      configureDmpRate(DMP_SMPLRT_DIV_BOOT, DMP_QUAT9_ODR_BOOT, false);
+    }
+    g_dmpClocked = false;
+    recordRateHz = RECORD_RATE_POLLED_HZ;
+    return recordRateHz;
+  }
+
+  // Slowest achievable rate not below 'hz': IMU_DMP_BASE_HZ / (div + 1)
+  g_dmpOdrDiv = (uint8_t)(IMU_DMP_BASE_HZ / hz - 1);
+
+  if (imuPresent) {
+    configureDmpRate(DMP_SMPLRT_DIV_HIGH, g_dmpOdrDiv, true);
+  }
+
+  g_dmpClocked = true;
+  recordRateHz = IMU_DMP_BASE_HZ / (g_dmpOdrDiv + 1);
+  g_simNextUs = 0;
+  return recordRateHz;
+}
+
+// -----------------------------------------------------------------------------
+// INT pin wake-up
+// -----------------------------------------------------------------------------
+//
+// The DMP pulses INT1 each time it writes a packet to the FIFO. The ISR only
+// timestamps the edge and notifies the waiting task; all SPI traffic stays in
+// task context.
+
+#if defined(IMU_IRQ_ACQUISITION)
+static TaskHandle_t g_imuWaiter = nullptr;
+static volatile uint32_t g_imuIrqUs = 0;
+static volatile uint32_t g_imuIrqCount = 0;
+static bool g_imuIrqArmed = false;
+
+static void IRAM_ATTR imuIsr() {
+  g_imuIrqUs = micros();
+  g_imuIrqCount++;
+
+  BaseType_t woken = pdFALSE;
+  if (g_imuWaiter) {
+    vTaskNotifyGiveFromISR(g_imuWaiter, &woken);
+  }
+  portYIELD_FROM_ISR(woken);
+}
+#endif
+
+void imuAttachInterrupt(uint8_t pin) {
+#if defined(IMU_IRQ_ACQUISITION)
+  if (!imuPresent || g_imuIrqArmed) {
+    return;
+  }
+
+  myICM.cfgIntActiveLow(true);
+  myICM.cfgIntOpenDrain(false);
+  myICM.cfgIntLatch(false);  // 50 us pulse per DMP packet
+  myICM.intEnableDMP(true);
+
+  pinMode(pin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(pin), imuIsr, FALLING);
+  g_imuIrqArmed = true;
+#else
+  (void)pin;
+#endif
+}
+
+bool imuInterruptArmed() {
+#if defined(IMU_IRQ_ACQUISITION)
+  return g_imuIrqArmed;
+#else
+  return false;
+#endif
+}
+
+uint32_t imuInterruptCount() {
+#if defined(IMU_IRQ_ACQUISITION)
+  return g_imuIrqCount;
+#else
+  return 0;
+#endif
+}
+
+bool imuWaitForData(uint32_t timeoutMs, uint32_t &edgeUs) {
+#if defined(IMU_IRQ_ACQUISITION)
+  if (g_imuIrqArmed) {
+    g_imuWaiter = xTaskGetCurrentTaskHandle();
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs)) > 0) {
+      edgeUs = g_imuIrqUs;
+      return true;
+    }
+  }
+#else
+  (void)timeoutMs;
+#endif
+  edgeUs = micros();
+  return false;
+}
+
+uint16_t imuDrainFrames(Frame20 *out, uint16_t maxFrames) {
+  uint16_t n = 0;
+
+  if (imuSimulated) {
+    // Emit the samples that fell due since the last call
+    const uint32_t nowUs = micros();
+    const uint32_t periodUs = imuSamplePeriodUs();
+    if (g_simNextUs == 0) g_simNextUs = nowUs;
+
+    while (n < maxFrames && (int32_t)(nowUs - g_simNextUs) >= 0) {
+      simAdvance(out[n++], periodUs * 1e-6f);
+      g_simNextUs += periodUs;
+    }
+    return n;
+  }
+
+  if (!imuPresent) {
+    return 0;
+  }
+
+  while (n < maxFrames) {
+    icm_20948_DMP_data_t dmpData;
+    myICM.readDMPdataFromFIFO(&dmpData);
+
+    if (!(myICM.status == ICM_20948_Stat_Ok || myICM.status == ICM_20948_Stat_FIFOMoreDataAvail)) {
+      break;  // FIFO empty or partial packet
+    }
+
+    if (dmpData.header & DMP_header_bitmap_Accel) {
+      g_dmpAccel[0] = dmpData.Raw_Accel.Data.X;
+      g_dmpAccel[1] = dmpData.Raw_Accel.Data.Y;
+      g_dmpAccel[2] = dmpData.Raw_Accel.Data.Z;
+    }
+
+    if (dmpData.header & DMP_header_bitmap_Compass) {
+      g_dmpCompass[0] = dmpData.Compass.Data.X;
+      g_dmpCompass[1] = dmpData.Compass.Data.Y;
+      g_dmpCompass[2] = dmpData.Compass.Data.Z;
+    }
+
+    Frame20 &f = out[n];
+    if (quat9ToFrame(dmpData, f)) {
+      f.ax = g_dmpAccel[0];
+      f.ay = g_dmpAccel[1];
+      f.az = g_dmpAccel[2];
+      f.mx = g_dmpCompass[0];
+      f.my = g_dmpCompass[1];
+      f.mz = g_dmpCompass[2];
+      n++;
+    }
+
+    if (myICM.status != ICM_20948_Stat_FIFOMoreDataAvail) {
+      break;
+    }
+  }
+
+  return n;
+}
+
+void noteRecordLoopPass() {
+  g_acqStats.loopPasses++;
+}
+
+void noteSampleAnchor(uint32_t anchorUs, uint16_t frames) {
+  if (frames == 0) {
+    return;
+  }
+
+  if (g_lastAnchorUs != 0) {
+    const uint32_t intervalUs = (anchorUs - g_lastAnchorUs) / frames;
+
+    // Welford running mean / variance
+    AcquisitionStats &a = g_acqStats;
+    a.intervals++;
+    const float d = (float)intervalUs - a.intervalMeanUs;
+    a.intervalMeanUs += d / a.intervals;
+    a.intervalM2 += d * ((float)intervalUs - a.intervalMeanUs);
+
+    if (a.intervals == 1 || intervalUs < a.intervalMinUs) a.intervalMinUs = intervalUs;
+    if (intervalUs > a.intervalMaxUs) a.intervalMaxUs = intervalUs;
+  }
+
+  g_lastAnchorUs = anchorUs;
+}
+
+// Samples missing between the last logged sample and one taken at
+// 'sampleMs', judged against the nominal period (rounded, so jitter below
+// half a period is not a gap). Covers dropped frames, failed reads, loop
+// stalls and lost FIFO packets alike.
+static uint8_t samplesMissedBefore(uint32_t sampleMs) {
+  if (!g_haveLastSample) {
+    return 0;
+  }
+
+  const uint32_t periodUs = imuSamplePeriodUs();
+  const uint64_t gapUs = (uint64_t)(sampleMs - g_lastSampleMs) * 1000ULL;
+  const uint64_t periods = (gapUs + periodUs / 2) / periodUs;
+
+  if (periods <= 1) {
+    return 0;
+  }
+  return (periods - 1 > 0xFF) ? 0xFF : (uint8_t)(periods - 1);
+}
+
+static void noteSampleLogged(uint32_t sampleMs, uint8_t missed) {
+  g_lastSampleMs = sampleMs;
+  g_haveLastSample = true;
+  g_acqStats.missed += missed;
+  if (missed > 0) g_acqStats.gaps++;
+}
+
+void noteAcquisitionBatch(uint16_t frames, uint32_t busyUs) {
+  g_acqStats.frames += frames;
+  g_acqStats.busyUs += busyUs;
+  g_acqStats.batches++;
+  g_acqStats.lastMs = millis();
+  if (frames > g_acqStats.maxBatch) g_acqStats.maxBatch = frames;
+}
+
+void getAcquisitionStats(AcquisitionStats &out) {
+  out = g_acqStats;
+}
+
+void resetAcquisitionStats() {
+  memset(&g_acqStats, 0, sizeof(g_acqStats));
+  g_acqStats.startMs = millis();
+  g_acqStats.lastMs = g_acqStats.startMs;
+  g_lastAnchorUs = 0;
+  g_haveLastSample = false;
+  g_simNextUs = 0;
+}
+
 // =============================================================================
 // UTILITIES
 // =============================================================================
@@ -312,20 +615,6 @@ int16_t floatToQ15(float x) {
   return (int16_t)v;
 }
 
-uint16_t crc16_ccitt(const uint8_t *data, size_t len) {
-  uint16_t crc = 0xFFFF;
-
-  while (len--) {
-    crc ^= (uint16_t)(*data++) << 8;
-    for (int i = 0; i < 8; i++) {
-      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021)
-                           : (uint16_t)(crc << 1);
-    }
-  }
-
-  return crc;
-}
-
 // =============================================================================
 // LIVE FRAME
 // =============================================================================
@@ -448,68 +737,13 @@ void printIMUDeviceID(Stream &out) {
   }
 }
 
-// =============================================================================
-// RESERVED TAIL STORAGE (256 x 256-byte elements)
-// =============================================================================
-
-static uint32_t storageBasePage() {
-  if (flashTotalPages < FLASH_RESERVED_PAGES) {
-    return 0;
-  }
-  return flashTotalPages - FLASH_RESERVED_PAGES;
-}
-
-static uint32_t storagePageForIndex(uint16_t index) {
-  return storageBasePage() + (uint32_t)index;
-}
-
-bool readStorageElement(uint16_t index, uint8_t *out256) {
-  if (!out256 || index >= FLASH_RESERVED_PAGES) {
-    return false;
-  }
-
-  const uint32_t page = storagePageForIndex(index);
-  const uint32_t addr = page * FLASH_PAGE_SIZE;
-  return flash.readData(addr, out256, FLASH_PAGE_SIZE);
-}
-
-bool writeStorageElement(uint16_t index, const uint8_t *in256) {
-  if (!in256 || index >= FLASH_RESERVED_PAGES) {
-    return false;
-  }
-
-  const uint32_t pageAddr = storagePageForIndex(index) * FLASH_PAGE_SIZE;
-  const uint32_t sectorAddr = pageAddr & ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
-  const uint32_t pageOffset = pageAddr - sectorAddr;
-
-  if (!flash.readData(sectorAddr, g_sectorBuf, FLASH_SECTOR_SIZE)) {
-    return false;
-  }
-
-  memcpy(g_sectorBuf + pageOffset, in256, FLASH_PAGE_SIZE);
-
-  if (!flash.eraseSector(sectorAddr)) {
-    return false;
-  }
-
-  for (uint32_t off = 0; off < FLASH_SECTOR_SIZE; off += FLASH_PAGE_SIZE) {
-    if (!flash.writePage(sectorAddr + off, g_sectorBuf + off, FLASH_PAGE_SIZE)) {
-      return false;
-    }
-  }
-
-  return true;
-}
-
 // =============================================================================
 // INTERNAL: DERIVE IMU vs SYNC REGION SPLIT
 // =============================================================================
 
 
 
-// One sync *page* holds 16 sync frames.
-// One sync frame is logged every ~50 IMU pages (60s).
-// → One sync page per 800 IMU pages.
+// One sync *page* holds 15 sync frames (see IMU_PAGES_PER_SYNC_PAGE).
 
 static void deriveRegionSplit() {
   flashSyncPages = 0;
@@ -564,58 +798,280 @@ void computeFlashLayout() {
 }
 
 // =============================================================================
-// FLASH BOOT SCAN (IMU region only)
+// IMU LOG MODE (linear / ring)
 // =============================================================================
 
-void scanFlashOnBoot() {
-  // Geometry must already be computed by computeFlashLayout()
-
-  bootPagesFound = 0;
-  bootValidPages = 0;
-  bootCorruptPages = 0;
+#define IMU_SECTOR_PAGES (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
 
-  uint8_t pageBuf[FLASH_PAGE_SIZE];
+static bool g_imuRing = false;
 
-  for (uint32_t page = 0; page < flashImuPages; page++) {
-    const uint32_t addr = page * FLASH_PAGE_SIZE;
-    if (!flash.readData(addr, pageBuf, FLASH_PAGE_SIZE)) {
-      break;
-    }
+bool imuRingEnabled() {
+  return g_imuRing;
+}
 
-    const uint16_t footerOffset = FLASH_PAGE_SIZE - sizeof(PageFooter);
+uint32_t imuRingPages() {
+  return flashImuPages - flashImuPages % IMU_SECTOR_PAGES;
+}
 
-    PageFooter footer;
-    memcpy(&footer, pageBuf + footerOffset, sizeof(PageFooter));
+// Flash pages the logical page numbers cycle over (0 without flash).
+static uint32_t imuLogPeriod() {
+  return g_imuRing ? imuRingPages() : flashImuPages;
+}
 
-    if (footer.magic != PAGE_MAGIC) {
-      break;
-    }
+bool setImuRingMode(bool on) {
+  if (on == g_imuRing) {
+    return true;
+  }
 
-    bootPagesFound++;
+  if (currentPage > imuRingPages() ||
+      (on && imuRingPages() < IMU_RING_MIN_SECTORS * IMU_SECTOR_PAGES)) {
+    return false;
+  }
 
-    const bool footerSane = (footer.validFrames <= FRAMES_PER_PAGE);
-    bool crcOk = false;
+  g_imuRing = on;
+  writeCheckpoint();
+  return true;
+}
 
-    if (footerSane) {
-      const uint16_t usedBytes = footer.validFrames * sizeof(Frame20);
-      const uint16_t crcLen = usedBytes + offsetof(PageFooter, crc16);
-      crcOk = (crc16_ccitt(pageBuf, crcLen) == footer.crc16);
-    }
+uint32_t imuTailPage() {
+  const uint32_t head = currentPage;
+  const uint32_t ringPages = imuRingPages();
 
-    if (footerSane && crcOk) {
-      bootValidPages++;
-    } else {
-      bootCorruptPages++;
-    }
+  if (!g_imuRing || head <= ringPages) {
+    return 0;
   }
 
-  currentPage = bootPagesFound;
+  // The head's sector was erased when the head entered it; everything after
+  // it, round the ring, is the previous lap.
+  const uint32_t headSectorEnd =
+    (head + IMU_SECTOR_PAGES - 1) / IMU_SECTOR_PAGES * IMU_SECTOR_PAGES;
+  return headSectorEnd - ringPages;
 }
 
-void scanSyncPagesOnBoot() {
+uint32_t imuFlashPage(uint32_t page) {
+  const uint32_t period = imuLogPeriod();
+  return period ? page % period : page;
+}
 
-  syncCurrentPage = 0;
-  syncFrameCounter = 0;
+bool readImuPages(uint32_t page, uint8_t *buf, uint32_t count) {
+  const uint32_t period = imuLogPeriod();
+  if (period == 0) {
+    return false;
+  }
+
+  // A ring run may pass the end of the region and continue at its start.
+  for (uint32_t done = 0; done < count;) {
+    const uint32_t flashPage = (page + done) % period;
+
+    uint32_t run = period - flashPage;
+    if (run > count - done) run = count - done;
+
+    if (!flash.readData(flashPage * FLASH_PAGE_SIZE, buf + done * FLASH_PAGE_SIZE,
+                        run * FLASH_PAGE_SIZE)) {
+      return false;
+    }
+    done += run;
+  }
+
+  // The tail moves when the erase of a sector is queued, before it runs:
+  // pages still at or above it were intact when read.
+  return page >= imuTailPage();
+}
+
+// =============================================================================
+// FLASH BOOT SCAN (IMU region only)
+// =============================================================================
+
+static bool readImuFooter(uint32_t flashPage, PageFooter &out) {
+  const uint32_t addr =
+    flashPage * FLASH_PAGE_SIZE + FLASH_PAGE_SIZE - sizeof(PageFooter);
+  return flash.readData(addr, (uint8_t *)&out, sizeof(PageFooter));
+}
+
+static ImuPageState checkImuPageBuf(const uint8_t *pageBuf) {
+  return decodeImuPage(pageBuf, nullptr);
+}
+
+// Pages fetched per flash transaction by the linear sweeps.
+#define SCAN_BATCH_PAGES 8
+static uint8_t g_scanBuf[SCAN_BATCH_PAGES * FLASH_PAGE_SIZE];
+
+// Linear CRC sweep over logical pages [fromPage, toPage).
+// Stops at the first absent page; returns the index of that page (or toPage).
+static uint32_t sweepImuPages(uint32_t fromPage, uint32_t toPage,
+                              uint32_t &valid, uint32_t &corrupt,
+                              uint32_t &firstCorrupt) {
+  uint32_t page = fromPage;
+
+  while (page < toPage) {
+    uint32_t batch = toPage - page;
+    if (batch > SCAN_BATCH_PAGES) batch = SCAN_BATCH_PAGES;
+
+    if (!readImuPages(page, g_scanBuf, batch)) {
+      return page;
+    }
+
+    for (uint32_t i = 0; i < batch; i++, page++) {
+      const ImuPageState st = checkImuPageBuf(g_scanBuf + i * FLASH_PAGE_SIZE);
+
+      if (st == IMU_PAGE_ABSENT) {
+        return page;
+      }
+
+      if (st == IMU_PAGE_VALID) {
+        valid++;
+      } else {
+        if (corrupt == 0) firstCorrupt = page;
+        corrupt++;
+      }
+    }
+  }
+
+  return toPage;
+}
+
+// Locate the IMU write head (a flash page) by bisecting page footers.
+//
+// The log is written from page 0 up, so "footer carries an IMU magic" is a
+// monotonic predicate over page index. firstFrameID must also be
+// non-decreasing, starting from page 0's; a page that breaks that is stale
+// data or, in a ring, the previous lap, not part of the newest run.
+//
+// A blank page 0 is head 0: an empty log, or a ring whose wrap erased
+// sector 0 before page 0 was programmed (imuRingWrappedAt() tells them apart).
+//
+// Invariant: pages [0, lo) are written, pages [hi, flashImuPages) are not.
+static uint32_t findImuWriteHead(uint32_t &firstID0) {
+  uint32_t lo = 1;
+  uint32_t hi = flashImuPages;
+
+  firstID0 = 0;
+  PageFooter footer;
+  if (hi == 0 || !readImuFooter(0, footer) || !imuPageMagicKnown(footer.magic)) {
+    return 0;
+  }
+  uint32_t loFirstID = footer.firstFrameID;
+  firstID0 = loFirstID;
+
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+
+    const bool written =
+      readImuFooter(mid, footer) &&
+      imuPageMagicKnown(footer.magic) &&
+      footer.firstFrameID >= loFirstID;
+
+    if (written) {
+      lo = mid + 1;
+      loFirstID = footer.firstFrameID;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+// A wrapped ring past flash page 'head': the rest of the head's sector is
+// erased (or, head on a sector boundary, still the previous lap), and the
+// next sector starts with a page older than page 0, or with any written
+// page when page 0 itself is blank (head 0).
+static bool imuRingWrappedAt(uint32_t head, uint32_t firstID0) {
+  const uint32_t ringPages = imuRingPages();
+  const uint32_t next = (head / IMU_SECTOR_PAGES + 1) * IMU_SECTOR_PAGES;
+
+  if (ringPages < IMU_RING_MIN_SECTORS * IMU_SECTOR_PAGES || next >= ringPages) {
+    return false;
+  }
+
+  PageFooter footer;
+  return readImuFooter(next, footer) &&
+         imuPageMagicKnown(footer.magic) &&
+         (head == 0 || footer.firstFrameID < firstID0);
+}
+
+void scanFlashOnBoot() {
+  // Geometry must already be computed by computeFlashLayout()
+
+  bootPagesFound = 0;
+  bootValidPages = 0;
+  bootCorruptPages = 0;
+  bootVerifyStartPage = 0;
+
+  uint32_t firstCorrupt = 0;
+  uint32_t firstID0 = 0;
+
+  uint32_t head = findImuWriteHead(firstID0);
+
+  // Without a checkpoint the number of laps is unknown: a wrapped ring is
+  // numbered as if on its second.
+  if (imuRingWrappedAt(head, firstID0)) {
+    g_imuRing = true;
+    head += imuRingPages();
+  }
+
+  currentPage = head;
+
+#if defined(BOOT_SCAN_FULL)
+  bootVerifyStartPage = imuTailPage();
+#else
+  if (head > BOOT_VERIFY_TAIL_PAGES) {
+    bootVerifyStartPage = head - BOOT_VERIFY_TAIL_PAGES;
+  }
+  if (bootVerifyStartPage < imuTailPage()) {
+    bootVerifyStartPage = imuTailPage();
+  }
+#endif
+
+  // Only the tail is re-verified (the whole log with BOOT_SCAN_FULL); a page
+  // missing inside the window means the bisect was fooled (e.g. torn
+  // write), so the head is pulled back to it.
+  bootPagesFound = sweepImuPages(bootVerifyStartPage, head,
+                                 bootValidPages, bootCorruptPages,
+                                 firstCorrupt);
+
+  currentPage = bootPagesFound;
+}
+
+void verifyImuLog() {
+  if (!flashPresent) {
+    emitEvent("# Flash unavailable");
+    return;
+  }
+
+  emitEvent("# Verify started");
+
+  uint32_t valid = 0;
+  uint32_t corrupt = 0;
+  uint32_t firstCorrupt = 0;
+
+  const uint32_t end = sweepImuPages(imuTailPage(), currentPage, valid, corrupt, firstCorrupt);
+
+  char line[128];
+  snprintf(line, sizeof(line),
+           "# Verify complete: pages=%lu valid=%lu corrupt=%lu",
+           (unsigned long)end,
+           (unsigned long)valid,
+           (unsigned long)corrupt);
+  emitEvent(line);
+
+  if (corrupt > 0) {
+    snprintf(line, sizeof(line), "# First corrupt page: %lu",
+             (unsigned long)firstCorrupt);
+    emitEvent(line);
+  }
+
+  if (end < currentPage) {
+    snprintf(line, sizeof(line), "# Missing footer at page %lu (head=%lu)",
+             (unsigned long)end, (unsigned long)currentPage);
+    emitEvent(line);
+  }
+}
+
+void scanSyncPagesOnBoot() {
+
+  syncCurrentPage = 0;
+  syncFrameCounter = 0;
 
   if (flashSyncPages == 0) {
     return;
@@ -665,16 +1121,13 @@ void reconstructFrameCounterFromFlash() {
     return;
   }
 
-  const uint32_t addr =
-    (currentPage - 1) * FLASH_PAGE_SIZE + FLASH_PAGE_SIZE - sizeof(PageFooter);
-
   PageFooter footer;
-  if (!flash.readData(addr, (uint8_t *)&footer, sizeof(PageFooter))) {
+  if (!readImuFooter(imuFlashPage(currentPage - 1), footer)) {
     frameCounter = 0;
     return;
   }
 
-  if (footer.magic != PAGE_MAGIC || footer.validFrames > FRAMES_PER_PAGE) {
+  if (!imuFooterSane(footer)) {
     frameCounter = 0;
     return;
   }
@@ -682,6 +1135,488 @@ void reconstructFrameCounterFromFlash() {
   frameCounter = footer.firstFrameID + footer.validFrames;
 }
 
+// =============================================================================
+// FLASH BENCHMARK
+// =============================================================================
+//
+// Read: FLASH_BENCH_READ_BYTES from page 0 in SCAN_BATCH_PAGES transactions.
+// Program: one sector past the IMU write head is erased, programmed page by
+// page (including busy waits) and erased again, so the log is untouched.
+
+#define FLASH_BENCH_READ_BYTES (64UL * 1024UL)
+
+// First 'size'-aligned area entirely past the IMU write head and inside the
+// IMU region (the ring, in ring mode), or SPIFlash::NO_BLOCK if there is none.
+// Nothing there is part of the log, so it may be used as destructive scratch
+// space. A ring that has wrapped has none.
+static uint32_t scratchAreaPastHead(uint32_t size) {
+  if (currentPage >= imuLogPeriod()) {
+    return SPIFlash::NO_BLOCK;
+  }
+
+  const uint32_t addr =
+    (currentPage * FLASH_PAGE_SIZE + size - 1) & ~(size - 1);
+
+  if (addr + size > imuLogPeriod() * FLASH_PAGE_SIZE) {
+    return SPIFlash::NO_BLOCK;
+  }
+  return addr;
+}
+
+static void emitBenchLine(const char *what, uint32_t bytes, uint32_t us) {
+  char line[96];
+  const float mbps = us ? (float)bytes / (float)us : 0.0f;  // bytes/us == MB/s
+  snprintf(line, sizeof(line), "# %s: %lu bytes in %lu us = %.2f MB/s",
+           what, (unsigned long)bytes, (unsigned long)us, mbps);
+  emitEvent(line);
+}
+
+void runFlashBenchmark() {
+  if (!flashPresent) {
+    emitEvent("# Flash unavailable");
+    return;
+  }
+
+  writerDrain();
+
+  // ---- read ----
+  uint32_t readBytes = FLASH_BENCH_READ_BYTES;
+  if (readBytes > flashCapacityBytes) readBytes = flashCapacityBytes;
+
+  uint32_t t0 = micros();
+  for (uint32_t off = 0; off < readBytes; off += sizeof(g_scanBuf)) {
+    flash.readData(off, g_scanBuf, sizeof(g_scanBuf));
+  }
+  emitBenchLine("read", readBytes, micros() - t0);
+
+  // ---- erase + program ----
+  const uint32_t sectorAddr = scratchAreaPastHead(FLASH_SECTOR_SIZE);
+
+  if (sectorAddr == SPIFlash::NO_BLOCK) {
+    emitEvent("# program: no free sector past the write head");
+    return;
+  }
+
+  memset(g_scanBuf, 0xA5, FLASH_PAGE_SIZE);
+
+  t0 = micros();
+  const bool erased = flash.eraseSector(sectorAddr);
+  const uint32_t eraseUs = micros() - t0;
+
+  t0 = micros();
+  bool programmed = erased;
+  for (uint32_t off = 0; programmed && off < FLASH_SECTOR_SIZE; off += FLASH_PAGE_SIZE) {
+    programmed = flash.writePage(sectorAddr + off, g_scanBuf, FLASH_PAGE_SIZE);
+  }
+  const uint32_t programUs = micros() - t0;
+
+  flash.eraseSector(sectorAddr);
+
+  if (!programmed) {
+    emitEvent("# program: flash write failed");
+    return;
+  }
+
+  emitBenchLine("program", FLASH_SECTOR_SIZE, programUs);
+
+  char line[64];
+  snprintf(line, sizeof(line), "# sector erase: %lu us", (unsigned long)eraseUs);
+  emitEvent(line);
+}
+
+void runFlashCharacterization() {
+  if (!flashPresent) {
+    emitEvent("# Flash unavailable");
+    return;
+  }
+
+  if (flash.isEmulated()) {
+    emitEvent("# flashprofile: not available on emulated flash");
+    return;
+  }
+
+  const uint32_t sectorAddr = scratchAreaPastHead(FLASH_SECTOR_SIZE);
+  if (sectorAddr == SPIFlash::NO_BLOCK) {
+    emitEvent("# flashprofile: no free sector past the write head");
+    return;
+  }
+
+  writerDrain();
+
+  emitEvent("# flashprofile: measuring (erase/program scratch past head)");
+
+  FlashTimingProfile p;
+  if (!flash.characterize(sectorAddr, scratchAreaPastHead(FLASH_BLOCK_SIZE), p)) {
+    emitEvent("# flashprofile: measurement failed");
+    return;
+  }
+
+  char line[96];
+  snprintf(line, sizeof(line), "# profile: tPP=%lu us tSE=%lu us tBE=%lu us",
+           (unsigned long)p.tPPus, (unsigned long)p.tSEus, (unsigned long)p.tBEus);
+  emitEvent(line);
+}
+
+// =============================================================================
+// WRITE-HEAD CHECKPOINT JOURNAL
+// =============================================================================
+
+static constexpr uint32_t CKPT_RECORDS_PER_SECTOR =
+  FLASH_SECTOR_SIZE / sizeof(LogCheckpoint);
+static constexpr uint32_t CKPT_RECORDS_TOTAL =
+  CKPT_RECORDS_PER_SECTOR * CHECKPOINT_SECTORS;
+
+// Upper bound on pages written after the newest checkpoint before we give up
+// rolling forward and fall back to the boot scan.
+static constexpr uint32_t CKPT_ROLL_FORWARD_LIMIT = 2 * CHECKPOINT_INTERVAL_PAGES;
+
+static uint32_t g_ckptNextRecord = 0;  // ring position of the next record
+static uint32_t g_ckptSeq = 0;         // seq of the newest record written
+
+uint16_t sessionID = 0;
+uint16_t logEpoch = 0;  // a scan boot restarts at 0
+
+static uint32_t checkpointRecordAddr(uint32_t record) {
+  return (flashStorageBasePage + STORAGE_SLOT_LIMIT) * FLASH_PAGE_SIZE +
+         record * sizeof(LogCheckpoint);
+}
+
+static bool readCheckpointRecord(uint32_t record, LogCheckpoint &out) {
+  if (!flash.readData(checkpointRecordAddr(record), (uint8_t *)&out, sizeof(out))) {
+    return false;
+  }
+
+  if (out.magic != CHECKPOINT_MAGIC) {
+    return false;
+  }
+
+  return crc16_ccitt((const uint8_t *)&out, offsetof(LogCheckpoint, crc16)) == out.crc16;
+}
+
+// Find the newest valid record.
+//
+// Each sector is filled front to back, so the sector holding the newest record
+// is the one whose first record has the highest seq, and within that sector
+// "record is programmed" is monotonic and can be bisected.
+static bool findNewestCheckpoint(uint32_t &recordOut, LogCheckpoint &out) {
+  int32_t bestSector = -1;
+  uint32_t bestSeq = 0;
+
+  for (uint32_t sec = 0; sec < CHECKPOINT_SECTORS; sec++) {
+    LogCheckpoint c;
+    if (readCheckpointRecord(sec * CKPT_RECORDS_PER_SECTOR, c) &&
+        (bestSector < 0 || c.seq > bestSeq)) {
+      bestSector = (int32_t)sec;
+      bestSeq = c.seq;
+    }
+  }
+
+  if (bestSector < 0) {
+    return false;
+  }
+
+  const uint32_t base = (uint32_t)bestSector * CKPT_RECORDS_PER_SECTOR;
+
+  // Invariant: records [base, base+lo) are programmed, [base+hi, ...) are not.
+  uint32_t lo = 1;
+  uint32_t hi = CKPT_RECORDS_PER_SECTOR;
+
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+
+    uint32_t magic = 0;
+    flash.readData(checkpointRecordAddr(base + mid), (uint8_t *)&magic, sizeof(magic));
+
+    if (magic == CHECKPOINT_MAGIC) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // A torn final record fails its CRC; step back to the last intact one.
+  for (uint32_t n = lo; n > 0; n--) {
+    if (readCheckpointRecord(base + n - 1, out)) {
+      recordOut = base + n - 1;
+      g_ckptNextRecord = (base + lo) % CKPT_RECORDS_TOTAL;
+      g_ckptSeq = out.seq;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool readSyncFooter(uint32_t index, SyncPageFooter &out) {
+  const uint32_t addr = (flashSyncBasePage + index) * FLASH_PAGE_SIZE +
+                        FLASH_PAGE_SIZE - sizeof(SyncPageFooter);
+  return flash.readData(addr, (uint8_t *)&out, sizeof(SyncPageFooter));
+}
+
+bool restoreFromCheckpoint() {
+  if (!flashPresent || flashTotalPages < FLASH_RESERVED_PAGES) {
+    return false;
+  }
+
+  uint32_t record = 0;
+  LogCheckpoint c;
+
+  g_ckptNextRecord = 0;
+  g_ckptSeq = 0;
+
+  if (!findNewestCheckpoint(record, c)) {
+    return false;
+  }
+
+  // Session numbering, the log epoch and the log mode survive even if the
+  // counters cannot be confirmed.
+  sessionID = c.sessionID;
+  logEpoch = c.logEpoch;
+  g_imuRing = (c.logMode == CKPT_LOG_RING) &&
+              imuRingPages() >= IMU_RING_MIN_SECTORS * IMU_SECTOR_PAGES;
+
+  if ((!g_imuRing && c.currentPage > flashImuPages) ||
+      c.syncCurrentPage > flashSyncPages) {
+    return false;
+  }
+
+  // --- IMU head: last recorded page must exist, then roll forward ---
+  uint32_t page = c.currentPage;
+  uint32_t lastID = 0;
+  PageFooter footer;
+
+  if (page > 0) {
+    if (!readImuFooter(imuFlashPage(page - 1), footer) ||
+        !imuPageMagicKnown(footer.magic) ||
+        footer.firstFrameID > c.frameCounter) {
+      return false;
+    }
+    lastID = footer.firstFrameID;
+  }
+
+  // A ring page older than the last one is the previous lap, not new data.
+  uint32_t rolled = 0;
+  while (g_imuRing || page < flashImuPages) {
+    PageFooter next;
+    if (!readImuFooter(imuFlashPage(page), next) || !imuPageMagicKnown(next.magic) ||
+        next.firstFrameID < lastID) {
+      break;
+    }
+
+    if (++rolled > CKPT_ROLL_FORWARD_LIMIT) {
+      return false;
+    }
+    lastID = next.firstFrameID;
+    page++;
+  }
+
+  // --- SYNC head: same confirmation over the sync region ---
+  uint32_t syncPage = c.syncCurrentPage;
+  SyncPageFooter sf;
+
+  if (syncPage > 0) {
+    if (!readSyncFooter(syncPage - 1, sf) || sf.magic != SYNC_MAGIC) {
+      return false;
+    }
+  }
+
+  while (syncPage < flashSyncPages &&
+         readSyncFooter(syncPage, sf) &&
+         sf.magic == SYNC_MAGIC &&
+         sf.validFrames <= SYNC_FRAMES_PER_PAGE) {
+    syncPage++;
+  }
+
+  syncCurrentPage = syncPage;
+  syncFrameCounter = 0;
+
+  if (syncPage > 0 &&
+      readSyncFooter(syncPage - 1, sf) &&
+      sf.validFrames > 0 && sf.validFrames <= SYNC_FRAMES_PER_PAGE) {
+    syncFrameCounter = sf.firstSyncID + sf.validFrames - 1;
+  }
+
+  currentPage = page;
+  recordStartPage = c.recordStartPage;
+  reconstructFrameCounterFromFlash();
+
+  bootPagesFound = currentPage;
+  bootValidPages = 0;
+  bootCorruptPages = 0;
+  bootVerifyStartPage = currentPage;
+  bootFromCheckpoint = true;
+
+  return true;
+}
+
+void resetCheckpointJournal() {
+  g_ckptNextRecord = 0;
+}
+
+void writeCheckpoint() {
+  if (!flashPresent || flashTotalPages < FLASH_RESERVED_PAGES) {
+    return;
+  }
+
+  const uint32_t record = g_ckptNextRecord;
+
+  LogCheckpoint c;
+  c.magic = CHECKPOINT_MAGIC;
+  c.seq = g_ckptSeq + 1;
+  c.currentPage = currentPage;
+  c.frameCounter = frameCounter;
+  c.syncFrameCounter = (uint16_t)syncFrameCounter;
+  c.logEpoch = logEpoch;
+  c.recordStartPage = recordStartPage;
+  c.syncCurrentPage = (uint16_t)syncCurrentPage;
+  c.sessionID = sessionID;
+  c.logMode = g_imuRing ? CKPT_LOG_RING : CKPT_LOG_LINEAR;
+  c.crc16 = crc16_ccitt((const uint8_t *)&c, offsetof(LogCheckpoint, crc16));
+
+  // Entering a sector: erase it. The other sector still holds the previous
+  // records, so a power loss here never leaves the journal empty.
+  const uint8_t flags =
+    ((record % CKPT_RECORDS_PER_SECTOR) == 0) ? WRITER_JOB_ERASE_SECTOR : 0;
+
+  // Queued behind any pending IMU pages, so it never lands before them.
+  writerSubmitCopy((const uint8_t *)&c, checkpointRecordAddr(record), sizeof(c), flags);
+
+  g_ckptSeq = c.seq;
+  g_ckptNextRecord = (record + 1) % CKPT_RECORDS_TOTAL;
+}
+
+// =============================================================================
+// IMU PAGE INDEX (sparse) + RANGE SEEK
+// =============================================================================
+
+static ImuIndexEntry g_imuIndex[IMU_INDEX_MAX_ENTRIES];
+static uint32_t g_imuIndexStride = IMU_INDEX_MIN_STRIDE;
+
+uint32_t imuIndexStride() {
+  return g_imuIndexStride;
+}
+
+// First page at or above 'page' that starts a stride.
+static uint32_t imuIndexPageFrom(uint32_t page) {
+  return (page + g_imuIndexStride - 1) / g_imuIndexStride * g_imuIndexStride;
+}
+
+uint32_t imuIndexEntries() {
+  const uint32_t first = imuIndexPageFrom(imuTailPage());
+  const uint32_t head = currentPage;
+  return (head > first) ? (head - first + g_imuIndexStride - 1) / g_imuIndexStride : 0;
+}
+
+static ImuIndexEntry &imuIndexEntry(uint32_t page) {
+  return g_imuIndex[(page / g_imuIndexStride) % IMU_INDEX_MAX_ENTRIES];
+}
+
+// Record page 'page' if it starts a stride.
+static void imuIndexNotePage(uint32_t page, uint32_t firstFrameID, uint32_t startMs) {
+  if ((page % g_imuIndexStride) != 0) {
+    return;
+  }
+
+  ImuIndexEntry &e = imuIndexEntry(page);
+  e.firstFrameID = firstFrameID;
+  e.pageStartMs = startMs;
+}
+
+void imuIndexRebuild() {
+  const uint32_t perEntry =
+    (flashImuPages + IMU_INDEX_MAX_ENTRIES - 1) / IMU_INDEX_MAX_ENTRIES;
+  g_imuIndexStride = (perEntry > IMU_INDEX_MIN_STRIDE) ? perEntry : IMU_INDEX_MIN_STRIDE;
+
+  ImuIndexEntry prev = { 0, 0 };
+
+  for (uint32_t page = imuIndexPageFrom(imuTailPage()); page < currentPage;
+       page += g_imuIndexStride) {
+    PageFooter footer;
+    if (readImuFooter(imuFlashPage(page), footer) && imuFooterSane(footer)) {
+      prev.firstFrameID = footer.firstFrameID;
+      prev.pageStartMs = footer.pageStartMs;
+    }
+    // An unreadable stride page inherits the previous keys, which keeps
+    // seeks conservative (they land earlier, never later).
+    imuIndexNotePage(page, prev.firstFrameID, prev.pageStartMs);
+  }
+}
+
+void imuRangeBegin(ImuRange &r, ImuRangeKind kind, uint32_t from, uint32_t to) {
+  r.kind = kind;
+  r.from = from;
+  r.to = to;
+  r.lastMs = 0;
+  r.started = false;
+}
+
+// Page keys lie beyond the start of the range.
+static bool rangeKeyPastFrom(const ImuRange &r, uint32_t firstFrameID, uint32_t startMs) {
+  return ((r.kind == IMU_RANGE_MS) ? startMs : firstFrameID) > r.from;
+}
+
+uint32_t imuRangeFirstPage(const ImuRange &r, uint32_t endPage) {
+  const uint32_t tail = imuTailPage();
+
+  if (r.kind == IMU_RANGE_ALL || endPage <= tail) {
+    return tail;
+  }
+
+  // Last indexed page not yet past 'from' (or the tail): the range starts
+  // in the stride after it (or in the unindexed part before the head).
+  uint32_t lo = tail;
+  uint32_t next = imuIndexPageFrom(tail + 1);
+
+  while (next < endPage) {
+    const ImuIndexEntry &e = imuIndexEntry(next);
+    if (rangeKeyPastFrom(r, e.firstFrameID, e.pageStartMs)) {
+      break;
+    }
+    lo = next;
+    next += g_imuIndexStride;
+  }
+
+  const uint32_t hi = (next < endPage) ? next : endPage;
+
+  for (uint32_t page = lo + 1; page < hi; page++) {
+    PageFooter footer;
+    if (readImuFooter(imuFlashPage(page), footer) && imuFooterSane(footer) &&
+        rangeKeyPastFrom(r, footer.firstFrameID, footer.pageStartMs)) {
+      return page - 1;
+    }
+  }
+
+  return hi - 1;
+}
+
+bool imuRangePastEnd(ImuRange &r, const PageFooter &footer) {
+  switch (r.kind) {
+    case IMU_RANGE_FRAMES:
+      return footer.firstFrameID > r.to;
+
+    case IMU_RANGE_MS: {
+      const bool clockReset = r.started && footer.pageStartMs < r.lastMs;
+      r.lastMs = footer.pageStartMs;
+      r.started = true;
+      return clockReset || footer.pageStartMs > r.to;
+    }
+
+    default:
+      return false;
+  }
+}
+
+bool imuRangeHasFrame(const ImuRange &r, uint32_t frameID, uint32_t ms) {
+  switch (r.kind) {
+    case IMU_RANGE_FRAMES:
+      return frameID >= r.from && frameID <= r.to;
+    case IMU_RANGE_MS:
+      return ms >= r.from && ms <= r.to;
+    default:
+      return true;
+  }
+}
+
 // =============================================================================
 // FLASH LOGGING (IMU)
 // =============================================================================
@@ -691,42 +1626,45 @@ void flushPageToFlash() {
     return;
   }
 
-  if (currentPage >= flashImuPages) {
+  if (!g_imuRing && currentPage >= flashImuPages) {
     emitEvent("# Flash full — recording stopped");
     mode = MODE_IDLE;
 
     // Ensure we can still flush any pending sync page when recording stops.
     flushPendingSyncPageToFlash();
+    writeCheckpoint();
+    writerDrain();
     return;
   }
 
-  const uint32_t addr = currentPage * FLASH_PAGE_SIZE;
-
-  const uint16_t usedBytes = FRAMES_PER_PAGE * sizeof(Frame20);
-  memcpy(g_flushRawPage, pageFrames, usedBytes);
-
-  const uint16_t footerOffset = FLASH_PAGE_SIZE - sizeof(PageFooter);
-  memset(g_flushRawPage + usedBytes, 0xFF, footerOffset - usedBytes);
+  if (!g_fillPage) {
+    return;
+  }
 
-  PageFooter footer;
-  footer.magic = PAGE_MAGIC;
-  footer.validFrames = frameIndexInPage;
-  footer.crc16 = 0;
-  footer.firstFrameID = pageFirstID;
-  footer.pageStartMs = pageStartMs;
+  const uint32_t flashPage = imuFlashPage(currentPage);
 
-  memcpy(g_flushRawPage + footerOffset, &footer, sizeof(PageFooter));
+  // Ring past its first lap: entering a sector means entering the oldest
+  // data, which is erased just ahead of this page's program.
+  const uint8_t flags =
+    (g_imuRing && currentPage >= imuRingPages() && (flashPage % IMU_SECTOR_PAGES) == 0)
+      ? WRITER_JOB_ERASE_SECTOR
+      : 0;
 
-  const uint16_t crcLen = usedBytes + offsetof(PageFooter, crc16);
-  ((PageFooter *)(g_flushRawPage + footerOffset))->crc16 = crc16_ccitt(g_flushRawPage, crcLen);
+  imuEncoderFinish(g_pageEnc, pageFirstID, pageStartMs);
+  imuIndexNotePage(currentPage, pageFirstID, pageStartMs);
 
-  flash.writePage(addr, g_flushRawPage, FLASH_PAGE_SIZE);
+  writerSubmitPage(g_fillPage, flashPage * FLASH_PAGE_SIZE, FLASH_PAGE_SIZE, flags);
+  g_fillPage = nullptr;
 
   frameIndexInPage = 0;
   currentPage++;
+
+  if ((currentPage % CHECKPOINT_INTERVAL_PAGES) == 0) {
+    writeCheckpoint();
+  }
 }
 
-bool logFrame(const Frame20 &f) {
+bool logFrame(const Frame20 &f, uint32_t sampleMs) {
   if (!flashPresent) {
     mode = MODE_IDLE;
     return false;
@@ -739,22 +1677,56 @@ bool logFrame(const Frame20 &f) {
   // Opportunistic sync scheduler (time-based)
   serviceSyncScheduler();
 
-  if (recordPageLimit > 0 && frameIndexInPage == 0 && (currentPage - recordStartPage) >= recordPageLimit) {
+  const uint8_t missed = samplesMissedBefore(sampleMs);
+
+  if (frameIndexInPage > 0) {
+    if (imuEncoderAppend(g_pageEnc, f, sampleMs, missed)) {
+      noteSampleLogged(sampleMs, missed);
+      frameIndexInPage++;
+      if (imuEncoderFull(g_pageEnc)) {
+        flushPageToFlash();
+      }
+      return true;
+    }
+
+    // Page capacity depends on how well the frames compress (and, for timed
+    // layouts, on dt fitting): close the page and let this frame open the
+    // next one.
+    flushPageToFlash();
+    if (mode != MODE_RECORDING) {
+      return false;
+    }
+  }
+
+  if (recordPageLimit > 0 && (currentPage - recordStartPage) >= recordPageLimit) {
 
     emitEvent("# Recording page limit reached");
     mode = MODE_IDLE;
 
     flushPendingSyncPageToFlash();
+    writeCheckpoint();
+    writerDrain();
     printPrompt();
     return false;
   }
 
-  pageFrames[frameIndexInPage++] = f;
-
-  if (frameIndexInPage >= FRAMES_PER_PAGE) {
-    flushPageToFlash();
+  if (!g_fillPage) {
+    g_fillPage = writerAcquirePage();
+    if (!g_fillPage) {
+      // Writer is behind and the pool is exhausted: drop this frame
+      // (counted as an overrun) rather than stall acquisition.
+      return false;
+    }
   }
 
+  imuEncoderBegin(g_pageEnc, g_fillPage, IMU_PAGE_RECORD_MAGIC, IMU_FRAME_LAYOUT);
+  imuEncoderAppend(g_pageEnc, f, sampleMs, missed);
+  noteSampleLogged(sampleMs, missed);
+
+  pageStartMs = sampleMs;
+  pageFirstID = frameCounter + 1;
+  frameIndexInPage = 1;
+
   return true;
 }
 
@@ -863,7 +1835,7 @@ void flushSyncPageToFlash() {
   const uint16_t crcLen = usedBytes + offsetof(SyncPageFooter, crc16);
   ((SyncPageFooter *)(raw + footerOffset))->crc16 = crc16_ccitt(raw, crcLen);
 
-  flash.writePage(addr, raw, FLASH_PAGE_SIZE);
+  writerSubmitCopy(raw, addr, FLASH_PAGE_SIZE);
 
   // Reset for next page
   syncFrameIndexInPage = 0;
@@ -905,7 +1877,7 @@ void flushPendingSyncPageToFlash() {
   const uint16_t crcLen = usedBytes + offsetof(SyncPageFooter, crc16);
   ((SyncPageFooter *)(raw + footerOffset))->crc16 = crc16_ccitt(raw, crcLen);
 
-  flash.writePage(addr, raw, FLASH_PAGE_SIZE);
+  writerSubmitCopy(raw, addr, FLASH_PAGE_SIZE);
 
   // Reset pending buffer
   syncFrameIndexInPage = 0;
@@ -917,99 +1889,414 @@ void flushPendingSyncPageToFlash() {
 // PLAYBACK
 // =============================================================================
 
-void playbackTask() {
-  if (!flashPresent) {
-    emitEvent("# Flash unavailable – cannot playback");
-    mode = MODE_IDLE;
-    printPrompt();
-    return;
+// Each open output sink gets its own cursor over the same range, paced by
+// that sink's free TX space: USB CDC runs at full speed while a BLE client
+// trickles, and each cursor reports its own completion. Playback ends when
+// the last cursor does.
+
+// Output of one playback step (GAP + frame line, footer line or summary).
+#define PLAYBACK_STEP_MAX_BYTES 192
+
+// Steps per cursor per playbackTask() pass, and how long a cursor may wait
+// for TX space before its sink is given up on.
+#define PLAYBACK_PASS_STEPS 32
+#define PLAYBACK_STALL_MS   10000
+
+struct PlaybackCursor {
+  bool active;
+  bool pageOpen;         // page footer emitted, frames in progress
+  bool rangeEnded;
+  ImuRange walk;         // playbackRange with this cursor's range-end state
+  uint32_t page;
+  uint16_t frameIndex;
+  uint32_t pagesSeen;
+  uint32_t crcWarnings;
+  uint32_t lastProgressMs;
+};
+
+static PlaybackCursor g_playbackCursors[OUTPUT_MAX_SINKS];
+
+// Shared decoded page: which page it is, its state and the frames left
+// after trimming to the range.
+static uint32_t g_playbackCachedPage = UINT32_MAX;
+static ImuPageState g_playbackCachedState = IMU_PAGE_ABSENT;
+static uint16_t g_playbackFirstFrame = 0;
+
+// Page the cursors stop at (playbackPageLimit pages from the first one).
+static uint32_t g_playbackEndPage = 0;
+
+void startPlayback(PlaybackFormat format, const ImuRange &range, uint32_t pageLimit) {
+  playbackRange = range;
+  playbackPageLimit = pageLimit;
+  playbackFormat = format;
+
+  g_playbackCachedPage = UINT32_MAX;
+
+  const uint32_t first = imuRangeFirstPage(range, currentPage);
+  g_playbackEndPage = (pageLimit > 0 && pageLimit < currentPage - first)
+                        ? first + pageLimit
+                        : currentPage;
+
+  for (uint8_t i = 0; i < OUTPUT_MAX_SINKS; i++) {
+    PlaybackCursor &c = g_playbackCursors[i];
+    c = {};
+    c.active = outputSinkOpen(i);
+    c.page = first;
+    c.walk = range;
+    c.lastProgressMs = millis();
   }
 
-  if ((playbackPageLimit > 0 && playbackPage >= playbackPageLimit) || (playbackPage >= currentPage)) {
+  mode = MODE_PLAYBACK;
+}
 
-    Serial.println();
-    Serial.println("Dump summary:");
-    Serial.print("  Pages processed: ");
-    Serial.println(playbackPagesSeen);
-    Serial.print("  CRC warnings:   ");
-    Serial.println(playbackCrcWarnings);
-    Serial.println();
+enum PlaybackPageKind {
+  PLAYBACK_PAGE_SKIP,      // absent, implausible or no frames in range
+  PLAYBACK_PAGE_PAST_END,  // beyond the range: stop
+  PLAYBACK_PAGE_FRAMES
+};
 
-    emitEvent("# Dump complete");
+// Decode 'page' into the shared buffers (unless already there) and trim it
+// to playbackRange. Touches no cursor state, so reloading a page another
+// cursor replaced is harmless.
+static void playbackLoadPage(uint32_t page) {
+  if (g_playbackCachedPage != page) {
+    g_playbackCachedPage = page;
 
-    mode = MODE_IDLE;
-    printPrompt();
-    return;
+    readImuPages(page, playbackPageBuf, 1);
+
+    const uint16_t footerOffset = FLASH_PAGE_SIZE - sizeof(PageFooter);
+    memcpy(&playbackFooter, playbackPageBuf + footerOffset, sizeof(PageFooter));
+
+    g_playbackCachedState =
+      decodeImuPage(playbackPageBuf, playbackFrames, &playbackFrameCount, playbackTimes);
+
+    // Trim frames outside the range (only boundary pages have any).
+    uint16_t first = 0;
+    while (first < playbackFrameCount &&
+           !imuRangeHasFrame(playbackRange, playbackFooter.firstFrameID + first,
+                             playbackTimes[first].ms)) {
+      first++;
+    }
+    while (playbackFrameCount > first &&
+           !imuRangeHasFrame(playbackRange,
+                             playbackFooter.firstFrameID + playbackFrameCount - 1,
+                             playbackTimes[playbackFrameCount - 1].ms)) {
+      playbackFrameCount--;
+    }
+    g_playbackFirstFrame = first;
   }
+}
 
-  if (!playbackPageLoaded) {
+// Classify the loaded page for a cursor opening it. The range-end check
+// advances the cursor's own walk state (time ranges track the previous page
+// start per cursor, so a slower transport is not cut short by a faster one).
+static PlaybackPageKind playbackPageKind(PlaybackCursor &c) {
+  if (g_playbackCachedState == IMU_PAGE_ABSENT || !imuFooterSane(playbackFooter)) {
+    return PLAYBACK_PAGE_SKIP;
+  }
+  if (imuRangePastEnd(c.walk, playbackFooter)) {
+    return PLAYBACK_PAGE_PAST_END;
+  }
+  if (g_playbackFirstFrame == playbackFrameCount) {
+    return PLAYBACK_PAGE_SKIP;
+  }
+  return PLAYBACK_PAGE_FRAMES;
+}
 
-    const uint32_t addr = playbackPage * FLASH_PAGE_SIZE;
-    flash.readData(addr, playbackPageBuf, FLASH_PAGE_SIZE);
+static bool playbackCursorDone(const PlaybackCursor &c) {
+  return c.page >= g_playbackEndPage || c.page >= currentPage || c.rangeEnded;
+}
 
-    const uint16_t footerOffset = FLASH_PAGE_SIZE - sizeof(PageFooter);
-    memcpy(&playbackFooter, playbackPageBuf + footerOffset, sizeof(PageFooter));
+static void playbackEmitFrame(uint8_t sink, uint16_t index) {
+  const Frame20 &f = playbackFrames[index];
+  const ImuFrameTime &t = playbackTimes[index];
+  const uint32_t id = playbackFooter.firstFrameID + index;
 
-    if (playbackFooter.magic != PAGE_MAGIC || playbackFooter.validFrames > FRAMES_PER_PAGE) {
-      playbackPage++;
-      playbackPageLoaded = false;
-      return;
+  if (playbackFormat == PLAYBACK_ASCII) {
+
+    char line[112];
+
+    if (t.missed > 0) {
+      snprintf(line, sizeof(line), "@GAP before=%lu missed=%u%s",
+               (unsigned long)id, t.missed,
+               t.missed >= TIME_GAP_MAX ? "+" : "");
+      outputLineTo(sink, line);
     }
 
-    const uint16_t usedBytes = playbackFooter.validFrames * sizeof(Frame20);
-    const uint16_t crcLen = usedBytes + offsetof(PageFooter, crc16);
+    snprintf(line, sizeof(line),
+             "%lu %d %d %d %d %d %d %d %d %d %d %lu",
+             (unsigned long)id,
+             f.q0, f.q1, f.q2, f.q3,
+             f.ax, f.ay, f.az,
+             f.mx, f.my, f.mz,
+             (unsigned long)t.ms);
+
+    outputLineTo(sink, line);
 
-    if (crc16_ccitt(playbackPageBuf, crcLen) != playbackFooter.crc16) {
-      playbackCrcWarnings++;
+  } else {
+
+    uint8_t pkt[24];
+    pkt[0] = 0x55;
+    pkt[1] = 0xAA;
+    pkt[2] = sizeof(Frame20);
+    pkt[3] = t.missed;  // gap marker (0 = contiguous)
+
+    memcpy(&pkt[4], &f, sizeof(Frame20));
+    outputWriteTo(sink, pkt, sizeof(pkt));
+  }
+}
+
+static void playbackFinishCursor(uint8_t sink, PlaybackCursor &c) {
+  char summary[PLAYBACK_STEP_MAX_BYTES];
+  snprintf(summary, sizeof(summary),
+           "\r\nDump summary:\r\n"
+           "  Pages processed: %lu\r\n"
+           "  CRC warnings:   %lu\r\n\r\n"
+           "# Dump complete",
+           (unsigned long)c.pagesSeen, (unsigned long)c.crcWarnings);
+  outputLineTo(sink, summary);
+  c.active = false;
+}
+
+// One unit of work for a cursor. False when its sink has no room for the
+// output (nothing consumed; retried next pass).
+static bool playbackStep(uint8_t sink, PlaybackCursor &c) {
+  if (!outputSinkHasRoom(sink, PLAYBACK_STEP_MAX_BYTES)) {
+    return false;
+  }
+
+  if (playbackCursorDone(c)) {
+    playbackFinishCursor(sink, c);
+    return true;
+  }
+
+  if (!c.pageOpen) {
+    playbackLoadPage(c.page);
+    const PlaybackPageKind kind = playbackPageKind(c);
+
+    if (kind == PLAYBACK_PAGE_PAST_END) {
+      c.rangeEnded = true;
+      return true;
+    }
+    if (kind == PLAYBACK_PAGE_SKIP) {
+      c.page++;
+      return true;
+    }
+
+    const bool crcOk = (g_playbackCachedState == IMU_PAGE_VALID);
+    if (!crcOk) {
+      c.crcWarnings++;
     }
 
     if (playbackFormat == PLAYBACK_ASCII) {
-      emitAsciiPageFooter(playbackPage, playbackFooter, true);
+      emitAsciiPageFooter(sink, c.page, playbackFooter, crcOk);
     } else {
-      emitBinaryPageFooter(playbackFooter);
+      emitBinaryPageFooter(sink, playbackFooter);
     }
 
-    playbackFrameIndex = 0;
-    playbackPageLoaded = true;
-    playbackPagesSeen++;
+    c.frameIndex = g_playbackFirstFrame;
+    c.pageOpen = true;
+    c.pagesSeen++;
+    return true;
+  }
+
+  // Another cursor may have loaded a different page meanwhile
+  playbackLoadPage(c.page);
+
+  if (c.frameIndex < playbackFrameCount) {
+    playbackEmitFrame(sink, c.frameIndex);
+    c.frameIndex++;
+    return true;
+  }
+
+  c.page++;
+  c.pageOpen = false;
+  return true;
+}
+
+static void pageDumpTask();
+
+void playbackTask() {
+  if (!flashPresent) {
+    emitEvent("# Flash unavailable – cannot playback");
+    mode = MODE_IDLE;
+    printPrompt();
+    return;
+  }
+
+  if (playbackFormat == PLAYBACK_PAGES) {
+    pageDumpTask();
     return;
   }
 
-  if (playbackFrameIndex < playbackFooter.validFrames) {
+  bool anyActive = false;
 
-    Frame20 &f = playbackFrames[playbackFrameIndex];
-    const uint32_t id = playbackFooter.firstFrameID + playbackFrameIndex;
+  for (uint8_t i = 0; i < OUTPUT_MAX_SINKS; i++) {
+    PlaybackCursor &c = g_playbackCursors[i];
+    if (!c.active) continue;
 
-    if (playbackFormat == PLAYBACK_ASCII) {
+    // Client gone, or not draining at all: stop feeding this transport
+    if (!outputSinkOpen(i) || millis() - c.lastProgressMs > PLAYBACK_STALL_MS) {
+      c.active = false;
+      continue;
+    }
 
-      char line[96];
-      snprintf(line, sizeof(line),
-               "%lu %d %d %d %d %d %d %d %d %d %d",
-               (unsigned long)id,
-               f.q0, f.q1, f.q2, f.q3,
-               f.ax, f.ay, f.az,
-               f.mx, f.my, f.mz);
+    for (uint8_t n = 0; n < PLAYBACK_PASS_STEPS && c.active; n++) {
+      if (!playbackStep(i, c)) break;
+      c.lastProgressMs = millis();
+    }
 
-      streamPrintln(line);
+    anyActive = anyActive || c.active;
+  }
 
-    } else {
+  if (!anyActive) {
+    mode = MODE_IDLE;
+    printPrompt();
+  }
+}
+
+// =============================================================================
+// PAGE DUMP (bdump)
+// =============================================================================
+//
+// Whole page records straight from flash to USB, as fast as the CDC TX
+// buffer drains: no decoding, BDUMP_READ_PAGES pages per flash read.
+
+#define BDUMP_READ_PAGES   4
+#define BDUMP_PASS_RECORDS 16      // records per playbackTask() pass, at most
+#define BDUMP_STALL_MS     10000   // host not reading: give up
+
+struct PageDump {
+  bool sync;
+  bool readError;
+  uint32_t page;            // next region page to load
+  uint32_t endPage;
+  uint16_t bufLen;          // record bytes loaded
+  uint16_t bufOff;          // record bytes sent
+  uint32_t sent;
+  uint32_t crcBad;
+  uint32_t crc32;
+  uint32_t lastProgressMs;
+  uint8_t records[BDUMP_READ_PAGES * STREAM_RECORD_BYTES];
+};
+
+static PageDump g_pageDump;
+
+bool startPageDump(bool sync, uint32_t firstPage, uint32_t pages) {
+  if (!outputSinkOpen(OUTPUT_SINK_USB)) {
+    return false;
+  }
+
+  writerDrain();
 
-      uint8_t pkt[24];
-      pkt[0] = 0x55;
-      pkt[1] = 0xAA;
-      pkt[2] = sizeof(Frame20);
-      pkt[3] = 0x00;
+  // IMU pages below the tail were overwritten (ring): start at the oldest
+  const uint32_t regionFirst = sync ? 0 : imuTailPage();
+  const uint32_t regionEnd = sync ? syncCurrentPage : currentPage;
+  if (firstPage < regionFirst) {
+    firstPage = regionFirst;
+  }
+  if (firstPage > regionEnd) {
+    firstPage = regionEnd;
+  }
+  if (pages == 0 || pages > regionEnd - firstPage) {
+    pages = regionEnd - firstPage;
+  }
+
+  PageDump &d = g_pageDump;
+  d.sync = sync;
+  d.readError = false;
+  d.page = firstPage;
+  d.endPage = firstPage + pages;
+  d.bufLen = 0;
+  d.bufOff = 0;
+  d.sent = 0;
+  d.crcBad = 0;
+  d.crc32 = 0;
+  d.lastProgressMs = millis();
+
+  char line[64];
+  snprintf(line, sizeof(line), "#BDUMP %s %lu %lu %u", sync ? "sync" : "imu",
+           (unsigned long)firstPage, (unsigned long)pages, (unsigned)STREAM_RECORD_BYTES);
+  outputLineTo(OUTPUT_SINK_USB, line);
+
+  playbackFormat = PLAYBACK_PAGES;
+  mode = MODE_PLAYBACK;
+  return true;
+}
 
-      memcpy(&pkt[4], &f, sizeof(Frame20));
-      streamWrite(pkt, sizeof(pkt));
+static bool pageDumpLoad(PageDump &d) {
+  uint32_t count = d.endPage - d.page;
+  if (count > BDUMP_READ_PAGES) {
+    count = BDUMP_READ_PAGES;
+  }
+
+  if (!loadPageRecords(d.records, d.sync, d.page, count)) {
+    d.readError = true;
+    return false;
+  }
+
+  for (uint32_t k = 0; k < count; k++) {
+    uint16_t flags;
+    memcpy(&flags, d.records + k * STREAM_RECORD_BYTES + 14, sizeof(flags));
+    if (!(flags & 0x0002)) {
+      d.crcBad++;
     }
+  }
 
-    playbackFrameIndex++;
+  d.bufLen = (uint16_t)(count * STREAM_RECORD_BYTES);
+  d.bufOff = 0;
+  d.crc32 = crc32_ieee_update(d.crc32, d.records, d.bufLen);
+  d.page += count;
+  return true;
+}
+
+// END record and summary; back to idle.
+static void pageDumpFinish(PageDump &d) {
+  BdumpEnd end;
+  end.magic = BDUMP_END_MAGIC;
+  end.pages = d.sent;
+  end.crcBad = d.crcBad;
+  end.crc32 = d.crc32;
+  outputWriteTo(OUTPUT_SINK_USB, (const uint8_t *)&end, sizeof(end));
+
+  char line[80];
+  snprintf(line, sizeof(line), "\r\n# bdump %s pages=%lu bad=%lu",
+           d.readError ? "read error" : "complete",
+           (unsigned long)d.sent, (unsigned long)d.crcBad);
+  outputLineTo(OUTPUT_SINK_USB, line);
+
+  mode = MODE_IDLE;
+  printPrompt();
+}
+
+static void pageDumpTask() {
+  PageDump &d = g_pageDump;
+
+  // Host gone or not reading: nobody left to frame the rest for
+  if (!outputSinkOpen(OUTPUT_SINK_USB) || millis() - d.lastProgressMs > BDUMP_STALL_MS) {
+    mode = MODE_IDLE;
     return;
   }
 
-  playbackPage++;
-  playbackPageLoaded = false;
+  for (uint8_t n = 0; n < BDUMP_PASS_RECORDS; n++) {
+    if (d.bufOff == d.bufLen &&
+        (d.page >= d.endPage || d.readError || !pageDumpLoad(d))) {
+      // END + summary line fit the room a record needs
+      if (outputSinkHasRoom(OUTPUT_SINK_USB, STREAM_RECORD_BYTES)) {
+        pageDumpFinish(d);
+      }
+      return;
+    }
+
+    if (!outputSinkHasRoom(OUTPUT_SINK_USB, STREAM_RECORD_BYTES)) {
+      return;
+    }
+
+    outputWriteTo(OUTPUT_SINK_USB, d.records + d.bufOff, STREAM_RECORD_BYTES);
+    d.bufOff += STREAM_RECORD_BYTES;
+    d.sent++;
+    d.lastProgressMs = millis();
+  }
 }
 
 void dumpSyncPagesAscii() {
@@ -1088,12 +2375,6 @@ void startNewRecordingSession() {
   recordPageLimit = 0;
   recordStartPage = currentPage;
 
-  playbackPage = 0;
-  playbackFrameIndex = 0;
-  playbackPageLoaded = false;
-
-  memset(pageFrames, 0, sizeof(pageFrames));
-
   // NEW: reset sync session state
   syncFrameIndexInPage = 0;
   syncCurrentPage = 0;
@@ -1105,6 +2386,12 @@ void startNewRecordingSession() {
   myICM.resetFIFO();
   myICM.resetDMP();
 
+  resetFlashWriterStats();
+  resetAcquisitionStats();
+
+  sessionID++;
+  writeCheckpoint();
+
   mode = MODE_RECORDING;
 
   emitEvent("# Recording started (append mode)");
@@ -1114,7 +2401,7 @@ void startNewRecordingSession() {
 // PAGE FOOTER EMISSION
 // =============================================================================
 
-void emitAsciiPageFooter(uint32_t page, const PageFooter &f, bool crcOk) {
+void emitAsciiPageFooter(uint8_t sink, uint32_t page, const PageFooter &f, bool crcOk) {
   char line[128];
   snprintf(line, sizeof(line),
            "@PAGE %lu %u %lu %lu 0x%04X %s",
@@ -1125,10 +2412,10 @@ void emitAsciiPageFooter(uint32_t page, const PageFooter &f, bool crcOk) {
            f.crc16,
            crcOk ? "OK" : "BAD");
 
-  streamPrintln(line);
+  outputLineTo(sink, line);
 }
 
-void emitBinaryPageFooter(const PageFooter &f) {
+void emitBinaryPageFooter(uint8_t sink, const PageFooter &f) {
   uint8_t pkt[4 + sizeof(PageFooter)];
   pkt[0] = 0x56;
   pkt[1] = 0xAA;
@@ -1136,5 +2423,5 @@ void emitBinaryPageFooter(const PageFooter &f) {
   pkt[3] = 0x00;
 
   memcpy(&pkt[4], &f, sizeof(PageFooter));
-  streamWrite(pkt, sizeof(pkt));
+  outputWriteTo(sink, pkt, sizeof(pkt));
 }
\ No newline at end of file
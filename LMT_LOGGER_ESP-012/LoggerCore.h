@@ -8,17 +8,21 @@
 
 #include "LoggerSync.h"
 #include "LoggerBeacon.h"
+#include "LoggerCRC.h"
+#include "LoggerFormat.h"
+#include "LoggerStorage.h"
+#include "LoggerWriter.h"
 
 // =============================================================================
 // LoggerCore — Domain / State Owner
 // =============================================================================
 //
 // Owns:
-//  - Frame/page formats (on-flash ABI)
+//  - Frame/page formats (on-flash ABI; IMU page codec in LoggerFormat)
 //  - Recording/playback state machines
 //  - Boot-time flash scan + frameCounter reconstruction
 //  - Output planes (CONTROL/EVENT)
-//  - Reserved tail storage (256 x 256-byte slots at end of flash)
+//  - Reserved tail layout (slot storage journal: LoggerStorage; checkpoints)
 //  - Sync-log reservation + buffering + flush (NEW)
 //
 // ABI NOTES
@@ -40,61 +44,86 @@
 #define VERBOSE_LOG 1
 // #define ERASE_FLASH_AT_START 1
 
-// =============================================================================
-// FRAME FORMAT (20 bytes)
+// Boot scan strategy.
+// Default: bisect IMU page footers to find the write head, then CRC-check only
+// the last BOOT_VERIFY_TAIL_PAGES pages. The full sweep is available on demand
+// via the `verify` CLI command.
+// Define BOOT_SCAN_FULL to CRC-check the whole log at boot (the head is still
+// found by bisection).
+// #define BOOT_SCAN_FULL 1
+#define BOOT_VERIFY_TAIL_PAGES 32
+
+// Pace acquisition from the ICM-20948 INT pin (DMP packet interrupt) instead
+// of polling: every record rate is DMP-clocked and the loop task sleeps until
+// the ISR wakes it. Comment out to restore the millis()-polled 10 Hz path.
+#define IMU_IRQ_ACQUISITION 1
+
+// Encoding for newly recorded IMU pages (see LoggerFormat.h).
+// PAGE_MAGIC_DELTA packs ~2-3x more frames per page; PAGE_MAGIC writes the
+// legacy raw layout. Readers accept both, so a log may mix them.
+#define IMU_PAGE_RECORD_MAGIC PAGE_MAGIC_DELTA
+
+// Frame layout for newly recorded IMU pages (FRAME_LAYOUT_* flags, see
+// LoggerFormat.h). FULL keeps Frame20 bit-exact; QUAT_S3 stores the
+// quaternion as smallest-three (<= 3 Q15 LSB error), MAG_REDUCED keeps
+// 10-bit magnetometer values (0.6 uT step, +-300 uT). Recorded in each page
+// footer, so pages of any layout decode side by side. TIMED adds a per-frame
+// dt + gap marker field (~1 byte per frame in delta pages).
+#define IMU_FRAME_LAYOUT FRAME_LAYOUT_TIMED
+// #define IMU_FRAME_LAYOUT (FRAME_LAYOUT_QUAT_S3 | FRAME_LAYOUT_MAG_REDUCED | FRAME_LAYOUT_TIMED)
+
+// =============================================================================
+// FRAME / IMU PAGE FORMATS
 // =============================================================================
 //
-// Stored frame format (20 bytes), little-endian.
+// Frame20, PageFooter and the IMU page encodings live in LoggerFormat.h so
+// host tools can share the codec.
 //
-struct Frame20 {
-  int16_t q0, q1, q2, q3;  // Quaternion (Q15)
-  int16_t ax, ay, az;      // Accelerometer (raw)
-  int16_t mx, my, mz;      // Magnetometer (raw)
-};
-static_assert(sizeof(Frame20) == 20, "Frame20 must be exactly 20 bytes");
+static_assert(FLASH_PAGE_SIZE == IMU_PAGE_BYTES, "IMU pages must be one flash page");
 
 // Live "frame" command response = Frame20 + CRC16(Frame20)
 static constexpr size_t LIVE_FRAME_BYTES = sizeof(Frame20) + sizeof(uint16_t);
 
 // =============================================================================
-// PAGE FOOTER FORMAT (IMU pages) — 16 bytes
+// IMU PAGE INDEX (sparse) + RANGE SEEK
 // =============================================================================
+//
+// The index keeps the footer keys of every imuIndexStride()-th IMU page:
+// page n * stride is kept in entry n % IMU_INDEX_MAX_ENTRIES. flushPageToFlash()
+// adds entries while recording; imuIndexRebuild() restores them at boot from
+// one footer read per stride. The stride grows with the IMU region so the
+// pages on flash (ring or not) never need more than IMU_INDEX_MAX_ENTRIES.
+//
+// A seek scans the table in RAM, then reads at most one stride of footers,
+// so time to first byte does not depend on where the range sits in the log.
+//
+// Time ranges use the recording's millis() clock, which restarts on every
+// boot: a time range resolves to its first occurrence in the log and ends
+// where the clock steps backwards.
 
-#define PAGE_MAGIC 0x50414745UL  // ASCII "PAGE"
+#define IMU_INDEX_MAX_ENTRIES 512
+#define IMU_INDEX_MIN_STRIDE  16  // pages
 
-struct PageFooter {
-  uint32_t magic;         // PAGE_MAGIC
-  uint16_t validFrames;   // Number of valid Frame20 entries
-  uint16_t crc16;         // CRC over frames + footer (excluding this field)
-  uint32_t firstFrameID;  // Global frame ID of first frame in page
-  uint32_t pageStartMs;   // millis() timestamp of first frame
+struct ImuIndexEntry {
+  uint32_t firstFrameID;
+  uint32_t pageStartMs;
 };
-static_assert(sizeof(PageFooter) == 16, "PageFooter must be exactly 16 bytes");
 
-// =============================================================================
-// SYNC PAGE FORMAT (NEW)
-// =============================================================================
-//
-// Sync pages are stored in a dedicated region after the IMU log region.
-//
-// Layout:
-//   - 0..(n*16-1) : SyncFrame entries (packed)
-//   - remaining bytes to footerOffset: 0xFF
-//   - last 16 bytes: SyncPageFooter
-//
-// CRC is computed over:
-//   [usedBytes] + [footer bytes up to (but excluding) crc16 field]
-//
-#define SYNC_MAGIC 0x53594E43UL  // ASCII "SYNC"
-
-struct SyncPageFooter {
-  uint32_t magic;        // SYNC_MAGIC
-  uint16_t validFrames;  // Number of valid SyncFrame entries
-  uint16_t crc16;        // CRC over frames + footer (excluding this field)
-  uint32_t firstSyncID;  // Monotonic sync frame ID (starts at 1)
-  uint32_t pageStartMs;  // millis() timestamp of first sync frame in page
+enum ImuRangeKind : uint8_t {
+  IMU_RANGE_ALL,     // whole log
+  IMU_RANGE_FRAMES,  // global frame IDs [from, to]
+  IMU_RANGE_MS       // sample times [from, to] (ms)
 };
-static_assert(sizeof(SyncPageFooter) == 16, "SyncPageFooter must be exactly 16 bytes");
+
+struct ImuRange {
+  ImuRangeKind kind;
+  uint32_t from;    // inclusive
+  uint32_t to;      // inclusive
+  uint32_t lastMs;  // walk state: previous page start (clock reset check)
+  bool started;     // walk state: a page has been checked
+};
+
+// Sync page format (SyncPageFooter, SYNC_MAGIC): see LoggerFormat.h.
 
 // =============================================================================
 // RECORDING PARAMETERS
@@ -102,17 +131,58 @@ static_assert(sizeof(SyncPageFooter) == 16, "SyncPageFooter must be exactly 16 b
 
 extern const uint32_t DEFAULT_PAGES_TO_LOG;
 
-// Frames per 256-byte page: floor(256 / 20) = 12
-static constexpr uint16_t FRAMES_PER_PAGE = 12;
-
 // =============================================================================
 // RESERVED TAIL STORAGE (256 pages @ end of flash)
 // =============================================================================
 //
-// Last 256 pages reserved for indexed storage elements.
+// Last 256 pages reserved for indexed storage elements (a log-structured
+// journal over [0, STORAGE_SLOT_LIMIT), see LoggerStorage.h) and the
+// checkpoint journal.
 //
 #define FLASH_RESERVED_PAGES 256
 
+// =============================================================================
+// WRITE-HEAD CHECKPOINT JOURNAL (last sectors of the reserved tail)
+// =============================================================================
+//
+// The last CHECKPOINT_SECTORS sectors of the reserved tail hold a rotating
+// journal of 32-byte LogCheckpoint records (8 per page, 128 per sector).
+// Records are appended into erased space; a sector is erased only when the
+// write position wraps into it, so older records in the other sector always
+// survive a power loss.
+//
+// Storage slots [STORAGE_SLOT_LIMIT, FLASH_RESERVED_PAGES) belong to the
+// checkpoint journal and are not available to the slot storage journal.
+//
+#define CHECKPOINT_MAGIC 0x434B5054UL  // ASCII "CKPT"
+
+#define CHECKPOINT_SECTORS 2
+#define CHECKPOINT_INTERVAL_PAGES 64  // IMU pages between checkpoints
+
+// LogCheckpoint.logMode (records from before ring mode hold 0xFFFF: linear)
+#define CKPT_LOG_LINEAR 0xFFFF
+#define CKPT_LOG_RING   0x5247  // ASCII "RG"
+
+#define STORAGE_SLOT_LIMIT \
+  (FLASH_RESERVED_PAGES - CHECKPOINT_SECTORS * (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE))
+
+struct LogCheckpoint {
+  uint32_t magic;             // CHECKPOINT_MAGIC
+  uint32_t seq;               // monotonic record sequence number
+  uint32_t currentPage;       // IMU log head (logical page)
+  uint32_t frameCounter;      // next IMU frame ID base
+  uint16_t syncFrameCounter;  // sync frames written, low 16 bits (restore recounts)
+  uint16_t logEpoch;          // erases so far (0 in records from before it)
+  uint32_t recordStartPage;   // first IMU page of the current session
+  uint16_t syncCurrentPage;   // sync pages written
+  uint16_t sessionID;         // incremented per recording session
+  uint16_t logMode;           // CKPT_LOG_LINEAR / CKPT_LOG_RING
+  uint16_t crc16;             // CRC over all preceding bytes
+};
+static_assert(sizeof(LogCheckpoint) == 32, "LogCheckpoint must be exactly 32 bytes");
+static_assert(FLASH_PAGE_SIZE % sizeof(LogCheckpoint) == 0,
+              "LogCheckpoint must tile a flash page");
+
 // // =============================================================================
 // // SYNC REGION RESERVATION (NEW)
 // // =============================================================================
@@ -160,6 +230,79 @@ extern bool imuSimulated;
 // Read one frame from real IMU or simulator.
 bool imuReadFrame(Frame20 &out);
 
+// -----------------------------------------------------------------------------
+// Acquisition rate
+// -----------------------------------------------------------------------------
+//
+// RECORD_RATE_POLLED_HZ without IMU_IRQ_ACQUISITION: the .ino polls
+// millis() and calls imuReadFrame() (one DMP packet + a full AGMT read).
+//
+// Otherwise the rate is DMP-clocked: the DMP runs at IMU_DMP_BASE_HZ with
+// Quat9, raw accel and uncalibrated compass records in the FIFO, and
+// imuDrainFrames() turns every queued Quat9 packet into a frame using the
+// latest accel/compass records (no AGMT read). Rates round up to
+// IMU_DMP_BASE_HZ / n: 225, 112, 75, 56 Hz (10 Hz -> 225 / 22).
+//
+#define RECORD_RATE_POLLED_HZ 10
+#define RECORD_RATE_MIN_HZ 50
+#define RECORD_RATE_MAX_HZ 225
+#define IMU_DMP_BASE_HZ 225
+#define IMU_DRAIN_MAX_FRAMES 32  // frames per imuDrainFrames() call
+
+extern uint16_t recordRateHz;
+
+// Select the acquisition rate (MODE_IDLE). Returns the rate configured, or 0
+// if 'hz' is neither RECORD_RATE_POLLED_HZ nor within the high-rate range.
+uint16_t imuSetRecordRate(uint16_t hz);
+
+// Nominal spacing of samples at the current rate.
+uint32_t imuSamplePeriodUs();
+
+// Recording uses imuDrainFrames() rather than the polled imuReadFrame().
+bool imuDmpClocked();
+
+// Arm the INT pin wake-up (IMU_IRQ_ACQUISITION builds, real IMU only).
+void imuAttachInterrupt(uint8_t pin);
+bool imuInterruptArmed();
+uint32_t imuInterruptCount();
+
+// Sleep the calling task until the next INT edge or 'timeoutMs'.
+// Returns true if woken by the IMU; 'edgeUs' is then the edge time, else now.
+bool imuWaitForData(uint32_t timeoutMs, uint32_t &edgeUs);
+
+// DMP-clocked path: drain queued DMP packets (or due simulator samples) into
+// 'out'. Returns the number of frames produced, oldest first.
+uint16_t imuDrainFrames(Frame20 *out, uint16_t maxFrames);
+
+struct AcquisitionStats {
+  uint32_t frames;    // frames logged this session
+  uint32_t batches;   // service calls that logged frames
+  uint32_t maxBatch;  // most frames from one drain
+  uint32_t busyUs;    // time spent draining + logging those frames
+  uint32_t startMs;   // session start (millis)
+  uint32_t lastMs;    // last batch (millis); achieved rate uses start..last
+
+  uint32_t missed;         // samples missed (sum of gap markers)
+  uint32_t gaps;           // frames carrying a gap marker
+
+  uint32_t loopPasses;     // recording loop passes (CPU spin indicator)
+  uint32_t intervals;      // sample intervals measured
+  uint32_t intervalMinUs;
+  uint32_t intervalMaxUs;
+  float intervalMeanUs;    // running mean
+  float intervalM2;        // running sum of squared deviations (Welford)
+};
+
+// Sustainable rate = frames * 1e6 / busyUs (the loop could do nothing else).
+void noteAcquisitionBatch(uint16_t frames, uint32_t busyUs);
+
+// Sample clock: 'anchorUs' is when the newest of 'frames' samples was taken
+// (INT edge, or read time when polled). Feeds the interval/jitter stats.
+void noteSampleAnchor(uint32_t anchorUs, uint16_t frames);
+void noteRecordLoopPass();
+void getAcquisitionStats(AcquisitionStats &out);
+void resetAcquisitionStats();
+
 // =============================================================================
 // FLASH LAYOUT (PUBLIC / COMPATIBILITY)
 // =============================================================================
@@ -191,7 +334,8 @@ extern const uint8_t PIN_FLASH_CS;
 // -----------------------------------------------------------------------------
 enum PlaybackFormat {
   PLAYBACK_ASCII,
-  PLAYBACK_BINARY
+  PLAYBACK_BINARY,
+  PLAYBACK_PAGES    // bdump: whole page records, USB only
 };
 extern PlaybackFormat playbackFormat;
 
@@ -213,9 +357,9 @@ extern uint32_t recordStartPage;
 
 extern uint32_t frameCounter;
 
-extern Frame20 pageFrames[FRAMES_PER_PAGE];
+// Frames are accumulated directly in a LoggerWriter pool buffer.
 extern uint16_t frameIndexInPage;
-extern uint32_t currentPage;  // IMU pages written (0..flashImuPages)
+extern uint32_t currentPage;  // IMU log head: pages written since the last erase
 
 // -----------------------------------------------------------------------------
 // Recording state (SYNC) — NEW
@@ -228,20 +372,15 @@ extern uint32_t  syncFrameCounter;  // monotonic sync frame ID (starts at 0 then
 extern uint32_t  lastSyncMs;        // last time a sync frame was sampled (millis)
 
 // -----------------------------------------------------------------------------
-// Playback state
+// Playback state (the decoded page shared by the per-sink cursors)
 // -----------------------------------------------------------------------------
-extern uint32_t playbackPage;
-extern uint16_t playbackFrameIndex;
-extern bool playbackPageLoaded;
-
-extern uint32_t playbackPagesSeen;
-extern uint32_t playbackCrcWarnings;
-
 extern uint8_t playbackPageBuf[FLASH_PAGE_SIZE];
-extern Frame20 *playbackFrames;
+extern Frame20 playbackFrames[MAX_FRAMES_PER_PAGE];
+extern uint16_t playbackFrameCount;  // frames decoded from the loaded page
 extern PageFooter playbackFooter;
 
 extern uint32_t playbackPageLimit;
+extern ImuRange playbackRange;  // frames emitted by playback (set by CLI)
 
 // -----------------------------------------------------------------------------
 // Boot-time flash scan diagnostics
@@ -249,6 +388,12 @@ extern uint32_t playbackPageLimit;
 extern uint32_t bootPagesFound;
 extern uint32_t bootValidPages;
 extern uint32_t bootCorruptPages;
+extern uint32_t bootVerifyStartPage;  // first page CRC-checked at boot
+extern bool bootFromCheckpoint;       // state restored from checkpoint journal
+
+extern uint16_t sessionID;            // current / last recording session
+extern uint16_t logEpoch;             // bumped by erase / erase_all; names the
+                                      // log in since_page pulls (X-LMT-Session)
 
 // -----------------------------------------------------------------------------
 // Command buffer (owned by core; filled by .ino and BLE RX)
@@ -267,7 +412,7 @@ void emitEvent(const char *msg);
 // UTILITIES
 // =============================================================================
 int16_t floatToQ15(float x);
-uint16_t crc16_ccitt(const uint8_t *data, size_t len);
+// crc16_ccitt() / crc16_ccitt_update(): see LoggerCRC.h
 
 void getMCUSerialString(char *out, size_t outLen);
 
@@ -275,11 +420,7 @@ void printFirmwareVersion(Stream &out);
 void printMCUDeviceID(Stream &out);
 void printIMUDeviceID(Stream &out);
 
-// =============================================================================
-// RESERVED TAIL STORAGE API
-// =============================================================================
-bool readStorageElement(uint16_t index, uint8_t *out256);
-bool writeStorageElement(uint16_t index, const uint8_t *in256);
+// readStorageElement() / writeStorageElement(): see LoggerStorage.h
 
 // =============================================================================
 // LIVE FRAME API
@@ -297,8 +438,121 @@ void serviceLiveFrameRequests();
 void scanFlashOnBoot();
 void reconstructFrameCounterFromFlash();
 
+// Full CRC sweep of IMU pages [imuTailPage(), currentPage); blocking, emits
+// a summary.
+void verifyImuLog();
+
+// Read / program / erase throughput probe; programs one erased sector past
+// the IMU write head and erases it again. Blocking, MODE_IDLE only.
+void runFlashBenchmark();
+
+// Measure tPP / tSE / tBE on scratch space past the write head and install
+// the result as the driver's timing profile. Blocking, MODE_IDLE only.
+void runFlashCharacterization();
+
+// =============================================================================
+// IMU LOG MODE (linear / ring)
+// =============================================================================
+//
+// IMU page numbers (currentPage, recordStartPage, playback and export page
+// indices) are logical: they count pages since the last erase and never go
+// back.
+//
+// Linear (default): logical page == flash page; recording stops with
+// "Flash full" at flashImuPages.
+//
+// Ring: logical page L lives at flash page L % imuRingPages() (the IMU
+// region rounded down to whole sectors). When the head enters a sector that
+// holds an older lap, the sector is erased with the first page programmed
+// into it. The newest pages, [imuTailPage(), currentPage), stay readable:
+// the whole ring less at most one sector.
+//
+//   - Page footers need no extra field: firstFrameID rises page by page, so
+//     the boot scan tells the newest lap from the previous one and finds
+//     head and tail (see scanFlashOnBoot())
+//   - The mode is kept in the checkpoint journal; a wrapped log found
+//     without one switches ring mode back on
+//   - Both layouts agree until the head passes imuRingPages(): the mode can
+//     only change before that (erase first otherwise)
+//   - Readers check after each flash read that the pages are still at or
+//     above the tail: a reader lapped by the recorder gets a read error,
+//     never a newer page under an old number
+//
+#define IMU_RING_MIN_SECTORS 2
+
+bool imuRingEnabled();
+
+// Turn ring mode on or off and record it in the checkpoint journal. False
+// if the log has passed imuRingPages() (or the region is too small for a
+// ring); nothing changes then.
+bool setImuRingMode(bool on);
+
+uint32_t imuRingPages();
+
+// Oldest logical page still on flash (0 unless a ring has wrapped).
+uint32_t imuTailPage();
+
+// Flash page holding logical IMU page 'page'.
+uint32_t imuFlashPage(uint32_t page);
+
+// Read logical IMU pages [page, page + count) into 'buf' (count pages).
+// False on a flash read error, or if any of them was overwritten (ring).
+bool readImuPages(uint32_t page, uint8_t *buf, uint32_t count);
+
+// =============================================================================
+// WRITE-HEAD CHECKPOINT
+// =============================================================================
+//
+// restoreFromCheckpoint():
+//   - locates the newest journal record (a few small reads)
+//   - confirms it against the IMU/sync footers around the recorded heads
+//   - rolls forward over pages written after the record
+//   - returns false if no record exists or it cannot be confirmed; the
+//     caller then falls back to the boot scans
+//
+// writeCheckpoint():
+//   - appends the current counters to the journal
+//   - called every CHECKPOINT_INTERVAL_PAGES, on session start/stop and erase
+//
+// resetCheckpointJournal():
+//   - restarts the journal at record 0 (after a chip erase wiped it)
+//
+bool restoreFromCheckpoint();
+void writeCheckpoint();
+void resetCheckpointJournal();
+
+// =============================================================================
+// IMU PAGE INDEX API (see IMU PAGE INDEX above)
+// =============================================================================
+
+void imuIndexRebuild();
+uint32_t imuIndexStride();
+uint32_t imuIndexEntries();
+
+void imuRangeBegin(ImuRange &r, ImuRangeKind kind, uint32_t from, uint32_t to);
+
+// First page below 'endPage' (normally currentPage; an export watermark
+// while recording) that may hold frames of the range (imuTailPage() for
+// IMU_RANGE_ALL).
+uint32_t imuRangeFirstPage(const ImuRange &r, uint32_t endPage);
+
+// Called for each page in order while walking a range. True once the page
+// (and so every later one) lies past the end of the range. 'r' carries the
+// walk state: each reader walks its own copy, once per page.
+bool imuRangePastEnd(ImuRange &r, const PageFooter &footer);
+
+// Frame-level filter for pages that straddle the range boundaries.
+bool imuRangeHasFrame(const ImuRange &r, uint32_t frameID, uint32_t ms);
+
+// flushPageToFlash() finalizes the fill buffer and hands it to the
+// background writer; currentPage advances at submit time.
+// logFrame() encodes one frame sampled at 'sampleMs' into the fill page,
+// flushing first if it no longer fits; it owns pageStartMs/pageFirstID.
+// Samples missing since the previous logged frame (judged against
+// imuSamplePeriodUs()) are recorded as a gap marker on this frame.
+// Returns false (frame dropped) if no pool buffer is free.
 void flushPageToFlash();
-bool logFrame(const Frame20 &f);
+bool logFrame(const Frame20 &f, uint32_t sampleMs);
 
 // =============================================================================
 // SYNC LOGGING (NEW)
@@ -332,10 +586,39 @@ void dumpSyncPagesAscii();
 // =============================================================================
 // PLAYBACK
 // =============================================================================
+// Reset playback state and enter MODE_PLAYBACK at the first page of 'range'.
+// 'pageLimit' (0 = none) stops after that many pages.
+// Every output sink open at the start gets its own cursor and pacing, and
+// its own "# Dump complete"; MODE_PLAYBACK ends with the last cursor.
+void startPlayback(PlaybackFormat format, const ImuRange &range, uint32_t pageLimit);
 void playbackTask();
 
-void emitAsciiPageFooter(uint32_t page, const PageFooter &f, bool crcOk);
-void emitBinaryPageFooter(const PageFooter &f);
+// Page dump (bdump): whole pages over USB CDC at line rate, framed as
+//   "#BDUMP <imu|sync> <first> <count> 272\r\n"
+//   count x [16-byte LMTP / LMTS header][256-byte page]   (as HTTP /imu)
+//   BdumpEnd (16 bytes)
+//   "\r\n# bdump complete pages=<n> bad=<m>\r\n"
+// crc32 covers every record byte (CRC-32 as in gzip). A read error ends
+// the dump early: END.pages < count. tools/lmt_capture reads this.
+#define BDUMP_END_MAGIC 0x4C4D5445UL  // ASCII "LMTE"
+
+struct BdumpEnd {
+  uint32_t magic;    // BDUMP_END_MAGIC
+  uint32_t pages;    // records sent
+  uint32_t crcBad;   // records without the CRC-valid flag
+  uint32_t crc32;    // over all record bytes
+};
+
+static_assert(sizeof(BdumpEnd) == 16, "BdumpEnd must be 16 bytes");
+
+// Region pages [firstPage, firstPage + pages) (pages 0 = to the end), in
+// MODE_PLAYBACK; an IMU firstPage below imuTailPage() starts at the tail.
+// False (nothing sent) without a USB host.
+bool startPageDump(bool sync, uint32_t firstPage, uint32_t pages);
+
+// Page footer record for one output sink (LoggerOutput index).
+void emitAsciiPageFooter(uint8_t sink, uint32_t page, const PageFooter &f, bool crcOk);
+void emitBinaryPageFooter(uint8_t sink, const PageFooter &f);
 
 // =============================================================================
 // RECORDING CONTROL
@@ -348,8 +631,9 @@ void startNewRecordingSession();
 
 // BLE transport (LoggerBLE.*)
 bool bleConnected();
-void bleWrite(const uint8_t *buf, size_t len);
+bool bleWrite(const uint8_t *buf, size_t len);
 void blePrintln(const char *s);
+bool bleTxHasRoom(size_t len);
 void startBLEUart();
 void stopBLEUart();
 
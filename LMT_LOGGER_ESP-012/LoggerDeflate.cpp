@@ -0,0 +1,221 @@
+#include "LoggerDeflate.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "LoggerCRC.h"
+
+// =============================================================================
+// DEFLATE CONSTANTS (RFC 1951 3.2.5)
+// =============================================================================
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+
+static const uint16_t kLengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t kLengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t kDistBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+  8193, 12289, 16385, 24577
+};
+static const uint8_t kDistExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static_assert(DEFLATE_WINDOW_BYTES <= 32768, "deflate distances stop at 32K");
+static_assert(DEFLATE_WINDOW_BYTES + DEFLATE_MAX_INPUT < 65536,
+              "hash positions are 16-bit");
+
+// =============================================================================
+// BIT WRITER
+// =============================================================================
+
+struct BitOut {
+  GzipStream &z;
+  uint8_t *out;
+  size_t n;
+};
+
+static void putBits(BitOut &o, uint32_t value, uint8_t bits) {
+  o.z.bitBuf |= value << o.z.bitCount;
+  o.z.bitCount += bits;
+  while (o.z.bitCount >= 8) {
+    o.out[o.n++] = (uint8_t)o.z.bitBuf;
+    o.z.bitBuf >>= 8;
+    o.z.bitCount -= 8;
+  }
+}
+
+// Huffman codes are defined MSB first; the stream is LSB first.
+static void putCode(BitOut &o, uint16_t code, uint8_t bits) {
+  uint16_t rev = 0;
+  for (uint8_t i = 0; i < bits; i++) {
+    rev = (uint16_t)((rev << 1) | ((code >> i) & 1));
+  }
+  putBits(o, rev, bits);
+}
+
+// Fixed literal/length code (RFC 1951 3.2.6).
+static void putSymbol(BitOut &o, uint16_t sym) {
+  if (sym < 144) {
+    putCode(o, (uint16_t)(0x30 + sym), 8);
+  } else if (sym < 256) {
+    putCode(o, (uint16_t)(0x190 + sym - 144), 9);
+  } else if (sym < 280) {
+    putCode(o, (uint16_t)(sym - 256), 7);
+  } else {
+    putCode(o, (uint16_t)(0xC0 + sym - 280), 8);
+  }
+}
+
+static void putMatch(BitOut &o, uint16_t len, uint16_t dist) {
+  uint8_t lc = 28;
+  while (kLengthBase[lc] > len) lc--;
+  putSymbol(o, (uint16_t)(257 + lc));
+  if (kLengthExtra[lc]) putBits(o, len - kLengthBase[lc], kLengthExtra[lc]);
+
+  uint8_t dc = 29;
+  while (kDistBase[dc] > dist) dc--;
+  putCode(o, dc, 5);
+  if (kDistExtra[dc]) putBits(o, dist - kDistBase[dc], kDistExtra[dc]);
+}
+
+// =============================================================================
+// MATCH FINDER
+// =============================================================================
+
+static uint16_t hash3(const uint8_t *p) {
+  const uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+  return (uint16_t)((uint32_t)(v * 2654435761u) >> (32 - DEFLATE_HASH_BITS));
+}
+
+// Keep the last DEFLATE_WINDOW_BYTES of buf[0, end) as history.
+static void slideWindow(GzipStream &z, uint16_t end) {
+  if (end <= DEFLATE_WINDOW_BYTES) {
+    z.histLen = end;
+    return;
+  }
+
+  const uint16_t shift = (uint16_t)(end - DEFLATE_WINDOW_BYTES);
+  memmove(z.buf, z.buf + shift, DEFLATE_WINDOW_BYTES);
+  for (uint16_t &h : z.head) {
+    h = (h > shift) ? (uint16_t)(h - shift) : 0;
+  }
+  z.histLen = DEFLATE_WINDOW_BYTES;
+}
+
+// =============================================================================
+// PUBLIC API
+// =============================================================================
+
+void gzipBegin(GzipStream &z) {
+  memset(z.head, 0, sizeof(z.head));
+  z.histLen = 0;
+  z.bitBuf = 0;
+  z.bitCount = 0;
+  z.headerSent = false;
+  z.crc = 0;
+  z.inBytes = 0;
+}
+
+size_t gzipWrite(GzipStream &z, const uint8_t *in, size_t len, uint8_t *out) {
+  BitOut o = { z, out, 0 };
+
+  if (!z.headerSent) {
+    // ID1 ID2 CM=deflate FLG=0 MTIME=0 XFL=0 OS=unknown
+    static const uint8_t kHeader[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+    memcpy(out, kHeader, sizeof(kHeader));
+    o.n = sizeof(kHeader);
+    z.headerSent = true;
+  }
+
+  if (len == 0) {
+    return o.n;
+  }
+  // Callers batch to fit (see the static_assert in LoggerHTTP.cpp); more
+  // would drop bytes from the stream. The clamp only keeps NDEBUG builds
+  // inside z.buf.
+  assert(len <= DEFLATE_MAX_INPUT);
+  if (len > DEFLATE_MAX_INPUT) {
+    len = DEFLATE_MAX_INPUT;
+  }
+
+  z.crc = crc32_ieee_update(z.crc, in, len);
+  z.inBytes += (uint32_t)len;
+
+  const uint16_t start = z.histLen;
+  const uint16_t end = (uint16_t)(start + len);
+  memcpy(z.buf + start, in, len);
+
+  putBits(o, 0, 1);  // BFINAL = 0
+  putBits(o, 1, 2);  // BTYPE = 01 (fixed Huffman)
+
+  uint16_t i = start;
+  while (i < end) {
+    uint16_t bestLen = 0;
+    uint16_t bestDist = 0;
+
+    if (i + MIN_MATCH <= end) {
+      const uint16_t h = hash3(z.buf + i);
+      const uint16_t cand = z.head[h];
+      z.head[h] = (uint16_t)(i + 1);
+
+      if (cand > 0) {
+        const uint16_t c = (uint16_t)(cand - 1);
+        const uint16_t dist = (uint16_t)(i - c);
+        if (dist <= DEFLATE_WINDOW_BYTES) {
+          const uint16_t limit = (end - i < MAX_MATCH) ? (uint16_t)(end - i) : MAX_MATCH;
+          uint16_t n = 0;
+          while (n < limit && z.buf[c + n] == z.buf[i + n]) n++;
+          if (n >= MIN_MATCH) {
+            bestLen = n;
+            bestDist = dist;
+          }
+        }
+      }
+    }
+
+    if (bestLen == 0) {
+      putSymbol(o, z.buf[i]);
+      i++;
+      continue;
+    }
+
+    putMatch(o, bestLen, bestDist);
+
+    // Index the positions the match covers so later data can refer to them.
+    const uint16_t stop = (uint16_t)(i + bestLen);
+    for (i++; i < stop; i++) {
+      if (i + MIN_MATCH <= end) {
+        z.head[hash3(z.buf + i)] = (uint16_t)(i + 1);
+      }
+    }
+  }
+
+  putSymbol(o, 256);  // end of block
+  slideWindow(z, end);
+  return o.n;
+}
+
+size_t gzipFinish(GzipStream &z, uint8_t *out) {
+  BitOut o = { z, out, 0 };
+
+  putBits(o, 1, 1);  // BFINAL = 1
+  putBits(o, 1, 2);  // fixed Huffman, empty
+  putSymbol(o, 256);
+  if (z.bitCount > 0) {
+    putBits(o, 0, (uint8_t)(8 - z.bitCount));
+  }
+
+  for (uint8_t k = 0; k < 4; k++) out[o.n++] = (uint8_t)(z.crc >> (8 * k));
+  for (uint8_t k = 0; k < 4; k++) out[o.n++] = (uint8_t)(z.inBytes >> (8 * k));
+  return o.n;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// LoggerDeflate — streaming gzip encoder for the HTTP log export
+// =============================================================================
+//
+// Produces a standard gzip member (RFC 1952 around RFC 1951 deflate) that
+// curl --compressed, zlib and browsers decode, sized for the ESP32-C3:
+//
+//   - LZ77 with a DEFLATE_WINDOW_BYTES sliding window and a single-probe
+//     hash table (no chains): one candidate per position
+//   - every gzipWrite() emits one fixed-Huffman block, so no code tables are
+//     built or sent; the bit stream simply continues across calls
+//   - ~17 KB of state, all inside GzipStream (allocate it only while a
+//     compressed response is in flight)
+//
+// What compresses in a log export: 0xFF page padding (distance-1 runs),
+// the page headers / footers repeating every 272 bytes, and slowly changing
+// fields in raw pages. Delta-encoded frame bytes themselves mostly pass as
+// literals.
+//
+// This file has no Arduino dependency so host tools can build it as-is.
+//
+
+#define DEFLATE_WINDOW_BYTES 4096   // match distance limit (deflate allows 32K)
+#define DEFLATE_MAX_INPUT    4608   // most bytes per gzipWrite() call
+#define DEFLATE_HASH_BITS    12
+
+struct GzipStream {
+  uint8_t buf[DEFLATE_WINDOW_BYTES + DEFLATE_MAX_INPUT];  // history + input
+  uint16_t head[1 << DEFLATE_HASH_BITS];  // hash -> last position + 1 (0 = none)
+  uint16_t histLen;    // history bytes at the front of buf
+  uint32_t bitBuf;     // pending output bits, LSB first
+  uint8_t bitCount;
+  bool headerSent;
+  uint32_t crc;        // CRC-32 of the input so far
+  uint32_t inBytes;    // input size mod 2^32
+};
+
+// Worst-case output of one gzipWrite() of 'len' bytes (all 9-bit literals,
+// block header, pending bits and the gzip header on the first call).
+static constexpr size_t gzipWriteBound(size_t len) {
+  return 10 + (len * 9 + 7) / 8 + 8;
+}
+
+// Most bytes gzipFinish() writes (final block, padding, trailer).
+static constexpr size_t GZIP_FINISH_BYTES = 16;
+
+void gzipBegin(GzipStream &z);
+
+// Compress 'len' bytes; returns the bytes written to 'out' (room for
+// gzipWriteBound(len)). 'len' must be <= DEFLATE_MAX_INPUT (asserted).
+size_t gzipWrite(GzipStream &z, const uint8_t *in, size_t len, uint8_t *out);
+
+// Close the stream: final empty block, byte alignment, CRC-32 and size.
+size_t gzipFinish(GzipStream &z, uint8_t *out);
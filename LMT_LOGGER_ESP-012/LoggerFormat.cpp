@@ -0,0 +1,528 @@
+#include "LoggerFormat.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LoggerCRC.h"
+#include "LoggerSync.h"
+
+// =============================================================================
+// FRAME LAYOUTS
+// =============================================================================
+
+// Smallest-three: +-1/sqrt(2) in Q15 maps onto a signed 15-bit value.
+#define S3_Q15_RANGE 23170
+#define S3_VAL_RANGE 16383
+
+// Reduced mag: 10-bit signed value of (m + 2) >> 2
+#define MAGR_SHIFT 2
+#define MAGR_MIN   (-512)
+#define MAGR_MAX   511
+
+// Time field: dt in the low 12 bits, gap marker in the high 4.
+#define TIME_GAP_SHIFT 12
+
+static uint8_t layoutFieldCount(uint8_t layout) {
+  uint8_t n = (layout & FRAME_LAYOUT_QUAT_S3) ? FRAME20_FIELDS - 1 : FRAME20_FIELDS;
+  if (layout & FRAME_LAYOUT_TIMED) n++;
+  return n;
+}
+
+// Index of the first magnetometer field (the time field, if any, follows).
+static uint8_t layoutMagField(uint8_t layout) {
+  return layoutFieldCount(layout) - 3 - ((layout & FRAME_LAYOUT_TIMED) ? 1 : 0);
+}
+
+// Raw page record size: the field vector, with reduced mag packed into 4 bytes.
+static uint8_t layoutRecordBytes(uint8_t layout) {
+  uint8_t bytes = layoutFieldCount(layout) * sizeof(uint16_t);
+  if (layout & FRAME_LAYOUT_MAG_REDUCED) bytes -= 2;
+  return bytes;
+}
+
+static int16_t clamp16(int32_t v, int32_t lo, int32_t hi) {
+  return (int16_t)(v < lo ? lo : (v > hi ? hi : v));
+}
+
+static void packQuatS3(const int16_t q[4], uint16_t *v) {
+  uint8_t big = 0;
+  for (uint8_t i = 1; i < 4; i++) {
+    if (abs(q[i]) > abs(q[big])) big = i;
+  }
+
+  const uint16_t tag[3] = {
+    (uint16_t)(big & 1),
+    (uint16_t)((big >> 1) & 1),
+    (uint16_t)(q[big] < 0 ? 1 : 0)
+  };
+
+  for (uint8_t i = 0, k = 0; i < 4; i++) {
+    if (i == big) continue;
+    const int32_t scaled =
+      (int32_t)lroundf((float)q[i] * S3_VAL_RANGE / S3_Q15_RANGE);
+    const int16_t s = clamp16(scaled, -S3_VAL_RANGE - 1, S3_VAL_RANGE);
+    v[k] = (uint16_t)((uint16_t)s << 1) | tag[k];
+    k++;
+  }
+}
+
+static void unpackQuatS3(const uint16_t *v, int16_t q[4]) {
+  const uint8_t big = (uint8_t)((v[0] & 1) | ((v[1] & 1) << 1));
+  const bool negative = (v[2] & 1) != 0;
+
+  float sum = 0.0f;
+  for (uint8_t i = 0, k = 0; i < 4; i++) {
+    if (i == big) continue;
+    const int16_t s = (int16_t)v[k++] >> 1;
+    q[i] = clamp16(lroundf((float)s * S3_Q15_RANGE / S3_VAL_RANGE), -32768, 32767);
+    sum += (float)q[i] * (float)q[i];
+  }
+
+  float rest = 32767.0f * 32767.0f - sum;
+  if (rest < 0.0f) rest = 0.0f;
+  const int16_t mag = clamp16(lroundf(sqrtf(rest)), 0, 32767);
+  q[big] = negative ? (int16_t)-mag : mag;
+}
+
+// Frame -> field vector (quantized per layout).
+static void frameToFields(const Frame20 &f, uint8_t layout, uint16_t *v) {
+  const int16_t q[4] = { f.q0, f.q1, f.q2, f.q3 };
+  uint8_t n = 0;
+
+  if (layout & FRAME_LAYOUT_QUAT_S3) {
+    packQuatS3(q, v);
+    n = 3;
+  } else {
+    for (uint8_t i = 0; i < 4; i++) v[n++] = (uint16_t)q[i];
+  }
+
+  v[n++] = (uint16_t)f.ax;
+  v[n++] = (uint16_t)f.ay;
+  v[n++] = (uint16_t)f.az;
+
+  const int16_t m[3] = { f.mx, f.my, f.mz };
+  for (uint8_t i = 0; i < 3; i++) {
+    v[n++] = (layout & FRAME_LAYOUT_MAG_REDUCED)
+               ? (uint16_t)clamp16(((int32_t)m[i] + 2) >> MAGR_SHIFT, MAGR_MIN, MAGR_MAX)
+               : (uint16_t)m[i];
+  }
+}
+
+static void fieldsToFrame(const uint16_t *v, uint8_t layout, Frame20 &f) {
+  int16_t q[4];
+  uint8_t n = 0;
+
+  if (layout & FRAME_LAYOUT_QUAT_S3) {
+    unpackQuatS3(v, q);
+    n = 3;
+  } else {
+    for (uint8_t i = 0; i < 4; i++) q[i] = (int16_t)v[n++];
+  }
+
+  f.q0 = q[0];
+  f.q1 = q[1];
+  f.q2 = q[2];
+  f.q3 = q[3];
+
+  f.ax = (int16_t)v[n++];
+  f.ay = (int16_t)v[n++];
+  f.az = (int16_t)v[n++];
+
+  int16_t m[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    m[i] = (layout & FRAME_LAYOUT_MAG_REDUCED)
+             ? (int16_t)((int16_t)v[n++] * (1 << MAGR_SHIFT))
+             : (int16_t)v[n++];
+  }
+
+  f.mx = m[0];
+  f.my = m[1];
+  f.mz = m[2];
+}
+
+static void fieldsToRecord(const uint16_t *v, uint8_t layout, uint8_t *rec) {
+  const uint8_t n = layoutFieldCount(layout);
+
+  if (!(layout & FRAME_LAYOUT_MAG_REDUCED)) {
+    memcpy(rec, v, n * sizeof(uint16_t));
+    return;
+  }
+
+  const uint8_t m = layoutMagField(layout);
+  memcpy(rec, v, m * sizeof(uint16_t));
+  const uint32_t packed =
+    (uint32_t)(v[m] & 0x3FF) |
+    ((uint32_t)(v[m + 1] & 0x3FF) << 10) |
+    ((uint32_t)(v[m + 2] & 0x3FF) << 20);
+  memcpy(rec + m * sizeof(uint16_t), &packed, sizeof(packed));
+  memcpy(rec + m * sizeof(uint16_t) + sizeof(packed), v + m + 3,
+         (n - m - 3) * sizeof(uint16_t));
+}
+
+static void recordToFields(const uint8_t *rec, uint8_t layout, uint16_t *v) {
+  const uint8_t n = layoutFieldCount(layout);
+
+  if (!(layout & FRAME_LAYOUT_MAG_REDUCED)) {
+    memcpy(v, rec, n * sizeof(uint16_t));
+    return;
+  }
+
+  const uint8_t m = layoutMagField(layout);
+  memcpy(v, rec, m * sizeof(uint16_t));
+  uint32_t packed;
+  memcpy(&packed, rec + m * sizeof(uint16_t), sizeof(packed));
+  for (uint8_t i = 0; i < 3; i++) {
+    // sign-extend 10 bits
+    v[m + i] = (uint16_t)((int16_t)(((packed >> (10 * i)) & 0x3FF) << 6) >> 6);
+  }
+  memcpy(v + m + 3, rec + m * sizeof(uint16_t) + sizeof(packed),
+         (n - m - 3) * sizeof(uint16_t));
+}
+
+// Advances 'ms' by the frame's dt and records its timing. Untimed layouts
+// step UNTIMED_FRAME_PERIOD_MS per frame (the first frame is at 'ms').
+static void fieldsToTime(const uint16_t *v, uint8_t layout, uint16_t index,
+                         uint32_t &ms, ImuFrameTime &t) {
+  if (layout & FRAME_LAYOUT_TIMED) {
+    const uint16_t tf = v[layoutFieldCount(layout) - 1];
+    ms += tf & TIME_DT_MAX_MS;
+    t.missed = (uint8_t)(tf >> TIME_GAP_SHIFT);
+  } else {
+    if (index > 0) ms += UNTIMED_FRAME_PERIOD_MS;
+    t.missed = 0;
+  }
+  t.ms = ms;
+}
+
+// =============================================================================
+// VARINT HELPERS
+// =============================================================================
+
+static uint16_t zigzag16(uint16_t delta) {
+  const int16_t d = (int16_t)delta;
+  return (uint16_t)(((uint16_t)d << 1) ^ (uint16_t)(d >> 15));
+}
+
+static uint16_t unzigzag16(uint16_t zz) {
+  return (uint16_t)((zz >> 1) ^ (uint16_t)-(int16_t)(zz & 1));
+}
+
+// Writes 1..3 bytes; returns the count.
+static uint8_t putVarint16(uint8_t *p, uint16_t v) {
+  uint8_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// Reads one varint from [p + pos, p + end). Returns false on truncation or
+// an encoding longer than 3 bytes.
+static bool getVarint16(const uint8_t *p, uint16_t end, uint16_t &pos, uint16_t &v) {
+  uint32_t acc = 0;
+  for (uint8_t shift = 0; shift < 21; shift += 7) {
+    if (pos >= end) return false;
+    const uint8_t b = p[pos++];
+    acc |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      if (acc > 0xFFFF) return false;
+      v = (uint16_t)acc;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Decodes 'count' delta-page frames. Each frame goes to 'out' (if non-null)
+// as a Frame20, to 'fields' (if non-null) as its field vector and to 'times'
+// (if non-null) timed from 'startMs'. 'used' receives the encoded length.
+// Returns false if the stream is cut short.
+static bool decodeDeltaFrames(const uint8_t *page, uint8_t layout, uint16_t count,
+                              Frame20 *out, uint16_t (*fields)[IMU_MAX_FIELDS],
+                              ImuFrameTime *times, uint32_t startMs,
+                              uint16_t &used, uint16_t *decoded) {
+  used = 0;
+  if (count == 0) return true;
+
+  const uint8_t n = layoutFieldCount(layout);
+  uint32_t ms = startMs;
+
+  uint16_t prev[IMU_MAX_FIELDS];
+  memcpy(prev, page, n * sizeof(uint16_t));
+  used = n * sizeof(uint16_t);
+
+  for (uint16_t i = 0; i < count; i++) {
+    if (i > 0) {
+      for (uint8_t k = 0; k < n; k++) {
+        uint16_t zz;
+        if (!getVarint16(page, IMU_PAGE_DATA_BYTES, used, zz)) {
+          return false;
+        }
+        prev[k] = (uint16_t)(prev[k] + unzigzag16(zz));
+      }
+    }
+    if (out) fieldsToFrame(prev, layout, out[i]);
+    if (fields) memcpy(fields[i], prev, n * sizeof(uint16_t));
+    if (times) fieldsToTime(prev, layout, i, ms, times[i]);
+    if (decoded) *decoded = i + 1;
+  }
+
+  return true;
+}
+
+// =============================================================================
+// FOOTER CHECKS
+// =============================================================================
+
+bool imuPageMagicKnown(uint32_t magic) {
+  return magic == PAGE_MAGIC || magic == PAGE_MAGIC_DELTA;
+}
+
+uint16_t imuPageCapacity(uint32_t magic, uint8_t layout) {
+  if (layout & ~FRAME_LAYOUT_KNOWN) {
+    return 0;
+  }
+
+  const uint8_t n = layoutFieldCount(layout);
+
+  switch (magic) {
+    case PAGE_MAGIC:
+      return IMU_PAGE_DATA_BYTES / layoutRecordBytes(layout);
+    case PAGE_MAGIC_DELTA:
+      return 1 + (IMU_PAGE_DATA_BYTES - n * sizeof(uint16_t)) / n;
+    default:
+      return 0;
+  }
+}
+
+bool imuFooterSane(const PageFooter &footer) {
+  const uint16_t cap = imuPageCapacity(footer.magic, footer.layout);
+  return cap > 0 && footer.validFrames <= cap;
+}
+
+// =============================================================================
+// DECODER
+// =============================================================================
+
+ImuPageState decodeImuPage(const uint8_t *page, Frame20 *out, uint16_t *decoded,
+                           ImuFrameTime *times) {
+  if (decoded) *decoded = 0;
+
+  PageFooter footer;
+  memcpy(&footer, page + IMU_PAGE_DATA_BYTES, sizeof(PageFooter));
+
+  if (!imuPageMagicKnown(footer.magic)) {
+    return IMU_PAGE_ABSENT;
+  }
+  if (!imuFooterSane(footer)) {
+    return IMU_PAGE_CORRUPT;
+  }
+
+  uint16_t usedBytes = 0;
+
+  if (footer.magic == PAGE_MAGIC) {
+    const uint8_t recBytes = layoutRecordBytes(footer.layout);
+    usedBytes = footer.validFrames * recBytes;
+
+    if (out || times) {
+      uint32_t ms = footer.pageStartMs;
+      for (uint16_t i = 0; i < footer.validFrames; i++) {
+        uint16_t v[IMU_MAX_FIELDS];
+        recordToFields(page + i * recBytes, footer.layout, v);
+        if (out) fieldsToFrame(v, footer.layout, out[i]);
+        if (times) fieldsToTime(v, footer.layout, i, ms, times[i]);
+      }
+    }
+    if (decoded) *decoded = footer.validFrames;
+
+  } else if (!decodeDeltaFrames(page, footer.layout, footer.validFrames,
+                                out, nullptr, times, footer.pageStartMs,
+                                usedBytes, decoded)) {
+    return IMU_PAGE_CORRUPT;
+  }
+
+  uint16_t crc = crc16_ccitt(page, usedBytes);
+  crc = crc16_ccitt_update(crc, (const uint8_t *)&footer, offsetof(PageFooter, crc16));
+
+  return (crc == footer.crc16) ? IMU_PAGE_VALID : IMU_PAGE_CORRUPT;
+}
+
+// =============================================================================
+// ENCODER
+// =============================================================================
+
+void imuEncoderBegin(ImuPageEncoder &e, uint8_t *buf, uint32_t magic, uint8_t layout) {
+  e.buf = buf;
+  e.magic = magic;
+  e.layout = layout;
+  e.used = 0;
+  e.frames = 0;
+  e.crc = CRC16_CCITT_INIT;
+  e.lastMs = 0;
+  memset(e.prev, 0, sizeof(e.prev));
+}
+
+// Re-encodes the frames of a delta page in place as a raw page.
+// Only called while e.frames < raw capacity, so the raw form fits.
+static void convertToRaw(ImuPageEncoder &e) {
+  uint16_t fields[MAX_FRAMES_PER_PAGE][IMU_MAX_FIELDS];
+  uint16_t used;
+  decodeDeltaFrames(e.buf, e.layout, e.frames, nullptr, fields, nullptr, 0,
+                    used, nullptr);
+
+  const uint8_t recBytes = layoutRecordBytes(e.layout);
+  for (uint16_t i = 0; i < e.frames; i++) {
+    fieldsToRecord(fields[i], e.layout, e.buf + i * recBytes);
+  }
+
+  e.magic = PAGE_MAGIC;
+  e.used = e.frames * recBytes;
+  e.crc = crc16_ccitt(e.buf, e.used);
+}
+
+bool imuEncoderAppend(ImuPageEncoder &e, const Frame20 &f,
+                      uint32_t sampleMs, uint8_t missed) {
+  const uint8_t n = layoutFieldCount(e.layout);
+
+  uint16_t cur[IMU_MAX_FIELDS];
+  frameToFields(f, e.layout, cur);
+
+  uint32_t frameMs = sampleMs;
+  if (e.layout & FRAME_LAYOUT_TIMED) {
+    uint32_t dt = 0;
+    if (e.frames > 0) {
+      // A clock step backwards (back-dated batch) is stored as dt 0.
+      const int32_t step = (int32_t)(sampleMs - e.lastMs);
+      dt = step > 0 ? (uint32_t)step : 0;
+      if (dt > TIME_DT_MAX_MS) {
+        return false;
+      }
+      frameMs = e.lastMs + dt;
+    }
+    if (missed > TIME_GAP_MAX) missed = TIME_GAP_MAX;
+    cur[n - 1] = (uint16_t)(((uint16_t)missed << TIME_GAP_SHIFT) | dt);
+  }
+
+  uint8_t tmp[IMU_MAX_FIELDS * DELTA_FIELD_MAX_BYTES];
+  uint16_t len = 0;
+
+  if (e.magic == PAGE_MAGIC_DELTA && e.frames > 0) {
+    for (uint8_t k = 0; k < n; k++) {
+      len += putVarint16(tmp + len, zigzag16((uint16_t)(cur[k] - e.prev[k])));
+    }
+  } else if (e.magic == PAGE_MAGIC_DELTA) {
+    // Key frame: field vector verbatim
+    memcpy(tmp, cur, n * sizeof(uint16_t));
+    len = n * sizeof(uint16_t);
+  } else {
+    fieldsToRecord(cur, e.layout, tmp);
+    len = layoutRecordBytes(e.layout);
+  }
+
+  if (e.used + len > IMU_PAGE_DATA_BYTES) {
+    // Never do worse than raw: a delta page that fills up below the raw
+    // capacity (noisy data) is re-laid out as a raw page.
+    if (e.magic != PAGE_MAGIC_DELTA ||
+        e.frames >= imuPageCapacity(PAGE_MAGIC, e.layout)) {
+      return false;
+    }
+    convertToRaw(e);
+    return imuEncoderAppend(e, f, sampleMs, missed);
+  }
+
+  memcpy(e.buf + e.used, tmp, len);
+  e.crc = crc16_ccitt_update(e.crc, tmp, len);
+  e.used += len;
+  e.frames++;
+  e.lastMs = frameMs;
+  memcpy(e.prev, cur, sizeof(e.prev));
+  return true;
+}
+
+bool imuEncoderFull(const ImuPageEncoder &e) {
+  if (e.magic == PAGE_MAGIC_DELTA) {
+    if (e.frames < imuPageCapacity(PAGE_MAGIC, e.layout)) {
+      return false;  // worst case the next append falls back to raw
+    }
+    return e.used + layoutFieldCount(e.layout) > IMU_PAGE_DATA_BYTES;
+  }
+
+  return e.used + layoutRecordBytes(e.layout) > IMU_PAGE_DATA_BYTES;
+}
+
+void imuEncoderFinish(ImuPageEncoder &e, uint32_t firstFrameID, uint32_t pageStartMs) {
+  memset(e.buf + e.used, 0xFF, IMU_PAGE_DATA_BYTES - e.used);
+
+  PageFooter footer;
+  footer.magic = e.magic;
+  footer.validFrames = (uint8_t)e.frames;
+  footer.layout = e.layout;
+  footer.crc16 = 0;
+  footer.firstFrameID = firstFrameID;
+  footer.pageStartMs = pageStartMs;
+
+  // Frames are already folded into e.crc; only the footer head remains.
+  footer.crc16 = crc16_ccitt_update(e.crc, (const uint8_t *)&footer,
+                                    offsetof(PageFooter, crc16));
+
+  memcpy(e.buf + IMU_PAGE_DATA_BYTES, &footer, sizeof(PageFooter));
+}
+
+// =============================================================================
+// STREAM RECORDS
+// =============================================================================
+
+void imuStreamHeader(uint32_t index, const uint8_t *pageData, uint8_t *hdr) {
+  StreamPageHeader h = {};
+  h.magic = FLASH_STREAM_MAGIC;
+  h.pageIndex = index;
+  h.pageSize = IMU_PAGE_BYTES;
+
+  PageFooter footer;
+  memcpy(&footer, pageData + IMU_PAGE_DATA_BYTES, sizeof(PageFooter));
+
+  if (imuFooterSane(footer)) {
+    h.flags |= 0x0001;  // footer valid
+    h.validFrames = footer.validFrames;
+    h.crc16 = footer.crc16;
+
+    if (decodeImuPage(pageData, nullptr) == IMU_PAGE_VALID) {
+      h.flags |= 0x0002;  // CRC OK
+    }
+
+    if (footer.magic == PAGE_MAGIC_DELTA) {
+      h.flags |= 0x0004;  // delta-encoded frames
+    }
+
+    h.flags |= (uint16_t)footer.layout << 8;  // FRAME_LAYOUT_* flags
+  }
+
+  memcpy(hdr, &h, sizeof(h));
+}
+
+void syncStreamHeader(uint32_t index, const uint8_t *pageData, uint8_t *hdr) {
+  StreamPageHeader h = {};
+  h.magic = SYNC_STREAM_MAGIC;
+  h.pageIndex = index;
+  h.pageSize = IMU_PAGE_BYTES;  // sync pages are flash pages too
+
+  SyncPageFooter footer;
+  memcpy(&footer, pageData + IMU_PAGE_BYTES - sizeof(SyncPageFooter), sizeof(SyncPageFooter));
+
+  if (footer.magic == SYNC_MAGIC && footer.validFrames <= SYNC_FRAMES_PER_PAGE) {
+    h.flags |= 0x0001;
+    h.validFrames = footer.validFrames;
+    h.crc16 = footer.crc16;
+
+    const uint16_t crcLen =
+      footer.validFrames * sizeof(SyncFrame) + offsetof(SyncPageFooter, crc16);
+    if (crc16_ccitt(pageData, crcLen) == footer.crc16) {
+      h.flags |= 0x0002;
+    }
+  }
+
+  memcpy(hdr, &h, sizeof(h));
+}
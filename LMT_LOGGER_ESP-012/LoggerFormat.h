@@ -0,0 +1,257 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// LoggerFormat — IMU frame/page formats (on-flash ABI) + page codec
+// =============================================================================
+//
+// Owns:
+//  - Frame20 / PageFooter layouts
+//  - IMU page encodings and their footer magics
+//  - Frame layouts (how a Frame20 is stored inside a page)
+//  - Page encoder (recording) and decoder (boot scan, playback, HTTP, tools)
+//  - Sync page footer
+//  - Stream record headers (HTTP /imu and /sync, BLE bulk, bdump, tools)
+//
+// This file has no Arduino dependency so host tools can build it as-is.
+//
+// FRAME LAYOUTS (PageFooter.layout bit flags)
+//
+//   A page stores each frame as a vector of 16-bit fields:
+//     quaternion  FULL: q0..q3 (Q15)                            4 fields
+//                 FRAME_LAYOUT_QUAT_S3: smallest three          3 fields
+//     accel       ax..az (raw)                                  3 fields
+//     mag         FULL: mx..mz (raw)                            3 fields
+//                 FRAME_LAYOUT_MAG_REDUCED: (m + 2) >> 2,       3 fields
+//                 clamped to 10 bits (+-2047 raw, 0.6 uT step)
+//     time        FRAME_LAYOUT_TIMED only:                      1 field
+//                   bits 0..11   dt: ms since the previous frame (0 for the
+//                                first frame, which is at pageStartMs)
+//                   bits 12..15  gap marker: samples missed just before this
+//                                frame (15 = 15 or more)
+//
+//   A frame whose dt would exceed TIME_DT_MAX_MS does not fit the page; the
+//   recorder then starts a new page, whose footer re-anchors the time base.
+//   Untimed pages predate per-frame times: decoders assume
+//   UNTIMED_FRAME_PERIOD_MS spacing and no gaps.
+//
+//   Smallest three: the largest |q| component is dropped and rebuilt as
+//   sqrt(1 - sum of squares). The others are rescaled from +-1/sqrt(2) to
+//   15 bits and shifted left one; the freed low bits carry the dropped index
+//   (fields 0, 1) and its sign (field 2).
+//
+//   QUAT_S3 and MAG_REDUCED are lossy; decoding yields an ordinary Frame20
+//   (plus an ImuFrameTime per frame on request).
+//
+// PAGE ENCODINGS (256-byte page, 16-byte PageFooter at the end)
+//
+//   PAGE_MAGIC ("PAGE")        raw: validFrames fixed-size records. A record
+//                              is the field vector, except that reduced mag
+//                              packs into 32 bits (x | y << 10 | z << 20),
+//                              ahead of the time field.
+//                              FULL records are plain Frame20.
+//
+//   PAGE_MAGIC_DELTA ("PAGD")  delta: the key frame's field vector verbatim,
+//                              then for each following frame one varint per
+//                              field:
+//                                d  = (int16)(cur - prev)      wrapping
+//                                zz = (d << 1) ^ (d >> 15)     zig-zag
+//                                LEB128, 7 bits per byte, 1..3 bytes
+//                              Frames are added while they fit before the
+//                              footer.
+//
+// Unused bytes up to the footer are 0xFF. For both encodings the CRC covers
+// the encoded bytes followed by the footer up to (excluding) crc16; for delta
+// pages the encoded length is found by decoding validFrames frames.
+//
+
+// =============================================================================
+// FRAME FORMAT (20 bytes)
+// =============================================================================
+//
+// Stored frame format (20 bytes), little-endian.
+//
+struct Frame20 {
+  int16_t q0, q1, q2, q3;  // Quaternion (Q15)
+  int16_t ax, ay, az;      // Accelerometer (raw)
+  int16_t mx, my, mz;      // Magnetometer (raw)
+};
+static_assert(sizeof(Frame20) == 20, "Frame20 must be exactly 20 bytes");
+
+static constexpr uint16_t FRAME20_FIELDS = sizeof(Frame20) / sizeof(int16_t);
+
+// Widest field vector: Frame20 plus the time field.
+static constexpr uint16_t IMU_MAX_FIELDS = FRAME20_FIELDS + 1;
+
+#define FRAME_LAYOUT_FULL        0x00
+#define FRAME_LAYOUT_QUAT_S3     0x01  // smallest-three quaternion
+#define FRAME_LAYOUT_MAG_REDUCED 0x02  // 10-bit magnetometer
+#define FRAME_LAYOUT_TIMED       0x04  // per-frame dt + gap marker
+#define FRAME_LAYOUT_KNOWN \
+  (FRAME_LAYOUT_QUAT_S3 | FRAME_LAYOUT_MAG_REDUCED | FRAME_LAYOUT_TIMED)
+
+// Time field limits (FRAME_LAYOUT_TIMED)
+static constexpr uint16_t TIME_DT_MAX_MS = 0x0FFF;
+static constexpr uint8_t TIME_GAP_MAX = 0x0F;
+
+// Frame spacing assumed for pages without FRAME_LAYOUT_TIMED (10 Hz polled).
+static constexpr uint32_t UNTIMED_FRAME_PERIOD_MS = 100;
+
+// Per-frame timing recovered by the decoder.
+struct ImuFrameTime {
+  uint32_t ms;     // sample time (millis() clock of the recording)
+  uint8_t missed;  // samples missed just before this frame (gap marker)
+};
+
+// =============================================================================
+// PAGE FOOTER FORMAT (IMU pages) — 16 bytes
+// =============================================================================
+
+#define PAGE_MAGIC       0x50414745UL  // ASCII "PAGE" (raw frames)
+#define PAGE_MAGIC_DELTA 0x50414744UL  // ASCII "PAGD" (key frame + deltas)
+
+struct PageFooter {
+  uint32_t magic;         // PAGE_MAGIC / PAGE_MAGIC_DELTA
+  uint8_t validFrames;    // Number of frames stored in the page
+  uint8_t layout;         // FRAME_LAYOUT_* flags (0 on pages from before layouts)
+  uint16_t crc16;         // CRC over frames + footer (excluding this field)
+  uint32_t firstFrameID;  // Global frame ID of first frame in page
+  uint32_t pageStartMs;   // millis() timestamp of first frame
+};
+static_assert(sizeof(PageFooter) == 16, "PageFooter must be exactly 16 bytes");
+
+// =============================================================================
+// PAGE GEOMETRY
+// =============================================================================
+
+static constexpr uint16_t IMU_PAGE_BYTES = 256;
+static constexpr uint16_t IMU_PAGE_DATA_BYTES = IMU_PAGE_BYTES - sizeof(PageFooter);
+
+// Raw FULL pages: floor(240 / 20) = 12
+static constexpr uint16_t FRAMES_PER_PAGE = IMU_PAGE_DATA_BYTES / sizeof(Frame20);
+
+// Varint bytes per delta field: 1..3
+static constexpr uint16_t DELTA_FIELD_MAX_BYTES = 3;
+
+// Upper bound on frames in any page encoding/layout (sizes decode buffers):
+// delta + QUAT_S3, 9 fields: 18-byte key frame + 9 bytes per frame after it.
+static constexpr uint16_t MIN_LAYOUT_FIELDS = FRAME20_FIELDS - 1;
+static constexpr uint16_t MAX_FRAMES_PER_PAGE =
+  1 + (IMU_PAGE_DATA_BYTES - 2 * MIN_LAYOUT_FIELDS) / MIN_LAYOUT_FIELDS;
+
+// Magic is one of the IMU page encodings.
+bool imuPageMagicKnown(uint32_t magic);
+
+// Most frames a page with this magic and layout can hold; 0 if unknown.
+uint16_t imuPageCapacity(uint32_t magic, uint8_t layout);
+
+// Footer carries a known magic/layout and a frame count that fits.
+bool imuFooterSane(const PageFooter &footer);
+
+// =============================================================================
+// DECODER
+// =============================================================================
+
+enum ImuPageState {
+  IMU_PAGE_ABSENT,   // no known IMU page magic: end of log
+  IMU_PAGE_VALID,    // footer sane and CRC matches
+  IMU_PAGE_CORRUPT   // footer present but insane, undecodable or CRC mismatch
+};
+
+// Decode a full IMU page.
+//   out     : MAX_FRAMES_PER_PAGE entries, or nullptr to only check the page
+//   decoded : frames written to 'out' (may be < validFrames when CORRUPT)
+//   times   : MAX_FRAMES_PER_PAGE entries, or nullptr
+ImuPageState decodeImuPage(const uint8_t *page, Frame20 *out,
+                           uint16_t *decoded = nullptr,
+                           ImuFrameTime *times = nullptr);
+
+// =============================================================================
+// ENCODER
+// =============================================================================
+//
+// Frames are encoded straight into the page buffer; the CRC over encoded
+// bytes is kept running so finishing a page only folds in the footer.
+
+struct ImuPageEncoder {
+  uint8_t *buf;     // IMU_PAGE_BYTES page being filled
+  uint32_t magic;   // PAGE_MAGIC / PAGE_MAGIC_DELTA
+  uint8_t layout;   // FRAME_LAYOUT_* flags
+  uint16_t used;    // encoded bytes in buf
+  uint16_t frames;  // frames encoded
+  uint16_t crc;     // running CRC over buf[0, used)
+  uint32_t lastMs;  // last frame's time as a decoder will rebuild it
+  uint16_t prev[IMU_MAX_FIELDS];  // last frame's fields (delta reference)
+};
+
+void imuEncoderBegin(ImuPageEncoder &e, uint8_t *buf, uint32_t magic, uint8_t layout);
+
+// Append a frame sampled at 'sampleMs', 'missed' samples after the previous
+// one (both ignored unless FRAME_LAYOUT_TIMED). Returns false (page
+// unchanged) if it does not fit, in space or in dt.
+bool imuEncoderAppend(ImuPageEncoder &e, const Frame20 &f,
+                      uint32_t sampleMs = 0, uint8_t missed = 0);
+
+// No further frame can fit, whatever its content.
+bool imuEncoderFull(const ImuPageEncoder &e);
+
+// Pad with 0xFF and write the footer. The page is then ready to program.
+void imuEncoderFinish(ImuPageEncoder &e, uint32_t firstFrameID, uint32_t pageStartMs);
+
+// =============================================================================
+// SYNC PAGE FORMAT
+// =============================================================================
+//
+// Sync pages are stored in a dedicated region after the IMU log region.
+//
+// Layout:
+//   - 0..(n*16-1) : SyncFrame entries (packed, see LoggerSync.h)
+//   - remaining bytes to footerOffset: 0xFF
+//   - last 16 bytes: SyncPageFooter
+//
+// CRC is computed over:
+//   [usedBytes] + [footer bytes up to (but excluding) crc16 field]
+//
+#define SYNC_MAGIC 0x53594E43UL  // ASCII "SYNC"
+
+struct SyncPageFooter {
+  uint32_t magic;        // SYNC_MAGIC
+  uint16_t validFrames;  // Number of valid SyncFrame entries
+  uint16_t crc16;        // CRC over frames + footer (excluding this field)
+  uint32_t firstSyncID;  // Monotonic sync frame ID (starts at 1)
+  uint32_t pageStartMs;  // millis() timestamp of first sync frame in page
+};
+static_assert(sizeof(SyncPageFooter) == 16, "SyncPageFooter must be exactly 16 bytes");
+
+// =============================================================================
+// STREAM RECORDS
+// =============================================================================
+//
+// Every page export (HTTP /imu and /sync, BLE bulk, bdump) sends records of
+// a 16-byte header followed by the raw 256-byte page. The header lets
+// clients find page boundaries and check integrity without knowing the log
+// size. Little-endian and binary-stable; the HTTP docs call it
+// FlashPageHeader ('LMTP') and SyncPageHeader ('LMTS').
+
+#define FLASH_STREAM_MAGIC 0x4C4D5450UL  // ASCII "LMTP"
+#define SYNC_STREAM_MAGIC  0x4C4D5453UL  // ASCII "LMTS"
+
+struct StreamPageHeader {
+  uint32_t magic;        // FLASH_STREAM_MAGIC / SYNC_STREAM_MAGIC
+  uint32_t pageIndex;    // logical IMU page / sync page index (0-based)
+  uint16_t pageSize;     // always 256
+  uint16_t validFrames;  // from the page footer (if present)
+  uint16_t crc16;        // footer CRC (if present)
+  uint16_t flags;        // bit0: footer valid, bit1: CRC valid,
+                         // IMU only: bit2: delta, bits8-15: frame layout
+};
+static_assert(sizeof(StreamPageHeader) == 16, "StreamPageHeader must be 16 bytes");
+
+#define STREAM_RECORD_BYTES (16 + 256)
+
+// Build the header of one raw page into 'hdr' (16 bytes).
+typedef void (*StreamHeaderFn)(uint32_t index, const uint8_t *pageData, uint8_t *hdr);
+
+void imuStreamHeader(uint32_t index, const uint8_t *pageData, uint8_t *hdr);
+void syncStreamHeader(uint32_t index, const uint8_t *pageData, uint8_t *hdr);
@@ -1,9 +1,18 @@
 #include "LoggerHTTP.h"
 
+#include <errno.h>
+#include <new>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
 #include <WiFi.h>
-#include <WebServer.h>
+#include <lwip/sockets.h>
 
 #include "LoggerCore.h"
+#include "LoggerDeflate.h"
 
 // ============================================================================
 // CONFIG
@@ -13,217 +22,1024 @@
 // It is only active while OTA mode is enabled.
 
 #define HTTP_PORT 80
-#define FLASH_STREAM_MAGIC 0x4C4D5450UL  // ASCII "LMTP"
-#define SYNC_STREAM_MAGIC 0x4C4D5453UL  // ASCII "LMTS"
+
+// Connections served at once. Further clients wait in the listen backlog
+// until a slot frees up.
+#define HTTP_MAX_CLIENTS 3
+
+// Request line + headers kept per connection; longer requests get 431.
+#define HTTP_REQUEST_MAX 768
+
+// A keep-alive connection without a new request is closed after
+// HTTP_IDLE_TIMEOUT_MS; a response the client stops reading, after
+// HTTP_STALL_TIMEOUT_MS without progress.
+#define HTTP_IDLE_TIMEOUT_MS 10000
+#define HTTP_STALL_TIMEOUT_MS 30000
+
+// Server task for the modes where loop() does not call serviceHTTP()
+// (recording, playback). It sits below loop()'s priority (1), so it only
+// runs while the recorder waits for the IMU (never delaying a sample) or
+// while playback yields between passes.
+#define HTTP_TASK_STACK 4096
+#define HTTP_TASK_PRIO  0
+
+static_assert(STREAM_RECORD_BYTES == 16 + FLASH_PAGE_SIZE,
+              "stream records are a 16-byte header + one flash page");
+
+// Page records produced per batch (one flash transaction, one HTTP chunk):
+// 16 x 272 = 4352 bytes. Per-write overhead in the TCP stack, not Wi-Fi
+// bandwidth, limits small writes.
+#define HTTP_STREAM_BATCH_PAGES 16
+
+// Room ahead of the records for a "<hex>\r\n" chunk size, and after them for
+// the chunk's trailing "\r\n".
+#define HTTP_CHUNK_PREFIX 8
+#define HTTP_CHUNK_SUFFIX 2
 
 // ============================================================================
 // INTERNAL STATE
 // ============================================================================
 //
-// The HTTP server is dynamically created and destroyed alongside OTA.
-// No background threads or async tasks are used.
+// The HTTP server is created and destroyed alongside OTA and runs entirely
+// inside serviceHTTP(), called from loop(). No call waits on a client:
+//
+//   - each connection is a small state machine: read request -> send
+//     response -> read the next request (keep-alive) or close
+//   - a response body is produced one batch at a time into the connection's
+//     own buffer and written with non-blocking socket sends; a client whose
+//     TCP window is full is skipped until the next pass
+//   - one serviceHTTP() pass reads at most one flash batch per connection,
+//     so OTA, the CLI and BLE keep running while downloads are in flight
+//   - in idle mode loop() services the server; in every other mode a
+//     low-priority task does, so exports also run during recording
+//   - each response streams up to a watermark taken at request time
+//     (currentPage plus a writer mark) and reads pages only once the
+//     writer has programmed everything below it
+
+struct HttpGzip;
+
+enum HttpConnState {
+  CONN_FREE,
+  CONN_REQUEST,   // collecting request line + headers
+  CONN_RESPONSE   // sending head + body
+};
+
+enum HttpBody {
+  BODY_NONE,      // head (and short text body) only
+  BODY_REGION,    // identity region stream: record bytes [off, endByte)
+  BODY_CHUNKED    // chunked records of pages [page, endPage)
+};
 
-static WebServer *g_http = nullptr;
+struct HttpConn {
+  WiFiClient client;
+  HttpConnState state;
+  uint32_t lastActivityMs;
+  bool keepAlive;
+
+  char req[HTTP_REQUEST_MAX];
+  uint16_t reqLen;
+
+  // Bytes queued for the socket: out[0, outLen)
+  const uint8_t *out;
+  uint32_t outLen;
+
+  // Body generator
+  HttpBody body;
+  bool sync;             // sync region (else the IMU log)
+  uint32_t firstPage;    // BODY_REGION: page of record byte 0
+  uint32_t pages;        // region pages (Content-Length snapshot)
+  uint32_t off;          // BODY_REGION: next record byte
+  uint32_t endByte;
+  uint32_t page;         // BODY_CHUNKED: next stream page
+  uint32_t endPage;
+  uint32_t writerMark;   // writer jobs covering the watermark (see above)
+  bool seekPending;      // BODY_CHUNKED: find 'page' once the data is durable
+  bool cursorTrailer;    // BODY_CHUNKED: since_page pull, cursor in the trailer
+  bool cursorReset;      // since_page named another log: restarted at page 0
+  char cursorSession[12];  // since_page pull: X-LMT-Session of the region
+  bool hasRange;         // BODY_CHUNKED: cut at the end of 'range'
+  ImuRange range;
+  bool bodyDone;         // BODY_CHUNKED: terminator queued
+  HttpGzip *gz;          // gzip encoder, or nullptr for identity
+
+  // [chunk prefix][records][chunk suffix]; response heads are built here too.
+  uint8_t buf[HTTP_CHUNK_PREFIX +
+              HTTP_STREAM_BATCH_PAGES * STREAM_RECORD_BYTES +
+              HTTP_CHUNK_SUFFIX];
+};
+
+static WiFiServer *g_http = nullptr;
 static bool g_httpStarted = false;
+static HttpConn g_conns[HTTP_MAX_CLIENTS];
+
+static TaskHandle_t g_httpTask = nullptr;
+static SemaphoreHandle_t g_httpLock = nullptr;  // one servicing context at a time
+
+static uint8_t *connRecords(HttpConn &c) {
+  return c.buf + HTTP_CHUNK_PREFIX;
+}
+
+// Number of pages to fetch next: min(remaining, batch).
+static uint32_t readBatchPages(uint32_t page, uint32_t endPage) {
+  const uint32_t left = endPage - page;
+  return (left > HTTP_STREAM_BATCH_PAGES) ? HTTP_STREAM_BATCH_PAGES : left;
+}
+
+
+// ============================================================================
+// BATCHED PAGE RECORDS
+// ============================================================================
+
+// Load stream pages [page, page + count) of a region into 'records' as
+// header + page records.
+//
+// The pages are read in one transaction into the tail of the record area and
+// expanded in place, front to back: record k (at 272k) never overlaps page
+// k + 1 (at 16 * count + 256 * (k + 1)), so no second buffer is needed.
+bool loadPageRecords(uint8_t *records, bool sync, uint32_t page, uint32_t count) {
+  uint8_t *raw = records + count * 16;
+  const StreamHeaderFn header = sync ? syncStreamHeader : imuStreamHeader;
+
+  const bool ok = sync ? flash.readData((flashSyncBasePage + page) * FLASH_PAGE_SIZE, raw,
+                                        count * FLASH_PAGE_SIZE)
+                       : readImuPages(page, raw, count);
+  if (!ok) {
+    return false;
+  }
+
+  for (uint32_t k = 0; k < count; k++) {
+    uint8_t *rec = records + k * STREAM_RECORD_BYTES;
+    memmove(rec + 16, raw + k * FLASH_PAGE_SIZE, FLASH_PAGE_SIZE);
+    header(page + k, rec + 16, rec);
+  }
 
-// Reused buffer for streaming flash pages.
-// Avoids heap churn and large stack allocations.
-static uint8_t g_pageBuf[FLASH_PAGE_SIZE];
+  return true;
+}
+
+// Frame data[0, len) as one HTTP chunk in place and queue it for sending.
+// The buffer must have HTTP_CHUNK_PREFIX bytes of room before 'data' and
+// HTTP_CHUNK_SUFFIX after it (HttpConn::buf and HttpGzip::out do).
+static void queueChunk(HttpConn &c, uint8_t *data, uint32_t len) {
+  char size[HTTP_CHUNK_PREFIX + 1];
+  const int n = snprintf(size, sizeof(size), "%lX\r\n", (unsigned long)len);
 
+  uint8_t *start = data - n;
+  memcpy(start, size, n);
+  data[len] = '\r';
+  data[len + 1] = '\n';
+
+  c.out = start;
+  c.outLen = n + len + HTTP_CHUNK_SUFFIX;
+}
 
 // ============================================================================
-// PAGE HEADER (sent before each flash page)
+// CONTENT ENCODING (gzip)
 // ============================================================================
 //
-// Each flash page is preceded by a fixed-size header so clients can:
-//   - identify page boundaries
-//   - validate page integrity
-//   - stream without prior knowledge of log size
+// Clients that send "Accept-Encoding: gzip" get chunked responses compressed
+// with LoggerDeflate (fixed-Huffman deflate, 4 KB window). The encoder state
+// is allocated per response and freed after it; if the heap cannot spare it
+// the response simply goes out uncompressed.
 //
-// Header is little-endian and binary-stable.
-
-struct FlashPageHeader {
-  uint32_t magic;        // "LMTP"
-  uint32_t pageIndex;    // sequential page number
-  uint16_t pageSize;     // always FLASH_PAGE_SIZE (256)
-  uint16_t validFrames;  // from PageFooter (if present)
-  uint16_t crc16;        // PageFooter CRC16 (if present)
-  uint16_t flags;        // bit0: footer valid, bit1: CRC valid
+// Range requests are always served as identity: byte offsets refer to the
+// uncompressed record stream, which is what resuming clients count.
+
+struct HttpGzip {
+  GzipStream z;
+  uint8_t out[HTTP_CHUNK_PREFIX +
+              gzipWriteBound(HTTP_STREAM_BATCH_PAGES * STREAM_RECORD_BYTES) +
+              HTTP_CHUNK_SUFFIX];
 };
 
-static_assert(sizeof(FlashPageHeader) == 16,
-              "FlashPageHeader must be 16 bytes");
+static_assert(HTTP_STREAM_BATCH_PAGES * STREAM_RECORD_BYTES <= DEFLATE_MAX_INPUT,
+              "one record batch must fit one gzipWrite()");
+
+// True if the Accept-Encoding list names gzip without "q=0".
+static bool acceptsGzip(const char *p) {
+  while (*p) {
+    while (*p == ' ' || *p == ',') p++;
+    const char *tok = p;
+    while (*p && *p != ',' && *p != ';' && *p != ' ') p++;
+    const bool gzip = (p - tok == 4) && strncasecmp(tok, "gzip", 4) == 0;
+
+    // Parameters up to the next list element ("gzip;q=0.5")
+    float q = 1.0f;
+    while (*p && *p != ',') {
+      if ((p[0] == 'q' || p[0] == 'Q') && p[1] == '=') {
+        q = strtof(p + 2, nullptr);
+      }
+      p++;
+    }
+    if (gzip) {
+      return q > 0.0f;
+    }
+  }
+  return false;
+}
+
+static void freeGzip(HttpConn &c) {
+  delete c.gz;
+  c.gz = nullptr;
+}
+
+// Queue one run of body bytes as a chunk, compressed when c.gz is set.
+static void queueBody(HttpConn &c, uint8_t *data, uint32_t len) {
+  if (!c.gz) {
+    queueChunk(c, data, len);
+    return;
+  }
+
+  uint8_t *out = c.gz->out + HTTP_CHUNK_PREFIX;
+  const size_t n = gzipWrite(c.gz->z, data, len, out);
+  if (n > 0) {
+    queueChunk(c, out, n);  // a zero-length chunk would end the body
+  }
+}
 
+// Queue the end of a chunked body: gzip trailer (if any), the final
+// zero-length chunk and, for since_page pulls, the next-cursor trailer.
+static void queueBodyEnd(HttpConn &c) {
+  uint8_t *p = connRecords(c);
+  uint8_t *end = p;
 
+  c.out = p;
+  c.outLen = 0;
 
-struct SyncPageHeader {
-  uint32_t magic;        // "LMTS"
-  uint32_t pageIndex;    // sync page index (0-based)
-  uint16_t pageSize;     // FLASH_PAGE_SIZE
-  uint16_t validFrames;  // from SyncPageFooter
-  uint16_t crc16;        // footer CRC
-  uint16_t flags;        // bit0: footer valid, bit1: CRC valid
-};
+  if (c.gz) {
+    const size_t n = gzipFinish(c.gz->z, p);
+    freeGzip(c);
+    queueChunk(c, p, n);
+    end = p + n + HTTP_CHUNK_SUFFIX;
+  }
+
+  if (!c.cursorTrailer) {
+    memcpy(end, "0\r\n\r\n", 5);
+    c.outLen += 5;
+    return;
+  }
 
-static_assert(sizeof(SyncPageHeader) == 16,
-              "SyncPageHeader must be 16 bytes");
+  // c.page: first page not sent (endPage, or where a read failure stopped)
+  const int n = snprintf((char *)end, 48, "0\r\nX-LMT-Next-Page: %lu\r\n\r\n",
+                         (unsigned long)c.page);
+  c.outLen += (n > 0) ? n : 0;
+}
 
 // ============================================================================
-// HTTP HANDLERS
+// REQUEST PARSING
+// ============================================================================
+
+// Copy the value of request header 'name' (case-insensitive) into 'out'.
+static bool requestHeader(const HttpConn &c, const char *name, char *out, size_t outLen) {
+  const size_t nameLen = strlen(name);
+  const char *line = strstr(c.req, "\r\n");
+
+  while (line && line[2] != '\r' && line[2] != 0) {
+    line += 2;
+    if (strncasecmp(line, name, nameLen) == 0 && line[nameLen] == ':') {
+      const char *v = line + nameLen + 1;
+      while (*v == ' ' || *v == '\t') v++;
+
+      size_t n = 0;
+      while (v[n] && v[n] != '\r' && n + 1 < outLen) n++;
+      memcpy(out, v, n);
+      out[n] = 0;
+      return true;
+    }
+    line = strstr(line, "\r\n");
+  }
+  return false;
+}
+
+static bool hasRequestHeader(const HttpConn &c, const char *name) {
+  char tmp[2];
+  return requestHeader(c, name, tmp, sizeof(tmp));
+}
+
+// Find 'name=value' in a query string ("a=1&b=2"): the value, or nullptr.
+static const char *queryValue(const char *query, const char *name) {
+  const size_t nameLen = strlen(name);
+
+  const char *p = query;
+  while (p && *p) {
+    if (strncmp(p, name, nameLen) == 0 && p[nameLen] == '=') {
+      return p + nameLen + 1;
+    }
+    p = strchr(p, '&');
+    if (p) p++;
+  }
+  return nullptr;
+}
+
+static bool queryArg(const char *query, const char *name, uint32_t &value) {
+  const char *v = queryValue(query, name);
+  if (!v) {
+    return false;
+  }
+  value = strtoul(v, nullptr, 10);
+  return true;
+}
+
+// True if the query has 'name' and its value is not exactly 'expected'.
+static bool queryArgDiffers(const char *query, const char *name, const char *expected) {
+  const char *v = queryValue(query, name);
+  if (!v) {
+    return false;
+  }
+  const size_t len = strlen(expected);
+  return strncmp(v, expected, len) != 0 || (v[len] != 0 && v[len] != '&');
+}
+
+// ============================================================================
+// RESPONSES
 // ============================================================================
+//
+// Heads (and short text bodies) are built in the connection buffer and sent
+// like any other queued bytes.
+
+// Start a response head in c.buf.
+static void beginHead(HttpConn &c, const char *status) {
+  c.out = c.buf;
+  c.outLen = 0;
+  c.body = BODY_NONE;
+
+  const int n = snprintf((char *)c.buf, sizeof(c.buf), "HTTP/1.1 %s\r\n", status);
+  c.outLen = (n > 0) ? n : 0;
+}
+
+// Append printf output to the response being built.
+static void headf(HttpConn &c, const char *fmt, ...) {
+  const size_t room = sizeof(c.buf) - c.outLen;
+
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = vsnprintf((char *)c.buf + c.outLen, room, fmt, ap);
+  va_end(ap);
+
+  if (n > 0) {
+    c.outLen += ((size_t)n < room) ? n : room - 1;
+  }
+}
+
+// Close the head with the Connection header and the blank line.
+static void endHead(HttpConn &c) {
+  headf(c, "Connection: %s\r\n\r\n", c.keepAlive ? "keep-alive" : "close");
+}
+
+// Complete response with a short text/plain body.
+static void queueText(HttpConn &c, const char *status, const char *text) {
+  beginHead(c, status);
+  headf(c, "Content-Type: text/plain\r\nContent-Length: %u\r\n", (unsigned)strlen(text));
+  endHead(c);
+  headf(c, "%s", text);
+}
 
-// Root endpoint: redirect browsers to Trace Dynamics site.
+// Redirect browsers to the Trace Dynamics site.
 // This avoids exposing a directory listing or empty page.
-static void handleRootRedirect() {
-  g_http->sendHeader("Location", "https://tracedynamics.ai", true);
-  g_http->send(302, "text/plain", "Redirecting to Trace Dynamics");
+static void queueRedirect(HttpConn &c) {
+  const char *text = "Redirecting to Trace Dynamics";
+  beginHead(c, "302 Found");
+  headf(c, "Location: https://tracedynamics.ai\r\n"
+           "Content-Type: text/plain\r\nContent-Length: %u\r\n", (unsigned)strlen(text));
+  endHead(c);
+  headf(c, "%s", text);
+}
+
+// Head of a chunked record stream; the body follows batch by batch.
+static void beginChunkedRecords(HttpConn &c, bool sync, uint32_t firstPage,
+                                uint32_t endPage, const ImuRange *range) {
+  beginHead(c, "200 OK");
+  headf(c, "Content-Type: application/octet-stream\r\n");
+  if (c.gz) {
+    headf(c, "Content-Encoding: gzip\r\n");
+  }
+  headf(c, "Vary: Accept-Encoding\r\n"
+           "Transfer-Encoding: chunked\r\n");
+  if (c.cursorTrailer) {
+    headf(c, "X-LMT-Since-Page: %lu\r\n"
+             "Trailer: X-LMT-Next-Page\r\n",
+          (unsigned long)firstPage);
+    headf(c, "X-LMT-Session: %s\r\n", c.cursorSession);
+    if (c.cursorReset) {
+      headf(c, "X-LMT-Cursor-Reset: 1\r\n");
+    }
+  }
+  endHead(c);
+
+  c.body = BODY_CHUNKED;
+  c.sync = sync;
+  c.page = firstPage;
+  c.endPage = endPage;
+  c.hasRange = (range != nullptr);
+  if (range) {
+    c.range = *range;
+  }
+  c.seekPending = false;
+  c.bodyDone = false;
+}
+
+// Encoder for this response, or nullptr for identity.
+static HttpGzip *beginGzip(const HttpConn &c) {
+  char accept[96];
+  if (!requestHeader(c, "Accept-Encoding", accept, sizeof(accept)) || !acceptsGzip(accept)) {
+    return nullptr;
+  }
+
+  HttpGzip *gz = new (std::nothrow) HttpGzip;
+  if (gz) {
+    gzipBegin(gz->z);
+  }
+  return gz;
 }
 
-// Stream the entire recorded flash log as a chunked HTTP response.
+// ============================================================================
+// RESUMABLE REGION STREAMS (Range / If-Range / ETag)
+// ============================================================================
 //
-// Behavior:
-//   - Pages are streamed sequentially from page 0 to currentPage (exclusive)
-//   - Logging may continue concurrently
-//   - No attempt is made to lock or snapshot flash contents
-//   - CRC validity is reported in headers but not enforced
+// A whole-region response (/imu without a range query, /sync) is the plain
+// concatenation of one 16-byte page header + 256-byte page per page, so its
+// size is known up front: it is sent with Content-Length and honors a single
+// Range in bytes (RFC 9110) or in pages ("Range: pages=a-b", a private unit).
 //
-// This endpoint is intended for trusted networks and test rigs.
-static void handleFlashStream() {
+// ETag = "<tag>-<sessionID>-<firstPage>-<pages>" (hex). Logs only grow
+// within a session, so an If-Range validator from the same session and first
+// page with <= pages describes a prefix of the current response; it is
+// accepted and the client resumes even if recording appended pages in the
+// meantime. A ring that has moved its tail no longer matches.
+
+struct RegionStream {
+  const char *tag;        // ETag prefix ("lmtp" / "lmts")
+  bool sync;              // sync region (else the IMU log)
+  uint32_t firstPage;     // page of response byte 0 (oldest on flash)
+  uint32_t pages;         // pages in the response (snapshot at request time)
+};
+
+enum RangeResult {
+  RANGE_NONE,           // absent, ignored or invalid: send everything (200)
+  RANGE_OK,             // [first, last] bytes (206)
+  RANGE_UNSATISFIABLE   // 416
+};
 
-  WiFiClient client = g_http->client();
+static void formatEtag(const RegionStream &src, char *out, size_t outLen) {
+  snprintf(out, outLen, "\"%s-%x-%lx-%lx\"",
+           src.tag, sessionID, (unsigned long)src.firstPage, (unsigned long)src.pages);
+}
+
+// If-Range validator names this log (same tag, session and first page) at a
+// size the current response extends.
+static bool ifRangeMatches(const RegionStream &src, const char *validator) {
+  char tag[8];
+  unsigned session = 0;
+  unsigned long first = 0;
+  unsigned long pages = 0;
+
+  if (sscanf(validator, "\"%7[^-]-%x-%lx-%lx\"", tag, &session, &first, &pages) != 4) {
+    return false;
+  }
+  return strcmp(tag, src.tag) == 0 && session == sessionID && first == src.firstPage &&
+         pages <= src.pages;
+}
+
+// Parse a single "bytes=" or "pages=" range against 'totalBytes'.
+static RangeResult parseRangeHeader(const char *spec, uint32_t totalBytes,
+                                    uint32_t &first, uint32_t &last, bool &pageUnits) {
+  pageUnits = strncmp(spec, "pages=", 6) == 0;
+  if (!pageUnits && strncmp(spec, "bytes=", 6) != 0) {
+    return RANGE_NONE;
+  }
+  spec += 6;
 
-  // Manual HTTP response (chunked transfer)
-  client.println("HTTP/1.1 200 OK");
-  client.println("Content-Type: application/octet-stream");
-  client.println("Transfer-Encoding: chunked");
-  client.println("Connection: close");
-  client.println();
+  if (strchr(spec, ',')) {
+    return RANGE_NONE;  // multipart ranges are not served; send it all
+  }
 
-  // Stream pages one-by-one
-  for (uint32_t page = 0; page < currentPage; page++) {
+  const uint32_t unit = pageUnits ? STREAM_RECORD_BYTES : 1;
+  const uint32_t total = totalBytes / unit;
 
-    const uint32_t addr = page * FLASH_PAGE_SIZE;
-    if (!flash.readData(addr, g_pageBuf, FLASH_PAGE_SIZE)) {
-      // Abort stream on read failure
-      break;
+  char *end = nullptr;
+  if (*spec == '-') {
+    const uint32_t suffix = strtoul(spec + 1, &end, 10);
+    if (end == spec + 1 || suffix == 0 || total == 0) {
+      return RANGE_UNSATISFIABLE;
     }
+    first = (suffix >= total) ? 0 : total - suffix;
+    last = total - 1;
+  } else {
+    first = strtoul(spec, &end, 10);
+    if (end == spec || *end != '-') {
+      return RANGE_NONE;
+    }
+    const char *lastStr = end + 1;
+    last = (*lastStr) ? strtoul(lastStr, &end, 10) : total - 1;
+    if (*lastStr && (end == lastStr || last < first)) {
+      return RANGE_NONE;
+    }
+    if (first >= total) {
+      return RANGE_UNSATISFIABLE;
+    }
+    if (last >= total) {
+      last = total - 1;
+    }
+  }
+
+  first *= unit;
+  last = (last + 1) * unit - 1;
+  return RANGE_OK;
+}
+
+static void beginRegionStream(HttpConn &c, const RegionStream &src) {
+  // src.pages was read first, so every page below it is covered by the mark
+  c.writerMark = writerSubmitMark();
 
-    FlashPageHeader hdr = {};
-    hdr.magic = FLASH_STREAM_MAGIC;
-    hdr.pageIndex = page;
-    hdr.pageSize = FLASH_PAGE_SIZE;
-    hdr.flags = 0;
+  const uint32_t totalBytes = src.pages * STREAM_RECORD_BYTES;
+  const bool hasRange = hasRequestHeader(c, "Range");
 
-    // Attempt to parse page footer (if present)
-    const uint16_t footerOffset =
-      FLASH_PAGE_SIZE - sizeof(PageFooter);
+  // Compressed: length unknown up front, so chunked and without Range.
+  if (!hasRange) {
+    c.gz = beginGzip(c);
+    if (c.gz) {
+      beginChunkedRecords(c, src.sync, src.firstPage, src.firstPage + src.pages, nullptr);
+      return;
+    }
+  }
 
-    PageFooter footer;
-    memcpy(&footer,
-           g_pageBuf + footerOffset,
-           sizeof(PageFooter));
+  char etag[40];
+  formatEtag(src, etag, sizeof(etag));
 
-    if (footer.magic == PAGE_MAGIC &&
-        footer.validFrames <= FRAMES_PER_PAGE) {
+  uint32_t first = 0;
+  uint32_t last = totalBytes ? totalBytes - 1 : 0;
+  bool pageUnits = false;
+  RangeResult rr = RANGE_NONE;
 
-      hdr.flags |= 0x0001;  // footer valid
-      hdr.validFrames = footer.validFrames;
-      hdr.crc16 = footer.crc16;
+  char spec[64];
+  char validator[48];
+  if (hasRange && requestHeader(c, "Range", spec, sizeof(spec)) &&
+      (!requestHeader(c, "If-Range", validator, sizeof(validator)) ||
+       ifRangeMatches(src, validator))) {
+    rr = parseRangeHeader(spec, totalBytes, first, last, pageUnits);
+  }
+  if (rr == RANGE_NONE) {
+    first = 0;
+  }
 
-      const uint16_t usedBytes =
-        footer.validFrames * sizeof(Frame20);
-      const uint16_t crcLen =
-        usedBytes + offsetof(PageFooter, crc16);
+  if (rr == RANGE_UNSATISFIABLE) {
+    beginHead(c, "416 Range Not Satisfiable");
+    headf(c, "Content-Range: %s */%lu\r\n"
+             "Content-Length: 0\r\n",
+          pageUnits ? "pages" : "bytes",
+          (unsigned long)(pageUnits ? src.pages : totalBytes));
+    endHead(c);
+    return;
+  }
 
-      if (crc16_ccitt(g_pageBuf, crcLen) == footer.crc16) {
-        hdr.flags |= 0x0002;  // CRC OK
-      }
+  const uint32_t endByte = (rr == RANGE_OK) ? last + 1 : totalBytes;
+
+  beginHead(c, rr == RANGE_OK ? "206 Partial Content" : "200 OK");
+  headf(c, "Content-Type: application/octet-stream\r\n"
+           "Accept-Ranges: bytes, pages\r\n"
+           "Vary: Accept-Encoding\r\n"
+           "ETag: %s\r\n", etag);
+  if (rr == RANGE_OK) {
+    if (pageUnits) {
+      headf(c, "Content-Range: pages %lu-%lu/%lu\r\n",
+            (unsigned long)(first / STREAM_RECORD_BYTES),
+            (unsigned long)(last / STREAM_RECORD_BYTES),
+            (unsigned long)src.pages);
+    } else {
+      headf(c, "Content-Range: bytes %lu-%lu/%lu\r\n",
+            (unsigned long)first, (unsigned long)last,
+            (unsigned long)totalBytes);
+    }
+  }
+  headf(c, "Content-Length: %lu\r\n", (unsigned long)(endByte - first));
+  endHead(c);
+
+  c.body = BODY_REGION;
+  c.sync = src.sync;
+  c.firstPage = src.firstPage;
+  c.pages = src.pages;
+  c.off = first;
+  c.endByte = endByte;
+}
+
+// ============================================================================
+// BODY GENERATOR
+// ============================================================================
+
+// Queue the next piece of the response body (at most one flash batch).
+// Returns false once the body is complete.
+static bool fillBody(HttpConn &c) {
+  uint8_t *records = connRecords(c);
+
+  if (c.body == BODY_NONE) {
+    return false;
+  }
+
+  // While recording, pages below the watermark may still sit in the writer
+  // queue; produce nothing until they are on flash.
+  if (!writerReached(c.writerMark)) {
+    c.outLen = 0;
+    return true;
+  }
+
+  if (c.seekPending) {
+    c.page = imuRangeFirstPage(c.range, c.endPage);
+    c.seekPending = false;
+  }
+
+  if (c.body == BODY_REGION) {
+    if (c.off >= c.endByte) {
+      return false;
+    }
+
+    const uint32_t page = c.off / STREAM_RECORD_BYTES;
+    const uint32_t batch = readBatchPages(page, c.pages);
+
+    if (!loadPageRecords(records, c.sync, c.firstPage + page, batch)) {
+      // Short body: the client sees Content-Length unmet and resumes
+      c.keepAlive = false;
+      return false;
     }
 
-    // ---- chunk: page header ----
-    client.printf("%X\r\n", sizeof(hdr));
-    client.write((const uint8_t *)&hdr, sizeof(hdr));
-    client.print("\r\n");
+    // The first and last batch of a Range may start / end mid-record.
+    const uint32_t skip = c.off - page * STREAM_RECORD_BYTES;
+    uint32_t len = batch * STREAM_RECORD_BYTES - skip;
+    if (len > c.endByte - c.off) {
+      len = c.endByte - c.off;
+    }
+
+    c.out = records + skip;
+    c.outLen = len;
+    c.off += len;
+    return true;
+  }
+
+  if (c.bodyDone) {
+    return false;
+  }
+
+  if (c.page < c.endPage) {
+    const uint32_t batch = readBatchPages(c.page, c.endPage);
+
+    if (loadPageRecords(records, c.sync, c.page, batch)) {
+
+      // Cut the batch at the first page past the range.
+      uint32_t keep = batch;
+      if (c.hasRange) {
+        keep = 0;
+        while (keep < batch) {
+          PageFooter footer;
+          memcpy(&footer, records + keep * STREAM_RECORD_BYTES + STREAM_RECORD_BYTES -
+                            sizeof(PageFooter), sizeof(footer));
+          if (imuFooterSane(footer) && imuRangePastEnd(c.range, footer)) {
+            break;
+          }
+          keep++;
+        }
+      }
 
-    // ---- chunk: raw page data ----
-    client.printf("%X\r\n", FLASH_PAGE_SIZE);
-    client.write(g_pageBuf, FLASH_PAGE_SIZE);
-    client.print("\r\n");
+      c.page = (keep < batch) ? c.endPage : c.page + batch;
+      c.outLen = 0;
+      if (keep > 0) {
+        queueBody(c, records, keep * STREAM_RECORD_BYTES);
+      }
+      return true;
+    }
+    // Abort stream on read failure (terminate the body cleanly)
   }
 
   // Final zero-length chunk terminates the stream
-  client.print("0\r\n\r\n");
-  client.stop();
+  queueBodyEnd(c);
+  c.bodyDone = true;
+  return true;
+}
+
+// ============================================================================
+// HTTP HANDLERS
+// ============================================================================
+
+// Parse an optional IMU range from the query string:
+//   ?from_frame=A&to_frame=B   global frame IDs (inclusive)
+//   ?from_ms=A&to_ms=B         sample times (inclusive, recording clock)
+// A missing bound is open. Returns false on a malformed or mixed range.
+static bool parseImuRangeArgs(const char *query, ImuRange &range) {
+  uint32_t fromFrame = 0, toFrame = UINT32_MAX;
+  uint32_t fromMs = 0, toMs = UINT32_MAX;
+
+  // '|' so both bounds are always parsed
+  const bool frames = queryArg(query, "from_frame", fromFrame) |
+                      queryArg(query, "to_frame", toFrame);
+  const bool times = queryArg(query, "from_ms", fromMs) |
+                     queryArg(query, "to_ms", toMs);
+
+  if (frames && times) {
+    return false;
+  }
+  if (!frames && !times) {
+    imuRangeBegin(range, IMU_RANGE_ALL, 0, 0);
+    return true;
+  }
+
+  const uint32_t from = frames ? fromFrame : fromMs;
+  const uint32_t to = frames ? toFrame : toMs;
+
+  if (from > to) {
+    return false;
+  }
+
+  imuRangeBegin(range, frames ? IMU_RANGE_FRAMES : IMU_RANGE_MS, from, to);
+  return true;
+}
+
+// Incremental pull (?since_page=N[&session=S]): pages [N, watermark) of a
+// region as a chunked stream; the trailer "X-LMT-Next-Page" carries the
+// cursor for the next pull (the watermark, or where a flash read error cut
+// the stream). "X-LMT-Session" names the log the cursor points into: the
+// log epoch (bumped by erase), plus the recording session for /sync, which
+// restarts with each one. A cursor into another log (S differs, or N is past
+// the watermark) restarts at the first page with "X-LMT-Cursor-Reset: 1".
+// A cursor below 'firstPage' (pages a ring overwrote before they were pulled)
+// starts at 'firstPage'; X-LMT-Since-Page tells the client.
+static void beginSinceStream(HttpConn &c, const char *query, uint32_t since, bool sync,
+                             uint32_t firstPage, uint32_t endPage) {
+  // endPage was read first, so every page below it is covered by the mark
+  c.writerMark = writerSubmitMark();
+
+  if (sync) {
+    snprintf(c.cursorSession, sizeof(c.cursorSession), "%x-%x", (unsigned)logEpoch,
+             (unsigned)sessionID);
+  } else {
+    snprintf(c.cursorSession, sizeof(c.cursorSession), "%x", (unsigned)logEpoch);
+  }
+
+  c.cursorTrailer = true;
+  c.cursorReset = since > endPage || queryArgDiffers(query, "session", c.cursorSession);
+  if (c.cursorReset || since < firstPage) {
+    since = firstPage;
+  }
+
+  c.gz = beginGzip(c);
+  beginChunkedRecords(c, sync, since, endPage, nullptr);
+}
+
+// Stream the recorded flash log. The whole log goes out as a resumable
+// region stream (Content-Length, Range, ETag); a frame/time range query is
+// sent chunked, since its end is only found while walking the pages.
+//
+// Behavior:
+//   - Pages are streamed sequentially up to currentPage (exclusive), from
+//     the oldest page on flash (imuTailPage(): 0 unless a ring has wrapped)
+//     or from the first page of the requested range (sparse index seek); a
+//     range ends at the first page whose footer lies past it
+//   - Whole pages are sent: boundary pages may hold frames outside the
+//     range, clients trim by frame ID / time
+//   - Pages are produced HTTP_STREAM_BATCH_PAGES at a time: one flash
+//     transaction (one HTTP chunk) per batch, one batch per serviceHTTP()
+//   - "Accept-Encoding: gzip" compresses the body (not with Range)
+//   - Logging may continue concurrently: the response ends at the
+//     currentPage watermark taken at request time, and pages are read only
+//     once the writer has programmed them (no lock is taken)
+//   - CRC validity is reported in headers but not enforced
+//
+// This endpoint is intended for trusted networks and test rigs.
+static void handleFlashStream(HttpConn &c, const char *query) {
+
+  ImuRange range;
+  if (!parseImuRangeArgs(query, range)) {
+    queueText(c, "400 Bad Request", "Bad range");
+    return;
+  }
+
+  uint32_t since = 0;
+  if (queryArg(query, "since_page", since)) {
+    if (range.kind != IMU_RANGE_ALL) {
+      queueText(c, "400 Bad Request", "since_page does not combine with a range");
+      return;
+    }
+    const uint32_t endPage = currentPage;
+    beginSinceStream(c, query, since, false, imuTailPage(), endPage);
+    return;
+  }
+
+  if (range.kind == IMU_RANGE_ALL) {
+    const uint32_t endPage = currentPage;
+    const uint32_t first = imuTailPage();
+    const RegionStream src = { "lmtp", false, first, endPage - first };
+    beginRegionStream(c, src);
+    return;
+  }
+
+  // Watermark: currentPage, then the writer mark covering it. The range seek
+  // reads footers, so it waits for durability too (first fillBody()).
+  const uint32_t endPage = currentPage;
+  c.writerMark = writerSubmitMark();
+
+  c.gz = beginGzip(c);
+  beginChunkedRecords(c, false, 0, endPage, &range);
+  c.seekPending = true;
 }
 
-static void handleSyncStream() {
+static void handleSyncStream(HttpConn &c, const char *query) {
+
+  uint32_t since = 0;
+  if (queryArg(query, "since_page", since)) {
+    // An empty region is a valid (empty) increment here, not 204
+    beginSinceStream(c, query, since, true, 0, syncCurrentPage);
+    return;
+  }
 
   if (flashSyncPages == 0 || syncCurrentPage == 0) {
-    g_http->send(204, "text/plain", "No sync data");
+    beginHead(c, "204 No Content");  // no sync data
+    endHead(c);
     return;
   }
 
-  WiFiClient client = g_http->client();
+  const RegionStream src = { "lmts", true, 0, syncCurrentPage };
+  beginRegionStream(c, src);
+}
 
-  client.println("HTTP/1.1 200 OK");
-  client.println("Content-Type: application/octet-stream");
-  client.println("Transfer-Encoding: chunked");
-  client.println("Connection: close");
-  client.println();
+// Device ID endpoint (equivalent to storage slot 0)
+static void handleId(HttpConn &c) {
+  char id[32];
+  getMCUSerialString(id, sizeof(id));
+  queueText(c, "200 OK", id);
+}
 
-  for (uint32_t i = 0; i < syncCurrentPage; i++) {
+// Route a complete request held in c.req and queue its response.
+static void handleRequest(HttpConn &c) {
+  char method[8];
+  char target[160];
+  char version[10];
 
-    const uint32_t page = flashSyncBasePage + i;
-    const uint32_t addr = page * FLASH_PAGE_SIZE;
+  c.state = CONN_RESPONSE;
+  c.lastActivityMs = millis();
+  c.cursorTrailer = false;
+  c.cursorReset = false;
 
-    if (!flash.readData(addr, g_pageBuf, FLASH_PAGE_SIZE)) {
-      break;
-    }
+  if (sscanf(c.req, "%7s %159s %9s", method, target, version) != 3) {
+    c.keepAlive = false;
+    queueText(c, "400 Bad Request", "Bad request");
+    return;
+  }
+
+  // HTTP/1.1 keeps the connection unless told otherwise; 1.0 only on request.
+  char conn[24];
+  const bool hasConn = requestHeader(c, "Connection", conn, sizeof(conn));
+  if (strcmp(version, "HTTP/1.1") == 0) {
+    c.keepAlive = !(hasConn && strcasecmp(conn, "close") == 0);
+  } else {
+    c.keepAlive = hasConn && strcasecmp(conn, "keep-alive") == 0;
+  }
+
+  if (strcmp(method, "GET") != 0) {
+    queueText(c, "405 Method Not Allowed", "GET only");
+    return;
+  }
+
+  char *query = strchr(target, '?');
+  if (query) {
+    *query++ = 0;
+  } else {
+    query = target + strlen(target);
+  }
+
+  if (strcmp(target, "/imu") == 0) {
+    handleFlashStream(c, query);
+  } else if (strcmp(target, "/sync") == 0) {
+    handleSyncStream(c, query);
+  } else if (strcmp(target, "/id") == 0) {
+    handleId(c);
+  } else {
+    // Root and unknown paths
+    queueRedirect(c);
+  }
+}
 
-    SyncPageHeader hdr = {};
-    hdr.magic     = SYNC_STREAM_MAGIC;
-    hdr.pageIndex = i;
-    hdr.pageSize  = FLASH_PAGE_SIZE;
-    hdr.flags     = 0;
+// ============================================================================
+// CONNECTIONS
+// ============================================================================
+
+static void closeConn(HttpConn &c) {
+  freeGzip(c);
+  c.client.stop();
+  c.state = CONN_FREE;
+  c.outLen = 0;
+  c.body = BODY_NONE;
+}
+
+// Response sent: wait for the next request, or close.
+static void endResponse(HttpConn &c) {
+  freeGzip(c);
+  c.body = BODY_NONE;
+
+  if (!c.keepAlive) {
+    closeConn(c);
+    return;
+  }
 
-    const uint16_t footerOffset =
-      FLASH_PAGE_SIZE - sizeof(SyncPageFooter);
+  c.state = CONN_REQUEST;
+  c.reqLen = 0;
+  c.lastActivityMs = millis();
+}
 
-    SyncPageFooter footer;
-    memcpy(&footer,
-           g_pageBuf + footerOffset,
-           sizeof(SyncPageFooter));
+// Write as much of the queued output as the socket takes right now.
+// Returns bytes written, 0 if the send buffer is full, -1 on error.
+static int sendQueued(HttpConn &c) {
+  const int n = send(c.client.fd(), c.out, c.outLen, MSG_DONTWAIT);
+  if (n < 0) {
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+  }
+  c.out += n;
+  c.outLen -= n;
+  return n;
+}
 
-    if (footer.magic == SYNC_MAGIC &&
-        footer.validFrames <= SYNC_FRAMES_PER_PAGE) {
+static void acceptClients() {
+  for (HttpConn &c : g_conns) {
+    if (c.state != CONN_FREE) continue;
+    if (!g_http->hasClient()) return;
+
+    c.client = g_http->accept();
+    if (!c.client) continue;
+
+    c.client.setNoDelay(true);
+    c.state = CONN_REQUEST;
+    c.reqLen = 0;
+    c.keepAlive = true;
+    c.outLen = 0;
+    c.body = BODY_NONE;
+    c.gz = nullptr;
+    c.lastActivityMs = millis();
+  }
+}
 
-      hdr.flags |= 0x0001;
-      hdr.validFrames = footer.validFrames;
-      hdr.crc16 = footer.crc16;
+// Read request bytes (non-blocking) until the blank line ending the headers.
+static void serviceRequest(HttpConn &c) {
+  while (c.client.available() > 0) {
+    const int ch = c.client.read();
+    if (ch < 0) break;
+
+    if (c.reqLen >= HTTP_REQUEST_MAX - 1) {
+      c.state = CONN_RESPONSE;
+      c.keepAlive = false;
+      queueText(c, "431 Request Header Fields Too Large", "Request too large");
+      return;
+    }
 
-      const uint16_t usedBytes =
-        footer.validFrames * sizeof(SyncFrame);
-      const uint16_t crcLen =
-        usedBytes + offsetof(SyncPageFooter, crc16);
+    c.req[c.reqLen++] = (char)ch;
+    c.lastActivityMs = millis();
 
-      if (crc16_ccitt(g_pageBuf, crcLen) == footer.crc16) {
-        hdr.flags |= 0x0002;
+    if (c.reqLen >= 4 && memcmp(c.req + c.reqLen - 4, "\r\n\r\n", 4) == 0) {
+      c.req[c.reqLen] = 0;
+      handleRequest(c);
+      return;
+    }
+  }
+
+  if (!c.client.connected() || millis() - c.lastActivityMs > HTTP_IDLE_TIMEOUT_MS) {
+    closeConn(c);
+  }
+}
+
+// Send queued bytes and produce at most one new body batch.
+static void serviceResponse(HttpConn &c) {
+  bool filled = false;
+
+  for (;;) {
+    if (c.outLen == 0) {
+      if (filled) break;  // one batch per connection per pass
+      if (!fillBody(c)) {
+        endResponse(c);
+        return;
       }
+      filled = true;
+      continue;
     }
 
-    // ---- chunk: header ----
-    client.printf("%X\r\n", sizeof(hdr));
-    client.write((const uint8_t *)&hdr, sizeof(hdr));
-    client.print("\r\n");
+    const int n = sendQueued(c);
+    if (n < 0) {
+      closeConn(c);
+      return;
+    }
+    if (n == 0) break;  // TCP window full; try again next pass
+    c.lastActivityMs = millis();
+  }
 
-    // ---- chunk: raw page ----
-    client.printf("%X\r\n", FLASH_PAGE_SIZE);
-    client.write(g_pageBuf, FLASH_PAGE_SIZE);
-    client.print("\r\n");
+  if (millis() - c.lastActivityMs > HTTP_STALL_TIMEOUT_MS) {
+    closeConn(c);
   }
+}
 
-  client.print("0\r\n\r\n");
-  client.stop();
+// ============================================================================
+// SERVICE TASK (recording / playback)
+// ============================================================================
+
+static void httpTask(void *) {
+  for (;;) {
+    if (mode != MODE_IDLE) {
+      serviceHTTP();
+    }
+    vTaskDelay(1);
+  }
 }
 
 // ============================================================================
@@ -241,34 +1057,21 @@ bool httpStarted() {
 void startHTTP() {
   if (g_httpStarted) return;
 
-  g_http = new WebServer(HTTP_PORT);
-
-  // Binary flash dump endpoints
-  g_http->on("/imu", HTTP_GET, handleFlashStream);
-  g_http->on("/sync", HTTP_GET, handleSyncStream);
-
-  // Root redirect
-  g_http->on("/", HTTP_GET, handleRootRedirect);
-
-  // Device ID endpoint (equivalent to storage slot 0)
-  g_http->on("/id", HTTP_GET, []() {
-    char id[32];
-    getMCUSerialString(id, sizeof(id));
+  g_http = new WiFiServer(HTTP_PORT, HTTP_MAX_CLIENTS);
+  g_http->setNoDelay(true);
+  g_http->begin();
 
-    g_http->send(
-      200,
-      "text/plain",
-      id);
-  });
+  for (HttpConn &c : g_conns) {
+    c.state = CONN_FREE;
+    c.gz = nullptr;
+  }
 
-  // Catch-all redirect for unknown paths
-  g_http->onNotFound([]() {
-    g_http->sendHeader("Location", "https://tracedynamics.ai", true);
-    g_http->send(302, "text/plain", "Redirecting to Trace Dynamics");
-  });
+  if (!g_httpLock) {
+    g_httpLock = xSemaphoreCreateMutex();
+  }
 
-  g_http->begin();
   g_httpStarted = true;
+  xTaskCreate(httpTask, "http", HTTP_TASK_STACK, nullptr, HTTP_TASK_PRIO, &g_httpTask);
 
   Serial.println("# HTTP: flash streaming enabled");
 }
@@ -277,18 +1080,46 @@ void startHTTP() {
 void stopHTTP() {
   if (!g_httpStarted) return;
 
+  // Wait out a pass in progress on the task, then remove the task.
+  xSemaphoreTake(g_httpLock, portMAX_DELAY);
+  if (g_httpTask) {
+    vTaskDelete(g_httpTask);
+    g_httpTask = nullptr;
+  }
+
+  for (HttpConn &c : g_conns) {
+    if (c.state != CONN_FREE) {
+      closeConn(c);
+    }
+  }
+
   g_http->stop();
   delete g_http;
   g_http = nullptr;
 
   g_httpStarted = false;
+  xSemaphoreGive(g_httpLock);
   Serial.println("# HTTP: stopped");
 }
 
-// Service HTTP client requests.
+// Service HTTP connections.
 //
-// Must be called periodically from loop() while HTTP is active.
+// Called periodically from loop() in idle mode and from the service task
+// otherwise. Never blocks on a client; each connection gets at most one flash
+// batch per call. A call while the other context is mid-pass returns at once.
 void serviceHTTP() {
   if (!g_httpStarted || !g_http) return;
-  g_http->handleClient();
-}
\ No newline at end of file
+  if (xSemaphoreTake(g_httpLock, 0) != pdTRUE) return;
+
+  acceptClients();
+
+  for (HttpConn &c : g_conns) {
+    switch (c.state) {
+      case CONN_REQUEST:  serviceRequest(c);  break;
+      case CONN_RESPONSE: serviceResponse(c); break;
+      default: break;
+    }
+  }
+
+  xSemaphoreGive(g_httpLock);
+}
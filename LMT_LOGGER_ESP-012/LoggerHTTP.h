@@ -1,13 +1,24 @@
 #pragma once
 #include <Arduino.h>
 
+#include "LoggerFormat.h"
+
 // HTTP flash export server (Wi-Fi required)
 
 bool httpStarted();
 
 void startHTTP();     // start HTTP server (safe to call repeatedly)
 void stopHTTP();      // stop HTTP server
-void serviceHTTP();   // call from loop() when OTA is enabled
+void serviceHTTP();   // call from loop() when OTA is enabled; never blocks
+
+// Stream records (StreamPageHeader + raw page, built by imuStreamHeader() /
+// syncStreamHeader() in LoggerFormat): the same record stream is sent by
+// /imu, /sync and the BLE bulk offload.
+
+// Load pages [page, page + count) of the IMU log (logical pages, see
+// readImuPages()) or of the sync region into 'records' as
+// count x STREAM_RECORD_BYTES; one flash read (two where a ring wraps).
+bool loadPageRecords(uint8_t *records, bool sync, uint32_t page, uint32_t count);
 
 // =============================================================================
 // HTTP API — Motion Logger (OTA / External Power Only)
@@ -19,6 +30,10 @@ void serviceHTTP();   // call from loop() when OTA is enabled
 //
 // The HTTP server is started and stopped automatically alongside OTA.
 //
+// Up to 3 clients are served at once, with HTTP/1.1 keep-alive. Downloads
+// advance one 16-page batch per connection per serviceHTTP() call using
+// non-blocking sends, so loop() (OTA, CLI, BLE) keeps running meanwhile.
+//
 // -----------------------------------------------------------------------------
 // Endpoints
 // -----------------------------------------------------------------------------
@@ -37,28 +52,63 @@ void serviceHTTP();   // call from loop() when OTA is enabled
 //
 // -----------------------------------------------------------------------------
 //
-// GET /flash
-//   Streams the entire recorded motion log as a binary, chunked HTTP response.
+// GET /imu   (GET /sync: same framing, 'LMTS' headers, sync region)
+//   Streams the entire recorded motion log as a binary HTTP response.
 //   Data is emitted sequentially, page-by-page, without buffering the full log
 //   in RAM.
 //
 //   Each page is preceded by a 16-byte FlashPageHeader structure, followed by
 //   exactly FLASH_PAGE_SIZE (256) bytes of raw flash page data.
 //
-//   Transfer encoding:
+//   Whole log (no query):
 //     Content-Type: application/octet-stream
-//     Transfer-Encoding: chunked
+//     Content-Length: pages x 272
+//     ETag: "lmtp-<sessionID>-<first page>-<pages>" (hex)
+//     Accept-Ranges: bytes, pages
+//   A single Range (bytes=a-b | a- | -n, or pages=a-b | a- | -n) gets 206 with
+//   Content-Range; If-Range is honored when it names this session and first
+//   page at a size <= the current one (the log only appends, so that prefix
+//   is unchanged; a ring moving its tail changes the first page).
+//   Multipart ranges are ignored (200); ranges past the end get 416.
+//
+//   Range query (?from_frame / ?from_ms, see documentation.md):
+//     Transfer-Encoding: chunked (length not known up front)
+//
+//   Incremental pull (?since_page=N[&session=S], not combined with a range
+//   query):
+//     Transfer-Encoding: chunked, pages [N, currentPage)
+//     X-LMT-Since-Page: <first page sent>
+//     X-LMT-Session: <log the cursor points into> (hex logEpoch for /imu,
+//       "<logEpoch>-<sessionID>" for /sync, which restarts per session)
+//     Trailer: X-LMT-Next-Page, sent after the last chunk as
+//       X-LMT-Next-Page: <cursor for the next pull>
+//     S not this log's session, or N past the log (erased since the last
+//     pull): restarts at the first page with X-LMT-Cursor-Reset: 1. Without
+//     S, a log erased and re-recorded past N goes unnoticed; clients should
+//     send the X-LMT-Session of their last pull. N below imuTailPage() (a ring
+//     overwrote those pages before they were pulled): starts at the tail,
+//     X-LMT-Since-Page says where. N at the end: empty body (also for /sync).
+//     tools/lmt_pull keeps one cursor per device and stream.
+//
+//   Accept-Encoding: gzip (without Range):
+//     Content-Encoding: gzip, Transfer-Encoding: chunked, no ETag
+//     Range requests are always answered uncompressed.
 //
 //   FlashPageHeader (16 bytes, little-endian):
 //     uint32_t magic        // ASCII "LMTP" (0x4C4D5450)
-//     uint32_t pageIndex    // Sequential page number
+//     uint32_t pageIndex    // Sequential (logical) page number
 //     uint16_t pageSize     // Always FLASH_PAGE_SIZE (256)
 //     uint16_t validFrames  // Frame count from PageFooter (if present)
 //     uint16_t crc16        // PageFooter CRC (if present)
-//     uint16_t flags        // bit0: footer valid, bit1: CRC valid
+//     uint16_t flags        // bit0: footer valid, bit1: CRC valid,
+//                           // bit2: delta-encoded page (PAGE_MAGIC_DELTA)
+//                           // bits8-15: PageFooter.layout (FRAME_LAYOUT_*)
 //
 //   Notes:
-//     - Pages are streamed from page 0 up to currentPage (exclusive).
+//     - Pages are streamed oldest to newest: from page 0 (ring mode: the
+//       oldest page still on flash) up to currentPage (exclusive).
+//     - A download the recorder laps in ring mode ends early, as on a read
+//       error.
 //     - CRC validation is reported but not enforced.
 //     - No authentication is currently applied.
 //     - Intended for trusted networks / test rigs.
@@ -68,8 +118,11 @@ void serviceHTTP();   // call from loop() when OTA is enabled
 // -----------------------------------------------------------------------------
 //
 // - HTTP is only active while OTA is enabled.
-// - Logging continues uninterrupted while streaming.
-// - Clients should consume the stream incrementally.
+// - Logging continues uninterrupted while streaming, and exports work while
+//   recording: a low-priority task serves HTTP outside idle mode. Each
+//   response is a snapshot up to the page count at request time.
+// - Clients should consume the stream incrementally; a response that makes
+//   no progress for 30 s is dropped, an idle keep-alive connection after 10 s.
 // - The API is stable and version-independent at the binary level.
 //
 // =============================================================================
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "LoggerOutput.h"
+
+#include "LoggerCore.h"
+
+// ============================================================================
+// INTERNAL STATE
+// ============================================================================
+
+struct OutputSink {
+  const char *name;
+  OutputOpenFn open;
+  OutputWriteFn write;
+  OutputHasRoomFn hasRoom;
+  uint32_t bytes;
+  uint32_t dropped;
+};
+
+static OutputSink g_sinks[OUTPUT_MAX_SINKS];
+static uint8_t g_sinkCount = 0;
+
+// Held for a whole render, so output from loop() and the BLE task never
+// interleaves mid-message. nullptr until startOutput() (boot is
+// single-threaded until then).
+static SemaphoreHandle_t g_outLock = nullptr;
+
+// ============================================================================
+// ARENA
+// ============================================================================
+//
+// The Stream handed to render functions. Bytes collect in a static buffer
+// that is fanned out when full and at the end of the render.
+
+static void fanOut(const uint8_t *buf, size_t len);
+
+// Arena flushes go to every open sink, or only to g_target when set.
+static int8_t g_target = -1;
+
+class OutputArena : public Stream {
+public:
+  int available() override {
+    return 0;
+  }
+  int read() override {
+    return -1;
+  }
+  int peek() override {
+    return -1;
+  }
+
+  size_t write(uint8_t c) override {
+    if (len == sizeof(buf)) {
+      flush();
+    }
+    buf[len++] = c;
+    return 1;
+  }
+
+  size_t write(const uint8_t *data, size_t n) override {
+    const size_t total = n;
+    while (n > 0) {
+      if (len == sizeof(buf)) {
+        flush();
+      }
+      size_t take = sizeof(buf) - len;
+      if (take > n) {
+        take = n;
+      }
+      memcpy(buf + len, data, take);
+      len += take;
+      data += take;
+      n -= take;
+    }
+    return total;
+  }
+
+  void flush() override {
+    if (len > 0) {
+      fanOut(buf, len);
+      len = 0;
+    }
+  }
+
+private:
+  uint8_t buf[OUTPUT_ARENA_BYTES];
+  size_t len = 0;
+};
+
+static OutputArena g_arena;
+
+// ============================================================================
+// BUILT-IN SINKS
+// ============================================================================
+
+// USB CDC: skipped without a host, so writes never wait on the driver's
+// TX timeout.
+static bool usbSinkOpen() {
+  return (bool)Serial;
+}
+
+static size_t usbSinkWrite(const uint8_t *buf, size_t len) {
+  return Serial.write(buf, len);
+}
+
+static bool usbSinkHasRoom(size_t len) {
+  return (size_t)Serial.availableForWrite() >= len;
+}
+
+// The BLE TX ring takes a write whole or drops it (and counts the drop).
+static size_t bleSinkWrite(const uint8_t *buf, size_t len) {
+  return bleWrite(buf, len) ? len : 0;
+}
+
+// ============================================================================
+// FAN-OUT
+// ============================================================================
+
+static void lockOutput() {
+  if (g_outLock) {
+    xSemaphoreTake(g_outLock, portMAX_DELAY);
+  }
+}
+
+static void unlockOutput() {
+  if (g_outLock) {
+    xSemaphoreGive(g_outLock);
+  }
+}
+
+static bool sinkOpen(const OutputSink &s) {
+  return !s.open || s.open();
+}
+
+static void sinkWrite(OutputSink &s, const uint8_t *buf, size_t len) {
+  const size_t taken = s.write(buf, len);
+  s.bytes += taken;
+  s.dropped += len - taken;
+}
+
+// A page dump (bdump) owns USB: its records are framed binary, so broadcast
+// text (events, replies to BLE commands, prompts) must not land between them.
+static bool sinkReserved(uint8_t index) {
+  return index == OUTPUT_SINK_USB && mode == MODE_PLAYBACK &&
+         playbackFormat == PLAYBACK_PAGES;
+}
+
+static void fanOut(const uint8_t *buf, size_t len) {
+  if (g_target >= 0) {
+    sinkWrite(g_sinks[g_target], buf, len);
+    return;
+  }
+
+  for (uint8_t i = 0; i < g_sinkCount; i++) {
+    if (sinkOpen(g_sinks[i]) && !sinkReserved(i)) {
+      sinkWrite(g_sinks[i], buf, len);
+    }
+  }
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+void startOutput() {
+  if (g_outLock) return;
+
+  g_outLock = xSemaphoreCreateMutex();
+
+  outputAddSink("USB", usbSinkOpen, usbSinkWrite, usbSinkHasRoom);
+  outputAddSink("BLE", bleConnected, bleSinkWrite, bleTxHasRoom);
+}
+
+int outputAddSink(const char *name, OutputOpenFn open, OutputWriteFn write,
+                  OutputHasRoomFn hasRoom) {
+  lockOutput();
+
+  int index = -1;
+  if (g_sinkCount < OUTPUT_MAX_SINKS) {
+    index = g_sinkCount;
+    g_sinks[index] = { name, open, write, hasRoom, 0, 0 };
+    g_sinkCount++;
+  }
+
+  unlockOutput();
+  return index;
+}
+
+void outputRender(void (*fn)(Stream &)) {
+  lockOutput();
+  fn(g_arena);
+  g_arena.flush();
+  unlockOutput();
+}
+
+void outputWrite(const uint8_t *buf, size_t len) {
+  lockOutput();
+  fanOut(buf, len);
+  unlockOutput();
+}
+
+void outputLine(const char *s) {
+  lockOutput();
+  g_arena.write((const uint8_t *)s, strlen(s));
+  g_arena.write((const uint8_t *)"\r\n", 2);
+  g_arena.flush();
+  unlockOutput();
+}
+
+bool outputSinkOpen(uint8_t index) {
+  return index < g_sinkCount && sinkOpen(g_sinks[index]);
+}
+
+bool outputSinkHasRoom(uint8_t index, size_t len) {
+  if (!outputSinkOpen(index)) {
+    return false;
+  }
+  const OutputSink &s = g_sinks[index];
+  return !s.hasRoom || s.hasRoom(len);
+}
+
+void outputWriteTo(uint8_t index, const uint8_t *buf, size_t len) {
+  if (index >= g_sinkCount) return;
+
+  lockOutput();
+  sinkWrite(g_sinks[index], buf, len);
+  unlockOutput();
+}
+
+void outputLineTo(uint8_t index, const char *s) {
+  if (index >= g_sinkCount) return;
+
+  lockOutput();
+  g_target = index;
+  g_arena.write((const uint8_t *)s, strlen(s));
+  g_arena.write((const uint8_t *)"\r\n", 2);
+  g_arena.flush();
+  g_target = -1;
+  unlockOutput();
+}
+
+uint8_t outputSinkCount() {
+  return g_sinkCount;
+}
+
+bool getOutputSinkStats(uint8_t index, OutputSinkStats &out) {
+  if (index >= g_sinkCount) {
+    return false;
+  }
+
+  const OutputSink &s = g_sinks[index];
+  out.name = s.name;
+  out.open = sinkOpen(s);
+  out.bytes = s.bytes;
+  out.dropped = s.dropped;
+  return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ============================================================================
+// LOGGER OUTPUT PLANE (single render, multi-sink fan-out)
+// ============================================================================
+//
+// Carries all human-readable and streaming output (control, event, live
+// frames, playback) to every attached transport.
+//
+// Responsibilities:
+//   - Renders each message exactly once, into a fixed static arena
+//   - Fans the rendered bytes out to a fixed table of sinks (USB CDC, BLE
+//     UART, and up to OUTPUT_MAX_SINKS in total for later network sinks)
+//   - Serializes producers (loop() and the BLE task both emit)
+//   - Counts bytes and short writes per sink
+//   - Per-sink writes and a room query, so a producer can pace each
+//     transport on its own (playback keeps one cursor per sink)
+//
+// Non-responsibilities:
+//   - No queueing of its own: each sink's write must not block for long and
+//     queues in its transport (USB CDC driver TX buffer, BLE TX ring)
+//   - No formatting policy (callers render with Print / snprintf)
+//
+// Design notes:
+//   - No heap: the arena is static, so there is no per-message String and no
+//     fragmentation
+//   - A render larger than the arena is flushed in OUTPUT_ARENA_BYTES pieces;
+//     every sink sees the same bytes in the same order
+//   - Lines end in "\r\n" on every sink (what Print::println() emits)
+//   - Sinks that are not open (USB without a host, BLE without a client)
+//     are skipped
+//   - While a page dump (bdump) runs, broadcast output skips USB; only the
+//     dump's own per-sink writes reach it
+//
+
+#define OUTPUT_ARENA_BYTES 512
+#define OUTPUT_MAX_SINKS   4
+
+// Built-in sink indices (registered by startOutput())
+#define OUTPUT_SINK_USB 0
+#define OUTPUT_SINK_BLE 1
+
+// Accept up to 'len' bytes; returns the count taken (short = dropped).
+typedef size_t (*OutputWriteFn)(const uint8_t *buf, size_t len);
+
+// Whether the sink currently wants output; nullptr = always.
+typedef bool (*OutputOpenFn)();
+
+// Whether 'len' bytes can be written now without blocking or dropping;
+// nullptr = always.
+typedef bool (*OutputHasRoomFn)(size_t len);
+
+struct OutputSinkStats {
+  const char *name;
+  bool open;
+  uint32_t bytes;     // bytes taken by the sink
+  uint32_t dropped;   // bytes the sink refused
+};
+
+// Create the lock and register the USB CDC and BLE UART sinks. Call once,
+// right after Serial.begin(); safe to call repeatedly.
+void startOutput();
+
+// Register another sink. Returns its index, or -1 if the table is full.
+int outputAddSink(const char *name, OutputOpenFn open, OutputWriteFn write,
+                  OutputHasRoomFn hasRoom = nullptr);
+
+// Render 'fn' once and send the result to every open sink.
+void outputRender(void (*fn)(Stream &));
+
+// Send raw bytes (binary frames) to every open sink.
+void outputWrite(const uint8_t *buf, size_t len);
+
+// Send 's' plus "\r\n" to every open sink, as one write per sink.
+void outputLine(const char *s);
+
+// Single-sink variants (index from 0 to outputSinkCount() - 1).
+bool outputSinkOpen(uint8_t index);
+bool outputSinkHasRoom(uint8_t index, size_t len);
+void outputWriteTo(uint8_t index, const uint8_t *buf, size_t len);
+void outputLineTo(uint8_t index, const char *s);
+
+uint8_t outputSinkCount();
+bool getOutputSinkStats(uint8_t index, OutputSinkStats &out);
@@ -0,0 +1,622 @@
+#include "LoggerStorage.h"
+
+#include "LoggerCore.h"
+
+#include <new>
+
+// ============================================================================
+// CONFIG
+// ============================================================================
+
+#define STORAGE_SECTORS (STORAGE_SLOT_LIMIT * FLASH_PAGE_SIZE / FLASH_SECTOR_SIZE)
+#define STORAGE_ALIGN   16
+
+static_assert((STORAGE_SLOT_LIMIT * FLASH_PAGE_SIZE) % FLASH_SECTOR_SIZE == 0,
+              "storage region must be whole sectors");
+
+// Record written once the region is in this format (formatted or migrated);
+// its absence at boot means the old fixed-slot layout is still present.
+#define STORAGE_KEY_FORMAT STORAGE_SLOT_LIMIT
+
+#define STORAGE_MAX_RECORD (sizeof(StorageRecord) + FLASH_PAGE_SIZE)
+
+// Free sectors kept for reclaim's copies (one more than a reclaim uses, so
+// one is still there after a power loss mid-reclaim)
+#define STORAGE_SPARE_SECTORS 2
+
+// liveBytes limit: the spares, the partly filled head, and each sector may
+// waste up to one record at its end.
+#define STORAGE_CAPACITY                           \
+  ((STORAGE_SECTORS - STORAGE_SPARE_SECTORS - 1) * \
+   (FLASH_SECTOR_SIZE - sizeof(StorageSectorHeader) - STORAGE_MAX_RECORD))
+
+// Record locations in the index: sector * (FLASH_SECTOR_SIZE / 16) + offset / 16
+#define STORAGE_NO_RECORD 0xFFFF
+
+// Sector states in g_sectorSeq (anything else is the sequence of a sector in use)
+#define SECTOR_FREE  0UL           // erased
+#define SECTOR_DIRTY 0xFFFFFFFFUL  // not in this format: erase before use
+
+// ============================================================================
+// INTERNAL STATE
+// ============================================================================
+
+static uint16_t g_index[STORAGE_SLOT_LIMIT + 1];      // slot -> record location
+static uint16_t g_recordBytes[STORAGE_SLOT_LIMIT + 1];
+
+static uint32_t g_sectorSeq[STORAGE_SECTORS];
+static int8_t g_head = -1;       // sector taking appends
+static uint16_t g_headOff = 0;   // next record offset in g_head
+static uint32_t g_nextSeq = 1;
+
+static bool g_mounted = false;
+static bool g_formatted = false;  // STORAGE_KEY_FORMAT present: dirty sectors may be erased
+static bool g_copying = false;    // reclaim/migration copies: may take the spares
+
+alignas(4) static uint8_t g_recBuf[STORAGE_MAX_RECORD];
+alignas(4) static uint8_t g_valueBuf[FLASH_PAGE_SIZE];  // write compare, migration
+alignas(4) static uint8_t g_moveBuf[FLASH_PAGE_SIZE];   // reclaim copies
+
+static StorageStats g_stats = {};
+
+// Serializes the CLI (loop() / BLE task) and readers on the HTTP/OTA side.
+static SemaphoreHandle_t g_storeLock = nullptr;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static uint32_t sectorAddr(uint8_t sector) {
+  return flashStorageBasePage * FLASH_PAGE_SIZE + (uint32_t)sector * FLASH_SECTOR_SIZE;
+}
+
+static uint16_t recordLoc(uint8_t sector, uint16_t off) {
+  return (uint16_t)(sector * (FLASH_SECTOR_SIZE / STORAGE_ALIGN) + off / STORAGE_ALIGN);
+}
+
+static uint32_t locAddr(uint16_t loc) {
+  return flashStorageBasePage * FLASH_PAGE_SIZE + (uint32_t)loc * STORAGE_ALIGN;
+}
+
+static uint16_t recordBytes(uint16_t len) {
+  return sizeof(StorageRecord) + ((len + STORAGE_ALIGN - 1) & ~(STORAGE_ALIGN - 1));
+}
+
+static bool sectorInUse(uint8_t s) {
+  return g_sectorSeq[s] != SECTOR_FREE && g_sectorSeq[s] != SECTOR_DIRTY;
+}
+
+// Program across page boundaries (a page program must not wrap).
+static bool programBytes(uint32_t addr, const uint8_t *buf, uint32_t len) {
+  while (len > 0) {
+    uint32_t n = FLASH_PAGE_SIZE - (addr % FLASH_PAGE_SIZE);
+    if (n > len) n = len;
+
+    if (!flash.writePage(addr, buf, (uint16_t)n)) {
+      return false;
+    }
+    addr += n;
+    buf += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool eraseStorageSector(uint8_t s) {
+  g_stats.erases++;
+  if (!flash.eraseSector(sectorAddr(s))) {
+    g_sectorSeq[s] = SECTOR_DIRTY;
+    return false;
+  }
+  g_sectorSeq[s] = SECTOR_FREE;
+  return true;
+}
+
+static uint32_t recordCrc(const StorageRecord &r, const uint8_t *payload) {
+  const uint32_t crc = crc32_ieee_update(0, (const uint8_t *)&r, offsetof(StorageRecord, crc32));
+  return crc32_ieee_update(crc, payload, r.len);
+}
+
+static uint32_t sectorHeaderCrc(const StorageSectorHeader &h) {
+  return crc32_ieee_update(0, (const uint8_t *)&h, offsetof(StorageSectorHeader, crc32));
+}
+
+static bool headerPlausible(const StorageRecord &r) {
+  return r.magic == STORAGE_RECORD_MAGIC && r.key <= STORAGE_KEY_FORMAT &&
+         r.len <= FLASH_PAGE_SIZE;
+}
+
+// Read and check the record at 'addr'; the payload lands in g_recBuf after
+// the header.
+static bool readRecord(uint32_t addr, StorageRecord &r) {
+  if (!flash.readData(addr, (uint8_t *)&r, sizeof(r)) || !headerPlausible(r)) {
+    return false;
+  }
+
+  uint8_t *payload = g_recBuf + sizeof(StorageRecord);
+  if (r.len > 0 && !flash.readData(addr + sizeof(r), payload, r.len)) {
+    return false;
+  }
+  return recordCrc(r, payload) == r.crc32;
+}
+
+static bool rangeErased(uint32_t addr, uint32_t len);
+
+// Find the next valid record at or after 'off' in sector 's'. Bytes that do
+// not parse (a record torn by power loss) are skipped 16 at a time. Returns
+// false past the last record, with 'off' at the append position
+// (FLASH_SECTOR_SIZE when the sector has no erased tail).
+static bool nextRecord(uint8_t s, uint16_t &off, StorageRecord &r) {
+  while (off + sizeof(StorageRecord) <= FLASH_SECTOR_SIZE) {
+    if (readRecord(sectorAddr(s) + off, r)) {
+      return true;
+    }
+    if (rangeErased(sectorAddr(s) + off, FLASH_SECTOR_SIZE - off)) {
+      return false;
+    }
+    off += STORAGE_ALIGN;
+  }
+
+  off = FLASH_SECTOR_SIZE;
+  return false;
+}
+
+static void expandValue(const StorageRecord &r, const uint8_t *payload, uint8_t *out256) {
+  memcpy(out256, payload, r.len);
+  memset(out256 + r.len, r.fill, FLASH_PAGE_SIZE - r.len);
+}
+
+static bool rangeErased(uint32_t addr, uint32_t len) {
+  while (len > 0) {
+    const uint32_t n = len < FLASH_PAGE_SIZE ? len : FLASH_PAGE_SIZE;
+    if (!flash.readData(addr, g_valueBuf, n)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      if (g_valueBuf[i] != 0xFF) return false;
+    }
+    addr += n;
+    len -= n;
+  }
+  return true;
+}
+
+static void indexRecord(uint16_t key, uint16_t loc, uint16_t bytes) {
+  if (g_index[key] == STORAGE_NO_RECORD) {
+    if (key < STORAGE_KEY_FORMAT) g_stats.slots++;
+  } else {
+    g_stats.liveBytes -= g_recordBytes[key];
+  }
+  g_index[key] = loc;
+  g_recordBytes[key] = bytes;
+  g_stats.liveBytes += bytes;
+}
+
+// ============================================================================
+// APPEND + RECLAIM
+// ============================================================================
+
+static uint8_t freeSectors() {
+  uint8_t n = 0;
+  for (uint8_t s = 0; s < STORAGE_SECTORS; s++) {
+    if (g_sectorSeq[s] == SECTOR_FREE || (g_formatted && g_sectorSeq[s] == SECTOR_DIRTY)) {
+      n++;
+    }
+  }
+  return n;
+}
+
+// Start a new head sector: the next usable one after the current head, so
+// sectors are taken in rotation.
+static bool openSector() {
+  const uint8_t start = g_head < 0 ? 0 : (uint8_t)(g_head + 1);
+
+  for (uint8_t i = 0; i < STORAGE_SECTORS; i++) {
+    const uint8_t s = (start + i) % STORAGE_SECTORS;
+
+    if (g_sectorSeq[s] == SECTOR_DIRTY) {
+      if (!g_formatted || !eraseStorageSector(s)) continue;
+    }
+    if (g_sectorSeq[s] != SECTOR_FREE) continue;
+
+    StorageSectorHeader h;
+    h.magic = STORAGE_SECTOR_MAGIC;
+    h.seq = g_nextSeq;
+    h.reserved = 0xFFFFFFFFUL;
+    h.crc32 = sectorHeaderCrc(h);
+
+    if (!programBytes(sectorAddr(s), (const uint8_t *)&h, sizeof(h))) {
+      g_sectorSeq[s] = SECTOR_DIRTY;
+      continue;
+    }
+
+    g_sectorSeq[s] = g_nextSeq++;
+    g_head = (int8_t)s;
+    g_headOff = sizeof(StorageSectorHeader);
+    return true;
+  }
+
+  return false;
+}
+
+static bool reclaimSector();
+
+static bool ensureRoom(uint16_t bytes) {
+  for (uint8_t tries = 0; tries <= 2 * STORAGE_SECTORS; tries++) {
+    if (g_head >= 0 && g_headOff + bytes <= FLASH_SECTOR_SIZE) {
+      return true;
+    }
+
+    if (freeSectors() > (g_copying ? 0 : STORAGE_SPARE_SECTORS)) {
+      if (!openSector()) return false;
+      continue;
+    }
+
+    if (g_copying || !reclaimSector()) {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Append 'key' = value (256 bytes; nullptr = empty record).
+static bool appendRecord(uint16_t key, const uint8_t *value) {
+  StorageRecord r;
+  r.magic = STORAGE_RECORD_MAGIC;
+  r.key = key;
+  r.len = 0;
+  r.fill = 0xFF;
+  memset(r.reserved, 0xFF, sizeof(r.reserved));
+
+  if (value) {
+    r.fill = value[FLASH_PAGE_SIZE - 1];
+    r.len = FLASH_PAGE_SIZE;
+    while (r.len > 0 && value[r.len - 1] == r.fill) {
+      r.len--;
+    }
+  }
+
+  const uint16_t bytes = recordBytes(r.len);
+  if (!ensureRoom(bytes)) {
+    return false;
+  }
+
+  uint8_t *payload = g_recBuf + sizeof(StorageRecord);
+  if (r.len > 0) {
+    memcpy(payload, value, r.len);
+  }
+  memset(payload + r.len, 0xFF, bytes - sizeof(StorageRecord) - r.len);
+  r.crc32 = recordCrc(r, payload);
+  memcpy(g_recBuf, &r, sizeof(r));
+
+  // Header first (programBytes goes front to back)
+  const uint16_t loc = recordLoc((uint8_t)g_head, g_headOff);
+  if (!programBytes(locAddr(loc), g_recBuf, bytes)) {
+    g_headOff += bytes;  // may be partly programmed: skip it
+    return false;
+  }
+
+  g_headOff += bytes;
+  g_stats.writes++;
+  indexRecord(key, loc, bytes);
+  return true;
+}
+
+static uint32_t sectorLiveBytes(uint8_t s) {
+  uint32_t live = 0;
+  uint16_t off = sizeof(StorageSectorHeader);
+  StorageRecord r;
+
+  while (nextRecord(s, off, r)) {
+    if (g_index[r.key] == recordLoc(s, off)) {
+      live += recordBytes(r.len);
+    }
+    off += recordBytes(r.len);
+  }
+  return live;
+}
+
+// Copy the live records of one sector to the head, then erase it.
+//
+// With the spares intact the oldest sector goes (rotation keeps wear even,
+// static values included). A power loss mid-reclaim costs a spare; until
+// they are back, the sector with the fewest live bytes goes, preferably
+// one whose records fit the rest of the head so no spare is touched.
+static bool reclaimSector() {
+  const uint8_t spares = freeSectors();
+  const uint32_t headRoom = g_head < 0 ? 0 : FLASH_SECTOR_SIZE - g_headOff;
+
+  int8_t victim = -1;
+  uint32_t victimLive = 0;
+  bool victimFits = false;
+
+  for (uint8_t s = 0; s < STORAGE_SECTORS; s++) {
+    if (!sectorInUse(s) || s == g_head) continue;
+
+    if (spares >= STORAGE_SPARE_SECTORS) {
+      if (victim < 0 || g_sectorSeq[s] < g_sectorSeq[victim]) victim = (int8_t)s;
+      continue;
+    }
+
+    const uint32_t live = sectorLiveBytes(s);
+    const bool fits = live <= headRoom;
+    if (!fits && spares == 0) continue;
+
+    if (victim < 0 || (fits && !victimFits) || (fits == victimFits && live < victimLive)) {
+      victim = (int8_t)s;
+      victimLive = live;
+      victimFits = fits;
+    }
+  }
+  if (victim < 0) {
+    return false;
+  }
+
+  g_copying = true;
+
+  bool ok = true;
+  uint16_t off = sizeof(StorageSectorHeader);
+  StorageRecord r;
+
+  while (ok && nextRecord((uint8_t)victim, off, r)) {
+    if (g_index[r.key] == recordLoc((uint8_t)victim, off)) {
+      expandValue(r, g_recBuf + sizeof(StorageRecord), g_moveBuf);
+      ok = appendRecord(r.key, r.key == STORAGE_KEY_FORMAT ? nullptr : g_moveBuf);
+    }
+    off += recordBytes(r.len);
+  }
+
+  g_copying = false;
+
+  if (!ok) {
+    return false;
+  }
+
+  g_stats.reclaims++;
+  eraseStorageSector((uint8_t)victim);
+  return true;
+}
+
+// ============================================================================
+// MOUNT
+// ============================================================================
+
+// Index one sector's records; returns its append position.
+static uint16_t scanSector(uint8_t s) {
+  uint16_t off = sizeof(StorageSectorHeader);
+  StorageRecord r;
+
+  while (nextRecord(s, off, r)) {
+    indexRecord(r.key, recordLoc(s, off), recordBytes(r.len));
+    off += recordBytes(r.len);
+  }
+  return off;
+}
+
+// Old layout: slot N was the raw page N of the region.
+//
+// Written pages are copied into records, then the format record is
+// appended; old sectors are erased only after that, so an interrupted
+// migration simply runs again. Only when no sector is blank (every old
+// sector holds a written slot) is one sector staged in RAM, erased and
+// rewritten in place: the same exposure as the old layout had on every
+// write, once.
+
+// A page left by a format interrupted before its first record: a partly
+// programmed sector or record header (programming only clears bits), rest
+// erased. Not a slot value.
+static bool formatDebris(const uint8_t *page) {
+  uint32_t word;
+  memcpy(&word, page, sizeof(word));
+  if ((word & STORAGE_SECTOR_MAGIC) != STORAGE_SECTOR_MAGIC &&
+      (word & STORAGE_RECORD_MAGIC) != STORAGE_RECORD_MAGIC) {
+    return false;
+  }
+  for (uint16_t i = 2 * sizeof(StorageRecord); i < FLASH_PAGE_SIZE; i++) {
+    if (page[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+static bool migrateSector(uint8_t s) {
+  const uint16_t pagesPerSector = FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE;
+
+  uint8_t *staged = nullptr;
+  if (freeSectors() == 0) {
+    staged = new (std::nothrow) uint8_t[FLASH_SECTOR_SIZE];
+    if (!staged || !flash.readData(sectorAddr(s), staged, FLASH_SECTOR_SIZE) ||
+        !eraseStorageSector(s)) {
+      delete[] staged;
+      return false;
+    }
+  }
+
+  bool ok = true;
+  for (uint16_t p = 0; ok && p < pagesPerSector; p++) {
+    const uint8_t *page = g_valueBuf;
+    if (staged) {
+      page = staged + p * FLASH_PAGE_SIZE;
+    } else if (!flash.readData(sectorAddr(s) + p * FLASH_PAGE_SIZE, g_valueBuf, FLASH_PAGE_SIZE)) {
+      ok = false;
+      break;
+    }
+
+    bool blank = true;
+    for (uint16_t i = 0; i < FLASH_PAGE_SIZE && blank; i++) {
+      blank = page[i] == 0xFF;
+    }
+    if (blank || formatDebris(page)) continue;
+
+    ok = appendRecord(s * pagesPerSector + p, page);
+  }
+
+  delete[] staged;
+  return ok;
+}
+
+static bool migrateFixedSlots() {
+  g_copying = true;
+
+  bool ok = true;
+  for (uint8_t s = 0; ok && s < STORAGE_SECTORS; s++) {
+    if (g_sectorSeq[s] == SECTOR_DIRTY) {
+      ok = migrateSector(s);
+    }
+  }
+  ok = ok && appendRecord(STORAGE_KEY_FORMAT, nullptr);
+
+  g_copying = false;
+  return ok;
+}
+
+bool startStorage() {
+  if (!g_storeLock) {
+    g_storeLock = xSemaphoreCreateMutex();
+  }
+
+  g_mounted = false;
+  g_formatted = false;
+  g_copying = false;
+  g_head = -1;
+  g_headOff = 0;
+  g_nextSeq = 1;
+  g_stats = {};
+  g_stats.sectors = STORAGE_SECTORS;
+  g_stats.capacityBytes = STORAGE_CAPACITY;
+
+  for (uint16_t k = 0; k <= STORAGE_KEY_FORMAT; k++) {
+    g_index[k] = STORAGE_NO_RECORD;
+  }
+
+  if (!flashPresent || flashTotalPages < FLASH_RESERVED_PAGES) {
+    return false;
+  }
+
+  // Classify sectors by their header
+  for (uint8_t s = 0; s < STORAGE_SECTORS; s++) {
+    StorageSectorHeader h;
+    flash.readData(sectorAddr(s), (uint8_t *)&h, sizeof(h));
+
+    if (h.magic == STORAGE_SECTOR_MAGIC &&
+        sectorHeaderCrc(h) == h.crc32 &&
+        h.seq != SECTOR_FREE && h.seq != SECTOR_DIRTY) {
+      g_sectorSeq[s] = h.seq;
+      if (h.seq >= g_nextSeq) g_nextSeq = h.seq + 1;
+    } else if (rangeErased(sectorAddr(s), FLASH_SECTOR_SIZE)) {
+      g_sectorSeq[s] = SECTOR_FREE;
+    } else {
+      g_sectorSeq[s] = SECTOR_DIRTY;
+    }
+  }
+
+  // Replay sectors oldest first, so later records win
+  uint32_t last = 0;
+  for (;;) {
+    int8_t next = -1;
+    for (uint8_t s = 0; s < STORAGE_SECTORS; s++) {
+      if (sectorInUse(s) && g_sectorSeq[s] > last &&
+          (next < 0 || g_sectorSeq[s] < g_sectorSeq[next])) {
+        next = (int8_t)s;
+      }
+    }
+    if (next < 0) break;
+
+    g_head = next;
+    g_headOff = scanSector((uint8_t)next);
+    last = g_sectorSeq[next];
+  }
+
+  g_formatted = g_index[STORAGE_KEY_FORMAT] != STORAGE_NO_RECORD;
+  if (!g_formatted) {
+    if (!migrateFixedSlots()) {
+      return false;
+    }
+    g_formatted = true;
+  }
+
+  g_mounted = true;
+  return true;
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+static void lockStorage() {
+  if (g_storeLock) {
+    xSemaphoreTake(g_storeLock, portMAX_DELAY);
+  }
+}
+
+static void unlockStorage() {
+  if (g_storeLock) {
+    xSemaphoreGive(g_storeLock);
+  }
+}
+
+static bool readValueLocked(uint16_t index, uint8_t *out256) {
+  const uint16_t loc = g_index[index];
+  if (loc == STORAGE_NO_RECORD) {
+    memset(out256, 0xFF, FLASH_PAGE_SIZE);
+    return true;
+  }
+
+  StorageRecord r;
+  if (!flash.readData(locAddr(loc), (uint8_t *)&r, sizeof(r)) || !headerPlausible(r)) {
+    return false;
+  }
+  if (r.len > 0 && !flash.readData(locAddr(loc) + sizeof(r), out256, r.len)) {
+    return false;
+  }
+  memset(out256 + r.len, r.fill, FLASH_PAGE_SIZE - r.len);
+  return true;
+}
+
+bool readStorageElement(uint16_t index, uint8_t *out256) {
+  if (!out256 || index >= STORAGE_SLOT_LIMIT || !g_mounted) {
+    return false;
+  }
+
+  lockStorage();
+  const bool ok = readValueLocked(index, out256);
+  unlockStorage();
+  return ok;
+}
+
+bool writeStorageElement(uint16_t index, const uint8_t *in256) {
+  if (!in256 || index >= STORAGE_SLOT_LIMIT || !g_mounted) {
+    return false;
+  }
+
+  lockStorage();
+
+  // Restore spares a power loss used up
+  for (uint8_t i = 0; i < STORAGE_SECTORS && freeSectors() < STORAGE_SPARE_SECTORS; i++) {
+    if (!reclaimSector()) break;
+  }
+
+  bool ok;
+  if (readValueLocked(index, g_valueBuf) && memcmp(g_valueBuf, in256, FLASH_PAGE_SIZE) == 0) {
+    g_stats.unchanged++;
+    ok = true;
+  } else {
+    // Refuse what reclaim could not make room for
+    uint16_t len = FLASH_PAGE_SIZE;
+    while (len > 0 && in256[len - 1] == in256[FLASH_PAGE_SIZE - 1]) len--;
+
+    const uint32_t old = g_index[index] == STORAGE_NO_RECORD ? 0 : g_recordBytes[index];
+    ok = g_stats.liveBytes - old + recordBytes(len) <= STORAGE_CAPACITY &&
+         appendRecord(index, in256);
+  }
+
+  unlockStorage();
+  return ok;
+}
+
+void getStorageStats(StorageStats &out) {
+  lockStorage();
+  out = g_stats;
+  out.mounted = g_mounted;
+  out.freeSectors = freeSectors();
+  unlockStorage();
+}
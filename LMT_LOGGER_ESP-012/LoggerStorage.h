@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ============================================================================
+// LOGGER TAIL STORAGE (log-structured key/value journal)
+// ============================================================================
+//
+// Backs readStorageElement() / writeStorageElement(): 256-byte values keyed
+// by slot index (0 .. STORAGE_SLOT_LIMIT - 1) in the reserved flash tail,
+// below the checkpoint journal.
+//
+// Responsibilities:
+//   - Appends each write as a record into erased space: no read-modify-
+//     erase-write of a sector per update
+//   - Keeps an in-RAM index (slot -> newest record), built by one scan at
+//     boot
+//   - Reclaims the oldest sector when space runs out (live records are
+//     copied to the head, then the sector is erased)
+//   - Migrates the old fixed-slot layout (slot N at tail page N) once
+//
+// Non-responsibilities:
+//   - No meaning of slots (1 SSID, 2 password, 3 OTA hash: see callers)
+//   - Not used by the IMU/sync writer path; writes are synchronous
+//
+// Design notes:
+//   - Sectors are used in rotation (sector sequence numbers order them), so
+//     erases spread evenly over the whole region
+//   - A record's header is programmed before its payload and its CRC covers
+//     both: a write torn by power loss is ignored and the previous value of
+//     that slot stays current
+//   - Reclaim erases a sector only after its live records are rewritten, so
+//     every slot survives a power loss at any point (a scan skips the torn
+//     bytes); two sectors stay erased as spares for reclaim
+//   - Trailing bytes equal to the last byte are not stored (a short string
+//     padded with 0x00 costs 16 bytes + its length); reads restore them
+//   - A slot never written reads as 0xFF, like the old erased page
+//   - Writing the value a slot already holds costs a read and no program
+//
+
+#define STORAGE_SECTOR_MAGIC 0x53564B4CUL  // ASCII "LKVS"
+#define STORAGE_RECORD_MAGIC 0x52564B4CUL  // ASCII "LKVR"
+
+// First 16 bytes of every storage sector in use.
+struct StorageSectorHeader {
+  uint32_t magic;     // STORAGE_SECTOR_MAGIC
+  uint32_t seq;       // sector sequence number (higher = newer)
+  uint32_t reserved;  // 0xFFFFFFFF
+  uint32_t crc32;     // CRC-32 over all preceding bytes
+};
+static_assert(sizeof(StorageSectorHeader) == 16, "StorageSectorHeader must be 16 bytes");
+
+// Record header; 'len' payload bytes follow, padded to 16 bytes.
+struct StorageRecord {
+  uint32_t magic;       // STORAGE_RECORD_MAGIC
+  uint16_t key;         // slot index
+  uint16_t len;         // stored payload bytes (0 .. FLASH_PAGE_SIZE)
+  uint8_t fill;         // value of bytes [len, FLASH_PAGE_SIZE)
+  uint8_t reserved[3];  // 0xFF
+  uint32_t crc32;       // CRC-32 over the preceding header bytes, then the payload
+};
+static_assert(sizeof(StorageRecord) == 16, "StorageRecord must be 16 bytes");
+
+struct StorageStats {
+  bool mounted;
+  uint16_t slots;           // slots holding a value
+  uint32_t liveBytes;       // record bytes of current values
+  uint32_t capacityBytes;   // liveBytes limit
+  uint8_t sectors;
+  uint8_t freeSectors;      // erased or reclaimable without copying
+  uint32_t writes;          // records appended (including reclaim copies)
+  uint32_t unchanged;       // writes skipped: value already stored
+  uint32_t reclaims;        // sectors reclaimed
+  uint32_t erases;          // sector erases since boot
+};
+
+// Scan the region and build the index (migrating the old layout on first
+// use). Call once after computeFlashLayout(); returns false if the region
+// is unusable, and reads/writes then fail.
+bool startStorage();
+
+// Slot API (index < STORAGE_SLOT_LIMIT). Slots [STORAGE_SLOT_LIMIT, 256)
+// are owned by the checkpoint journal.
+bool readStorageElement(uint16_t index, uint8_t *out256);
+bool writeStorageElement(uint16_t index, const uint8_t *in256);
+
+void getStorageStats(StorageStats &out);
@@ -1,7 +1,7 @@
 #pragma once
 #include <stdint.h>
 
-#define SYNC_FRAMES_PER_PAGE 16   // 256 / 16
+#define SYNC_FRAMES_PER_PAGE 15   // (256 - 16-byte footer) / 16
 #define SYNC_INTERVAL_MS    60000 // 60 seconds
 
 struct SyncFrame {
@@ -0,0 +1,201 @@
+#include "LoggerWriter.h"
+
+#include "LoggerCore.h"
+
+// ============================================================================
+// CONFIG
+// ============================================================================
+
+#define WRITER_TASK_STACK 3072
+#define WRITER_TASK_PRIO  2  // above loop() (1); mostly blocked on the queue
+
+// ============================================================================
+// INTERNAL STATE
+// ============================================================================
+
+struct WriterJob {
+  uint8_t slot;
+  uint8_t flags;
+  uint16_t len;
+  uint32_t addr;
+  uint32_t submitUs;
+};
+
+alignas(4) static uint8_t g_pool[WRITER_POOL_PAGES][FLASH_PAGE_SIZE];
+
+static QueueHandle_t g_freeQ = nullptr;  // uint8_t slot indices
+static QueueHandle_t g_jobQ = nullptr;   // WriterJob
+static TaskHandle_t g_task = nullptr;
+
+// Jobs submitted but not yet programmed (queued + in flight)
+static volatile uint32_t g_inFlight = 0;
+
+// Monotonic job counts behind writerSubmitMark() / writerReached()
+static volatile uint32_t g_submitted = 0;
+static volatile uint32_t g_completed = 0;
+
+static FlashWriterStats g_stats = {};
+static portMUX_TYPE g_statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static int slotForBuf(const uint8_t *buf) {
+  for (int i = 0; i < WRITER_POOL_PAGES; i++) {
+    if (buf == g_pool[i]) return i;
+  }
+  return -1;
+}
+
+static bool programJob(const uint8_t *buf, uint32_t addr, uint16_t len, uint8_t flags) {
+  if (flags & WRITER_JOB_ERASE_SECTOR) {
+    if (!flash.eraseSector(addr)) {
+      return false;
+    }
+  }
+  return flash.writePage(addr, buf, len);
+}
+
+// ============================================================================
+// WRITER TASK
+// ============================================================================
+
+static void writerTask(void *) {
+  WriterJob job;
+
+  for (;;) {
+    if (xQueueReceive(g_jobQ, &job, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+
+    const bool ok = programJob(g_pool[job.slot], job.addr, job.len, job.flags);
+    const uint32_t latency = micros() - job.submitUs;
+
+    xQueueSend(g_freeQ, &job.slot, 0);
+
+    portENTER_CRITICAL(&g_statsMux);
+    g_inFlight--;
+    g_completed++;
+    g_stats.pagesWritten++;
+    g_stats.lastLatencyUs = latency;
+    if (latency > g_stats.maxLatencyUs) g_stats.maxLatencyUs = latency;
+    if (!ok) g_stats.writeErrors++;
+    portEXIT_CRITICAL(&g_statsMux);
+  }
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+void startFlashWriter() {
+  if (g_task) return;
+
+  g_freeQ = xQueueCreate(WRITER_POOL_PAGES, sizeof(uint8_t));
+  g_jobQ = xQueueCreate(WRITER_POOL_PAGES, sizeof(WriterJob));
+
+  for (uint8_t i = 0; i < WRITER_POOL_PAGES; i++) {
+    xQueueSend(g_freeQ, &i, 0);
+  }
+
+  xTaskCreate(writerTask, "flashWriter", WRITER_TASK_STACK, nullptr,
+              WRITER_TASK_PRIO, &g_task);
+}
+
+uint8_t *writerAcquirePage() {
+  uint8_t slot = 0;
+
+  if (!g_freeQ) {
+    return nullptr;  // writer not started: callers fall back to sync writes
+  }
+
+  if (xQueueReceive(g_freeQ, &slot, 0) != pdTRUE) {
+    portENTER_CRITICAL(&g_statsMux);
+    g_stats.overruns++;
+    portEXIT_CRITICAL(&g_statsMux);
+    return nullptr;
+  }
+
+  return g_pool[slot];
+}
+
+void writerReleasePage(uint8_t *buf) {
+  const int slot = slotForBuf(buf);
+  if (slot < 0) return;
+
+  const uint8_t s = (uint8_t)slot;
+  xQueueSend(g_freeQ, &s, 0);
+}
+
+void writerSubmitPage(uint8_t *buf, uint32_t addr, uint16_t len, uint8_t flags) {
+  const int slot = slotForBuf(buf);
+  if (slot < 0) return;
+
+  WriterJob job;
+  job.slot = (uint8_t)slot;
+  job.flags = flags;
+  job.len = len;
+  job.addr = addr;
+  job.submitUs = micros();
+
+  portENTER_CRITICAL(&g_statsMux);
+  g_inFlight++;
+  g_submitted++;
+  if (g_inFlight > g_stats.maxQueued) g_stats.maxQueued = g_inFlight;
+  portEXIT_CRITICAL(&g_statsMux);
+
+  // Cannot fail: every job owns a pool slot and the queue is pool-sized.
+  xQueueSend(g_jobQ, &job, 0);
+}
+
+void writerSubmitCopy(const uint8_t *src, uint32_t addr, uint16_t len, uint8_t flags) {
+  if (len > FLASH_PAGE_SIZE) return;
+
+  uint8_t *buf = writerAcquirePage();
+
+  if (!buf) {
+    // Keep ordering: everything queued before us must land first.
+    writerDrain();
+    if (!programJob(src, addr, len, flags)) {
+      portENTER_CRITICAL(&g_statsMux);
+      g_stats.writeErrors++;
+      portEXIT_CRITICAL(&g_statsMux);
+    }
+    return;
+  }
+
+  memcpy(buf, src, len);
+  writerSubmitPage(buf, addr, len, flags);
+}
+
+void writerDrain() {
+  while (g_inFlight > 0) {
+    delay(1);
+  }
+}
+
+// The synchronous fallback in writerSubmitCopy() is durable on return and is
+// not counted, which keeps completions in submission order.
+uint32_t writerSubmitMark() {
+  return g_submitted;
+}
+
+bool writerReached(uint32_t mark) {
+  return (int32_t)(g_completed - mark) >= 0;
+}
+
+void getFlashWriterStats(FlashWriterStats &out) {
+  portENTER_CRITICAL(&g_statsMux);
+  out = g_stats;
+  out.queued = g_inFlight;
+  portEXIT_CRITICAL(&g_statsMux);
+}
+
+void resetFlashWriterStats() {
+  portENTER_CRITICAL(&g_statsMux);
+  const uint32_t inFlight = g_inFlight;
+  g_stats = {};
+  g_stats.maxQueued = inFlight;
+  portEXIT_CRITICAL(&g_statsMux);
+}
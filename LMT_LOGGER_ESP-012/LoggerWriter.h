@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ============================================================================
+// LOGGER FLASH WRITER (page pool + background task)
+// ============================================================================
+//
+// Moves flash programming off the acquisition path.
+//
+// Responsibilities:
+//   - Owns a fixed pool of WRITER_POOL_PAGES page buffers
+//   - Runs a FreeRTOS task that programs queued buffers in FIFO order
+//   - Tracks queue depth, queue latency, overruns and write errors
+//
+// Non-responsibilities:
+//   - No page formats (LoggerCore builds page contents)
+//   - No head/counter bookkeeping (LoggerCore advances currentPage at submit)
+//
+// Design notes:
+//   - Jobs are written strictly in submission order, so a checkpoint
+//     submitted after page N always lands after page N
+//   - Acquire/submit never block; an empty pool is an overrun and the
+//     caller decides what to drop
+//   - SPIFlash serializes bus access, so idle-mode readers are safe, but
+//     callers that need *complete* data must writerDrain() first
+//   - Readers that run during recording (HTTP export) cannot drain; they
+//     take a writerSubmitMark() and wait for writerReached() instead
+//
+
+#define WRITER_POOL_PAGES 8
+
+// Job flags
+#define WRITER_JOB_ERASE_SECTOR 0x01  // erase the sector containing addr first
+
+struct FlashWriterStats {
+  uint32_t queued;          // jobs currently waiting or in flight
+  uint32_t maxQueued;       // high-water mark of 'queued'
+  uint32_t lastLatencyUs;   // submit -> programmed, most recent job
+  uint32_t maxLatencyUs;    // submit -> programmed, worst case
+  uint32_t pagesWritten;    // jobs completed
+  uint32_t overruns;        // acquire attempts with the pool exhausted
+  uint32_t writeErrors;     // erase/program failures
+};
+
+// Create pool, queues and the writer task. Safe to call repeatedly.
+void startFlashWriter();
+
+// Take a free page buffer (FLASH_PAGE_SIZE bytes, 4-byte aligned).
+// Returns nullptr and counts an overrun if the pool is exhausted.
+uint8_t *writerAcquirePage();
+
+// Return an acquired buffer without writing it.
+void writerReleasePage(uint8_t *buf);
+
+// Queue an acquired buffer for programming at 'addr'. Ownership passes to
+// the writer; the buffer returns to the pool once programmed.
+void writerSubmitPage(uint8_t *buf, uint32_t addr, uint16_t len, uint8_t flags = 0);
+
+// Copy 'len' bytes into a pool buffer and queue it. Falls back to a
+// synchronous write if the pool is exhausted, so the data is never lost.
+void writerSubmitCopy(const uint8_t *src, uint32_t addr, uint16_t len, uint8_t flags = 0);
+
+// Block until every submitted job has been programmed.
+void writerDrain();
+
+// Durability marks for concurrent readers. writerSubmitMark() names every
+// job submitted so far; writerReached(mark) turns true once all of them are
+// programmed (jobs complete in submission order). Neither call blocks.
+uint32_t writerSubmitMark();
+bool writerReached(uint32_t mark);
+
+void getFlashWriterStats(FlashWriterStats &out);
+void resetFlashWriterStats();
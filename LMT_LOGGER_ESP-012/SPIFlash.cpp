@@ -24,6 +24,36 @@ void SPIFlash::csHigh() {
   digitalWrite(_cs, HIGH);
 }
 
+// =============================================================================
+// CONCURRENCY
+// =============================================================================
+//
+// The flash shares the SPI bus with the IMU and is driven from both loop()
+// and the background writer. SPI.beginTransaction() arbitrates the bus per
+// transaction; this lock additionally keeps a whole command sequence
+// (WREN + program/erase + busy wait) atomic, since the chip ignores new
+// commands while a program or erase is in progress.
+
+void SPIFlash::lock() {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (_lock) xSemaphoreTakeRecursive(_lock, portMAX_DELAY);
+#endif
+}
+
+void SPIFlash::unlock() {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (_lock) xSemaphoreGiveRecursive(_lock);
+#endif
+}
+
+namespace {
+struct FlashGuard {
+  explicit FlashGuard(SPIFlash &f) : _f(f) { _f.lock(); }
+  ~FlashGuard() { _f.unlock(); }
+  SPIFlash &_f;
+};
+}
+
 // =============================================================================
 // SMALL UTILS
 // =============================================================================
@@ -55,36 +85,106 @@ uint8_t SPIFlash::capCodeForBytesPow2(uint32_t bytesPow2) {
 // =============================================================================
 
 void SPIFlash::writeEnable() {
-  csLow();
   SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
   SPI.transfer(FLASH_CMD_WREN);
+  csHigh();
   SPI.endTransaction();
+}
+
+bool SPIFlash::isBusy() {
+  SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
+
+  SPI.transfer(FLASH_CMD_RDSR);
+  const uint8_t status = SPI.transfer(0);
+
   csHigh();
+  SPI.endTransaction();
+
+  // WIP bit set -> busy
+  return (status & 0x01) != 0;
 }
 
-bool SPIFlash::waitForReady(uint32_t timeoutMs) {
-  const uint32_t start = millis();
+void SPIFlash::sleepUs(uint32_t us) {
+  if (us >= 2000) {
+    delay(us / 1000);  // yields to other tasks
+  } else if (us > 0) {
+    delayMicroseconds(us);
+  }
+}
 
-  while ((millis() - start) < timeoutMs) {
+bool SPIFlash::waitForReady(uint32_t expectedUs, uint32_t timeoutUs, FlashOpStats *stats) {
+  const uint32_t start = micros();
 
-    csLow();
-    SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  // Nothing to learn from polling before the op can plausibly be done.
+  sleepUs(expectedUs * 3 / 4);
 
-    SPI.transfer(FLASH_CMD_RDSR);
-    const uint8_t status = SPI.transfer(0);
+  uint32_t interval = expectedUs / 32;
+  if (interval < 8) interval = 8;
 
-    SPI.endTransaction();
-    csHigh();
+  uint32_t cap = expectedUs / 4;
+  if (cap < interval) cap = interval;
 
-    // WIP bit cleared -> ready
-    if ((status & 0x01) == 0) {
+  for (;;) {
+    if (!isBusy()) {
+      if (stats) recordOp(*stats, micros() - start);
       return true;
     }
 
-    delay(1);
+    if ((uint32_t)(micros() - start) >= timeoutUs) {
+      return false;
+    }
+
+    sleepUs(interval);
+
+    interval *= 2;
+    if (interval > cap) interval = cap;
   }
+}
 
-  return false;
+void SPIFlash::recordOp(FlashOpStats &st, uint32_t us) {
+  if (st.count == 0 || us < st.minUs) st.minUs = us;
+  if (us > st.maxUs) st.maxUs = us;
+  st.totalUs += us;
+  st.count++;
+}
+
+// Observed mean once there is enough history, otherwise the profile value.
+uint32_t SPIFlash::expectedUs(const FlashOpStats &st, uint32_t profileUs) {
+  return (st.count >= FLASH_PROFILE_MIN_SAMPLES) ? st.avgUs() : profileUs;
+}
+
+// Typical datasheet timings by JEDEC manufacturer ID.
+FlashTimingProfile SPIFlash::defaultProfileFor(uint8_t man) {
+  switch (man) {
+    case 0xEF:  // Winbond W25Q: tPP 0.4 ms, tSE 45 ms, tBE64 150 ms
+      return { 400, 45000, 150000 };
+    case 0xC8:  // GigaDevice GD25Q: tPP 0.6 ms, tSE 50 ms, tBE64 220 ms
+      return { 600, 50000, 220000 };
+    default:    // Conservative generic NOR
+      return { 800, 60000, 250000 };
+  }
+}
+
+void SPIFlash::resetStats() {
+  FlashGuard guard(*this);
+
+  _progStats = {};
+  _eraseStats = {};
+  _blockStats = {};
+}
+
+void SPIFlash::sendCommandAddr(uint8_t cmd, uint32_t addr, bool dummy) {
+  const uint8_t hdr[5] = {
+    cmd,
+    (uint8_t)((addr >> 16) & 0xFF),
+    (uint8_t)((addr >> 8) & 0xFF),
+    (uint8_t)(addr & 0xFF),
+    0x00  // FAST_READ dummy byte
+  };
+
+  SPI.writeBytes(hdr, dummy ? 5 : 4);
 }
 
 // =============================================================================
@@ -93,16 +193,16 @@ bool SPIFlash::waitForReady(uint32_t timeoutMs) {
 
 bool SPIFlash::tryDetectExternalJedec(uint8_t &man, uint8_t &type, uint8_t &cap) {
   // Minimal JEDEC read; treat 0x00/0xFF as "not present / not wired"
-  csLow();
   SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
 
   SPI.transfer(FLASH_CMD_RDID);
   man = SPI.transfer(0);
   type = SPI.transfer(0);
   cap = SPI.transfer(0);
 
-  SPI.endTransaction();
   csHigh();
+  SPI.endTransaction();
 
   if (man == 0x00 || man == 0xFF) return false;
   if (cap == 0x00 || cap == 0xFF) return false;
@@ -143,6 +243,14 @@ bool SPIFlash::tryInitInternalPartition() {
 // =============================================================================
 
 bool SPIFlash::begin() {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (!_lock) {
+    _lock = xSemaphoreCreateRecursiveMutex();
+  }
+#endif
+
+  FlashGuard guard(*this);
+
   pinMode(_cs, OUTPUT);
   csHigh();
 
@@ -153,6 +261,7 @@ bool SPIFlash::begin() {
   // Try external JEDEC
   uint8_t man = 0, type = 0, cap = 0;
   if (tryDetectExternalJedec(man, type, cap)) {
+    _profile = defaultProfileFor(man);
     _emulated = false;
     _emuCapacityBytes = 0;
 #if defined(ARDUINO_ARCH_ESP32)
@@ -177,6 +286,8 @@ bool SPIFlash::begin() {
 // =============================================================================
 
 bool SPIFlash::readID(uint8_t &man, uint8_t &type, uint8_t &cap) {
+  FlashGuard guard(*this);
+
 
   if (_emulated) {
     // Synthetic, recognizable "emulated" ID.
@@ -188,16 +299,16 @@ bool SPIFlash::readID(uint8_t &man, uint8_t &type, uint8_t &cap) {
   }
 
   // External SPI JEDEC
-  csLow();
   SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
 
   SPI.transfer(FLASH_CMD_RDID);
   man = SPI.transfer(0);
   type = SPI.transfer(0);
   cap = SPI.transfer(0);
 
-  SPI.endTransaction();
   csHigh();
+  SPI.endTransaction();
 
   return true;
 }
@@ -207,6 +318,8 @@ bool SPIFlash::readID(uint8_t &man, uint8_t &type, uint8_t &cap) {
 // =============================================================================
 
 bool SPIFlash::eraseSector(uint32_t addr) {
+  FlashGuard guard(*this);
+
 
   if (_emulated) {
 #if defined(ARDUINO_ARCH_ESP32)
@@ -226,21 +339,51 @@ bool SPIFlash::eraseSector(uint32_t addr) {
   // External
   writeEnable();
 
-  csLow();
   SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
 
-  SPI.transfer(FLASH_CMD_SE);
-  SPI.transfer((addr >> 16) & 0xFF);
-  SPI.transfer((addr >> 8) & 0xFF);
-  SPI.transfer(addr & 0xFF);
+  sendCommandAddr(FLASH_CMD_SE, addr);
 
+  csHigh();
   SPI.endTransaction();
+
+  return waitForReady(expectedUs(_eraseStats, _profile.tSEus), 2000000UL, &_eraseStats);
+}
+
+bool SPIFlash::eraseBlock(uint32_t addr) {
+  FlashGuard guard(*this);
+
+  if (_emulated) {
+#if defined(ARDUINO_ARCH_ESP32)
+    if (!_part) return false;
+
+    const uint32_t a = addr & ~(uint32_t)(FLASH_BLOCK_SIZE - 1);
+    if ((a + FLASH_BLOCK_SIZE) > _emuCapacityBytes) return false;
+
+    const esp_err_t err = esp_partition_erase_range(_part, a, FLASH_BLOCK_SIZE);
+    return (err == ESP_OK);
+#else
+    return false;
+#endif
+  }
+
+  // External
+  writeEnable();
+
+  SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
+
+  sendCommandAddr(FLASH_CMD_BE64, addr);
+
   csHigh();
+  SPI.endTransaction();
 
-  return waitForReady(2000);
+  return waitForReady(expectedUs(_blockStats, _profile.tBEus), 4000000UL, &_blockStats);
 }
 
 bool SPIFlash::chipErase() {
+  FlashGuard guard(*this);
+
 
   if (_emulated) {
 #if defined(ARDUINO_ARCH_ESP32)
@@ -266,14 +409,14 @@ bool SPIFlash::chipErase() {
   // External
   writeEnable();
 
-  csLow();
   SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
   SPI.transfer(FLASH_CMD_CE);
-  SPI.endTransaction();
   csHigh();
+  SPI.endTransaction();
 
   // Typical: ~100 ms, worst-case: tens of seconds
-  return waitForReady(100000);
+  return waitForReady(100000UL, 100000000UL, nullptr);
 }
 
 // =============================================================================
@@ -281,6 +424,8 @@ bool SPIFlash::chipErase() {
 // =============================================================================
 
 bool SPIFlash::readData(uint32_t addr, uint8_t *buf, uint32_t len) {
+  FlashGuard guard(*this);
+
   if (!buf) return false;
 
   if (_emulated) {
@@ -296,25 +441,23 @@ bool SPIFlash::readData(uint32_t addr, uint8_t *buf, uint32_t len) {
   }
 
   // External
+  SPI.beginTransaction(SPISettings(FLASH_SPI_DATA_SPEED, MSBFIRST, SPI_MODE0));
   csLow();
-  SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
 
-  SPI.transfer(FLASH_CMD_READ);
-  SPI.transfer((addr >> 16) & 0xFF);
-  SPI.transfer((addr >> 8) & 0xFF);
-  SPI.transfer(addr & 0xFF);
+  sendCommandAddr(FLASH_CMD_FAST_READ, addr, true);
 
-  while (len--) {
-    *buf++ = SPI.transfer(0);
-  }
+  // In-place full-duplex transfer: MOSI content is ignored by the chip.
+  SPI.transfer(buf, len);
 
-  SPI.endTransaction();
   csHigh();
+  SPI.endTransaction();
 
   return true;
 }
 
 bool SPIFlash::writePage(uint32_t addr, const uint8_t *buf, uint16_t len) {
+  FlashGuard guard(*this);
+
   if (!buf) return false;
   if (len > FLASH_PAGE_SIZE) return false;
 
@@ -337,22 +480,97 @@ bool SPIFlash::writePage(uint32_t addr, const uint8_t *buf, uint16_t len) {
   // External
   writeEnable();
 
+  SPI.beginTransaction(SPISettings(FLASH_SPI_DATA_SPEED, MSBFIRST, SPI_MODE0));
   csLow();
-  SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
 
-  SPI.transfer(FLASH_CMD_PP);
-  SPI.transfer((addr >> 16) & 0xFF);
-  SPI.transfer((addr >> 8) & 0xFF);
-  SPI.transfer(addr & 0xFF);
+  sendCommandAddr(FLASH_CMD_PP, addr);
+  SPI.writeBytes(buf, len);
+
+  csHigh();
+  SPI.endTransaction();
+
+  return waitForReady(expectedUs(_progStats, _profile.tPPus), 10000UL, &_progStats);
+}
+
+// =============================================================================
+// CHARACTERIZATION
+// =============================================================================
+//
+// Grown from the SPI_JEDEC_test bring-up sketch: after the RDID probe, time
+// real erase/program cycles on a scratch area with tight (8 us) polling so
+// the result reflects the chip, not the poll interval.
+
+#define FLASH_CHARACTERIZE_ROUNDS 3
+
+bool SPIFlash::characterize(uint32_t sectorAddr, uint32_t blockAddr, FlashTimingProfile &out) {
+  if (_emulated) return false;
+
+  FlashGuard guard(*this);
+
+  uint8_t pattern[FLASH_PAGE_SIZE];
+  memset(pattern, 0xA5, sizeof(pattern));
+
+  sectorAddr &= ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
 
-  for (uint16_t i = 0; i < len; i++) {
-    SPI.transfer(buf[i]);
+  FlashOpStats se = {};
+  FlashOpStats pp = {};
+
+  for (int round = 0; round < FLASH_CHARACTERIZE_ROUNDS; round++) {
+    writeEnable();
+
+    SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+    csLow();
+    sendCommandAddr(FLASH_CMD_SE, sectorAddr);
+    csHigh();
+    SPI.endTransaction();
+
+    if (!waitForReady(0, 2000000UL, &se)) return false;
+
+    // Program the whole sector once (skip after the last erase so the
+    // scratch area is left erased).
+    if (round == FLASH_CHARACTERIZE_ROUNDS - 1) break;
+
+    for (uint32_t off = 0; off < FLASH_SECTOR_SIZE; off += FLASH_PAGE_SIZE) {
+      writeEnable();
+
+      SPI.beginTransaction(SPISettings(FLASH_SPI_DATA_SPEED, MSBFIRST, SPI_MODE0));
+      csLow();
+      sendCommandAddr(FLASH_CMD_PP, sectorAddr + off);
+      SPI.writeBytes(pattern, FLASH_PAGE_SIZE);
+      csHigh();
+      SPI.endTransaction();
+
+      if (!waitForReady(0, 10000UL, &pp)) return false;
+    }
   }
 
-  SPI.endTransaction();
-  csHigh();
+  out.tPPus = pp.avgUs();
+  out.tSEus = se.avgUs();
+  out.tBEus = _profile.tBEus;
+
+  if (blockAddr != NO_BLOCK) {
+    FlashOpStats be = {};
+
+    writeEnable();
+
+    SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+    csLow();
+    sendCommandAddr(FLASH_CMD_BE64, blockAddr & ~(uint32_t)(FLASH_BLOCK_SIZE - 1));
+    csHigh();
+    SPI.endTransaction();
+
+    if (!waitForReady(0, 4000000UL, &be)) return false;
+    out.tBEus = be.avgUs();
+  }
 
-  return waitForReady(10);
+  _profile = out;
+
+  // Fresh profile: let the observed means rebuild from it.
+  _progStats = {};
+  _eraseStats = {};
+  _blockStats = {};
+
+  return true;
 }
 
 // =============================================================================
@@ -360,29 +578,33 @@ bool SPIFlash::writePage(uint32_t addr, const uint8_t *buf, uint16_t len) {
 // =============================================================================
 
 void SPIFlash::sleep() {
+  FlashGuard guard(*this);
+
   if (_emulated) {
     // No-op for internal partition backend
     return;
   }
 
-  csLow();
   SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
   SPI.transfer(FLASH_CMD_DP);
-  SPI.endTransaction();
   csHigh();
+  SPI.endTransaction();
 }
 
 void SPIFlash::wake() {
+  FlashGuard guard(*this);
+
   if (_emulated) {
     // No-op for internal partition backend
     return;
   }
 
-  csLow();
   SPI.beginTransaction(SPISettings(FLASH_SPI_SPEED, MSBFIRST, SPI_MODE0));
+  csLow();
   SPI.transfer(FLASH_CMD_RDP);
-  SPI.endTransaction();
   csHigh();
+  SPI.endTransaction();
 
   // Datasheet-mandated wake delay
   delay(1);
@@ -14,8 +14,10 @@
 
 #define FLASH_CMD_RDID 0x9F  // Read JEDEC ID
 #define FLASH_CMD_READ 0x03  // Read data (3-byte address)
+#define FLASH_CMD_FAST_READ 0x0B  // Fast read (3-byte address + 1 dummy byte)
 #define FLASH_CMD_PP   0x02  // Page program
 #define FLASH_CMD_SE   0x20  // Sector erase (4 KB)
+#define FLASH_CMD_BE64 0xD8  // Block erase (64 KB)
 #define FLASH_CMD_CE   0xC7  // Chip erase
 #define FLASH_CMD_RDSR 0x05  // Read status register
 #define FLASH_CMD_WREN 0x06  // Write enable
@@ -37,6 +39,39 @@
 
 #define FLASH_PAGE_SIZE   256
 #define FLASH_SECTOR_SIZE 4096
+#define FLASH_BLOCK_SIZE  65536
+
+// =============================================================================
+// TIMING PROFILE / STATISTICS
+// =============================================================================
+//
+// Busy waits are driven by the expected duration of the operation:
+//   - sleep through ~3/4 of the expected time without touching the bus
+//   - then poll RDSR tightly (expected/32), doubling the interval up to
+//     expected/4 as the operation overruns
+//   - sleeps >= 2 ms use delay() so other tasks run
+//
+// The expected duration comes from the chip profile (JEDEC table default or
+// a measured profile from characterize()), and switches to the observed mean
+// once FLASH_PROFILE_MIN_SAMPLES operations have been timed.
+//
+
+#define FLASH_PROFILE_MIN_SAMPLES 8
+
+struct FlashTimingProfile {
+  uint32_t tPPus;  // page program (256 bytes)
+  uint32_t tSEus;  // 4 KB sector erase
+  uint32_t tBEus;  // 64 KB block erase
+};
+
+struct FlashOpStats {
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t totalUs;
+
+  uint32_t avgUs() const { return count ? (uint32_t)(totalUs / count) : 0; }
+};
 
 // =============================================================================
 // SPI CONFIGURATION
@@ -44,6 +79,14 @@
 
 #define FLASH_SPI_SPEED 4000000  // 4 MHz (safe default)
 
+// Clock for bulk data phases (FAST_READ, PAGE PROGRAM).
+// The P25Q/W25Q parts used here are rated >= 80 MHz for 0x0B / 0x02; the limit
+// is the ESP32-C3 GPIO matrix, which samples MISO reliably up to ~26 MHz.
+// Control commands (RDID, RDSR, WREN, erase) stay at FLASH_SPI_SPEED.
+#ifndef FLASH_SPI_DATA_SPEED
+#define FLASH_SPI_DATA_SPEED 20000000  // 20 MHz
+#endif
+
 // =============================================================================
 // INTERNAL FLASH EMULATION (ESP32)
 // =============================================================================
@@ -115,6 +158,9 @@ public:
   // Erases the 4KB sector containing 'addr' (addr is not required to be aligned).
   bool eraseSector(uint32_t addr);
 
+  // Erases the 64KB block containing 'addr' (addr is not required to be aligned).
+  bool eraseBlock(uint32_t addr);
+
   // Erases the entire available flash (external) or emulation window (ESP32).
   bool chipErase();
 
@@ -123,11 +169,13 @@ public:
   // -------------------------------------------------------------------------
   //
   // readData():
-  //  - External: raw SPI READ (0x03) with 24-bit address.
+  //  - External: FAST_READ (0x0B) with 24-bit address at FLASH_SPI_DATA_SPEED.
+  //    Any length is read in one CS-low transaction (crossing pages is fine),
+  //    using a single bulk SPI transfer rather than per-byte calls.
   //  - Emulated (ESP32): reads from partition offset.
   //
   // writePage():
-  //  - External: PAGE PROGRAM (0x02) with 24-bit address.
+  //  - External: PAGE PROGRAM (0x02) with 24-bit address, bulk transfer.
   //  - Emulated (ESP32): writes to partition offset (requires 4-byte alignment).
   //
   bool readData(uint32_t addr, uint8_t *buf, uint32_t len);
@@ -140,6 +188,42 @@ public:
   bool isEmulated() const { return _emulated; }
   uint32_t emulatedCapacityBytes() const { return _emuCapacityBytes; }
 
+  // -------------------------------------------------------------------------
+  // Timing
+  // -------------------------------------------------------------------------
+  //
+  // profile(): active timing profile (table default or measured).
+  // programStats() / eraseStats() / blockEraseStats(): observed busy times of
+  //   external operations since boot or resetStats().
+  //
+  // characterize():
+  //  - DESTRUCTIVE to the given sector (and block, if blockAddr != NO_BLOCK)
+  //  - times FLASH_CHARACTERIZE_ROUNDS sector erases, one sector of page
+  //    programs and optionally one 64 KB block erase with tight polling
+  //  - installs the measured profile and leaves the area erased
+  //  - external flash only
+  //
+  static const uint32_t NO_BLOCK = 0xFFFFFFFFUL;
+
+  const FlashTimingProfile &profile() const { return _profile; }
+  const FlashOpStats &programStats() const { return _progStats; }
+  const FlashOpStats &eraseStats() const { return _eraseStats; }
+  const FlashOpStats &blockEraseStats() const { return _blockStats; }
+  void resetStats();
+
+  bool characterize(uint32_t sectorAddr, uint32_t blockAddr, FlashTimingProfile &out);
+
+  // -------------------------------------------------------------------------
+  // Concurrency
+  // -------------------------------------------------------------------------
+  //
+  // Every public operation holds a recursive lock for its full duration
+  // (including the busy wait). Callers may hold it across several calls to
+  // make a sequence atomic. No-op on non-ESP32 targets.
+  //
+  void lock();
+  void unlock();
+
 private:
   // -------------------------------------------------------------------------
   // Hardware state
@@ -157,6 +241,7 @@ private:
 
 #if defined(ARDUINO_ARCH_ESP32)
   const esp_partition_t *_part = nullptr;
+  SemaphoreHandle_t _lock = nullptr;  // created in begin()
 #endif
 
   // -------------------------------------------------------------------------
@@ -166,7 +251,25 @@ private:
   void csHigh();
 
   void writeEnable();
-  bool waitForReady(uint32_t timeoutMs = 3000);
+  bool isBusy();
+
+  // Adaptive busy wait (see TIMING PROFILE above). Records the observed
+  // duration into 'stats' when non-null.
+  bool waitForReady(uint32_t expectedUs, uint32_t timeoutUs, FlashOpStats *stats);
+
+  static void sleepUs(uint32_t us);
+  static void recordOp(FlashOpStats &st, uint32_t us);
+  static uint32_t expectedUs(const FlashOpStats &st, uint32_t profileUs);
+  static FlashTimingProfile defaultProfileFor(uint8_t man);
+
+  FlashTimingProfile _profile = { 800, 60000, 250000 };
+  FlashOpStats _progStats = {};
+  FlashOpStats _eraseStats = {};
+  FlashOpStats _blockStats = {};
+
+  // Send opcode + 24-bit address (+ optional dummy byte) in one bulk write.
+  // Caller owns the transaction and chip select.
+  void sendCommandAddr(uint8_t cmd, uint32_t addr, bool dummy = false);
 
   bool tryDetectExternalJedec(uint8_t &man, uint8_t &type, uint8_t &cap);
 
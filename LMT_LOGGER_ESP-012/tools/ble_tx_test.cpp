@@ -0,0 +1,406 @@
+// =============================================================================
+// ble_tx_test — BLE UART TX ring and bulk offload test
+// =============================================================================
+//
+// Runs the real LoggerBLE against the stand-in BLE library in tools/host/
+// (BLEDevice.h), with the test playing both the client and the controller:
+// notifications are captured, send completions (GATTS CONF) and congestion
+// events are delivered by hand, RX writes go through the RX callback.
+//
+// Scenarios:
+//   1. RX text reaches the CLI line by line
+//   2. bulk offload at MTU 23 and 247: the reassembled DATA stream equals the
+//      records, END carries the cursor; abort and resume, exact credits,
+//      stall at zero credits, replacement by a new session, a cursor past
+//      the end (RESET flag) or below the IMU tail, the sync stream, a read
+//      error
+//   3. TX ring: short writes coalesce into full notifications with at most
+//      4 in flight; a full ring drops whole writes (bleWrite() returns
+//      false) and bleTxHasRoom() reports backpressure; congestion pauses
+//      the drain until relief (CONGEST event or CONF with congested status);
+//      a missing completion frees the window after 500 ms, and late or
+//      surplus completions never widen it; a disconnect
+//      discards queued text; nothing is queued while notifications are off
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -Ihost -I.. -o ble_tx_test ble_tx_test.cpp host/host_runtime.cpp ../LoggerBLE.cpp
+//
+// Usage:
+//   ./ble_tx_test
+//
+// Exit status 0 when every check passes; the first failure aborts.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <BLEDevice.h>
+
+#include "LoggerBLE.h"
+#include "LoggerCLI.h"
+#include "LoggerCore.h"
+#include "LoggerHTTP.h"
+
+// ============================================================================
+// FIRMWARE STUBS (core state, CLI, record loader)
+// ============================================================================
+
+#define IMU_PAGES  300
+#define SYNC_PAGES 40
+
+uint32_t currentPage = IMU_PAGES;
+uint32_t syncCurrentPage = SYNC_PAGES;
+bool flashPresent = true;
+RunMode mode = MODE_IDLE;
+char cmdBuf[CMD_BUF_SIZE];
+uint16_t cmdLen = 0;
+
+static uint32_t g_tailPage = 0;
+static uint32_t g_failPage = UINT32_MAX;  // loadPageRecords() fails from here
+static std::vector<std::string> g_commands;
+
+void handleCommand(const char *cmd) { g_commands.push_back(cmd); }
+bool liveFrameRequestPending() { return false; }
+void printPrompt() {}
+uint32_t imuTailPage() { return g_tailPage; }
+
+// Record bytes are a function of stream, page and offset, so any stream of
+// records can be rebuilt and compared.
+static uint8_t recordByte(bool sync, uint32_t page, uint32_t offset) {
+  return (uint8_t)(page * 131u + offset * 7u + (sync ? 0x55u : 0u));
+}
+
+bool loadPageRecords(uint8_t *records, bool sync, uint32_t page, uint32_t count) {
+  if (page + count > g_failPage) return false;
+  for (uint32_t k = 0; k < count; k++) {
+    for (uint32_t i = 0; i < STREAM_RECORD_BYTES; i++) {
+      records[k * STREAM_RECORD_BYTES + i] = recordByte(sync, page + k, i);
+    }
+  }
+  return true;
+}
+
+static std::vector<uint8_t> expectedRecords(bool sync, uint32_t from, uint32_t to) {
+  std::vector<uint8_t> out;
+  for (uint32_t p = from; p < to; p++) {
+    for (uint32_t i = 0; i < STREAM_RECORD_BYTES; i++) out.push_back(recordByte(sync, p, i));
+  }
+  return out;
+}
+
+// ============================================================================
+// CLIENT / CONTROLLER SIDE
+// ============================================================================
+
+typedef std::vector<std::vector<uint8_t>> Notes;
+
+static Notes takeNotes() {
+  Notes v;
+  v.swap(hostBle.notifications);
+  return v;
+}
+
+static void rxWrite(const std::vector<uint8_t> &bytes) {
+  BLECharacteristic *rx = hostBle.chars[1];
+  rx->value = bytes;
+  rx->callbacks->onWrite(rx);
+}
+
+static void grantCredits(uint16_t n) {
+  rxWrite({ BLE_BULK_CTRL_CREDIT, (uint8_t)n, (uint8_t)(n >> 8) });
+}
+
+static void sendConf(int status = ESP_GATT_OK) {
+  esp_ble_gatts_cb_param_t p = {};
+  p.conf.status = status;
+  p.conf.handle = HOST_BLE_TX_HANDLE;
+  hostBle.gattsHandler(ESP_GATTS_CONF_EVT, 0, &p);
+}
+
+static void sendCongest(bool on) {
+  esp_ble_gatts_cb_param_t p = {};
+  p.congest.congested = on;
+  hostBle.gattsHandler(ESP_GATTS_CONGEST_EVT, 0, &p);
+}
+
+static void connect() {
+  esp_ble_gatts_cb_param_t p = {};
+  hostBle.server->onConnect(nullptr);
+  hostBle.server->onConnect(nullptr, &p);
+}
+
+static void setMtu(uint16_t mtu) {
+  esp_ble_gatts_cb_param_t p = {};
+  p.mtu.mtu = mtu;
+  hostBle.server->onMtuChanged(nullptr, &p);
+}
+
+static BleTxStats txStats() {
+  BleTxStats st;
+  getBleTxStats(st);
+  return st;
+}
+
+// ============================================================================
+// BULK SESSIONS
+// ============================================================================
+
+struct BulkResult {
+  BleBulkBegin begin = {};
+  BleBulkEnd end = {};
+  std::vector<uint8_t> data;
+  size_t dataNotes = 0;
+  bool ended = false;
+};
+
+// One session: the client grants a credit per DATA notification (unless
+// 'grant' is false) and aborts after 'abortAfter' of them. Every
+// notification is confirmed once the pass that sent it is over.
+static BulkResult runBulk(BleBulkStream stream, uint32_t from, uint16_t credits,
+                          size_t abortAfter = SIZE_MAX, bool grant = true) {
+  BulkResult r;
+  takeNotes();
+  assert(bleBulkStart(stream, from, credits));
+
+  uint8_t seq = 0;
+  bool begun = false;
+  for (int idle = 0; !r.ended && idle < 100;) {
+    serviceBLEBulk();
+    const Notes notes = takeNotes();
+    idle = notes.empty() ? idle + 1 : 0;
+
+    for (const std::vector<uint8_t> &n : notes) {
+      if (n[0] == BLE_BULK_PKT_BEGIN) {
+        memcpy(&r.begin, n.data(), sizeof(r.begin));
+        begun = true;
+      } else if (n[0] == BLE_BULK_PKT_DATA) {
+        assert(begun && n[1] == seq);
+        seq++;
+        r.data.insert(r.data.end(), n.begin() + 2, n.end());
+        if (++r.dataNotes == abortAfter) {
+          rxWrite({ BLE_BULK_CTRL_ABORT });
+        } else if (grant) {
+          grantCredits(1);
+        }
+      } else if (n[0] == BLE_BULK_PKT_END && begun) {
+        memcpy(&r.end, n.data(), sizeof(r.end));
+        r.ended = true;
+      }
+    }
+    for (size_t i = 0; i < notes.size(); i++) sendConf();
+  }
+  return r;
+}
+
+static void testBulk() {
+  const std::vector<uint8_t> imu = expectedRecords(false, 0, IMU_PAGES);
+
+  // Default MTU: 18 record bytes per DATA
+  BulkResult a = runBulk(BLE_BULK_IMU, 0, BLE_BULK_DEFAULT_CREDITS);
+  assert(a.ended && a.end.status == BLE_BULK_COMPLETE);
+  assert(a.begin.dataBytes == 18 && a.data == imu && a.end.nextPage == IMU_PAGES);
+
+  setMtu(247);
+  const int updates0 = hostBle.connUpdates;
+  BulkResult b = runBulk(BLE_BULK_IMU, 0, BLE_BULK_DEFAULT_CREDITS);
+  assert(b.ended && b.end.status == BLE_BULK_COMPLETE && b.data == imu);
+  assert(b.begin.dataBytes == 242 && hostBle.connUpdates == updates0 + 1);
+  printf("bulk: mtu 23 %zu notes, mtu 247 %zu notes (%.1f B/note)\n", a.dataNotes,
+         b.dataNotes, (double)b.data.size() / b.dataNotes);
+
+  // Abort, then resume from the last complete record
+  BulkResult c1 = runBulk(BLE_BULK_IMU, 0, BLE_BULK_DEFAULT_CREDITS, 100);
+  const uint32_t complete = (uint32_t)(c1.data.size() / STREAM_RECORD_BYTES);
+  assert(c1.end.status == BLE_BULK_ABORTED && c1.end.nextPage <= complete);
+  BulkResult c2 = runBulk(BLE_BULK_IMU, complete, BLE_BULK_DEFAULT_CREDITS);
+  std::vector<uint8_t> joined(c1.data.begin(), c1.data.begin() + complete * STREAM_RECORD_BYTES);
+  joined.insert(joined.end(), c2.data.begin(), c2.data.end());
+  assert(c2.begin.firstPage == complete && joined == imu);
+
+  // Exactly enough credits: END needs none
+  const uint16_t need = (10 * STREAM_RECORD_BYTES + 241) / 242;
+  BulkResult d = runBulk(BLE_BULK_IMU, IMU_PAGES - 10, need, SIZE_MAX, false);
+  assert(d.ended && d.end.status == BLE_BULK_COMPLETE && d.dataNotes == need);
+
+  // No further credits: the session pauses, then a new request replaces it
+  BulkResult e = runBulk(BLE_BULK_IMU, 0, 4, SIZE_MAX, false);
+  assert(!e.ended && e.dataNotes == 4);
+  BulkResult f = runBulk(BLE_BULK_IMU, IMU_PAGES + 5, BLE_BULK_DEFAULT_CREDITS);
+  assert(f.begin.flags == BLE_BULK_FLAG_RESET && f.begin.firstPage == 0 && f.data == imu);
+
+  // Ring mode: a cursor below the oldest page starts there
+  g_tailPage = 120;
+  BulkResult g = runBulk(BLE_BULK_IMU, 7, BLE_BULK_DEFAULT_CREDITS);
+  assert(g.begin.firstPage == 120 && g.data == expectedRecords(false, 120, IMU_PAGES));
+  g_tailPage = 0;
+
+  BulkResult s = runBulk(BLE_BULK_SYNC, 0, BLE_BULK_DEFAULT_CREDITS);
+  assert(s.end.status == BLE_BULK_COMPLETE && s.data == expectedRecords(true, 0, SYNC_PAGES));
+
+  BulkResult h = runBulk(BLE_BULK_IMU, IMU_PAGES, BLE_BULK_DEFAULT_CREDITS);
+  assert(h.ended && h.end.status == BLE_BULK_COMPLETE && h.data.empty());
+
+  g_failPage = 50;
+  BulkResult k = runBulk(BLE_BULK_IMU, 0, BLE_BULK_DEFAULT_CREDITS);
+  assert(k.end.status == BLE_BULK_READ_ERROR && k.end.nextPage <= 50);
+  g_failPage = UINT32_MAX;
+  puts("bulk: ok");
+}
+
+// ============================================================================
+// TX RING
+// ============================================================================
+
+static void testCoalescing() {
+  takeNotes();
+
+  // 200 short lines while the stack confirms nothing
+  std::string expect;
+  for (int i = 0; i < 200; i++) {
+    char line[32];
+    snprintf(line, sizeof(line), "line %d", i);
+    blePrintln(line);
+    expect += line;
+    expect += "\n";
+  }
+
+  Notes notes = takeNotes();
+  assert(notes.size() == 4);  // the in-flight window
+  std::string got;
+  size_t count = 0;
+  while (!notes.empty()) {
+    for (const std::vector<uint8_t> &n : notes) {
+      assert(n.size() <= 244);
+      got.append(n.begin(), n.end());
+    }
+    count += notes.size();
+    for (int i = 0; i < 4; i++) sendConf();
+    notes = takeNotes();
+  }
+  assert(got == expect);
+  assert(count <= 4 + (expect.size() + 243) / 244);
+  printf("coalesce: %zu bytes in %zu notifications\n", got.size(), count);
+}
+
+static void testFullRing() {
+  const uint32_t dropped0 = txStats().droppedWrites;
+  const std::vector<uint8_t> blob(1000, 'x');
+
+  // The first write fills the window (976 bytes out), the ring takes four
+  // more, the rest are dropped whole
+  int accepted = 0;
+  for (int i = 0; i < 10; i++) {
+    if (bleWrite(blob.data(), blob.size())) accepted++;
+  }
+  BleTxStats st = txStats();
+  assert(accepted == 5 && st.droppedWrites - dropped0 == 5);
+  assert(st.ringUsed == 4024 && st.ringPeak == 4024);
+
+  assert(!bleTxHasRoom(2000));
+  assert(txStats().backpressure == 1);
+  assert(bleTxHasRoom(72));
+  printf("full ring: %d of 10 writes kept\n", accepted);
+}
+
+static void testCongestion() {
+  takeNotes();
+  sendCongest(true);
+  for (int i = 0; i < 4; i++) sendConf();
+  serviceBLETx();
+  assert(hostBle.notifications.empty());
+
+  sendCongest(false);
+  assert(hostBle.notifications.size() == 4);
+
+  // A completion reporting congestion pauses as well
+  takeNotes();
+  sendConf(ESP_GATT_CONGESTED);
+  assert(hostBle.notifications.empty());
+  sendCongest(false);
+  assert(hostBle.notifications.size() == 1);
+  assert(txStats().congestion == 2);
+}
+
+static void testConfTimeout() {
+  takeNotes();
+  const uint32_t timeouts0 = txStats().confTimeouts;
+  serviceBLETx();
+  assert(hostBle.notifications.empty());  // window full, no completions
+
+  delay(600);
+  serviceBLETx();
+  assert(hostBle.notifications.size() == 4);
+  assert(txStats().confTimeouts == timeouts0 + 1);
+
+  // The written-off four complete late: each completion frees one slot and
+  // the window stays at 4
+  takeNotes();
+  for (int i = 0; i < 6; i++) sendConf();
+  assert(takeNotes().size() == 6);
+  serviceBLETx();
+  assert(hostBle.notifications.empty());
+
+  // More completions than notifications in flight: settled up to the sent
+  // count, never past it, so the next write gets the whole window
+  for (int i = 0; i < 8; i++) sendConf();
+  takeNotes();
+  const std::string text(2000, 'y');
+  assert(bleWrite((const uint8_t *)text.data(), text.size()));
+  assert(takeNotes().size() == 4);
+}
+
+static void testDisconnect() {
+  assert(txStats().ringUsed > 0);
+  hostBle.server->onDisconnect(nullptr);
+  assert(txStats().ringUsed == 0);
+  assert(bleWrite((const uint8_t *)"x", 1));  // discarded, not dropped
+  assert(txStats().ringUsed == 0);
+
+  connect();
+  takeNotes();
+
+  hostBle.cccdOn = false;
+  blePrintln("hidden");
+  assert(hostBle.notifications.empty() && bleTxHasRoom(100000));
+  hostBle.cccdOn = true;
+
+  blePrintln("shown\n");
+  assert(hostBle.notifications.size() == 1);
+  const std::vector<uint8_t> &n = hostBle.notifications[0];
+  assert(std::string(n.begin(), n.end()) == "shown\n");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main() {
+  setvbuf(stdout, nullptr, _IONBF, 0);  // keep the log if an assert aborts
+
+  startBLEUart();
+  connect();
+
+  rxWrite({ 's', 't', 'a', 't', 'u', 's', '\n' });
+  assert(g_commands.size() == 1 && g_commands[0] == "status");
+
+  testBulk();
+  testCoalescing();
+  testFullRing();
+  testCongestion();
+  testConfTimeout();
+  testDisconnect();
+
+  const BleTxStats st = txStats();
+  printf("stats: notifications=%lu bytes=%lu dropped=%lu/%luB backpressure=%lu "
+         "congestion=%lu timeouts=%lu peak=%u\n",
+         (unsigned long)st.notifications, (unsigned long)st.bytes,
+         (unsigned long)st.droppedWrites, (unsigned long)st.droppedBytes,
+         (unsigned long)st.backpressure, (unsigned long)st.congestion,
+         (unsigned long)st.confTimeouts, st.ringPeak);
+  puts("OK");
+  return 0;
+}
@@ -0,0 +1,362 @@
+// =============================================================================
+// checkpoint_test — write-head checkpoint journal boot and power-loss test
+// =============================================================================
+//
+// Runs the real LoggerCore (logFrame, sync pages, checkpoint journal, boot
+// scans) over the NOR flash model in host/nor_flash.h. The flash writer is
+// replaced by synchronous programs, so every submitted job is durable when
+// it returns.
+//
+// Scenarios:
+//   1. blank flash: no record, the scan boot writes the first one
+//   2. restore: after a recording stops, a checkpoint boot gives back the
+//      IMU and sync heads, frame counters, session, epoch and record start,
+//      in a few reads (the scan boot's read count is printed next to it)
+//   3. roll forward: a boot mid-session (pages written after the newest
+//      record) still finds the head
+//   4. journal rotation: many records wrap both sectors; each sector is
+//      erased once per lap and the newest record always wins
+//   5. power cuts while a record is written (torn program, half-erased
+//      sector on entry): the next boot restores from the previous record
+//   6. a log erased behind the journal's back is not trusted (scan boot);
+//      an erase through the CLI path bumps the epoch and restores it
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -Ihost -I.. -o checkpoint_test checkpoint_test.cpp host/host_runtime.cpp host/nor_flash.cpp ../LoggerCore.cpp ../LoggerOutput.cpp ../LoggerHTTP.cpp ../LoggerFormat.cpp ../LoggerCRC.cpp ../LoggerDeflate.cpp
+//
+// Usage:
+//   ./checkpoint_test [seed] [cut_trials]      (defaults: 1, 2000)
+//
+// Exit status 0 when every check passes; the first failure aborts.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "LoggerCore.h"
+#include "LoggerWriter.h"
+#include "nor_flash.h"
+
+// Pins normally defined by the sketch
+const uint8_t PIN_FLASH_CS = 1;
+const uint8_t PIN_IMU_CS = 2;
+
+// ============================================================================
+// FIRMWARE STUBS (writer, BLE, beacon, CLI)
+// ============================================================================
+
+static uint8_t g_writerPage[FLASH_PAGE_SIZE];
+
+static void runJob(const uint8_t *buf, uint32_t addr, uint16_t len, uint8_t flags) {
+  if (flags & WRITER_JOB_ERASE_SECTOR) flash.eraseSector(addr);
+  flash.writePage(addr, buf, len);
+}
+
+uint8_t *writerAcquirePage() { return g_writerPage; }
+void writerSubmitPage(uint8_t *buf, uint32_t addr, uint16_t len, uint8_t flags) {
+  runJob(buf, addr, len, flags);
+}
+void writerSubmitCopy(const uint8_t *src, uint32_t addr, uint16_t len, uint8_t flags) {
+  runJob(src, addr, len, flags);
+}
+void writerDrain() {}
+uint32_t writerSubmitMark() { return 1; }
+bool writerReached(uint32_t) { return true; }
+void resetFlashWriterStats() {}
+
+bool bleConnected() { return false; }
+bool bleTxHasRoom(size_t) { return true; }
+bool bleWrite(const uint8_t *, size_t) { return true; }
+uint64_t getLastBeaconTimeMs() { return 0; }
+void printPrompt() {}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static uint32_t g_sampleMs = 1000;
+static Frame20 g_frame = {};
+
+// Log frames until 'pages' more pages are on flash (or recording stops).
+// The sketch bumps frameCounter after each accepted frame; so does this.
+static void recordPages(uint32_t pages) {
+  const uint32_t target = currentPage + pages;
+  while (currentPage < target) {
+    g_frame.q0++;
+    g_frame.ax += 3;
+    g_frame.mx -= 1;
+    g_sampleMs += 10;
+    if (logFrame(g_frame, g_sampleMs)) {
+      frameCounter++;
+    } else {
+      assert(mode != MODE_RECORDING);
+    }
+    if (mode != MODE_RECORDING) return;
+  }
+}
+
+// Fill and flush 'pages' whole sync pages.
+static void recordSyncPages(uint32_t pages) {
+  for (uint32_t p = 0; p < pages && syncCurrentPage < flashSyncPages; p++) {
+    while (syncFrameIndexInPage < SYNC_FRAMES_PER_PAGE) {
+      SyncFrame &f = syncFrames[syncFrameIndexInPage++];
+      memset(&f, 0, sizeof(f));
+      f.local_ms = g_sampleMs;
+      syncFrameCounter++;
+    }
+    flushSyncPageToFlash();
+  }
+}
+
+// What a boot has to give back.
+struct LogState {
+  uint32_t currentPage;
+  uint32_t frameCounter;
+  uint32_t recordStartPage;
+  uint32_t syncCurrentPage;
+  uint32_t syncFrameCounter;
+  uint16_t sessionID;
+  uint16_t logEpoch;
+};
+
+// The sync frames still buffered in RAM are lost at a reset; flush them so
+// the snapshot is what flash holds.
+static LogState snapshot() {
+  flushPendingSyncPageToFlash();
+  return LogState{ currentPage,      frameCounter,     recordStartPage, syncCurrentPage,
+                   syncFrameCounter, sessionID,        logEpoch };
+}
+
+static void checkState(const LogState &want, const char *what) {
+  // The frame that closed the last page opened the next one (see ring_test)
+  if (currentPage != want.currentPage || recordStartPage != want.recordStartPage ||
+      (frameCounter != want.frameCounter && frameCounter != want.frameCounter + 1) ||
+      syncCurrentPage != want.syncCurrentPage || syncFrameCounter != want.syncFrameCounter ||
+      sessionID != want.sessionID || logEpoch != want.logEpoch) {
+    printf("FAIL %s: head %lu/%lu frame %lu/%lu start %lu/%lu sync %lu/%lu syncID %lu/%lu "
+           "session %u/%u epoch %u/%u\n",
+           what, (unsigned long)currentPage, (unsigned long)want.currentPage,
+           (unsigned long)frameCounter, (unsigned long)want.frameCounter,
+           (unsigned long)recordStartPage, (unsigned long)want.recordStartPage,
+           (unsigned long)syncCurrentPage, (unsigned long)want.syncCurrentPage,
+           (unsigned long)syncFrameCounter, (unsigned long)want.syncFrameCounter,
+           sessionID, want.sessionID, logEpoch, want.logEpoch);
+    abort();
+  }
+}
+
+// The sketch's boot path: checkpoint, or the scans followed by a checkpoint.
+// RAM starts from zero, as after a reset. Returns the flash reads it took.
+static uint32_t boot(bool useCheckpoint) {
+  currentPage = 0;
+  frameCounter = 0;
+  recordStartPage = 0;
+  syncCurrentPage = 0;
+  syncFrameCounter = 0;
+  syncFrameIndexInPage = 0;
+  frameIndexInPage = 0;
+  sessionID = 0;
+  logEpoch = 0;
+  bootFromCheckpoint = false;
+  mode = MODE_IDLE;
+
+  const uint32_t reads0 = hostNor.reads;
+  if (!useCheckpoint || !restoreFromCheckpoint()) {
+    scanFlashOnBoot();
+    scanSyncPagesOnBoot();
+    reconstructFrameCounterFromFlash();
+    writeCheckpoint();
+  }
+  return hostNor.reads - reads0;
+}
+
+// The CLI's erase: wipe the log, restart the journal, bump the epoch.
+static void eraseLog() {
+  norEraseAll();
+  resetCheckpointJournal();
+  currentPage = 0;
+  frameCounter = 0;
+  recordStartPage = 0;
+  syncCurrentPage = 0;
+  syncFrameCounter = 0;
+  syncFrameIndexInPage = 0;
+  logEpoch++;
+  writeCheckpoint();
+}
+
+// Erases of the journal's sectors (the rest of the tail is slot storage).
+static uint32_t g_journalErases = 0;
+
+static void countJournalErases(uint32_t addr, uint32_t len) {
+  const uint32_t journal = (flashStorageBasePage + STORAGE_SLOT_LIMIT) * FLASH_PAGE_SIZE;
+  if (len == FLASH_SECTOR_SIZE && addr >= journal) g_journalErases++;
+}
+
+// ============================================================================
+// SCENARIOS
+// ============================================================================
+
+static void testBlank() {
+  assert(!restoreFromCheckpoint());
+  boot(true);
+  assert(!bootFromCheckpoint && currentPage == 0);
+
+  const LogState empty = snapshot();
+  boot(true);
+  assert(bootFromCheckpoint);
+  checkState(empty, "blank");
+  puts("blank: scan boot, then restore");
+}
+
+static void testRestore() {
+  startNewRecordingSession();
+  recordPages(300);
+  recordSyncPages(5);
+  recordPages(17);
+  mode = MODE_IDLE;
+  const LogState want = snapshot();
+  writeCheckpoint();  // the stop path
+
+  const uint32_t reads = boot(true);
+  assert(bootFromCheckpoint);
+  checkState(want, "restore");
+  assert(reads <= 20);
+
+  const uint32_t scanReads = boot(false);
+  assert(!bootFromCheckpoint && currentPage == want.currentPage);
+  printf("restore: %lu reads (scan boot: %lu)\n", (unsigned long)reads,
+         (unsigned long)scanReads);
+
+  // The scans cannot know the session or the epoch; put them back
+  sessionID = want.sessionID;
+  logEpoch = want.logEpoch;
+  writeCheckpoint();
+}
+
+static void testRollForward() {
+  startNewRecordingSession();
+  recordPages(CHECKPOINT_INTERVAL_PAGES - currentPage % CHECKPOINT_INTERVAL_PAGES);
+  recordPages(CHECKPOINT_INTERVAL_PAGES - 3);  // all after the newest record
+  recordSyncPages(2);
+  const LogState want = snapshot();
+
+  boot(true);
+  assert(bootFromCheckpoint);
+  checkState(want, "roll forward");
+  puts("roll forward: ok");
+}
+
+static void testRotation() {
+  const uint32_t records = 5 * 2 * FLASH_SECTOR_SIZE / sizeof(LogCheckpoint);
+  mode = MODE_RECORDING;
+  for (uint32_t i = 0; i < records; i++) {
+    if (i % 50 == 0) recordPages(1);
+    writeCheckpoint();
+  }
+  mode = MODE_IDLE;
+
+  g_journalErases = 0;
+  hostNor.checkRange = countJournalErases;
+  for (uint32_t i = 0; i < records; i++) writeCheckpoint();
+  hostNor.checkRange = nullptr;
+  assert(g_journalErases == records / (FLASH_SECTOR_SIZE / sizeof(LogCheckpoint)));
+
+  const LogState want = snapshot();
+  boot(true);
+  assert(bootFromCheckpoint);
+  checkState(want, "rotation");
+  printf("rotation: %lu records, %lu journal erases\n", (unsigned long)records,
+         (unsigned long)g_journalErases);
+}
+
+static void testCuts(int trials) {
+  int restored = 0, entries = 0;
+  for (int t = 0; t < trials; t++) {
+    if (currentPage + 100 > flashImuPages) {
+      eraseLog();
+      startNewRecordingSession();
+    }
+
+    mode = MODE_RECORDING;
+    recordPages(1 + (uint32_t)rand() % 40);
+    if (rand() % 4 == 0) recordSyncPages(1);
+    for (int n = rand() % 100; n > 0; n--) writeCheckpoint();  // spread over the sectors
+    const LogState want = snapshot();
+
+    // Entering a sector is an erase, then a program; anything else a program
+    g_journalErases = 0;
+    hostNor.checkRange = countJournalErases;
+    norArmCut(rand() % 2);
+    try {
+      writeCheckpoint();
+    } catch (const PowerCut &) {
+    }
+    norDisarmCut();
+    hostNor.checkRange = nullptr;
+
+    boot(true);
+    if (!bootFromCheckpoint) {
+      printf("FAIL cut %d: no checkpoint boot\n", t);
+      abort();
+    }
+    checkState(want, "cut");
+    if (hostNor.cutHappened) restored++;
+    if (hostNor.cutHappened && g_journalErases) entries++;
+  }
+  printf("cuts: %d trials, %d cut mid-record (%d entering a sector)\n", trials, restored,
+         entries);
+}
+
+static void testErase() {
+  mode = MODE_RECORDING;
+  recordPages(20);
+  mode = MODE_IDLE;
+  writeCheckpoint();
+
+  // The log is gone but the journal is not: its head cannot be confirmed
+  std::fill(hostNor.mem.begin(),
+            hostNor.mem.begin() + (flashImuPages + flashSyncPages) * FLASH_PAGE_SIZE, 0xFF);
+  boot(true);
+  assert(!bootFromCheckpoint && currentPage == 0 && syncCurrentPage == 0);
+
+  const uint16_t epoch = logEpoch;
+  eraseLog();
+  const LogState want = snapshot();
+  boot(true);
+  assert(bootFromCheckpoint && logEpoch == (uint16_t)(epoch + 1));
+  checkState(want, "erase");
+  puts("erase: ok");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char **argv) {
+  const unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 0) : 1;
+  const int trials = argc > 2 ? atoi(argv[2]) : 2000;
+  srand(seed);
+  setvbuf(stdout, nullptr, _IONBF, 0);  // keep the log if an assert aborts
+
+  Serial.begin(0);
+  flashPresent = true;
+  flashCapacityBytes = HOST_NOR_BYTES;
+  flashTotalPages = HOST_NOR_BYTES / FLASH_PAGE_SIZE;
+  flashRecordPages = flashTotalPages - FLASH_RESERVED_PAGES;
+  computeFlashLayout();
+  printf("seed %u: imu pages %lu, sync pages %lu\n", seed, (unsigned long)flashImuPages,
+         (unsigned long)flashSyncPages);
+
+  testBlank();
+  testRestore();
+  testRollForward();
+  testRotation();
+  testCuts(trials);
+  testErase();
+
+  puts("OK");
+  return 0;
+}
@@ -0,0 +1,180 @@
+// =============================================================================
+// crc16_bench — LoggerCRC exactness test and throughput table
+// =============================================================================
+//
+// Checks the table-driven CRC-16-CCITT in LoggerCRC against the bit-serial
+// reference it replaced (kept here), then times both.
+//
+// Checks:
+//   1. check value: crc16_ccitt("123456789") == 0x29B1
+//   2. one-shot: random buffers of 0..4096 bytes at every start alignment
+//      equal the reference
+//   3. incremental: each buffer cut at random split points (1 to 8 pieces,
+//      empty pieces included) and chained through crc16_ccitt_update()
+//      equals the one-shot CRC
+//
+// Throughput (host CPU; the firmware uses the same tables unless the ESP32
+// ROM routine is selected):
+//   MB/s for the bit-serial reference and crc16_ccitt() at the sizes the
+//   firmware hashes: 24 (one frame), 250 (page body), 256 (page), 4096
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -I.. -o crc16_bench crc16_bench.cpp ../LoggerCRC.cpp
+//
+// Usage:
+//   ./crc16_bench [seed] [trials]      (defaults: 1, 20000)
+//
+// Exit status 0 when every check passes, 1 on the first mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "LoggerCRC.h"
+
+// ============================================================================
+// REFERENCE
+// ============================================================================
+
+// The original bit-serial implementation (poly 0x1021, init 0xFFFF).
+static uint16_t crc16_ccitt_ref(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// ============================================================================
+// EXACTNESS
+// ============================================================================
+
+#define MAX_LEN    4096
+#define MAX_PIECES 8
+
+static size_t randomLength() {
+  // Mostly short buffers (the table loop's head/tail paths), some long ones
+  switch (rand() % 4) {
+    case 0: return (size_t)(rand() % 16);
+    case 1: return (size_t)(rand() % 300);
+    default: return (size_t)(rand() % (MAX_LEN + 1));
+  }
+}
+
+static bool checkValue() {
+  const uint8_t check[] = "123456789";
+  const uint16_t got = crc16_ccitt(check, 9);
+  const uint16_t ref = crc16_ccitt_ref(check, 9);
+  printf("check value: 0x%04X (reference 0x%04X)\n", got, ref);
+  return got == 0x29B1 && ref == 0x29B1;
+}
+
+static bool checkRandom(int trials) {
+  std::vector<uint8_t> buf(MAX_LEN + 8);
+
+  for (int t = 0; t < trials; t++) {
+    const size_t len = randomLength();
+    const size_t align = (size_t)(t % 8);
+    uint8_t *data = buf.data() + align;
+    for (size_t i = 0; i < len; i++) data[i] = (uint8_t)rand();
+
+    const uint16_t ref = crc16_ccitt_ref(data, len);
+    const uint16_t one = crc16_ccitt(data, len);
+    if (one != ref) {
+      printf("FAIL one-shot: len %zu align %zu: 0x%04X, reference 0x%04X\n", len, align, one,
+             ref);
+      return false;
+    }
+
+    // Random split points, sorted; duplicates give empty pieces
+    const int pieces = 1 + rand() % MAX_PIECES;
+    size_t cuts[MAX_PIECES + 1];
+    cuts[0] = 0;
+    for (int p = 1; p < pieces; p++) cuts[p] = len ? (size_t)rand() % (len + 1) : 0;
+    cuts[pieces] = len;
+    for (int p = 1; p < pieces; p++) {
+      for (int q = p + 1; q < pieces; q++) {
+        if (cuts[q] < cuts[p]) {
+          const size_t tmp = cuts[p];
+          cuts[p] = cuts[q];
+          cuts[q] = tmp;
+        }
+      }
+    }
+
+    uint16_t crc = CRC16_CCITT_INIT;
+    for (int p = 0; p < pieces; p++) {
+      crc = crc16_ccitt_update(crc, data + cuts[p], cuts[p + 1] - cuts[p]);
+    }
+    if (crc != ref) {
+      printf("FAIL incremental: len %zu in %d pieces: 0x%04X, reference 0x%04X\n", len,
+             pieces, crc, ref);
+      return false;
+    }
+  }
+
+  printf("random: %d buffers, one-shot and incremental match the reference\n", trials);
+  return true;
+}
+
+// ============================================================================
+// THROUGHPUT
+// ============================================================================
+
+typedef uint16_t (*CrcFn)(const uint8_t *, size_t);
+
+static volatile uint16_t g_sink;
+
+// MB/s over 'totalBytes' of input
+static double measure(CrcFn fn, uint8_t *data, size_t len, size_t totalBytes) {
+  const size_t iters = totalBytes / len;
+  uint16_t acc = 0;
+
+  const auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iters; i++) {
+    acc ^= fn(data, len);
+    data[0] = (uint8_t)acc;  // each call depends on the last one
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+
+  g_sink = acc;
+  const double s = std::chrono::duration<double>(t1 - t0).count();
+  return (double)(iters * len) / s / 1e6;
+}
+
+static void throughput() {
+  static const size_t kSizes[] = { 24, 250, 256, 4096 };
+  std::vector<uint8_t> buf(MAX_LEN);
+  for (uint8_t &b : buf) b = (uint8_t)rand();
+
+  printf("\n%8s %14s %14s %9s\n", "bytes", "bit-serial", "crc16_ccitt", "speedup");
+  for (size_t len : kSizes) {
+    const double ref = measure(crc16_ccitt_ref, buf.data(), len, (size_t)8 << 20);
+    const double fast = measure(crc16_ccitt, buf.data(), len, (size_t)64 << 20);
+    printf("%8zu %9.1f MB/s %9.1f MB/s %8.1fx\n", len, ref, fast, fast / ref);
+  }
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char **argv) {
+  const unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 0) : 1;
+  const int trials = argc > 2 ? atoi(argv[2]) : 20000;
+  srand(seed);
+
+  if (!checkValue() || !checkRandom(trials)) {
+    return 1;
+  }
+
+  throughput();
+  puts("\nOK");
+  return 0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+// =============================================================================
+// Host build shim: Arduino core (ESP32) subset
+// =============================================================================
+//
+// Just enough of the Arduino-ESP32 API for the firmware modules to compile
+// and run on Linux inside the host tests in tools/. Output through Serial is
+// discarded; time comes from CLOCK_MONOTONIC (host_runtime.cpp).
+//
+// Not a simulator: no pins, no interrupts, no second core. FreeRTOS calls
+// are single-threaded stand-ins (see freertos/).
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define IRAM_ATTR
+
+typedef bool boolean;
+
+class String {
+public:
+  String() {}
+  String(const char *s) : s_(s ? s : "") {}
+  String(const char *s, size_t n) : s_(s, n) {}
+
+  size_t length() const { return s_.size(); }
+  const char *c_str() const { return s_.c_str(); }
+  char operator[](size_t i) const { return s_[i]; }
+  String &operator+=(char c) {
+    s_ += c;
+    return *this;
+  }
+  int toInt() const { return atoi(s_.c_str()); }
+  bool operator==(const char *o) const { return s_ == o; }
+
+private:
+  std::string s_;
+};
+
+// Print formats nothing: host tests check bytes through the output sinks
+// and module state, not through Serial text.
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const char *) { return 0; }
+  size_t print(const String &) { return 0; }
+  size_t print(char) { return 0; }
+  size_t print(int, int = DEC) { return 0; }
+  size_t print(unsigned, int = DEC) { return 0; }
+  size_t print(long, int = DEC) { return 0; }
+  size_t print(unsigned long, int = DEC) { return 0; }
+  size_t print(long long, int = DEC) { return 0; }
+  size_t print(unsigned long long, int = DEC) { return 0; }
+  size_t print(double, int = 2) { return 0; }
+  template <typename T> size_t println(T v) { return print(v); }
+  template <typename T> size_t println(T v, int f) { return print(v, f); }
+  size_t println() { return 0; }
+  size_t printf(const char *, ...) __attribute__((format(printf, 2, 3))) { return 0; }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t readBytes(uint8_t *, size_t) { return 0; }
+  void setTimeout(unsigned long) {}
+};
+
+// USB CDC with a host attached that reads everything.
+class HWCDC : public Stream {
+public:
+  void begin(unsigned long) {}
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t *, size_t n) override { return n; }
+  using Print::write;
+  int availableForWrite() override { return 4096; }
+  operator bool() const { return true; }
+  void setTxTimeoutMs(uint32_t) {}
+  void setTxBufferSize(size_t) {}
+};
+
+extern HWCDC Serial;
+
+struct EspClass {
+  uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getMinFreeHeap() { return 150000; }
+  uint32_t getMaxAllocHeap() { return 100000; }
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(int, void (*)(), int);
+void detachInterrupt(int);
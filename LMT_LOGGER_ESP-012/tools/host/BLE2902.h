@@ -0,0 +1,11 @@
+#pragma once
+
+// Host build shim: client characteristic configuration descriptor. Reports
+// hostBle.cccdOn (see BLEDevice.h).
+
+#include "BLEDevice.h"
+
+class BLE2902 : public BLEDescriptor {
+public:
+  bool getNotifications() { return hostBle.cccdOn; }
+};
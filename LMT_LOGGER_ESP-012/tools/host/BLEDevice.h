@@ -0,0 +1,155 @@
+#pragma once
+
+// =============================================================================
+// Host build shim: Arduino-ESP32 BLE library (the parts LoggerBLE uses)
+// =============================================================================
+//
+// No radio. The stack's side of the conversation is exposed in hostBle so a
+// test can play the client and the controller:
+//
+//   - notify() appends the characteristic value to hostBle.notifications
+//   - hostBle.server / hostBle.chars[] are the callbacks and characteristics
+//     the firmware registered (chars in creation order: TX, then RX)
+//   - hostBle.gattsHandler delivers CONF / CONGEST events
+//   - hostBle.cccdOn is what the TX descriptor reports (client subscribed)
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "Arduino.h"
+
+#define ESP_PWR_LVL_P9 9
+
+#define ESP_GATT_OK        0x00
+#define ESP_GATT_CONGESTED 0x8f
+
+typedef uint8_t esp_bd_addr_t[6];
+typedef uint8_t esp_gatt_if_t;
+
+typedef enum {
+  ESP_GATTS_CONF_EVT = 5,
+  ESP_GATTS_CONGEST_EVT = 24
+} esp_gatts_cb_event_t;
+
+typedef union {
+  struct {
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+  } connect;
+  struct {
+    uint16_t conn_id;
+    uint16_t mtu;
+  } mtu;
+  struct {
+    int status;
+    uint16_t conn_id;
+    uint16_t handle;
+  } conf;
+  struct {
+    uint16_t conn_id;
+    bool congested;
+  } congest;
+} esp_ble_gatts_cb_param_t;
+
+typedef void (*gatts_event_handler)(esp_gatts_cb_event_t, esp_gatt_if_t,
+                                    esp_ble_gatts_cb_param_t *);
+
+class BLECharacteristic;
+class BLEServer;
+class BLEServerCallbacks;
+
+struct HostBle {
+  std::vector<std::vector<uint8_t>> notifications;
+  BLEServerCallbacks *server = nullptr;
+  BLECharacteristic *chars[2] = {};
+  int charCount = 0;
+  gatts_event_handler gattsHandler = nullptr;
+  bool cccdOn = true;
+  int connUpdates = 0;
+};
+
+inline HostBle hostBle;
+
+#define HOST_BLE_TX_HANDLE 42
+
+class BLEDescriptor {
+public:
+  virtual ~BLEDescriptor() {}
+};
+
+class BLECharacteristicCallbacks {
+public:
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onWrite(BLECharacteristic *) {}
+};
+
+class BLECharacteristic {
+public:
+  static const uint32_t PROPERTY_NOTIFY = 0x01;
+  static const uint32_t PROPERTY_WRITE = 0x02;
+  static const uint32_t PROPERTY_WRITE_NR = 0x04;
+
+  std::vector<uint8_t> value;
+  BLECharacteristicCallbacks *callbacks = nullptr;
+
+  void setValue(const uint8_t *data, size_t len) { value.assign(data, data + len); }
+  void setValue(uint8_t *data, size_t len) { value.assign(data, data + len); }
+  String getValue() { return String((const char *)value.data(), value.size()); }
+  void notify(bool = true) { hostBle.notifications.push_back(value); }
+  void addDescriptor(BLEDescriptor *) {}
+  uint16_t getHandle() { return HOST_BLE_TX_HANDLE; }
+  void setCallbacks(BLECharacteristicCallbacks *cb) { callbacks = cb; }
+};
+
+class BLEService {
+public:
+  BLECharacteristic *createCharacteristic(const char *, uint32_t) {
+    BLECharacteristic *c = new BLECharacteristic;
+    if (hostBle.charCount < 2) hostBle.chars[hostBle.charCount++] = c;
+    return c;
+  }
+  void start() {}
+};
+
+class BLEServerCallbacks {
+public:
+  virtual ~BLEServerCallbacks() {}
+  virtual void onConnect(BLEServer *) {}
+  virtual void onConnect(BLEServer *, esp_ble_gatts_cb_param_t *) {}
+  virtual void onDisconnect(BLEServer *) {}
+  virtual void onMtuChanged(BLEServer *, esp_ble_gatts_cb_param_t *) {}
+};
+
+class BLEServer {
+public:
+  void setCallbacks(BLEServerCallbacks *cb) { hostBle.server = cb; }
+  BLEService *createService(const char *) { return new BLEService; }
+  void disconnect(uint16_t) {}
+  uint16_t getConnId() { return 0; }
+  void updateConnParams(esp_bd_addr_t, uint16_t, uint16_t, uint16_t, uint16_t) {
+    hostBle.connUpdates++;
+  }
+};
+
+class BLEAdvertising {
+public:
+  void addServiceUUID(const char *) {}
+  void start() {}
+  void stop() {}
+};
+
+class BLEDevice {
+public:
+  static void init(const char *) {}
+  static void setPower(int) {}
+  static int setMTU(uint16_t) { return 0; }
+  static BLEServer *createServer() { return new BLEServer; }
+  static BLEAdvertising *getAdvertising() {
+    static BLEAdvertising adv;
+    return &adv;
+  }
+  static void startAdvertising() {}
+  static void setCustomGattsHandler(gatts_event_handler h) { hostBle.gattsHandler = h; }
+};
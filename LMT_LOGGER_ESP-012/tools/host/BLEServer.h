@@ -0,0 +1,5 @@
+#pragma once
+
+// Host build shim: declared in BLEDevice.h.
+
+#include "BLEDevice.h"
@@ -0,0 +1,92 @@
+#pragma once
+
+// Host build shim: SparkFun ICM-20948 driver (the parts the firmware uses).
+// Every call reports FIFO empty; host tests feed frames to logFrame().
+
+#include "Arduino.h"
+#include "SPI.h"
+
+typedef enum {
+  ICM_20948_Stat_Ok = 0,
+  ICM_20948_Stat_FIFOMoreDataAvail,
+  ICM_20948_Stat_FIFONoDataAvail,
+  ICM_20948_Stat_Err
+} ICM_20948_Status_e;
+
+enum {
+  INV_ICM20948_SENSOR_ORIENTATION = 1,
+  INV_ICM20948_SENSOR_RAW_ACCELEROMETER,
+  INV_ICM20948_SENSOR_MAGNETIC_FIELD_UNCALIBRATED
+};
+
+enum { DMP_ODR_Reg_Quat9 = 1, DMP_ODR_Reg_Accel, DMP_ODR_Reg_Cpass };
+
+#define DMP_header_bitmap_Quat9 0x0400
+#define DMP_header_bitmap_Accel 0x8000
+#define DMP_header_bitmap_Compass 0x2000
+
+typedef struct {
+  uint16_t header;
+  uint16_t header2;
+  struct {
+    struct {
+      int32_t Q1, Q2, Q3;
+      int16_t Accuracy;
+    } Data;
+  } Quat9;
+  struct {
+    struct {
+      int16_t X, Y, Z;
+    } Data;
+  } Raw_Accel;
+  struct {
+    struct {
+      int16_t X, Y, Z;
+    } Data;
+  } Compass;
+} icm_20948_DMP_data_t;
+
+typedef struct {
+  struct {
+    struct {
+      int16_t x, y, z;
+    } axes;
+  } acc, gyr, mag;
+} ICM_20948_AGMT_t;
+
+typedef enum {
+  ICM_20948_Internal_Acc = (1 << 0),
+  ICM_20948_Internal_Gyr = (1 << 1)
+} ICM_20948_InternalSensorID_bm;
+
+typedef struct {
+  uint16_t a;
+  uint8_t g;
+} ICM_20948_smplrt_t;
+
+class ICM_20948_SPI {
+public:
+  ICM_20948_Status_e status = ICM_20948_Stat_FIFONoDataAvail;
+  ICM_20948_AGMT_t agmt = {};
+
+  ICM_20948_Status_e begin(uint8_t, SPIClass &, uint32_t = 7000000) { return status; }
+  ICM_20948_Status_e startupMagnetometer(bool = false) { return status; }
+  ICM_20948_Status_e initializeDMP() { return status; }
+  ICM_20948_Status_e enableDMPSensor(int, bool = true) { return status; }
+  ICM_20948_Status_e setDMPODRrate(int, int) { return status; }
+  ICM_20948_Status_e setSampleRate(uint8_t, ICM_20948_smplrt_t) { return status; }
+  ICM_20948_Status_e setGyroSF(unsigned char, int) { return status; }
+  ICM_20948_Status_e enableFIFO(bool = true) { return status; }
+  ICM_20948_Status_e enableDMP(bool = true) { return status; }
+  ICM_20948_Status_e resetDMP() { return status; }
+  ICM_20948_Status_e resetFIFO() { return status; }
+  ICM_20948_Status_e readDMPdataFromFIFO(icm_20948_DMP_data_t *data) {
+    data->header = 0;
+    return status;
+  }
+  ICM_20948_AGMT_t getAGMT() { return agmt; }
+  ICM_20948_Status_e cfgIntActiveLow(bool) { return status; }
+  ICM_20948_Status_e cfgIntOpenDrain(bool) { return status; }
+  ICM_20948_Status_e cfgIntLatch(bool) { return status; }
+  ICM_20948_Status_e intEnableDMP(bool) { return status; }
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+// Host build shim: SPI bus. Nothing answers unless a test attaches a device
+// to hostSpi (most tests mock flash at the SPIFlash level instead, see
+// nor_flash.h):
+//
+//   - hostSpi.device sees every chip-select write (digitalWrite) and every
+//     byte clocked, and answers MISO
+//   - hostSpi.clock is the clock of the open transaction
+//   - hostSpi.byteCalls / bulkCalls count single-byte and buffer transfers
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+#define SPI_MODE3 3
+
+struct SPISettings {
+  SPISettings() {}
+  SPISettings(uint32_t clock, uint8_t, uint8_t) : clock(clock) {}
+  uint32_t clock = 0;
+};
+
+class HostSpiDevice {
+public:
+  virtual ~HostSpiDevice() {}
+  virtual void pinWrite(uint8_t pin, uint8_t level) = 0;
+  virtual uint8_t exchange(uint8_t mosi) = 0;
+};
+
+struct HostSpi {
+  HostSpiDevice *device = nullptr;
+  uint32_t clock = 0;
+  uint32_t byteCalls = 0;
+  uint32_t bulkCalls = 0;
+};
+
+inline HostSpi hostSpi;
+
+class SPIClass {
+public:
+  void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+  void beginTransaction(SPISettings s) { hostSpi.clock = s.clock; }
+  void endTransaction() {}
+  uint8_t transfer(uint8_t b) {
+    hostSpi.byteCalls++;
+    return hostSpi.device ? hostSpi.device->exchange(b) : 0;
+  }
+  void transfer(void *buf, uint32_t n) { transferBytes((uint8_t *)buf, (uint8_t *)buf, n); }
+  void transferBytes(const uint8_t *out, uint8_t *in, uint32_t n) {
+    hostSpi.bulkCalls++;
+    if (!hostSpi.device) return;
+    for (uint32_t i = 0; i < n; i++) {
+      const uint8_t b = hostSpi.device->exchange(out ? out[i] : 0xFF);
+      if (in) in[i] = b;
+    }
+  }
+  void writeBytes(const uint8_t *out, uint32_t n) { transferBytes(out, nullptr, n); }
+  void setFrequency(uint32_t hz) { hostSpi.clock = hz; }
+};
+
+extern SPIClass SPI;
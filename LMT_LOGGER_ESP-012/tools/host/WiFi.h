@@ -0,0 +1,32 @@
+#pragma once
+
+// Host build shim: Wi-Fi server with no clients. Lets LoggerHTTP link into
+// host tests that only use its record helpers (loadPageRecords()).
+
+#include "Arduino.h"
+
+class WiFiClient : public Stream {
+public:
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t *, size_t n) override { return n; }
+  using Print::write;
+  uint8_t connected() { return 0; }
+  void stop() {}
+  void setNoDelay(bool) {}
+  int fd() const { return -1; }
+  explicit operator bool() const { return false; }
+};
+
+class WiFiServer {
+public:
+  WiFiServer(uint16_t = 80, uint8_t = 4) {}
+  void begin() {}
+  void stop() {}
+  void end() {}
+  void setNoDelay(bool) {}
+  bool hasClient() { return false; }
+  WiFiClient accept() { return WiFiClient(); }
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+// Host build shim: ESP-IDF die temperature sensor (reads 0 C).
+
+#include "esp_err.h"
+
+typedef void *temperature_sensor_handle_t;
+
+typedef struct {
+  int range_min;
+  int range_max;
+} temperature_sensor_config_t;
+
+#define TEMPERATURE_SENSOR_CONFIG_DEFAULT(min, max) {min, max}
+
+esp_err_t temperature_sensor_install(const temperature_sensor_config_t *,
+                                     temperature_sensor_handle_t *);
+esp_err_t temperature_sensor_enable(temperature_sensor_handle_t);
+esp_err_t temperature_sensor_get_celsius(temperature_sensor_handle_t, float *);
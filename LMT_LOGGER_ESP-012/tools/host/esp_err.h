@@ -0,0 +1,8 @@
+#pragma once
+
+// Host build shim: ESP-IDF error codes.
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
@@ -0,0 +1,16 @@
+#pragma once
+
+// Host build shim: queue API (declarations only; the writer task is
+// replaced by each test).
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t);
+BaseType_t xQueueSend(QueueHandle_t, const void *, TickType_t);
+BaseType_t xQueueSendFromISR(QueueHandle_t, const void *, BaseType_t *);
+BaseType_t xQueueReceive(QueueHandle_t, void *, TickType_t);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t);
+void vQueueDelete(QueueHandle_t);
@@ -0,0 +1,22 @@
+#pragma once
+
+// Host build shim: tasks are created but never run (host tests call the
+// service functions directly); delays return at once.
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t,
+                       TaskHandle_t *);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t,
+                                   TaskHandle_t *, BaseType_t);
+void vTaskDelay(TickType_t);
+void vTaskDelete(TaskHandle_t);
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t);
+BaseType_t xTaskNotifyGive(TaskHandle_t);
+void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t *);
+TickType_t xTaskGetTickCount();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t);
+TaskHandle_t xTaskGetCurrentTaskHandle();
@@ -0,0 +1,99 @@
+// =============================================================================
+// Host build shim: runtime for the stand-in Arduino / FreeRTOS headers
+// =============================================================================
+//
+// Linked into every host test that builds firmware modules. Single thread:
+// tasks are never started, mutexes never block, ISR hooks do nothing.
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "driver/temperature_sensor.h"
+
+HWCDC Serial;
+SPIClass SPI;
+EspClass ESP;
+
+// ---- time ----
+
+static uint64_t monotonicUs() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000u + (uint64_t)t.tv_nsec / 1000u;
+}
+
+unsigned long millis() { return (unsigned long)(uint32_t)(monotonicUs() / 1000u); }
+unsigned long micros() { return (unsigned long)(uint32_t)monotonicUs(); }
+
+void delay(unsigned long ms) {
+  const uint64_t end = monotonicUs() + (uint64_t)ms * 1000u;
+  while (monotonicUs() < end) {
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  const uint64_t end = monotonicUs() + us;
+  while (monotonicUs() < end) {
+  }
+}
+
+void yield() {}
+
+// ---- pins ----
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (hostSpi.device) hostSpi.device->pinWrite(pin, level);
+}
+int digitalRead(uint8_t) { return HIGH; }
+int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int, void (*)(), int) {}
+void detachInterrupt(int) {}
+
+// ---- FreeRTOS ----
+
+static int g_handle;
+
+BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t,
+                       TaskHandle_t *task) {
+  if (task) *task = &g_handle;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *task,
+                                   BaseType_t) {
+  return xTaskCreate(fn, name, stack, arg, prio, task);
+}
+
+void vTaskDelay(TickType_t) {}
+void vTaskDelete(TaskHandle_t) {}
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t *) {}
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 1024; }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return &g_handle; }
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return &g_handle; }
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return &g_handle; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t) { return pdTRUE; }
+
+// ---- die temperature ----
+
+esp_err_t temperature_sensor_install(const temperature_sensor_config_t *,
+                                     temperature_sensor_handle_t *out) {
+  *out = &g_handle;
+  return ESP_OK;
+}
+
+esp_err_t temperature_sensor_enable(temperature_sensor_handle_t) { return ESP_OK; }
+
+esp_err_t temperature_sensor_get_celsius(temperature_sensor_handle_t, float *out) {
+  *out = 0.0f;
+  return ESP_OK;
+}
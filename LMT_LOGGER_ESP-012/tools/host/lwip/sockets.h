@@ -0,0 +1,6 @@
+#pragma once
+
+// Host build shim: lwIP sockets are BSD sockets.
+
+#include <errno.h>
+#include <sys/socket.h>
@@ -0,0 +1,60 @@
+// =============================================================================
+// Host build shim: NOR flash behind SPIFlash (see nor_flash.h)
+// =============================================================================
+
+#include "nor_flash.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool cutNow() {
+  if (hostNor.cutAfter < 0) return false;
+  if (hostNor.cutAfter-- > 0) return false;
+  hostNor.cutHappened = true;
+  return true;
+}
+
+SPIFlash::SPIFlash(uint8_t) {}
+
+bool SPIFlash::readData(uint32_t addr, uint8_t *buf, uint32_t len) {
+  if (addr + len > hostNor.mem.size()) return false;
+  hostNor.reads++;
+  memcpy(buf, &hostNor.mem[addr], len);
+  return true;
+}
+
+bool SPIFlash::writePage(uint32_t addr, const uint8_t *buf, uint16_t len) {
+  // PAGE PROGRAM wraps inside its page on a real part; no caller may rely on it
+  assert(len > 0 && addr / FLASH_PAGE_SIZE == (addr + len - 1) / FLASH_PAGE_SIZE);
+  assert(addr + len <= hostNor.mem.size());
+  if (hostNor.checkRange) hostNor.checkRange(addr, len);
+  hostNor.programs++;
+
+  uint16_t n = len;
+  const bool cut = cutNow();
+  if (cut) n = (uint16_t)(rand() % (len + 1));
+  for (uint16_t i = 0; i < n; i++) hostNor.mem[addr + i] &= buf[i];
+  if (cut) throw PowerCut();
+  return true;
+}
+
+bool SPIFlash::eraseSector(uint32_t addr) {
+  addr &= ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
+  assert(addr < hostNor.mem.size());
+  if (hostNor.checkRange) hostNor.checkRange(addr, FLASH_SECTOR_SIZE);
+  hostNor.erases++;
+
+  if (cutNow()) {
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE; i++) {
+      if (rand() & 1) hostNor.mem[addr + i] = 0xFF;
+    }
+    throw PowerCut();
+  }
+  memset(&hostNor.mem[addr], 0xFF, FLASH_SECTOR_SIZE);
+  return true;
+}
+
+bool SPIFlash::characterize(uint32_t, uint32_t, FlashTimingProfile &) {
+  return false;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// =============================================================================
+// Host build shim: NOR flash behind SPIFlash
+// =============================================================================
+//
+// Implements SPIFlash's data path (readData, writePage, eraseSector) over a
+// 1 MB RAM image with NOR semantics: an erase sets a 4 KB sector to 0xFF, a
+// program can only clear bits. Link tools/host/nor_flash.cpp instead of
+// ../SPIFlash.cpp. The test's side is exposed in hostNor:
+//
+//   - hostNor.mem is the image (norEraseAll() returns it to blank)
+//   - hostNor.reads / programs / erases count operations
+//   - hostNor.checkRange, when set, sees every program and erase range
+//   - norArmCut(n) cuts power at the n-th following program or erase
+//     (0: the next one). A cut program leaves a random prefix of its bytes
+//     programmed, a cut erase leaves the sector half erased (random bytes
+//     back to 0xFF); either then throws PowerCut.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "SPIFlash.h"
+
+#define HOST_NOR_BYTES (1u << 20)
+
+struct PowerCut {};
+
+struct HostNor {
+  std::vector<uint8_t> mem = std::vector<uint8_t>(HOST_NOR_BYTES, 0xFF);
+  uint32_t reads = 0;
+  uint32_t programs = 0;
+  uint32_t erases = 0;
+  long cutAfter = -1;  // flash ops until the power cut (-1: none)
+  bool cutHappened = false;
+  void (*checkRange)(uint32_t addr, uint32_t len) = nullptr;
+};
+
+inline HostNor hostNor;
+
+inline void norArmCut(long ops) {
+  hostNor.cutAfter = ops;
+  hostNor.cutHappened = false;
+}
+
+inline void norDisarmCut() { hostNor.cutAfter = -1; }
+
+inline void norEraseAll() { std::fill(hostNor.mem.begin(), hostNor.mem.end(), 0xFF); }
@@ -0,0 +1,320 @@
+// =============================================================================
+// http_stream_bench — host throughput benchmark for the /imu stream writer
+// =============================================================================
+//
+// Replays the firmware's two /imu body writers over a loopback TCP socket
+// (the stand-in for the logger's WiFiClient) and reports KB/s for each:
+//
+//   per-page : the previous writer; per page printf("10\r\n"), header,
+//              "\r\n", printf("100\r\n"), page, "\r\n" (6 writes, 2 chunks)
+//   batched  : LoggerHTTP's writer; HTTP_STREAM_BATCH_PAGES header + page
+//              records framed as one chunk and sent with one write
+//   gzip     : batched, each batch compressed by LoggerDeflate first
+//              (the "Accept-Encoding: gzip" response)
+//
+// The reader parses the chunked body (inflating it with zlib for gzip) and
+// checks every 'LMTP' record, so all writers are verified to produce the same
+// stream. Bytes on the wire are reported next to the throughput. '-w' adds a fixed cost per
+// write to model the per-call overhead of a small-MCU TCP stack.
+//
+// Input: a raw flash image (256-byte IMU pages) or, without one, synthetic
+// delta pages.
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -pthread -I.. -o http_stream_bench http_stream_bench.cpp ../LoggerFormat.cpp ../LoggerCRC.cpp ../LoggerDeflate.cpp -lz
+//
+// Usage:
+//   ./http_stream_bench [-p pages] [-w us_per_write] [flash.img]
+//
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <thread>
+#include <vector>
+
+#include "LoggerDeflate.h"
+#include "LoggerFormat.h"
+
+#define HTTP_STREAM_BATCH_PAGES 16  // keep in step with LoggerHTTP.cpp
+
+static std::vector<uint8_t> g_image;
+static uint32_t g_pages = 0;
+static unsigned g_writeCostUs = 0;
+
+static double nowSec() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned long g_writes = 0;
+
+static bool sendAll(int fd, const void *buf, size_t len) {
+  if (g_writeCostUs) {
+    const double until = nowSec() + g_writeCostUs * 1e-6;
+    while (nowSec() < until) {
+    }
+  }
+  g_writes++;
+
+  const uint8_t *p = (const uint8_t *)buf;
+  while (len > 0) {
+    const ssize_t n = send(fd, p, len, 0);
+    if (n <= 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool sendPrintf(int fd, const char *fmt, unsigned v) {
+  char tmp[16];
+  const int n = snprintf(tmp, sizeof(tmp), fmt, v);
+  return sendAll(fd, tmp, n);
+}
+
+static void writePerPage(int fd) {
+  for (uint32_t page = 0; page < g_pages; page++) {
+    const uint8_t *pageData = &g_image[(size_t)page * IMU_PAGE_BYTES];
+    uint8_t hdr[sizeof(StreamPageHeader)];
+    imuStreamHeader(page, pageData, hdr);
+
+    sendPrintf(fd, "%X\r\n", 16);
+    sendAll(fd, hdr, sizeof(hdr));
+    sendAll(fd, "\r\n", 2);
+    sendPrintf(fd, "%X\r\n", IMU_PAGE_BYTES);
+    sendAll(fd, pageData, IMU_PAGE_BYTES);
+    sendAll(fd, "\r\n", 2);
+  }
+  sendAll(fd, "0\r\n\r\n", 5);
+}
+
+// Frame data[0, len) as one chunk in place (8 bytes of room before, 2 after).
+static void sendChunk(int fd, uint8_t *data, uint32_t len) {
+  char size[9];
+  const int n = snprintf(size, sizeof(size), "%X\r\n", len);
+  memcpy(data - n, size, n);
+  data[len] = '\r';
+  data[len + 1] = '\n';
+  sendAll(fd, data - n, n + len + 2);
+}
+
+static GzipStream g_gzip;
+
+static void writeBatchedImpl(int fd, bool gzip) {
+  static uint8_t buf[8 + HTTP_STREAM_BATCH_PAGES * STREAM_RECORD_BYTES + 2];
+  static uint8_t zbuf[8 + gzipWriteBound(HTTP_STREAM_BATCH_PAGES * STREAM_RECORD_BYTES) + 2];
+  uint8_t *records = buf + 8;
+  uint8_t *zout = zbuf + 8;
+
+  if (gzip) gzipBegin(g_gzip);
+
+  for (uint32_t page = 0; page < g_pages;) {
+    const uint32_t left = g_pages - page;
+    const uint32_t batch = left > HTTP_STREAM_BATCH_PAGES ? HTTP_STREAM_BATCH_PAGES : left;
+
+    for (uint32_t k = 0; k < batch; k++) {
+      uint8_t *rec = records + k * STREAM_RECORD_BYTES;
+      memcpy(rec + 16, &g_image[(size_t)(page + k) * IMU_PAGE_BYTES], IMU_PAGE_BYTES);
+      imuStreamHeader(page + k, rec + 16, rec);
+    }
+
+    const uint32_t len = batch * STREAM_RECORD_BYTES;
+    if (gzip) {
+      sendChunk(fd, zout, gzipWrite(g_gzip, records, len, zout));
+    } else {
+      sendChunk(fd, records, len);
+    }
+
+    page += batch;
+  }
+  if (gzip) sendChunk(fd, zout, gzipFinish(g_gzip, zout));
+  sendAll(fd, "0\r\n\r\n", 5);
+}
+
+static void writeBatched(int fd) { writeBatchedImpl(fd, false); }
+static void writeGzip(int fd) { writeBatchedImpl(fd, true); }
+
+static bool g_expectGzip = false;
+static size_t g_wireBytes = 0;
+
+static bool gunzip(const std::vector<uint8_t> &in, std::vector<uint8_t> &out) {
+  z_stream zs = {};
+  if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) return false;
+  out.resize((size_t)g_pages * STREAM_RECORD_BYTES + 1);
+  zs.next_in = (Bytef *)in.data();
+  zs.avail_in = in.size();
+  zs.next_out = out.data();
+  zs.avail_out = out.size();
+  const int rc = inflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+  inflateEnd(&zs);
+  return rc == Z_STREAM_END;
+}
+
+// Read the whole chunked body; returns payload bytes, or -1 on a framing or
+// record error.
+static long readChunkedBody(int fd) {
+  std::vector<uint8_t> in;
+  uint8_t tmp[65536];
+  for (;;) {
+    const ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+    if (n <= 0) break;
+    in.insert(in.end(), tmp, tmp + n);
+  }
+
+  g_wireBytes = in.size();
+
+  std::vector<uint8_t> body;
+  size_t pos = 0;
+  for (;;) {
+    char *end = nullptr;
+    const unsigned long len = strtoul((const char *)&in[pos], &end, 16);
+    pos = (const uint8_t *)end - in.data() + 2;
+    if (len == 0) break;
+    if (pos + len + 2 > in.size()) return -1;
+    body.insert(body.end(), in.begin() + pos, in.begin() + pos + len);
+    pos += len + 2;
+  }
+
+  if (g_expectGzip) {
+    std::vector<uint8_t> plain;
+    if (!gunzip(body, plain)) return -1;
+    body.swap(plain);
+  }
+
+  if (body.size() != (size_t)g_pages * STREAM_RECORD_BYTES) return -1;
+  for (uint32_t page = 0; page < g_pages; page++) {
+    StreamPageHeader hdr;
+    memcpy(&hdr, &body[(size_t)page * STREAM_RECORD_BYTES], sizeof(hdr));
+    if (hdr.magic != FLASH_STREAM_MAGIC || hdr.pageIndex != page) return -1;
+    if (memcmp(&body[(size_t)page * STREAM_RECORD_BYTES + 16],
+               &g_image[(size_t)page * IMU_PAGE_BYTES], IMU_PAGE_BYTES) != 0) return -1;
+  }
+  return (long)body.size();
+}
+
+static double runOnce(void (*writer)(int), unsigned long &writes, long &bytes) {
+  g_expectGzip = (writer == writeGzip);
+
+  const int ls = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t alen = sizeof(addr);
+  bind(ls, (sockaddr *)&addr, sizeof(addr));
+  listen(ls, 1);
+  getsockname(ls, (sockaddr *)&addr, &alen);
+
+  const int cs = socket(AF_INET, SOCK_STREAM, 0);
+  connect(cs, (sockaddr *)&addr, sizeof(addr));
+  const int ss = accept(ls, nullptr, nullptr);
+
+  // Segments leave per write, as on the device's stack.
+  const int one = 1;
+  setsockopt(ss, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  g_writes = 0;
+  long got = 0;
+  std::thread reader([&] { got = readChunkedBody(cs); });
+
+  const double t0 = nowSec();
+  writer(ss);
+  shutdown(ss, SHUT_WR);
+  reader.join();
+  const double dt = nowSec() - t0;
+
+  close(ss);
+  close(cs);
+  close(ls);
+
+  writes = g_writes;
+  bytes = got;
+  return dt;
+}
+
+static void makeSyntheticImage(uint32_t pages) {
+  g_image.assign((size_t)pages * IMU_PAGE_BYTES, 0xFF);
+  Frame20 f = {};
+  uint32_t id = 1, ms = 0;
+  for (uint32_t p = 0; p < pages; p++) {
+    ImuPageEncoder e;
+    uint8_t *buf = &g_image[(size_t)p * IMU_PAGE_BYTES];
+    imuEncoderBegin(e, buf, PAGE_MAGIC_DELTA, FRAME_LAYOUT_TIMED);
+    const uint32_t start = ms;
+    while (!imuEncoderFull(e)) {
+      f.q0 += rand() % 7 - 3; f.ax += rand() % 31 - 15; f.mx += rand() % 3 - 1;
+      if (!imuEncoderAppend(e, f, ms, 0)) break;
+      ms += 10;
+    }
+    imuEncoderFinish(e, id, start);
+    id += e.frames;
+  }
+}
+
+int main(int argc, char **argv) {
+  uint32_t pages = 4096;
+  const char *path = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-p") && i + 1 < argc) pages = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "-w") && i + 1 < argc) g_writeCostUs = strtoul(argv[++i], nullptr, 10);
+    else path = argv[i];
+  }
+
+  if (path) {
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+      perror(path);
+      return 2;
+    }
+    uint8_t page[IMU_PAGE_BYTES];
+    while (fread(page, 1, sizeof(page), in) == sizeof(page) &&
+           decodeImuPage(page, nullptr) != IMU_PAGE_ABSENT) {
+      g_image.insert(g_image.end(), page, page + sizeof(page));
+    }
+    fclose(in);
+    g_pages = g_image.size() / IMU_PAGE_BYTES;
+  } else {
+    makeSyntheticImage(pages);
+    g_pages = pages;
+  }
+
+  printf("pages=%u (%.1f KB of records), write cost %u us\n", g_pages,
+         g_pages * STREAM_RECORD_BYTES / 1024.0, g_writeCostUs);
+
+  struct { const char *name; void (*fn)(int); double kbps; } modes[] = {
+    { "per-page", writePerPage, 0 },
+    { "batched ", writeBatched, 0 },
+    { "gzip    ", writeGzip, 0 },
+  };
+
+  for (auto &m : modes) {
+    unsigned long writes = 0;
+    long bytes = 0;
+    double best = 1e9;
+    for (int rep = 0; rep < 3; rep++) {
+      const double dt = runOnce(m.fn, writes, bytes);
+      if (bytes < 0) {
+        printf("%s: stream verification FAILED\n", m.name);
+        return 1;
+      }
+      if (dt < best) best = dt;
+    }
+    m.kbps = bytes / 1024.0 / best;
+    printf("%s: %8.0f KB/s  %7lu writes  %.3f s  %8.1f KB on the wire\n",
+           m.name, m.kbps, writes, best, g_wireBytes / 1024.0);
+  }
+
+  printf("speedup: %.1fx\n", modes[1].kbps / modes[0].kbps);
+  return 0;
+}
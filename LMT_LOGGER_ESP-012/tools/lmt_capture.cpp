@@ -0,0 +1,369 @@
+// =============================================================================
+// lmt_capture — capture a page dump (bdump) from the logger's USB serial port
+// =============================================================================
+//
+// Sends "bdump <imu|sync> <from> <pages>" and reads the reply framed as in
+// LoggerCore.h:
+//
+//   "#BDUMP <imu|sync> <first> <count> 272\r\n"
+//   count x [16-byte LMTP / LMTS header][256-byte page]
+//   BdumpEnd: 'LMTE', pages, crcBad, crc32 (16 bytes)
+//
+// Every record is checked: magic, consecutive page index, and the page CRC
+// recomputed here (firmware codec, LoggerFormat.cpp) against the header's
+// CRC-valid flag, so pages corrupted in transfer are told apart from pages
+// stored bad. The END record's page count and CRC-32 over all record bytes
+// are checked too.
+//
+// Output:
+//   -o FILE  records as received (an /imu or /sync export body; lmt_decode
+//            reads the IMU form)
+//   -c FILE  CSV, IMU: page,frame_id,time_ms,missed,q0,q1,q2,q3,ax,ay,az,mx,my,mz
+//                 sync: page,sync_id,master_unix_ms,local_ms,temp_c_x100,crc_ok
+//   Summary and throughput on stderr.
+//
+// Exit status: 0 ok, 1 pages stored or received bad, 2 usage / I/O error,
+// 3 protocol error or timeout.
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -I.. -o lmt_capture lmt_capture.cpp ../LoggerFormat.cpp ../LoggerCRC.cpp
+//
+// Usage:
+//   ./lmt_capture [-s] [-f from_page] [-n pages] [-o out.bin] [-c out.csv]
+//                 [-t idle_timeout_s] /dev/ttyACM0
+//
+// Testing without hardware: "lmt_standin -t imu.img" serves the same
+// framing on a pty and prints its path.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "LoggerCRC.h"
+#include "LoggerFormat.h"
+#include "LoggerSync.h"
+
+#define BDUMP_END_MAGIC    0x4C4D5445UL  // ASCII "LMTE"
+#define STREAM_HEADER_BYTES sizeof(StreamPageHeader)
+
+struct BdumpEnd {
+  uint32_t magic;
+  uint32_t pages;
+  uint32_t crcBad;
+  uint32_t crc32;
+};
+static_assert(sizeof(BdumpEnd) == 16, "BdumpEnd must be 16 bytes");
+
+// ============================================================================
+// SERIAL
+// ============================================================================
+
+static int g_fd = -1;
+static int g_idleMs = 5000;
+static std::string g_in;  // received, not yet consumed
+
+static int openSerial(const char *path) {
+  const int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+
+  termios t;
+  if (tcgetattr(fd, &t) == 0) {
+    cfmakeraw(&t);
+    cfsetispeed(&t, B115200);  // CDC ignores the rate; a UART bridge does not
+    cfsetospeed(&t, B115200);
+    t.c_cc[VMIN] = 0;
+    t.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &t);
+  }
+  tcflush(fd, TCIFLUSH);
+  return fd;
+}
+
+static bool writeAll(const char *s) {
+  size_t len = strlen(s);
+  while (len > 0) {
+    const ssize_t n = write(g_fd, s, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    s += n;
+    len -= n;
+  }
+  return true;
+}
+
+// Append more input to g_in; false on timeout or error.
+static bool fill() {
+  pollfd p = { g_fd, POLLIN, 0 };
+  const int r = poll(&p, 1, g_idleMs);
+  if (r <= 0) return false;
+
+  char buf[4096];
+  const ssize_t n = read(g_fd, buf, sizeof(buf));
+  if (n <= 0) return false;
+  g_in.append(buf, n);
+  return true;
+}
+
+// Consume exactly 'len' bytes into 'out'.
+static bool readExact(void *out, size_t len) {
+  while (g_in.size() < len) {
+    if (!fill()) return false;
+  }
+  memcpy(out, g_in.data(), len);
+  g_in.erase(0, len);
+  return true;
+}
+
+static double nowSeconds() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// ============================================================================
+// PAGE CHECKS
+// ============================================================================
+
+// CRC status computed here, as the firmware sets header flag bit1.
+static bool imuPageCrcOk(const uint8_t *page) {
+  PageFooter footer;
+  memcpy(&footer, page + IMU_PAGE_DATA_BYTES, sizeof(footer));
+  return imuFooterSane(footer) && decodeImuPage(page, nullptr) == IMU_PAGE_VALID;
+}
+
+static bool syncPageCrcOk(const uint8_t *page) {
+  SyncPageFooter footer;
+  memcpy(&footer, page + IMU_PAGE_BYTES - sizeof(footer), sizeof(footer));
+  if (footer.magic != SYNC_MAGIC || footer.validFrames > SYNC_FRAMES_PER_PAGE) return false;
+  const uint16_t crcLen =
+    footer.validFrames * sizeof(SyncFrame) + offsetof(SyncPageFooter, crc16);
+  return crc16_ccitt(page, crcLen) == footer.crc16;
+}
+
+static void writeImuCsv(FILE *csv, uint32_t pageIndex, const uint8_t *page) {
+  Frame20 frames[MAX_FRAMES_PER_PAGE];
+  ImuFrameTime times[MAX_FRAMES_PER_PAGE];
+  uint16_t n = 0;
+  if (decodeImuPage(page, frames, &n, times) == IMU_PAGE_ABSENT) return;
+
+  PageFooter footer;
+  memcpy(&footer, page + IMU_PAGE_DATA_BYTES, sizeof(footer));
+
+  for (uint16_t i = 0; i < n; i++) {
+    const Frame20 &f = frames[i];
+    fprintf(csv, "%lu,%lu,%lu,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+            (unsigned long)pageIndex,
+            (unsigned long)(footer.firstFrameID + i),
+            (unsigned long)times[i].ms,
+            times[i].missed,
+            f.q0, f.q1, f.q2, f.q3,
+            f.ax, f.ay, f.az,
+            f.mx, f.my, f.mz);
+  }
+}
+
+static void writeSyncCsv(FILE *csv, uint32_t pageIndex, const uint8_t *page) {
+  SyncPageFooter footer;
+  memcpy(&footer, page + IMU_PAGE_BYTES - sizeof(footer), sizeof(footer));
+  if (footer.magic != SYNC_MAGIC || footer.validFrames > SYNC_FRAMES_PER_PAGE) return;
+
+  for (uint16_t i = 0; i < footer.validFrames; i++) {
+    SyncFrame f;
+    memcpy(&f, page + i * sizeof(SyncFrame), sizeof(f));
+    const bool ok = crc16_ccitt((const uint8_t *)&f, offsetof(SyncFrame, crc16)) == f.crc16;
+    fprintf(csv, "%lu,%lu,%llu,%lu,%d,%d\n",
+            (unsigned long)pageIndex,
+            (unsigned long)(footer.firstSyncID + i),
+            (unsigned long long)f.master_unix_ms,
+            (unsigned long)f.local_ms,
+            f.temp_c_x100,
+            ok ? 1 : 0);
+  }
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char **argv) {
+  bool sync = false;
+  unsigned long from = 0, pages = 0;
+  const char *outPath = nullptr;
+  const char *csvPath = nullptr;
+  const char *dev = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-s")) sync = true;
+    else if (!strcmp(argv[i], "-f") && i + 1 < argc) from = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc) pages = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc) outPath = argv[++i];
+    else if (!strcmp(argv[i], "-c") && i + 1 < argc) csvPath = argv[++i];
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc) g_idleMs = atoi(argv[++i]) * 1000;
+    else if (!dev && argv[i][0] != '-') dev = argv[i];
+    else dev = nullptr, i = argc;
+  }
+
+  if (!dev) {
+    fprintf(stderr, "usage: %s [-s] [-f from_page] [-n pages] [-o out.bin] [-c out.csv] "
+                    "[-t idle_timeout_s] <serial device>\n", argv[0]);
+    return 2;
+  }
+
+  FILE *out = outPath ? fopen(outPath, "wb") : nullptr;
+  FILE *csv = csvPath ? fopen(csvPath, "w") : nullptr;
+  if ((outPath && !out) || (csvPath && !csv)) {
+    perror(outPath && !out ? outPath : csvPath);
+    return 2;
+  }
+  if (csv) {
+    fputs(sync ? "page,sync_id,master_unix_ms,local_ms,temp_c_x100,crc_ok\n"
+               : "page,frame_id,time_ms,missed,q0,q1,q2,q3,ax,ay,az,mx,my,mz\n",
+          csv);
+  }
+
+  g_fd = openSerial(dev);
+  if (g_fd < 0) return 2;
+
+  // Leading newline ends any partial line left in the device's CLI buffer
+  char cmd[64];
+  snprintf(cmd, sizeof(cmd), "\nbdump %s %lu %lu\n", sync ? "sync" : "imu", from, pages);
+  if (!writeAll(cmd)) {
+    perror(dev);
+    return 2;
+  }
+
+  // Skip prompt / earlier output up to the BEGIN line. A "# ..." line
+  // before it is a refusal (only text ahead of BEGIN counts: a short dump
+  // can arrive in one read, summary line included).
+  size_t begin;
+  for (;;) {
+    begin = g_in.find("#BDUMP ");
+    if (begin != std::string::npos && g_in.find('\n', begin) != std::string::npos) break;
+
+    const size_t text = begin == std::string::npos ? g_in.size() : begin;
+    const size_t refusal = g_in.find("\n# ");
+    if (refusal < text && g_in.find('\n', refusal + 1) < text) {
+      const size_t eol = g_in.find_first_of("\r\n", refusal + 1);
+      fprintf(stderr, "device refused: %s\n", g_in.substr(refusal + 3, eol - refusal - 3).c_str());
+      return 3;
+    }
+
+    if (!fill()) {
+      fprintf(stderr, "no #BDUMP reply (got %zu bytes)\n", g_in.size());
+      return 3;
+    }
+  }
+
+  const size_t eol = g_in.find('\n', begin);
+  char stream[8] = {};
+  unsigned long first = 0, count = 0, recordBytes = 0;
+  if (sscanf(g_in.c_str() + begin, "#BDUMP %7s %lu %lu %lu", stream, &first, &count,
+             &recordBytes) != 4 || recordBytes != STREAM_RECORD_BYTES ||
+      strcmp(stream, sync ? "sync" : "imu") != 0) {
+    fprintf(stderr, "bad #BDUMP line: %s\n", g_in.substr(begin, eol - begin).c_str());
+    return 3;
+  }
+  g_in.erase(0, eol + 1);
+
+  const uint32_t magic = sync ? SYNC_STREAM_MAGIC : FLASH_STREAM_MAGIC;
+  const double t0 = nowSeconds();
+
+  uint8_t rec[STREAM_RECORD_BYTES];
+  uint32_t crc32 = 0;
+  unsigned long storedBad = 0, transferBad = 0;
+  unsigned long received = 0;
+
+  for (unsigned long i = 0; i < count; i++) {
+    // A flash read error ends the dump early: END instead of the next record
+    uint32_t next = 0;
+    while (g_in.size() < sizeof(next) && fill()) {
+    }
+    if (g_in.size() >= sizeof(next)) memcpy(&next, g_in.data(), sizeof(next));
+    if (next == BDUMP_END_MAGIC) break;
+
+    if (!readExact(rec, sizeof(rec))) {
+      fprintf(stderr, "timeout after %lu of %lu pages\n", i, count);
+      return 3;
+    }
+    received++;
+
+    StreamPageHeader hdr;
+    memcpy(&hdr, rec, sizeof(hdr));
+    if (hdr.magic != magic || hdr.pageIndex != first + i || hdr.pageSize != IMU_PAGE_BYTES) {
+      fprintf(stderr, "record %lu: lost framing (magic %08lx page %lu)\n", i,
+              (unsigned long)hdr.magic, (unsigned long)hdr.pageIndex);
+      return 3;
+    }
+
+    const uint8_t *page = rec + STREAM_HEADER_BYTES;
+    const bool deviceOk = (hdr.flags & 0x0002) != 0;
+    const bool hostOk = sync ? syncPageCrcOk(page) : imuPageCrcOk(page);
+    if (!deviceOk) {
+      storedBad++;
+    }
+    if (deviceOk != hostOk) {
+      transferBad++;
+      fprintf(stderr, "page %lu: CRC %s on device, %s here (corrupted in transfer)\n",
+              (unsigned long)hdr.pageIndex, deviceOk ? "ok" : "bad", hostOk ? "ok" : "bad");
+    }
+
+    crc32 = crc32_ieee_update(crc32, rec, sizeof(rec));
+    if (out) fwrite(rec, 1, sizeof(rec), out);
+    if (csv) {
+      if (sync) writeSyncCsv(csv, hdr.pageIndex, page);
+      else writeImuCsv(csv, hdr.pageIndex, page);
+    }
+  }
+
+  BdumpEnd end;
+  if (!readExact(&end, sizeof(end)) || end.magic != BDUMP_END_MAGIC) {
+    fprintf(stderr, "missing END record\n");
+    return 3;
+  }
+
+  const double secs = nowSeconds() - t0;
+  const double bytes = (double)received * STREAM_RECORD_BYTES;
+
+  if (out) fclose(out);
+  if (csv) fclose(csv);
+
+  fprintf(stderr, "%s pages %lu-%lu: %lu pages, stored bad=%lu, transfer bad=%lu, "
+                  "%.0f bytes in %.2f s (%.1f KB/s)\n",
+          stream, first, first + received, received, storedBad, transferBad, bytes, secs,
+          secs > 0 ? bytes / 1024.0 / secs : 0.0);
+
+  if (end.pages != received) {
+    fprintf(stderr, "END reports %lu pages, received %lu\n", (unsigned long)end.pages, received);
+    return 3;
+  }
+  if (received != count) {
+    fprintf(stderr, "device stopped after %lu of %lu pages (flash read error)\n", received,
+            count);
+    return 3;
+  }
+  if (end.crc32 != crc32) {
+    fprintf(stderr, "stream CRC-32 mismatch: device %08lx, here %08lx\n",
+            (unsigned long)end.crc32, (unsigned long)crc32);
+    return 1;
+  }
+  if (end.crcBad != storedBad) {
+    fprintf(stderr, "device counted %lu bad pages, headers say %lu\n",
+            (unsigned long)end.crcBad, storedBad);
+    return 1;
+  }
+
+  return (storedBad || transferBad) ? 1 : 0;
+}
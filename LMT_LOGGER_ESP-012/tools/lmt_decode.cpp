@@ -0,0 +1,119 @@
+// =============================================================================
+// lmt_decode — host-side IMU page decoder
+// =============================================================================
+//
+// Decodes IMU pages (raw "PAGE" and delta "PAGD" encodings) to CSV using the
+// firmware's own codec (LoggerFormat.cpp), so both sides stay bit-exact.
+//
+// Input (auto-detected from the first 4 bytes):
+//   - an /imu HTTP export body: [FlashPageHeader 'LMTP'][256-byte page]...
+//   - a raw flash image: 256-byte pages from page 0
+// either as-is or gzip-compressed (a body saved with "Accept-Encoding: gzip"
+// but without decoding); zlib reads both forms.
+//
+// Output (stdout):
+//   page,frame_id,time_ms,missed,q0,q1,q2,q3,ax,ay,az,mx,my,mz
+// time_ms is exact for FRAME_LAYOUT_TIMED pages and assumes
+// UNTIMED_FRAME_PERIOD_MS spacing otherwise; missed is the gap marker
+// (samples lost just before the frame). Summary on stderr. Exit status 1 if any page failed its CRC.
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -I.. -o lmt_decode lmt_decode.cpp ../LoggerFormat.cpp ../LoggerCRC.cpp -lz
+//
+// Usage:
+//   curl -s http://<logger>/imu -o imu.bin && ./lmt_decode imu.bin > imu.csv
+//   curl -s -H 'Accept-Encoding: gzip' http://<logger>/imu -o imu.bin.gz &&
+//     ./lmt_decode imu.bin.gz > imu.csv
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "LoggerFormat.h"
+
+#define STREAM_HEADER_BYTES sizeof(StreamPageHeader)
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <imu.bin | flash.img>\n", argv[0]);
+    return 2;
+  }
+
+  gzFile in = gzopen(argv[1], "rb");
+  if (!in) {
+    perror(argv[1]);
+    return 2;
+  }
+
+  uint32_t magic = 0;
+  const bool stream =
+    gzread(in, &magic, sizeof(magic)) == sizeof(magic) &&
+    magic == FLASH_STREAM_MAGIC;
+  gzrewind(in);
+
+  printf("page,frame_id,time_ms,missed,q0,q1,q2,q3,ax,ay,az,mx,my,mz\n");
+
+  uint8_t hdr[STREAM_HEADER_BYTES];
+  uint8_t page[IMU_PAGE_BYTES];
+  Frame20 frames[MAX_FRAMES_PER_PAGE];
+  ImuFrameTime times[MAX_FRAMES_PER_PAGE];
+
+  unsigned long pages = 0, rawPages = 0, deltaPages = 0, badPages = 0;
+  unsigned long frameCount = 0, missedCount = 0, gapCount = 0;
+  uint32_t pageIndex = 0;
+
+  for (;;) {
+    if (stream) {
+      if (gzread(in, hdr, sizeof(hdr)) != sizeof(hdr)) break;
+      memcpy(&pageIndex, hdr + 4, sizeof(pageIndex));
+    }
+    if (gzread(in, page, sizeof(page)) != sizeof(page)) break;
+
+    uint16_t n = 0;
+    const ImuPageState st = decodeImuPage(page, frames, &n, times);
+
+    if (st == IMU_PAGE_ABSENT) {
+      if (!stream) break;  // end of log in a flash image
+      pageIndex++;
+      continue;
+    }
+
+    PageFooter footer;
+    memcpy(&footer, page + IMU_PAGE_DATA_BYTES, sizeof(footer));
+
+    pages++;
+    if (footer.magic == PAGE_MAGIC_DELTA) deltaPages++; else rawPages++;
+    if (st != IMU_PAGE_VALID) {
+      badPages++;
+      fprintf(stderr, "page %lu: CRC/decode error (%u of %u frames)\n",
+              (unsigned long)pageIndex, n, footer.validFrames);
+    }
+
+    for (uint16_t i = 0; i < n; i++) {
+      const Frame20 &f = frames[i];
+      printf("%lu,%lu,%lu,%u,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+             (unsigned long)pageIndex,
+             (unsigned long)(footer.firstFrameID + i),
+             (unsigned long)times[i].ms,
+             times[i].missed,
+             f.q0, f.q1, f.q2, f.q3,
+             f.ax, f.ay, f.az,
+             f.mx, f.my, f.mz);
+      missedCount += times[i].missed;
+      if (times[i].missed) gapCount++;
+    }
+    frameCount += n;
+    pageIndex++;
+  }
+
+  gzclose(in);
+
+  fprintf(stderr,
+          "pages=%lu (raw=%lu delta=%lu) bad=%lu frames=%lu frames/page=%.2f "
+          "gaps=%lu missed=%lu\n",
+          pages, rawPages, deltaPages, badPages, frameCount,
+          pages ? (double)frameCount / pages : 0.0, gapCount, missedCount);
+
+  return badPages ? 1 : 0;
+}
@@ -0,0 +1,829 @@
+// =============================================================================
+// lmt_pull — incremental log sync for a fleet of loggers
+// =============================================================================
+//
+// Pulls only the pages each logger recorded since the last run:
+//
+//   GET /imu?since_page=<cursor>    then    GET /sync?since_page=<cursor>
+//
+// over one keep-alive connection per device, with many devices in flight at
+// once (single thread, non-blocking sockets, epoll). Per device the pages
+// are appended to
+//
+//   <outdir>/<host>_<port>/imu.lmtp     'LMTP' records (same as a full /imu)
+//   <outdir>/<host>_<port>/sync.lmts    'LMTS' records (same as a full /sync)
+//   <outdir>/<host>_<port>/cursor       "imu <next page>\nsync <next page>\n"
+//                                       + "imu_session <S>\nsync_session <S>\n"
+//
+// so the files always equal a full download of the log so far and can be fed
+// to lmt_decode directly. A logger in ring mode may overwrite pages before
+// they are pulled: it then answers with an X-LMT-Since-Page past the
+// cursor, the skipped pages are counted as lost and the file carries the
+// gap in its page indices (lmt_decode follows them).
+//
+// Every record is checked before it is appended: stream magic, and a page
+// index equal to the cursor (records below it are skipped, a gap fails the
+// device). The response trailer "X-LMT-Next-Page" must agree with the
+// cursor reached. Each request carries the X-LMT-Session of the last pull
+// (&session=S): the log the cursor points into. "X-LMT-Cursor-Reset: 1"
+// (the log was erased or restarted since the last pull) truncates the file
+// and starts over from page 0; so does an X-LMT-Session that differs from
+// the stored one when the server did not reset (the response is dropped and
+// the stream pulled again from page 0). A failed or
+// interrupted pull keeps every complete record received and saves that
+// cursor, so the next run resumes there.
+//
+// Firmware without since_page support answers with the whole log; records
+// already held are skipped, so the result is the same, just slower.
+//
+// Test against the stand-in server (tools/lmt_standin.cpp):
+//   ./lmt_standin -P 9100 -n 32 -s 500 -g 100 flash.img &
+//   ./lmt_pull -o pulled 127.0.0.1:9100-9131
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -o lmt_pull lmt_pull.cpp -lz
+//
+// Usage:
+//   ./lmt_pull [-o outdir] [-j max_parallel] [-t timeout_s] [-z]
+//              host:port[-last_port] ... | -f device_list
+//
+//   -z  request gzip (Accept-Encoding) and inflate on the fly
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+#define FLASH_STREAM_MAGIC 0x4C4D5450UL  // ASCII "LMTP"
+#define SYNC_STREAM_MAGIC  0x4C4D5453UL  // ASCII "LMTS"
+#define STREAM_RECORD_BYTES 272          // 16-byte header + 256-byte page
+
+#define HEAD_MAX 4096
+
+enum StreamId { STREAM_IMU, STREAM_SYNC, STREAM_COUNT };
+
+static const char *const kStreamPath[STREAM_COUNT] = { "/imu", "/sync" };
+static const char *const kStreamFile[STREAM_COUNT] = { "imu.lmtp", "sync.lmts" };
+static const uint32_t kStreamMagic[STREAM_COUNT] = { FLASH_STREAM_MAGIC, SYNC_STREAM_MAGIC };
+
+enum PullState {
+  PULL_WAITING,     // not started (over the -j limit)
+  PULL_CONNECTING,
+  PULL_SENDING,
+  PULL_HEAD,        // reading status line + headers
+  PULL_CHUNK_SIZE,
+  PULL_CHUNK_DATA,
+  PULL_CHUNK_CRLF,
+  PULL_TRAILER,
+  PULL_LENGTH_BODY, // Content-Length body (no since_page support, or error text)
+  PULL_DONE,
+  PULL_FAILED
+};
+
+struct StreamPull {
+  FILE *file = nullptr;
+  uint32_t startCursor = 0;
+  uint32_t cursor = 0;        // next page index expected
+  uint32_t added = 0;         // records appended this run
+  uint32_t skipped = 0;       // records already held
+  uint32_t lost = 0;          // pages overwritten on the device before the pull
+  bool reset = false;
+  std::string session;        // X-LMT-Session of the last pull ("" unknown)
+};
+
+struct Device {
+  std::string host;
+  std::string port;
+  std::string dir;
+
+  int fd = -1;
+  PullState state = PULL_WAITING;
+  int stream = STREAM_IMU;
+  StreamPull streams[STREAM_COUNT];
+  char error[160] = {};
+
+  // request
+  char req[256];
+  size_t reqLen = 0;
+  size_t reqSent = 0;
+
+  // response
+  std::string head;
+  int status = 0;
+  bool keepAlive = true;
+  bool gzipped = false;
+  bool haveTrailerCursor = false;
+  uint32_t trailerCursor = 0;
+  bool repull = false;        // body is from another log: drop it, ask again
+  uint64_t remaining = 0;     // chunk bytes or Content-Length bytes left
+  std::string line;           // chunk size / trailer line being assembled
+
+  z_stream z = {};
+  bool zActive = false;
+  uint8_t rec[STREAM_RECORD_BYTES];
+  size_t recLen = 0;
+  std::string errorBody;
+
+  uint64_t wireBytes = 0;
+  double lastActivity = 0;
+};
+
+static std::string g_outDir = "pulled";
+static int g_maxParallel = 16;
+static double g_timeoutS = 10.0;
+static bool g_gzip = false;
+
+static double nowSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fail(Device &d, const char *fmt, ...) {
+  if (d.state == PULL_FAILED) return;
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(d.error, sizeof(d.error), fmt, args);
+  va_end(args);
+  d.state = PULL_FAILED;
+}
+
+// ============================================================================
+// PER-DEVICE FILES
+// ============================================================================
+
+static std::string cursorPath(const Device &d) { return d.dir + "/cursor"; }
+
+static void closeDeviceFiles(Device &d) {
+  for (StreamPull &s : d.streams) {
+    if (s.file) fclose(s.file);
+    s.file = nullptr;
+  }
+}
+
+// Page index of record 'n' in a stream file.
+static bool recordPageIndex(FILE *f, uint32_t n, uint32_t &pageIndex) {
+  uint8_t hdr[8];
+  if (fseek(f, (long)n * STREAM_RECORD_BYTES, SEEK_SET) != 0 ||
+      fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) {
+    return false;
+  }
+  memcpy(&pageIndex, hdr + 4, sizeof(pageIndex));
+  return true;
+}
+
+// Open the stream files at the saved cursors. Records at or past the cursor
+// (interrupted before the cursor was saved) are cut back; a file ending
+// short of it (edited by hand) lowers the cursor to the page after its last
+// record. Page indices, not record counts, give the cursor: a ring-mode
+// pull may have skipped overwritten pages.
+static bool openDeviceFiles(Device &d) {
+  mkdir(g_outDir.c_str(), 0755);
+  if (mkdir(d.dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    fail(d, "mkdir %s: %s", d.dir.c_str(), strerror(errno));
+    return false;
+  }
+
+  uint32_t saved[STREAM_COUNT] = { 0, 0 };
+  if (FILE *in = fopen(cursorPath(d).c_str(), "r")) {
+    char name[16];
+    char value[32];
+    while (fscanf(in, "%15s %31s", name, value) == 2) {
+      if (!strcmp(name, "imu")) saved[STREAM_IMU] = strtoul(value, nullptr, 10);
+      else if (!strcmp(name, "sync")) saved[STREAM_SYNC] = strtoul(value, nullptr, 10);
+      else if (!strcmp(name, "imu_session")) d.streams[STREAM_IMU].session = value;
+      else if (!strcmp(name, "sync_session")) d.streams[STREAM_SYNC].session = value;
+    }
+    fclose(in);
+  }
+
+  for (int s = 0; s < STREAM_COUNT; s++) {
+    const std::string path = d.dir + "/" + kStreamFile[s];
+    FILE *f = fopen(path.c_str(), "r+b");
+    if (!f) f = fopen(path.c_str(), "w+b");
+    if (!f) {
+      fail(d, "open %s: %s", path.c_str(), strerror(errno));
+      closeDeviceFiles(d);
+      return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    uint32_t held = (uint32_t)(ftell(f) / STREAM_RECORD_BYTES);
+    uint32_t cursor = 0;
+    while (held > 0) {
+      uint32_t pageIndex;
+      if (!recordPageIndex(f, held - 1, pageIndex)) {
+        fail(d, "read %s: %s", path.c_str(), strerror(errno));
+        fclose(f);
+        closeDeviceFiles(d);
+        return false;
+      }
+      if (pageIndex < saved[s]) {
+        cursor = pageIndex + 1;
+        break;
+      }
+      held--;
+    }
+    if (ftruncate(fileno(f), (off_t)held * STREAM_RECORD_BYTES) != 0) {
+      fail(d, "truncate %s: %s", path.c_str(), strerror(errno));
+      fclose(f);
+      closeDeviceFiles(d);
+      return false;
+    }
+    fseek(f, 0, SEEK_END);
+
+    d.streams[s].file = f;
+    d.streams[s].startCursor = cursor;
+    d.streams[s].cursor = cursor;
+  }
+  return true;
+}
+
+// Flush the stream files, then replace the cursor file atomically.
+static void saveDevice(Device &d) {
+  for (StreamPull &s : d.streams) {
+    if (!s.file) continue;
+    fflush(s.file);
+    fsync(fileno(s.file));
+    fclose(s.file);
+    s.file = nullptr;
+  }
+
+  const std::string tmp = cursorPath(d) + ".tmp";
+  FILE *out = fopen(tmp.c_str(), "w");
+  if (!out) {
+    fail(d, "write %s: %s", tmp.c_str(), strerror(errno));
+    return;
+  }
+  fprintf(out, "imu %lu\nsync %lu\n", (unsigned long)d.streams[STREAM_IMU].cursor,
+          (unsigned long)d.streams[STREAM_SYNC].cursor);
+  for (int s = 0; s < STREAM_COUNT; s++) {
+    if (!d.streams[s].session.empty()) {
+      fprintf(out, "%s_session %s\n", s == STREAM_IMU ? "imu" : "sync",
+              d.streams[s].session.c_str());
+    }
+  }
+  fflush(out);
+  fsync(fileno(out));
+  fclose(out);
+  if (rename(tmp.c_str(), cursorPath(d).c_str()) != 0) {
+    fail(d, "rename %s: %s", tmp.c_str(), strerror(errno));
+  }
+}
+
+// ============================================================================
+// RECORDS
+// ============================================================================
+
+static void acceptRecord(Device &d) {
+  StreamPull &s = d.streams[d.stream];
+
+  uint32_t magic, pageIndex;
+  memcpy(&magic, d.rec, 4);
+  memcpy(&pageIndex, d.rec + 4, 4);
+
+  if (magic != kStreamMagic[d.stream]) {
+    fail(d, "%s: bad record magic 0x%08lX at page %lu", kStreamPath[d.stream],
+         (unsigned long)magic, (unsigned long)s.cursor);
+    return;
+  }
+  if (pageIndex < s.cursor) {
+    s.skipped++;
+    return;
+  }
+  if (pageIndex > s.cursor) {
+    fail(d, "%s: gap, expected page %lu, got %lu", kStreamPath[d.stream],
+         (unsigned long)s.cursor, (unsigned long)pageIndex);
+    return;
+  }
+
+  if (fwrite(d.rec, 1, sizeof(d.rec), s.file) != sizeof(d.rec)) {
+    fail(d, "write %s: %s", kStreamFile[d.stream], strerror(errno));
+    return;
+  }
+  s.cursor++;
+  s.added++;
+}
+
+static void recordBytes(Device &d, const uint8_t *p, size_t len) {
+  while (len > 0 && d.state != PULL_FAILED) {
+    const size_t take = (sizeof(d.rec) - d.recLen < len) ? sizeof(d.rec) - d.recLen : len;
+    memcpy(d.rec + d.recLen, p, take);
+    d.recLen += take;
+    p += take;
+    len -= take;
+    if (d.recLen == sizeof(d.rec)) {
+      d.recLen = 0;
+      acceptRecord(d);
+    }
+  }
+}
+
+// Decoded body bytes: records, or error text for a non-200 response.
+static void bodyBytes(Device &d, const uint8_t *p, size_t len) {
+  if (d.repull) {
+    return;
+  }
+  if (d.status != 200) {
+    if (d.errorBody.size() < 120) d.errorBody.append((const char *)p, len);
+    return;
+  }
+  if (!d.gzipped) {
+    recordBytes(d, p, len);
+    return;
+  }
+
+  uint8_t out[16384];
+  d.z.next_in = (Bytef *)p;
+  d.z.avail_in = (uInt)len;
+  while (d.z.avail_in > 0 && d.state != PULL_FAILED) {
+    d.z.next_out = out;
+    d.z.avail_out = sizeof(out);
+    const int rc = inflate(&d.z, Z_NO_FLUSH);
+    recordBytes(d, out, sizeof(out) - d.z.avail_out);
+    if (rc == Z_STREAM_END) break;
+    if (rc != Z_OK && rc != Z_BUF_ERROR) {
+      fail(d, "%s: gzip error %d", kStreamPath[d.stream], rc);
+    }
+  }
+}
+
+// ============================================================================
+// HTTP
+// ============================================================================
+
+static bool headerValue(const std::string &head, const char *name, std::string &value) {
+  const size_t nameLen = strlen(name);
+  size_t pos = head.find("\r\n");
+  while (pos != std::string::npos && pos + 2 < head.size()) {
+    const size_t start = pos + 2;
+    const size_t end = head.find("\r\n", start);
+    if (end == std::string::npos) break;
+    if (end - start > nameLen && head[start + nameLen] == ':' &&
+        strncasecmp(head.c_str() + start, name, nameLen) == 0) {
+      size_t v = start + nameLen + 1;
+      while (v < end && head[v] == ' ') v++;
+      value = head.substr(v, end - v);
+      return true;
+    }
+    pos = end;
+  }
+  return false;
+}
+
+static void queueRequest(Device &d) {
+  const StreamPull &s = d.streams[d.stream];
+  d.reqLen = snprintf(d.req, sizeof(d.req),
+                      "GET %s?since_page=%lu%s%s HTTP/1.1\r\nHost: %s\r\n%s\r\n",
+                      kStreamPath[d.stream], (unsigned long)s.cursor,
+                      s.session.empty() ? "" : "&session=", s.session.c_str(),
+                      d.host.c_str(), g_gzip ? "Accept-Encoding: gzip\r\n" : "");
+  d.reqSent = 0;
+  d.head.clear();
+  d.line.clear();
+  d.status = 0;
+  d.gzipped = false;
+  d.haveTrailerCursor = false;
+  d.repull = false;
+  d.recLen = 0;
+  d.errorBody.clear();
+  d.state = PULL_SENDING;
+}
+
+static void onHead(Device &d) {
+  if (sscanf(d.head.c_str(), "HTTP/1.%*d %d", &d.status) != 1) {
+    fail(d, "%s: bad status line", kStreamPath[d.stream]);
+    return;
+  }
+
+  std::string v;
+  d.keepAlive = !(headerValue(d.head, "Connection", v) && strcasecmp(v.c_str(), "close") == 0);
+  StreamPull &s = d.streams[d.stream];
+
+  if (d.status == 200) {
+    const bool serverReset = headerValue(d.head, "X-LMT-Cursor-Reset", v) && v == "1";
+    bool otherLog = false;
+    if (headerValue(d.head, "X-LMT-Session", v)) {
+      // The server kept a cursor that points into another log (it ignored
+      // &session=): this body continues the wrong log
+      otherLog = !serverReset && !s.session.empty() && v != s.session;
+      s.session = v;
+    }
+    if (serverReset || otherLog) {
+      // Log erased or restarted on the device: start this stream over
+      fflush(s.file);
+      if (ftruncate(fileno(s.file), 0) != 0) {
+        fail(d, "truncate %s: %s", kStreamFile[d.stream], strerror(errno));
+        return;
+      }
+      fseek(s.file, 0, SEEK_SET);
+      s.cursor = 0;
+      s.reset = true;
+      d.repull = otherLog;
+    }
+    if (!d.repull && headerValue(d.head, "X-LMT-Since-Page", v)) {
+      const uint32_t since = (uint32_t)strtoul(v.c_str(), nullptr, 10);
+      if (since < s.cursor) {
+        fail(d, "%s: server resumed at page %s, cursor is %lu", kStreamPath[d.stream], v.c_str(),
+             (unsigned long)s.cursor);
+        return;
+      }
+      // Ring mode: pages below 'since' were overwritten before this pull
+      s.lost += since - s.cursor;
+      s.cursor = since;
+    }
+    if (headerValue(d.head, "Content-Encoding", v)) {
+      if (strcasecmp(v.c_str(), "gzip") != 0) {
+        fail(d, "%s: unsupported Content-Encoding %s", kStreamPath[d.stream], v.c_str());
+        return;
+      }
+      d.gzipped = true;
+      if (d.zActive) inflateEnd(&d.z);
+      d.z = {};
+      inflateInit2(&d.z, 16 + MAX_WBITS);
+      d.zActive = true;
+    }
+  }
+
+  if (d.status == 204 || d.status == 304) {
+    d.remaining = 0;
+    d.state = PULL_LENGTH_BODY;
+  } else if (headerValue(d.head, "Transfer-Encoding", v) && strcasecmp(v.c_str(), "chunked") == 0) {
+    d.state = PULL_CHUNK_SIZE;
+  } else if (headerValue(d.head, "Content-Length", v)) {
+    d.remaining = strtoull(v.c_str(), nullptr, 10);
+    d.state = PULL_LENGTH_BODY;
+  } else {
+    fail(d, "%s: response has no length", kStreamPath[d.stream]);
+  }
+}
+
+// One response finished: check it, then ask for the next stream or stop.
+static void onResponseEnd(Device &d) {
+  StreamPull &s = d.streams[d.stream];
+
+  if (d.status != 200 && d.status != 204) {
+    while (!d.errorBody.empty() && (d.errorBody.back() == '\n' || d.errorBody.back() == '\r')) {
+      d.errorBody.pop_back();
+    }
+    fail(d, "%s: HTTP %d %s", kStreamPath[d.stream], d.status, d.errorBody.c_str());
+    return;
+  }
+  if (d.recLen != 0) {
+    fail(d, "%s: body ends inside a record", kStreamPath[d.stream]);
+    return;
+  }
+  if (!d.repull && d.haveTrailerCursor && d.trailerCursor != s.cursor) {
+    fail(d, "%s: server cursor %lu, received up to %lu", kStreamPath[d.stream],
+         (unsigned long)d.trailerCursor, (unsigned long)s.cursor);
+    return;
+  }
+
+  // A dropped body asks for the same stream again, from page 0
+  if (!d.repull && ++d.stream == STREAM_COUNT) {
+    d.state = PULL_DONE;
+    return;
+  }
+  if (!d.keepAlive) {
+    // Reconnect for the next stream
+    close(d.fd);
+    d.fd = -1;
+    d.state = PULL_WAITING;
+    return;
+  }
+  queueRequest(d);
+}
+
+// Feed received bytes through the response parser.
+static void parse(Device &d, const uint8_t *p, size_t len) {
+  while (d.state != PULL_FAILED && d.state != PULL_DONE && d.state != PULL_WAITING) {
+    switch (d.state) {
+    case PULL_HEAD: {
+      if (len == 0) return;
+      const size_t before = d.head.size();
+      d.head.append((const char *)p, len);
+      const size_t end = d.head.find("\r\n\r\n");
+      if (end == std::string::npos) {
+        if (d.head.size() > HEAD_MAX) fail(d, "%s: header too large", kStreamPath[d.stream]);
+        return;
+      }
+      const size_t used = end + 4 - before;
+      d.head.resize(end + 2);
+      p += used;
+      len -= used;
+      onHead(d);
+      break;
+    }
+
+    case PULL_CHUNK_SIZE:
+    case PULL_CHUNK_CRLF:
+    case PULL_TRAILER: {
+      if (len == 0) return;
+      const uint8_t *nl = (const uint8_t *)memchr(p, '\n', len);
+      const size_t take = nl ? (size_t)(nl - p) + 1 : len;
+      d.line.append((const char *)p, take);
+      p += take;
+      len -= take;
+      if (!nl) {
+        if (d.line.size() > 256) fail(d, "%s: bad chunk framing", kStreamPath[d.stream]);
+        return;
+      }
+      const std::string l = d.line.substr(0, d.line.find_last_not_of("\r\n") + 1);
+      d.line.clear();
+
+      if (d.state == PULL_CHUNK_CRLF) {
+        if (!l.empty()) fail(d, "%s: bad chunk framing", kStreamPath[d.stream]);
+        else d.state = PULL_CHUNK_SIZE;
+      } else if (d.state == PULL_CHUNK_SIZE) {
+        char *end;
+        d.remaining = strtoull(l.c_str(), &end, 16);
+        if (end == l.c_str()) fail(d, "%s: bad chunk size", kStreamPath[d.stream]);
+        else d.state = d.remaining ? PULL_CHUNK_DATA : PULL_TRAILER;
+      } else if (l.empty()) {
+        onResponseEnd(d);
+      } else if (strncasecmp(l.c_str(), "X-LMT-Next-Page:", 16) == 0) {
+        d.trailerCursor = strtoul(l.c_str() + 16, nullptr, 10);
+        d.haveTrailerCursor = true;
+      }
+      break;
+    }
+
+    case PULL_CHUNK_DATA:
+    case PULL_LENGTH_BODY: {
+      const size_t take = (d.remaining < len) ? (size_t)d.remaining : len;
+      bodyBytes(d, p, take);
+      p += take;
+      len -= take;
+      d.remaining -= take;
+      if (d.remaining == 0) {
+        if (d.state == PULL_CHUNK_DATA) d.state = PULL_CHUNK_CRLF;
+        else onResponseEnd(d);
+      } else if (len == 0) {
+        return;
+      }
+      break;
+    }
+
+    default:
+      return;
+    }
+  }
+}
+
+// ============================================================================
+// EVENT LOOP
+// ============================================================================
+
+static void startConnect(Device &d, int ep) {
+  addrinfo hints = {}, *ai = nullptr;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  const int rc = getaddrinfo(d.host.c_str(), d.port.c_str(), &hints, &ai);
+  if (rc != 0) {
+    fail(d, "resolve %s: %s", d.host.c_str(), gai_strerror(rc));
+    return;
+  }
+
+  d.fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  const int one = 1;
+  setsockopt(d.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (connect(d.fd, ai->ai_addr, ai->ai_addrlen) != 0 && errno != EINPROGRESS) {
+    fail(d, "connect: %s", strerror(errno));
+    close(d.fd);
+    d.fd = -1;
+    freeaddrinfo(ai);
+    return;
+  }
+  freeaddrinfo(ai);
+
+  epoll_event ev = {};
+  ev.events = EPOLLIN | EPOLLOUT;
+  ev.data.ptr = &d;
+  epoll_ctl(ep, EPOLL_CTL_ADD, d.fd, &ev);
+
+  d.state = PULL_CONNECTING;
+  d.lastActivity = nowSeconds();
+}
+
+static void onEvent(Device &d, uint32_t events, int ep) {
+  d.lastActivity = nowSeconds();
+
+  if (d.state == PULL_CONNECTING) {
+    int err = 0;
+    socklen_t errLen = sizeof(err);
+    getsockopt(d.fd, SOL_SOCKET, SO_ERROR, &err, &errLen);
+    if (err != 0) {
+      fail(d, "connect: %s", strerror(err));
+      return;
+    }
+    queueRequest(d);
+  }
+
+  if (d.state == PULL_SENDING && (events & EPOLLOUT)) {
+    const ssize_t n = send(d.fd, d.req + d.reqSent, d.reqLen - d.reqSent, MSG_NOSIGNAL);
+    if (n < 0 && errno != EAGAIN) {
+      fail(d, "send: %s", strerror(errno));
+      return;
+    }
+    if (n > 0) d.reqSent += n;
+    if (d.reqSent == d.reqLen) {
+      d.state = PULL_HEAD;
+      epoll_event ev = {};
+      ev.events = EPOLLIN;
+      ev.data.ptr = &d;
+      epoll_ctl(ep, EPOLL_CTL_MOD, d.fd, &ev);
+    }
+  }
+
+  if (d.state < PULL_HEAD || d.state > PULL_LENGTH_BODY) return;
+  if (!(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) return;
+
+  uint8_t buf[65536];
+  for (;;) {
+    const ssize_t n = recv(d.fd, buf, sizeof(buf), 0);
+    if (n < 0 && errno == EAGAIN) break;
+    if (n <= 0) {
+      // Peer closed: a Content-Length body or the head must have been complete
+      if (d.state == PULL_LENGTH_BODY && d.remaining == 0) onResponseEnd(d);
+      else fail(d, "%s: connection closed mid-response", kStreamPath[d.stream]);
+      return;
+    }
+    d.wireBytes += n;
+    parse(d, buf, n);
+    if (d.state == PULL_SENDING) {
+      // Next request queued on the kept-alive connection
+      epoll_event ev = {};
+      ev.events = EPOLLIN | EPOLLOUT;
+      ev.data.ptr = &d;
+      epoll_ctl(ep, EPOLL_CTL_MOD, d.fd, &ev);
+      return;
+    }
+    if (d.state < PULL_HEAD || d.state > PULL_LENGTH_BODY) return;
+  }
+}
+
+static void finishDevice(Device &d) {
+  if (d.fd >= 0) {
+    close(d.fd);
+    d.fd = -1;
+  }
+  if (d.zActive) {
+    inflateEnd(&d.z);
+    d.zActive = false;
+  }
+  saveDevice(d);
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+// "host:port" or "host:first-last" (one device per port)
+static bool addDevices(const char *spec, std::vector<Device *> &devs) {
+  const char *colon = strrchr(spec, ':');
+  if (!colon || colon == spec) return false;
+
+  char *end;
+  const unsigned long first = strtoul(colon + 1, &end, 10);
+  unsigned long last = first;
+  if (*end == '-') last = strtoul(end + 1, &end, 10);
+  if (*end != 0 || first == 0 || last < first || last > 65535) return false;
+
+  for (unsigned long port = first; port <= last; port++) {
+    Device *d = new Device;
+    d->host.assign(spec, colon - spec);
+    d->port = std::to_string(port);
+    d->dir = g_outDir + "/" + d->host + "_" + d->port;
+    devs.push_back(d);
+  }
+  return true;
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [-o outdir] [-j max_parallel] [-t timeout_s] [-z] "
+                  "host:port[-last_port] ... | -f device_list\n", argv0);
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> specs;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-o") && i + 1 < argc) g_outDir = argv[++i];
+    else if (!strcmp(argv[i], "-j") && i + 1 < argc) g_maxParallel = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc) g_timeoutS = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-z")) g_gzip = true;
+    else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+      FILE *in = fopen(argv[++i], "r");
+      if (!in) {
+        perror(argv[i]);
+        return 2;
+      }
+      char line[256];
+      while (fscanf(in, "%255s", line) == 1) {
+        if (line[0] != '#') specs.push_back(line);
+      }
+      fclose(in);
+    } else if (argv[i][0] == '-') {
+      usage(argv[0]);
+      return 2;
+    } else {
+      specs.push_back(argv[i]);
+    }
+  }
+
+  std::vector<Device *> devs;
+  for (const std::string &spec : specs) {
+    if (!addDevices(spec.c_str(), devs)) {
+      fprintf(stderr, "bad device '%s' (want host:port or host:first-last)\n", spec.c_str());
+      return 2;
+    }
+  }
+  if (devs.empty() || g_maxParallel < 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  const int ep = epoll_create1(0);
+  const double t0 = nowSeconds();
+  int active = 0;
+
+  for (;;) {
+    // Start devices (and reconnects after "Connection: close") up to the limit
+    for (Device *d : devs) {
+      if (active >= g_maxParallel) break;
+      if (d->state != PULL_WAITING || d->fd >= 0) continue;
+      const bool fresh = d->stream == STREAM_IMU && !d->streams[STREAM_IMU].file;
+      if (fresh && !openDeviceFiles(*d)) continue;
+      startConnect(*d, ep);
+      if (d->state != PULL_FAILED) active++;
+    }
+    size_t pending = 0;
+    for (Device *d : devs) {
+      if (d->state != PULL_DONE && d->state != PULL_FAILED) pending++;
+    }
+    if (pending == 0) break;
+
+    epoll_event events[64];
+    const int n = epoll_wait(ep, events, 64, 200);
+    for (int k = 0; k < n; k++) {
+      Device &d = *(Device *)events[k].data.ptr;
+      onEvent(d, events[k].events, ep);
+      if (d.state == PULL_WAITING) active--;  // closed for a reconnect
+    }
+
+    const double now = nowSeconds();
+    for (Device *d : devs) {
+      if (d->fd >= 0 && d->state != PULL_DONE && d->state != PULL_FAILED &&
+          now - d->lastActivity > g_timeoutS) {
+        fail(*d, "%s: timed out", kStreamPath[d->stream]);
+      }
+      if ((d->state == PULL_DONE || d->state == PULL_FAILED) && d->fd >= 0) {
+        finishDevice(*d);
+        active--;
+      } else if (d->state == PULL_FAILED && d->streams[STREAM_IMU].file) {
+        finishDevice(*d);  // failed before connecting
+      }
+    }
+  }
+
+  // Summary
+  int failed = 0;
+  uint64_t totalWire = 0, totalPages = 0;
+  for (Device *d : devs) {
+    const StreamPull &imu = d->streams[STREAM_IMU];
+    const StreamPull &sync = d->streams[STREAM_SYNC];
+    char lost[24] = "";
+    if (imu.lost > 0) snprintf(lost, sizeof(lost), " lost %lu", (unsigned long)imu.lost);
+    printf("%s:%-5s  imu %6lu -> %-6lu (+%lu)%s%s  sync %5lu -> %-5lu (+%lu)%s  %8.1f KB  %s\n",
+           d->host.c_str(), d->port.c_str(),
+           (unsigned long)imu.startCursor, (unsigned long)imu.cursor, (unsigned long)imu.added,
+           imu.reset ? " reset" : "", lost,
+           (unsigned long)sync.startCursor, (unsigned long)sync.cursor, (unsigned long)sync.added,
+           sync.reset ? " reset" : "",
+           d->wireBytes / 1024.0, d->state == PULL_DONE ? "ok" : d->error);
+    if (d->state != PULL_DONE) failed++;
+    totalWire += d->wireBytes;
+    totalPages += imu.added + sync.added;
+  }
+
+  const double elapsed = nowSeconds() - t0;
+  printf("%zu device(s), %d failed: %llu pages, %.1f KB on the wire in %.2f s (%.1f KB/s)\n",
+         devs.size(), failed, (unsigned long long)totalPages, totalWire / 1024.0, elapsed,
+         elapsed > 0 ? totalWire / 1024.0 / elapsed : 0.0);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,533 @@
+// =============================================================================
+// lmt_standin — local stand-in for a fleet of loggers' HTTP export
+// =============================================================================
+//
+// Serves a flash image with the firmware's framing so host tools (lmt_pull,
+// curl, scripts) can be tested on Linux without hardware:
+//
+//   GET /id                      "STANDIN-<n>"
+//   GET /imu                     whole IMU log, Content-Length, 'LMTP' records
+//   GET /sync                    whole sync region, 'LMTS' records (204 if none)
+//   GET /imu?since_page=N        pages [N, watermark), chunked, cursor trailer
+//   GET /sync?since_page=N       same for the sync region
+//
+// The since_page responses follow LoggerHTTP: X-LMT-Since-Page and
+// X-LMT-Session headers, "X-LMT-Next-Page: <cursor>" trailer, and restart at
+// page 0 with X-LMT-Cursor-Reset: 1 when N lies past the log or &session=
+// names another one. Keep-alive is supported.
+//
+// Each port is one simulated device; -n devices listen on consecutive ports.
+// A device starts with -s pages of the image visible (default: all) and
+// "records" -g more after every since_page response, up to the image size,
+// so repeated pulls see only new data. -e N erases the device before every
+// Nth /imu since_page pull and re-records the whole image (a new log epoch,
+// already past any cursor); -I then ignores &session=, as firmware without
+// it would, to exercise lmt_pull's own check.
+//
+// With -t, a pty also stands in for the USB serial CLI and answers
+// "bdump [imu|sync] [from_page] [pages]" with the firmware's page dump
+// framing (see LoggerCore.h), for tools/lmt_capture. Its path is printed at
+// start. -x N flips one byte of page N in transit (after the device-side
+// CRC-32), to exercise the capture tool's checks.
+//
+// Input: a raw flash image (256-byte IMU pages from page 0; the scan stops
+// at the first blank page) and optionally a sync region image.
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -pthread -I.. -o lmt_standin lmt_standin.cpp ../LoggerFormat.cpp ../LoggerCRC.cpp
+//
+// Usage:
+//   ./lmt_standin [-P base_port] [-n devices] [-s start_pages] [-g grow_pages]
+//                 [-e erase_every [-I]] [-t [-x corrupt_page]] imu.img [sync.img]
+//
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LoggerCRC.h"
+#include "LoggerFormat.h"
+
+#define BDUMP_END_MAGIC    0x4C4D5445UL  // ASCII "LMTE"
+#define BATCH_PAGES 16  // same batching as LoggerHTTP
+
+struct Region {
+  std::vector<uint8_t> data;
+  uint32_t pages = 0;
+};
+
+struct Device {
+  int index;
+  int listenFd;
+  std::atomic<uint32_t> imuVisible;
+  std::atomic<uint32_t> syncVisible;
+  std::atomic<uint32_t> epoch;     // erases so far (X-LMT-Session)
+  std::atomic<uint32_t> imuPulls;  // /imu since_page requests (for -e)
+};
+
+static Region g_imu;
+static Region g_sync;
+static uint32_t g_growPages = 0;
+static uint32_t g_eraseEvery = 0;
+static bool g_ignoreSession = false;
+
+// ============================================================================
+// HTTP
+// ============================================================================
+
+static bool sendAll(int fd, const void *buf, size_t len) {
+  const uint8_t *p = (const uint8_t *)buf;
+  while (len > 0) {
+    const ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool sendText(int fd, const char *status, const char *body, bool keepAlive) {
+  char head[256];
+  const int n = snprintf(head, sizeof(head),
+                         "HTTP/1.1 %s\r\nContent-Type: text/plain\r\n"
+                         "Content-Length: %zu\r\nConnection: %s\r\n\r\n",
+                         status, strlen(body), keepAlive ? "keep-alive" : "close");
+  return sendAll(fd, head, n) && sendAll(fd, body, strlen(body));
+}
+
+// Records [first, end) of a region into 'out'.
+static void buildRecords(const Region &r, bool sync, uint32_t first, uint32_t end,
+                         std::vector<uint8_t> &out) {
+  out.resize((size_t)(end - first) * STREAM_RECORD_BYTES);
+  for (uint32_t p = first; p < end; p++) {
+    uint8_t *rec = &out[(size_t)(p - first) * STREAM_RECORD_BYTES];
+    const uint8_t *page = &r.data[(size_t)p * IMU_PAGE_BYTES];
+    if (sync) syncStreamHeader(p, page, rec);
+    else imuStreamHeader(p, page, rec);
+    memcpy(rec + sizeof(StreamPageHeader), page, IMU_PAGE_BYTES);
+  }
+}
+
+static bool sendWhole(int fd, const Region &r, bool sync, uint32_t pages, bool keepAlive) {
+  if (sync && pages == 0) {
+    char head[128];
+    const int n = snprintf(head, sizeof(head), "HTTP/1.1 204 No Content\r\nConnection: %s\r\n\r\n",
+                           keepAlive ? "keep-alive" : "close");
+    return sendAll(fd, head, n);
+  }
+
+  char head[256];
+  const int n = snprintf(head, sizeof(head),
+                         "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                         "Content-Length: %lu\r\nConnection: %s\r\n\r\n",
+                         (unsigned long)pages * STREAM_RECORD_BYTES,
+                         keepAlive ? "keep-alive" : "close");
+  if (!sendAll(fd, head, n)) return false;
+
+  std::vector<uint8_t> recs;
+  for (uint32_t p = 0; p < pages; p += BATCH_PAGES) {
+    const uint32_t end = (p + BATCH_PAGES < pages) ? p + BATCH_PAGES : pages;
+    buildRecords(r, sync, p, end, recs);
+    if (!sendAll(fd, recs.data(), recs.size())) return false;
+  }
+  return true;
+}
+
+static bool sendSince(int fd, const Region &r, bool sync, uint32_t since, uint32_t watermark,
+                      const char *session, bool otherSession, bool keepAlive) {
+  const bool reset = since > watermark || otherSession;
+  if (reset) since = 0;
+
+  char head[384];
+  const int n = snprintf(head, sizeof(head),
+                         "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                         "Transfer-Encoding: chunked\r\nX-LMT-Since-Page: %lu\r\n"
+                         "X-LMT-Session: %s\r\n"
+                         "Trailer: X-LMT-Next-Page\r\n%sConnection: %s\r\n\r\n",
+                         (unsigned long)since, session,
+                         reset ? "X-LMT-Cursor-Reset: 1\r\n" : "",
+                         keepAlive ? "keep-alive" : "close");
+  if (!sendAll(fd, head, n)) return false;
+
+  std::vector<uint8_t> recs;
+  for (uint32_t p = since; p < watermark; p += BATCH_PAGES) {
+    const uint32_t end = (p + BATCH_PAGES < watermark) ? p + BATCH_PAGES : watermark;
+    buildRecords(r, sync, p, end, recs);
+    char size[16];
+    const int sn = snprintf(size, sizeof(size), "%zX\r\n", recs.size());
+    if (!sendAll(fd, size, sn) || !sendAll(fd, recs.data(), recs.size()) ||
+        !sendAll(fd, "\r\n", 2)) {
+      return false;
+    }
+  }
+
+  char trailer[64];
+  const int tn = snprintf(trailer, sizeof(trailer), "0\r\nX-LMT-Next-Page: %lu\r\n\r\n",
+                          (unsigned long)watermark);
+  return sendAll(fd, trailer, tn);
+}
+
+// Simulate recording between pulls.
+static void grow(std::atomic<uint32_t> &visible, uint32_t limit) {
+  uint32_t v = visible.load();
+  const uint32_t next = (v + g_growPages < limit) ? v + g_growPages : limit;
+  visible.store(next);
+}
+
+static const char *queryValue(const char *query, const char *name) {
+  const size_t nameLen = strlen(name);
+  for (const char *p = query; p && *p;) {
+    if (strncmp(p, name, nameLen) == 0 && p[nameLen] == '=') {
+      return p + nameLen + 1;
+    }
+    p = strchr(p, '&');
+    if (p) p++;
+  }
+  return nullptr;
+}
+
+static bool queryArg(const char *query, const char *name, uint32_t &value) {
+  const char *v = queryValue(query, name);
+  if (v) value = strtoul(v, nullptr, 10);
+  return v != nullptr;
+}
+
+// As LoggerHTTP: the query has 'name' and its value is not 'expected'.
+static bool queryArgDiffers(const char *query, const char *name, const char *expected) {
+  const char *v = queryValue(query, name);
+  const size_t len = strlen(expected);
+  return v && (strncmp(v, expected, len) != 0 || (v[len] != 0 && v[len] != '&'));
+}
+
+// Erase and re-record the whole image: a new log past any client's cursor.
+static void eraseAndRerecord(Device *dev) {
+  dev->epoch++;
+  dev->imuVisible = g_imu.pages;
+  dev->syncVisible = g_sync.pages;
+}
+
+static void serveConnection(Device *dev, int fd) {
+  const int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  std::string buf;
+  char tmp[1024];
+
+  for (;;) {
+    size_t endHdr;
+    while ((endHdr = buf.find("\r\n\r\n")) == std::string::npos) {
+      const ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+      if (n <= 0) {
+        close(fd);
+        return;
+      }
+      buf.append(tmp, n);
+    }
+    const std::string req = buf.substr(0, endHdr + 4);
+    buf.erase(0, endHdr + 4);
+
+    char method[8] = {}, target[256] = {}, version[12] = {};
+    sscanf(req.c_str(), "%7s %255s %11s", method, target, version);
+
+    bool keepAlive = strcmp(version, "HTTP/1.1") == 0;
+    if (strcasestr(req.c_str(), "\r\nConnection: close")) keepAlive = false;
+
+    char *query = strchr(target, '?');
+    if (query) *query++ = 0;
+
+    bool ok;
+    uint32_t since = 0;
+    const bool hasSince = query && queryArg(query, "since_page", since);
+
+    if (strcmp(target, "/id") == 0) {
+      char id[32];
+      snprintf(id, sizeof(id), "STANDIN-%d", dev->index);
+      ok = sendText(fd, "200 OK", id, keepAlive);
+    } else if (strcmp(target, "/imu") == 0 || strcmp(target, "/sync") == 0) {
+      const bool sync = target[1] == 's';
+      const Region &r = sync ? g_sync : g_imu;
+      std::atomic<uint32_t> &visible = sync ? dev->syncVisible : dev->imuVisible;
+      if (hasSince && !sync && g_eraseEvery && ++dev->imuPulls % g_eraseEvery == 0) {
+        eraseAndRerecord(dev);
+      }
+      const uint32_t watermark = visible.load();
+      if (hasSince) {
+        // Log epoch for /imu; the sync token also names the (single) session
+        char session[24];
+        snprintf(session, sizeof(session), sync ? "%x-0" : "%x", (unsigned)dev->epoch.load());
+        const bool other = !g_ignoreSession && queryArgDiffers(query, "session", session);
+        ok = sendSince(fd, r, sync, since, watermark, session, other, keepAlive);
+        grow(visible, r.pages);
+      } else {
+        ok = sendWhole(fd, r, sync, watermark, keepAlive);
+      }
+    } else {
+      ok = sendText(fd, "404 Not Found", "not found", keepAlive);
+    }
+
+    if (!ok || !keepAlive) {
+      close(fd);
+      return;
+    }
+  }
+}
+
+// ============================================================================
+// SERIAL (pty): the USB CLI's bdump
+// ============================================================================
+
+static uint32_t g_corruptPage = UINT32_MAX;
+
+static bool writeAllFd(int fd, const void *buf, size_t len) {
+  const uint8_t *p = (const uint8_t *)buf;
+  while (len > 0) {
+    const ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool writeLine(int fd, const char *s) {
+  return writeAllFd(fd, s, strlen(s)) && writeAllFd(fd, "\r\n", 2);
+}
+
+// "#BDUMP" line, records, BdumpEnd and summary, as LoggerCore's page dump.
+static void serveBdump(int fd, const char *args) {
+  while (*args == ' ') args++;
+
+  bool sync = false;
+  if (!strncmp(args, "sync", 4) && (args[4] == 0 || args[4] == ' ')) {
+    sync = true;
+    args += 4;
+  } else if (!strncmp(args, "imu", 3) && (args[3] == 0 || args[3] == ' ')) {
+    args += 3;
+  }
+
+  unsigned long from = 0, pages = 0;
+  sscanf(args, "%lu %lu", &from, &pages);
+
+  const Region &r = sync ? g_sync : g_imu;
+  if (from > r.pages) from = r.pages;
+  if (pages == 0 || pages > r.pages - from) pages = r.pages - from;
+
+  char line[64];
+  snprintf(line, sizeof(line), "#BDUMP %s %lu %lu %u", sync ? "sync" : "imu", from, pages,
+           (unsigned)STREAM_RECORD_BYTES);
+  if (!writeLine(fd, line)) return;
+
+  uint32_t crc32 = 0, crcBad = 0;
+  std::vector<uint8_t> records;
+  for (uint32_t p = from; p < from + pages; p += BATCH_PAGES) {
+    const uint32_t end = std::min<uint32_t>(p + BATCH_PAGES, from + pages);
+    buildRecords(r, sync, p, end, records);
+
+    for (uint32_t k = 0; k < end - p; k++) {
+      StreamPageHeader hdr;
+      memcpy(&hdr, &records[(size_t)k * STREAM_RECORD_BYTES], sizeof(hdr));
+      if (!(hdr.flags & 0x0002)) crcBad++;
+    }
+    crc32 = crc32_ieee_update(crc32, records.data(), records.size());
+
+    if (g_corruptPage >= p && g_corruptPage < end) {
+      records[(size_t)(g_corruptPage - p) * STREAM_RECORD_BYTES + 16 + 7] ^= 0x40;
+    }
+    if (!writeAllFd(fd, records.data(), records.size())) return;
+  }
+
+  const uint32_t end[4] = { BDUMP_END_MAGIC, (uint32_t)pages, crcBad, crc32 };
+  writeAllFd(fd, end, sizeof(end));
+
+  snprintf(line, sizeof(line), "\r\n# bdump complete pages=%lu bad=%lu", pages,
+           (unsigned long)crcBad);
+  writeLine(fd, line);
+  writeAllFd(fd, "\r\n> ", 4);
+}
+
+static void servePty(int master) {
+  std::string cmd;
+  char buf[256];
+  for (;;) {
+    const ssize_t n = read(master, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      usleep(100000);  // no client on the slave side
+      continue;
+    }
+
+    for (ssize_t i = 0; i < n; i++) {
+      if (buf[i] != '\r' && buf[i] != '\n') {
+        cmd += buf[i];
+        continue;
+      }
+      if (cmd.empty()) continue;
+
+      if (!strncmp(cmd.c_str(), "bdump", 5) && (cmd[5] == 0 || cmd[5] == ' ')) {
+        serveBdump(master, cmd.c_str() + 5);
+      } else {
+        writeLine(master, "# stand-in: only bdump is served here");
+        writeAllFd(master, "\r\n> ", 4);
+      }
+      cmd.clear();
+    }
+  }
+}
+
+// Raw pty whose slave end stays open (so the master never sees a hangup
+// between clients). Returns the master fd, or -1.
+static int openPty() {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    perror("pty");
+    return -1;
+  }
+
+  const char *slavePath = ptsname(master);
+  const int slave = open(slavePath, O_RDWR | O_NOCTTY);
+  if (slave < 0) {
+    perror(slavePath);
+    return -1;
+  }
+
+  termios t;
+  tcgetattr(slave, &t);
+  cfmakeraw(&t);
+  tcsetattr(slave, TCSANOW, &t);
+
+  printf("lmt_standin: serial on %s\n", slavePath);
+  return master;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static bool loadRegion(const char *path, Region &r, bool imu) {
+  FILE *in = fopen(path, "rb");
+  if (!in) {
+    perror(path);
+    return false;
+  }
+  uint8_t page[IMU_PAGE_BYTES];
+  while (fread(page, 1, sizeof(page), in) == sizeof(page)) {
+    if (imu && decodeImuPage(page, nullptr) == IMU_PAGE_ABSENT) break;
+    if (!imu) {
+      SyncPageFooter f;
+      memcpy(&f, page + IMU_PAGE_BYTES - sizeof(f), sizeof(f));
+      if (f.magic != SYNC_MAGIC) break;
+    }
+    r.data.insert(r.data.end(), page, page + sizeof(page));
+  }
+  fclose(in);
+  r.pages = r.data.size() / IMU_PAGE_BYTES;
+  return true;
+}
+
+static int listenOn(uint16_t port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  const int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+    perror("bind/listen");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  unsigned basePort = 8080;
+  int devices = 1;
+  long startPages = -1;
+  const char *imuPath = nullptr;
+  const char *syncPath = nullptr;
+  bool serial = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-P") && i + 1 < argc) basePort = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "-n") && i + 1 < argc) devices = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc) startPages = atol(argv[++i]);
+    else if (!strcmp(argv[i], "-g") && i + 1 < argc) g_growPages = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "-e") && i + 1 < argc) g_eraseEvery = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "-I")) g_ignoreSession = true;
+    else if (!strcmp(argv[i], "-t")) serial = true;
+    else if (!strcmp(argv[i], "-x") && i + 1 < argc) g_corruptPage = strtoul(argv[++i], nullptr, 10);
+    else if (!imuPath) imuPath = argv[i];
+    else syncPath = argv[i];
+  }
+
+  if (!imuPath || devices < 1) {
+    fprintf(stderr, "usage: %s [-P base_port] [-n devices] [-s start_pages] [-g grow_pages] "
+                    "[-e erase_every [-I]] [-t [-x corrupt_page]] imu.img [sync.img]\n",
+            argv[0]);
+    return 2;
+  }
+  if (!loadRegion(imuPath, g_imu, true)) return 2;
+  if (syncPath && !loadRegion(syncPath, g_sync, false)) return 2;
+
+  signal(SIGPIPE, SIG_IGN);
+
+  if (serial) {
+    const int master = openPty();
+    if (master < 0) return 1;
+    std::thread(servePty, master).detach();
+  }
+
+  std::vector<Device *> devs;
+  std::vector<pollfd> fds;
+  for (int d = 0; d < devices; d++) {
+    Device *dev = new Device;
+    dev->index = d;
+    dev->listenFd = listenOn(basePort + d);
+    if (dev->listenFd < 0) return 1;
+
+    const uint32_t imuStart = (startPages < 0 || (uint32_t)startPages > g_imu.pages)
+                                ? g_imu.pages : (uint32_t)startPages;
+    const uint32_t syncStart = (startPages < 0 || (uint32_t)startPages > g_sync.pages)
+                                 ? g_sync.pages : (uint32_t)startPages;
+    dev->imuVisible = imuStart;
+    dev->syncVisible = syncStart;
+    dev->epoch = 0;
+    dev->imuPulls = 0;
+
+    devs.push_back(dev);
+    fds.push_back({ dev->listenFd, POLLIN, 0 });
+  }
+
+  printf("lmt_standin: %d device(s) on 127.0.0.1:%u-%u, imu=%u pages, sync=%u pages, "
+         "grow=%u\n", devices, basePort, basePort + devices - 1, g_imu.pages, g_sync.pages,
+         g_growPages);
+  fflush(stdout);
+
+  for (;;) {
+    if (poll(fds.data(), fds.size(), -1) < 0) continue;
+    for (size_t i = 0; i < fds.size(); i++) {
+      if (!(fds[i].revents & POLLIN)) continue;
+      const int fd = accept(fds[i].fd, nullptr, nullptr);
+      if (fd >= 0) std::thread(serveConnection, devs[i], fd).detach();
+    }
+  }
+}
@@ -0,0 +1,457 @@
+// =============================================================================
+// ring_test — IMU ring mode wrap and boot-recovery test
+// =============================================================================
+//
+// Runs the real LoggerCore (logFrame, checkpoint journal, boot scans, range
+// seek, playback) and LoggerHTTP's record loader over the 1 MB NOR flash
+// model in host/nor_flash.h. The flash writer is replaced by synchronous
+// programs, so every submitted job is durable when it returns.
+//
+// Scenarios:
+//   1. linear mode still stops at the end of the IMU region, and ring mode
+//      cannot be switched on past the ring end
+//   2. after an erase: ring on, fill the first lap, then wrap (one sector
+//      erase, tail moves to the next sector)
+//   3. random record bursts over many laps, each followed by:
+//        - a checkpoint boot (head, tail and frame counter unchanged)
+//        - every 5th: a scan-only boot (journal lost) that must find the
+//          ring from flash alone, then a seek check
+//        - every 7th: a power cut after the erase ahead of the head but
+//          before its first page is programmed (only that sector is lost)
+//      After every boot the live log [tail, head) must decode page by page
+//      with contiguous frame IDs; the same cut at flash page 0 with no
+//      journal must still boot as a wrapped ring
+//   4. loadPageRecords() across the physical ring end; a page below the
+//      tail is refused
+//   5. ASCII playback emits exactly the live pages, starting at the tail;
+//      a time-range dump to a fast and a slow transport gives both the same
+//      output
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -Ihost -I.. -o ring_test ring_test.cpp host/host_runtime.cpp host/nor_flash.cpp ../LoggerCore.cpp ../LoggerOutput.cpp ../LoggerHTTP.cpp ../LoggerFormat.cpp ../LoggerCRC.cpp ../LoggerDeflate.cpp
+//
+// Usage:
+//   ./ring_test [seed] [iterations]      (defaults: 1, 400)
+//
+// Exit status 0 when every check passes; the first failure aborts.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "LoggerCore.h"
+#include "LoggerFormat.h"
+#include "LoggerHTTP.h"
+#include "LoggerOutput.h"
+#include "LoggerWriter.h"
+#include "nor_flash.h"
+
+// Pins normally defined by the sketch
+const uint8_t PIN_FLASH_CS = 1;
+const uint8_t PIN_IMU_CS = 2;
+
+// ============================================================================
+// FIRMWARE STUBS (writer, BLE, beacon, CLI)
+// ============================================================================
+
+static uint32_t g_imuPrograms = 0;
+static bool g_dropImuPrograms = false;  // power cut: erases land, IMU programs do not
+
+static uint8_t g_writerPage[FLASH_PAGE_SIZE];
+
+static void runJob(const uint8_t *buf, uint32_t addr, uint16_t len, uint8_t flags) {
+  if (flags & WRITER_JOB_ERASE_SECTOR) flash.eraseSector(addr);
+  if (addr < flashImuPages * FLASH_PAGE_SIZE) {
+    if (g_dropImuPrograms) return;
+    g_imuPrograms++;
+  }
+  flash.writePage(addr, buf, len);
+}
+
+uint8_t *writerAcquirePage() { return g_writerPage; }
+void writerSubmitPage(uint8_t *buf, uint32_t addr, uint16_t len, uint8_t flags) {
+  runJob(buf, addr, len, flags);
+}
+void writerSubmitCopy(const uint8_t *src, uint32_t addr, uint16_t len, uint8_t flags) {
+  runJob(src, addr, len, flags);
+}
+void writerDrain() {}
+uint32_t writerSubmitMark() { return 1; }
+bool writerReached(uint32_t) { return true; }
+void resetFlashWriterStats() {}
+
+bool bleConnected() { return false; }
+bool bleTxHasRoom(size_t) { return true; }
+bool bleWrite(const uint8_t *, size_t) { return true; }
+uint64_t getLastBeaconTimeMs() { return 0; }
+void printPrompt() {}
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static uint32_t g_sampleMs = 1000;
+static Frame20 g_frame = {};
+
+// Log frames until 'pages' more pages are on flash (or recording stops).
+// The sketch bumps frameCounter after each accepted frame; so does this.
+static void recordPages(uint32_t pages) {
+  const uint32_t target = currentPage + pages;
+  while (currentPage < target) {
+    g_frame.q0++;
+    g_frame.ax += 3;
+    g_frame.mx -= 1;
+    g_sampleMs += 10;
+    if (logFrame(g_frame, g_sampleMs)) {
+      frameCounter++;
+    } else {
+      assert(mode != MODE_RECORDING);
+    }
+    if (mode != MODE_RECORDING) return;
+  }
+}
+
+static PageFooter footerAt(uint32_t page) {
+  uint8_t buf[FLASH_PAGE_SIZE];
+  assert(readImuPages(page, buf, 1));
+  PageFooter f;
+  memcpy(&f, buf + FLASH_PAGE_SIZE - sizeof(f), sizeof(f));
+  return f;
+}
+
+// Every live page decodes and frame IDs continue from page to page.
+static void checkLog(const char *what) {
+  const uint32_t tail = imuTailPage();
+  uint32_t expect = 0;
+  std::vector<uint8_t> buf(FLASH_PAGE_SIZE * 13);
+
+  for (uint32_t p = tail; p < currentPage;) {
+    const uint32_t n = currentPage - p < 13 ? currentPage - p : 13;
+    assert(readImuPages(p, buf.data(), n));
+    for (uint32_t k = 0; k < n; k++, p++) {
+      const uint8_t *page = &buf[k * FLASH_PAGE_SIZE];
+      PageFooter f;
+      memcpy(&f, page + FLASH_PAGE_SIZE - sizeof(f), sizeof(f));
+      if (decodeImuPage(page, nullptr) != IMU_PAGE_VALID) {
+        printf("FAIL %s: page %lu invalid (tail %lu head %lu)\n", what, (unsigned long)p,
+               (unsigned long)tail, (unsigned long)currentPage);
+        abort();
+      }
+      if (expect && (f.firstFrameID < expect || f.firstFrameID > expect + 1)) {
+        printf("FAIL %s: page %lu starts at frame %lu, expected %lu\n", what,
+               (unsigned long)p, (unsigned long)f.firstFrameID, (unsigned long)expect);
+        abort();
+      }
+      expect = f.firstFrameID + f.validFrames;
+    }
+  }
+}
+
+// The sketch's boot path: checkpoint, or the scans followed by a checkpoint.
+static void boot(bool useCheckpoint) {
+  currentPage = 0;
+  frameCounter = 0;
+  bootFromCheckpoint = false;
+  mode = MODE_IDLE;
+  if (!useCheckpoint) {
+    // RAM starts linear, as after a reset: the scan must find the ring
+    assert(setImuRingMode(false));
+  }
+  if (!useCheckpoint || !restoreFromCheckpoint()) {
+    scanFlashOnBoot();
+    scanSyncPagesOnBoot();
+    reconstructFrameCounterFromFlash();
+    writeCheckpoint();
+  }
+  imuIndexRebuild();
+}
+
+// A frame-range seek lands on the page holding the frame (or the tail).
+static void checkSeek() {
+  const uint32_t tail = imuTailPage();
+  const PageFooter first = footerAt(tail);
+  const PageFooter last = footerAt(currentPage - 1);
+  const uint32_t span = last.firstFrameID - first.firstFrameID + 100;
+
+  for (int i = 0; i < 200; i++) {
+    const uint32_t from = first.firstFrameID - 50 + (uint32_t)rand() % span;
+    ImuRange r;
+    imuRangeBegin(r, IMU_RANGE_FRAMES, from, UINT32_MAX);
+    const uint32_t p = imuRangeFirstPage(r, currentPage);
+    assert(p >= tail && p < currentPage);
+    if (p > tail) assert(footerAt(p).firstFrameID <= from);
+    if (p + 1 < currentPage) {
+      assert(footerAt(p + 1).firstFrameID > from || (p == tail && from < first.firstFrameID));
+    }
+  }
+}
+
+static void eraseLog() {
+  const uint32_t end = (flashImuPages + flashSyncPages) * FLASH_PAGE_SIZE;
+  for (uint32_t a = 0; a < end; a += FLASH_SECTOR_SIZE) flash.eraseSector(a);
+  currentPage = 0;
+  frameCounter = 0;
+  recordStartPage = 0;
+  syncCurrentPage = 0;
+  writeCheckpoint();
+}
+
+// ============================================================================
+// SCENARIOS
+// ============================================================================
+
+static void testLinear() {
+  startNewRecordingSession();
+  recordPageLimit = 0;
+  recordPages(flashImuPages + 100);
+  assert(mode == MODE_IDLE && currentPage == flashImuPages);
+  assert(!setImuRingMode(true));  // already past the ring end
+  checkLog("linear");
+  puts("linear: stops when full");
+}
+
+static void testFirstWrap() {
+  eraseLog();
+  assert(setImuRingMode(true) && imuRingEnabled());
+  boot(true);
+  assert(imuRingEnabled());
+
+  startNewRecordingSession();
+  recordPageLimit = 0;
+  recordPages(imuRingPages() - 5);
+  assert(imuTailPage() == 0);
+  checkLog("first lap");
+
+  recordPages(5);
+  assert(currentPage == imuRingPages() && imuTailPage() == 0);
+  checkLog("ring full");
+
+  const uint32_t erases0 = hostNor.erases;
+  recordPages(1);
+  assert(hostNor.erases == erases0 + 1);
+  assert(imuTailPage() == FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE);
+  checkLog("wrap");
+  assert(!setImuRingMode(false));
+  puts("first wrap: ok");
+}
+
+static void testLaps(int iterations) {
+  const uint32_t pagesPerSector = FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE;
+  int scanBoots = 0, cuts = 0;
+
+  for (int it = 0; it < iterations; it++) {
+    recordPages(1 + (uint32_t)rand() % 700);
+    assert(mode == MODE_RECORDING);
+    checkLog("record");
+
+    const uint32_t head = currentPage;
+    const uint32_t tail = imuTailPage();
+    const uint32_t fc = frameCounter;
+    assert(head - tail <= imuRingPages() && head - tail > imuRingPages() - pagesPerSector);
+    if (it % 4 == 0) checkSeek();
+
+    boot(true);
+    if (currentPage != head || imuTailPage() != tail || !imuRingEnabled() ||
+        (frameCounter != fc && frameCounter != fc + 1)) {
+      printf("FAIL checkpoint boot %d: head %lu/%lu tail %lu/%lu\n", it,
+             (unsigned long)currentPage, (unsigned long)head, (unsigned long)imuTailPage(),
+             (unsigned long)tail);
+      abort();
+    }
+
+    if (it % 5 == 0) {
+      // Journal lost: the scans find the same physical head. A head in the
+      // ring's last sector leaves nothing of the previous lap: linear.
+      boot(false);
+      scanBoots++;
+      const bool lastSector = head % imuRingPages() >= imuRingPages() - pagesPerSector;
+      if (currentPage % imuRingPages() != head % imuRingPages() ||
+          currentPage - imuTailPage() != head - tail || imuRingEnabled() == lastSector ||
+          (frameCounter != fc && frameCounter != fc + 1)) {
+        printf("FAIL scan boot %d: head %lu/%lu tail %lu/%lu frame %lu/%lu\n", it,
+               (unsigned long)currentPage, (unsigned long)head, (unsigned long)imuTailPage(),
+               (unsigned long)tail, (unsigned long)frameCounter, (unsigned long)fc);
+        abort();
+      }
+      checkLog("scan boot");
+      checkSeek();
+      if (lastSector) {
+        assert(setImuRingMode(true));
+      }
+    }
+    checkLog("boot");
+    mode = MODE_RECORDING;
+
+    if (it % 7 == 3) {
+      // Power cut between the erase ahead of the head and its first program
+      recordPages((pagesPerSector - currentPage % pagesPerSector) % pagesPerSector);
+      g_dropImuPrograms = true;
+      recordPages(1);
+      g_dropImuPrograms = false;
+      const uint32_t want = currentPage - 1;
+      cuts++;
+
+      const bool scanOnly = it % 2 != 0;
+      const bool linear = scanOnly && want % imuRingPages() >= imuRingPages() - pagesPerSector;
+      boot(!scanOnly);
+      if (currentPage % imuRingPages() != want % imuRingPages() || imuRingEnabled() == linear) {
+        printf("FAIL cut boot %d: head %lu, expected %lu, ring %d\n", it,
+               (unsigned long)currentPage, (unsigned long)want, (int)imuRingEnabled());
+        abort();
+      }
+      if (linear) {
+        assert(setImuRingMode(true));
+      }
+      mode = MODE_RECORDING;
+      recordPages(3);
+      checkLog("after cut");
+    }
+  }
+  // currentPage restarts its lap count after a scan boot; count programs
+  printf("laps: %.1f, %lu erases, %d scan boots, %d cuts\n",
+         (double)g_imuPrograms / imuRingPages(), (unsigned long)hostNor.erases, scanBoots, cuts);
+}
+
+// The cut above, at flash page 0 with the journal lost: page 0 is blank and
+// sector 1 holds the previous lap, which must still read as a wrapped ring.
+static void testCutAtRingStart() {
+  const uint32_t ringPages = imuRingPages();
+  recordPages((ringPages - currentPage % ringPages) % ringPages);
+  g_dropImuPrograms = true;
+  recordPages(1);
+  g_dropImuPrograms = false;
+
+  boot(false);
+  if (currentPage % ringPages != 0 || !imuRingEnabled()) {
+    printf("FAIL cut at page 0: head %lu (phys %lu), ring %d tail %lu\n",
+           (unsigned long)currentPage, (unsigned long)imuFlashPage(currentPage),
+           (int)imuRingEnabled(), (unsigned long)imuTailPage());
+    abort();
+  }
+  mode = MODE_RECORDING;
+  recordPages(3);
+  checkLog("after cut at page 0");
+  assert(imuTailPage() == currentPage - currentPage % ringPages - ringPages +
+                            FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE);
+  puts("cut at page 0: ring found");
+}
+
+static void testRecords() {
+  const uint32_t kRecords = 16;
+  std::vector<uint8_t> rec(STREAM_RECORD_BYTES * kRecords);
+
+  // A batch that straddles the physical end of the ring
+  uint32_t p = (currentPage / imuRingPages()) * imuRingPages() - kRecords / 2;
+  if (p < imuTailPage()) p += imuRingPages();
+  if (p + kRecords <= currentPage) {
+    assert(loadPageRecords(rec.data(), false, p, kRecords));
+    for (uint32_t k = 0; k < kRecords; k++) {
+      uint32_t idx;
+      memcpy(&idx, &rec[k * STREAM_RECORD_BYTES + 4], sizeof(idx));
+      assert(idx == p + k);
+    }
+    puts("records: batch across the ring end ok");
+  }
+  assert(!loadPageRecords(rec.data(), false, imuTailPage() - 1, 4));
+}
+
+static std::string g_fastOut, g_slowOut;
+static uint32_t g_slowCalls = 0;
+
+static size_t fastWrite(const uint8_t *buf, size_t len) {
+  g_fastOut.append((const char *)buf, len);
+  return len;
+}
+
+static size_t slowWrite(const uint8_t *buf, size_t len) {
+  g_slowOut.append((const char *)buf, len);
+  return len;
+}
+
+// Room for one step in five: a transport far slower than the other
+static bool slowHasRoom(size_t) {
+  return ++g_slowCalls % 5 == 0;
+}
+
+static size_t countPages(const std::string &out) {
+  size_t pages = 0;
+  for (size_t q = out.find("@PAGE"); q != std::string::npos; q = out.find("@PAGE", q + 1)) {
+    pages++;
+  }
+  return pages;
+}
+
+static void runPlayback(const ImuRange &range) {
+  g_fastOut.clear();
+  g_slowOut.clear();
+  mode = MODE_IDLE;
+  startPlayback(PLAYBACK_ASCII, range, 0);
+  while (mode == MODE_PLAYBACK) playbackTask();
+}
+
+static void testPlayback() {
+  outputAddSink("FAST", nullptr, fastWrite);
+
+  ImuRange all;
+  imuRangeBegin(all, IMU_RANGE_ALL, 0, 0);
+  runPlayback(all);
+
+  char first[32];
+  snprintf(first, sizeof(first), "@PAGE %lu ", (unsigned long)imuTailPage());
+  assert(g_fastOut.find(first) != std::string::npos);
+
+  const size_t pages = countPages(g_fastOut);
+  printf("playback: %zu pages (live %lu)\n", pages,
+         (unsigned long)(currentPage - imuTailPage()));
+  assert(pages == currentPage - imuTailPage());
+
+  // A time range to a fast and a slow transport: each cursor keeps its own
+  // range-end state, so the slow one is not cut short by the fast one
+  outputAddSink("SLOW", nullptr, slowWrite, slowHasRoom);
+  const PageFooter from = footerAt(imuTailPage() + 10);
+  const PageFooter to = footerAt(currentPage - 10);
+  ImuRange byTime;
+  imuRangeBegin(byTime, IMU_RANGE_MS, from.pageStartMs, to.pageStartMs);
+  runPlayback(byTime);
+
+  printf("playback by time: fast %zu pages, slow %zu pages\n", countPages(g_fastOut),
+         countPages(g_slowOut));
+  assert(countPages(g_fastOut) > 0 && g_slowOut == g_fastOut);
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char **argv) {
+  const unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 0) : 1;
+  const int iterations = argc > 2 ? atoi(argv[2]) : 400;
+  srand(seed);
+  setvbuf(stdout, nullptr, _IONBF, 0);  // keep the log if an assert aborts
+
+  Serial.begin(0);
+  flashPresent = true;
+  flashCapacityBytes = HOST_NOR_BYTES;
+  flashTotalPages = HOST_NOR_BYTES / FLASH_PAGE_SIZE;
+  flashRecordPages = flashTotalPages - FLASH_RESERVED_PAGES;
+  computeFlashLayout();
+  printf("seed %u: imu pages %lu, ring pages %lu\n", seed, (unsigned long)flashImuPages,
+         (unsigned long)imuRingPages());
+
+  boot(true);
+  assert(currentPage == 0 && !imuRingEnabled());
+
+  testLinear();
+  testFirstWrap();
+  testLaps(iterations);
+  testCutAtRingStart();
+  testRecords();
+  testPlayback();
+
+  puts("OK");
+  return 0;
+}
@@ -0,0 +1,410 @@
+// =============================================================================
+// spiflash_test — SPIFlash bus-level test against a mock NOR chip
+// =============================================================================
+//
+// Runs the real SPIFlash driver over the host SPI shim with a command-level
+// NOR chip on the bus (JEDEC ID, RDSR, WREN, READ/FAST_READ, PP, SE, BE64,
+// CE, DP/RDP). The chip keeps a write-enable latch, a busy time per
+// operation, page-wrapping programs and AND-only programming, and logs each
+// chip-select transaction.
+//
+// Checks:
+//   1. begin(): RDID detection and readID(); an empty bus (MISO high) is
+//      not detected
+//   2. readData(): FAST_READ (0x0B + address + dummy) at FLASH_SPI_DATA_SPEED,
+//      a multi-page read in one chip-select transaction, buffer transfers
+//      only (no per-byte calls), any start alignment
+//   3. writePage(): WREN then PAGE PROGRAM at FLASH_SPI_DATA_SPEED, bulk
+//      data, waits out the busy time before returning; control commands
+//      stay at FLASH_SPI_SPEED
+//   4. eraseSector() / eraseBlock(): the sector or block holding an
+//      unaligned address, neighbours untouched
+//   5. a chip that never leaves busy makes writePage() time out
+//   6. characterize(): the measured profile follows the chip's busy times
+//      and the scratch sector is left erased
+//   7. sleep() / wake(): commands are ignored in deep power-down
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -Ihost -I.. -o spiflash_test spiflash_test.cpp host/host_runtime.cpp ../SPIFlash.cpp
+//
+// Usage:
+//   ./spiflash_test [seed]      (default: 1)
+//
+// Exit status 0 when every check passes; the first failure aborts.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "SPIFlash.h"
+
+// ============================================================================
+// MOCK NOR CHIP
+// ============================================================================
+
+#define CHIP_CS    5
+#define CHIP_BYTES (1u << 20)
+
+// Busy times (us); short so the test runs quickly
+#define CHIP_T_PP 300
+#define CHIP_T_SE 3000
+#define CHIP_T_BE 9000
+#define CHIP_T_CE 20000
+
+struct Transaction {
+  uint8_t cmd;
+  uint32_t bytes;  // clocked while selected, opcode included
+  uint32_t clock;
+  bool ignored;    // arrived while busy, in deep power-down, or without WEL
+};
+
+class NorChip : public HostSpiDevice {
+public:
+  std::vector<uint8_t> mem = std::vector<uint8_t>(CHIP_BYTES, 0xFF);
+  std::vector<Transaction> log;
+  bool stuckBusy = false;
+  bool deepPowerDown = false;
+
+  void pinWrite(uint8_t pin, uint8_t level) override {
+    if (pin != CHIP_CS) return;
+    if (level == LOW && !_selected) {
+      _selected = true;
+      _n = 0;
+      _addr = 0;
+      _data.clear();
+      log.push_back({ 0, 0, hostSpi.clock, false });
+    } else if (level == HIGH && _selected) {
+      _selected = false;
+      if (_n > 0) finish();
+    }
+  }
+
+  uint8_t exchange(uint8_t mosi) override {
+    if (!_selected) return 0xFF;
+    Transaction &t = log.back();
+    const uint32_t i = _n++;
+    t.bytes++;
+
+    if (i == 0) {
+      t.cmd = mosi;
+      t.ignored = (busy() && mosi != FLASH_CMD_RDSR) ||
+                  (deepPowerDown && mosi != FLASH_CMD_RDP);
+      return 0xFF;
+    }
+    if (t.ignored) return 0xFF;
+
+    switch (t.cmd) {
+      case FLASH_CMD_RDID: {
+        static const uint8_t kId[3] = { 0xEF, 0x40, 0x14 };  // W25Q80: 1 MB
+        return i <= 3 ? kId[i - 1] : 0xFF;
+      }
+      case FLASH_CMD_RDSR:
+        return (uint8_t)((busy() ? 0x01 : 0) | (_wel ? 0x02 : 0));
+      case FLASH_CMD_READ:
+      case FLASH_CMD_FAST_READ:
+      case FLASH_CMD_PP:
+      case FLASH_CMD_SE:
+      case FLASH_CMD_BE64:
+        break;
+      default:
+        return 0xFF;
+    }
+
+    if (i <= 3) {
+      _addr = (_addr << 8) | mosi;
+      return 0xFF;
+    }
+    const uint32_t first = (t.cmd == FLASH_CMD_FAST_READ) ? 5 : 4;  // FAST_READ: dummy
+    if (i < first) return 0xFF;
+
+    const uint32_t k = i - first;
+    if (t.cmd == FLASH_CMD_PP) {
+      _data.push_back(mosi);
+      return 0xFF;
+    }
+    if (t.cmd == FLASH_CMD_READ || t.cmd == FLASH_CMD_FAST_READ) {
+      return mem[(_addr + k) % CHIP_BYTES];  // sequential read crosses pages
+    }
+    return 0xFF;
+  }
+
+private:
+  bool _selected = false;
+  bool _wel = false;
+  uint32_t _n = 0;
+  uint32_t _addr = 0;
+  std::vector<uint8_t> _data;
+  uint32_t _busyStart = 0;
+  uint32_t _busyUs = 0;
+
+  bool busy() const { return stuckBusy || (uint32_t)(micros() - _busyStart) < _busyUs; }
+
+  void startBusy(uint32_t us) {
+    _busyStart = micros();
+    _busyUs = us;
+    _wel = false;
+  }
+
+  void erase(uint32_t size, uint32_t us) {
+    const uint32_t base = (_addr % CHIP_BYTES) & ~(size - 1);
+    memset(&mem[base], 0xFF, size);
+    startBusy(us);
+  }
+
+  // Operations take effect when chip select goes high.
+  void finish() {
+    Transaction &t = log.back();
+    if (t.ignored) return;
+
+    const bool writes = t.cmd == FLASH_CMD_PP || t.cmd == FLASH_CMD_SE ||
+                        t.cmd == FLASH_CMD_BE64 || t.cmd == FLASH_CMD_CE;
+    if (writes && !_wel) {
+      t.ignored = true;
+      return;
+    }
+
+    switch (t.cmd) {
+      case FLASH_CMD_WREN:
+        _wel = true;
+        break;
+      case FLASH_CMD_PP: {
+        // The address wraps inside its 256-byte page, bits only clear
+        const uint32_t page = (_addr % CHIP_BYTES) & ~(uint32_t)(FLASH_PAGE_SIZE - 1);
+        for (size_t k = 0; k < _data.size(); k++) {
+          mem[page + ((_addr + k) & (FLASH_PAGE_SIZE - 1))] &= _data[k];
+        }
+        startBusy(CHIP_T_PP);
+        break;
+      }
+      case FLASH_CMD_SE:
+        erase(FLASH_SECTOR_SIZE, CHIP_T_SE);
+        break;
+      case FLASH_CMD_BE64:
+        erase(FLASH_BLOCK_SIZE, CHIP_T_BE);
+        break;
+      case FLASH_CMD_CE:
+        std::fill(mem.begin(), mem.end(), 0xFF);
+        startBusy(CHIP_T_CE);
+        break;
+      case FLASH_CMD_DP:
+        deepPowerDown = true;
+        break;
+      case FLASH_CMD_RDP:
+        deepPowerDown = false;
+        break;
+    }
+  }
+};
+
+// An empty bus: MISO pulled high
+class EmptyBus : public HostSpiDevice {
+public:
+  void pinWrite(uint8_t, uint8_t) override {}
+  uint8_t exchange(uint8_t) override { return 0xFF; }
+};
+
+static NorChip g_chip;
+static SPIFlash g_flash(CHIP_CS);
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static void randomFill(uint8_t *buf, size_t n) {
+  for (size_t i = 0; i < n; i++) buf[i] = (uint8_t)rand();
+}
+
+// Transactions logged since 'from' with opcode 'cmd'
+static size_t countCmd(size_t from, uint8_t cmd) {
+  size_t n = 0;
+  for (size_t i = from; i < g_chip.log.size(); i++) {
+    if (g_chip.log[i].cmd == cmd) n++;
+  }
+  return n;
+}
+
+// Control commands at the safe clock, data phases at the data clock
+static void checkClocks(size_t from) {
+  for (size_t i = from; i < g_chip.log.size(); i++) {
+    const Transaction &t = g_chip.log[i];
+    const bool data = t.cmd == FLASH_CMD_FAST_READ || t.cmd == FLASH_CMD_PP;
+    if (t.clock != (data ? FLASH_SPI_DATA_SPEED : FLASH_SPI_SPEED)) {
+      printf("FAIL clock: command 0x%02X at %lu Hz\n", t.cmd, (unsigned long)t.clock);
+      abort();
+    }
+  }
+}
+
+// ============================================================================
+// SCENARIOS
+// ============================================================================
+
+static void testDetect() {
+  EmptyBus empty;
+  hostSpi.device = &empty;
+  SPIFlash absent(CHIP_CS);
+  assert(!absent.begin());
+
+  hostSpi.device = &g_chip;
+  assert(g_flash.begin() && !g_flash.isEmulated());
+  uint8_t man = 0, type = 0, cap = 0;
+  assert(g_flash.readID(man, type, cap));
+  assert(man == 0xEF && type == 0x40 && cap == 0x14);
+  assert(g_flash.profile().tSEus == 45000);  // Winbond table default
+  puts("detect: ok");
+}
+
+static void testRead() {
+  randomFill(g_chip.mem.data(), CHIP_BYTES);
+  std::vector<uint8_t> buf(13 * FLASH_PAGE_SIZE + 8);
+
+  for (int i = 0; i < 200; i++) {
+    const uint32_t len = 1 + (uint32_t)rand() % (uint32_t)buf.size();
+    const uint32_t addr = (uint32_t)rand() % (CHIP_BYTES - len);
+    const size_t log0 = g_chip.log.size();
+    const uint32_t bytes0 = hostSpi.byteCalls, bulk0 = hostSpi.bulkCalls;
+
+    assert(g_flash.readData(addr, buf.data(), len));
+    assert(memcmp(buf.data(), &g_chip.mem[addr], len) == 0);
+
+    // One transaction: opcode, address, dummy, data; header + data in two
+    // buffer transfers
+    assert(g_chip.log.size() == log0 + 1);
+    const Transaction &t = g_chip.log.back();
+    assert(t.cmd == FLASH_CMD_FAST_READ && t.bytes == 5 + len && !t.ignored);
+    assert(hostSpi.byteCalls == bytes0 && hostSpi.bulkCalls == bulk0 + 2);
+    checkClocks(log0);
+  }
+  puts("read: FAST_READ, one transaction per read, bulk transfers only");
+}
+
+static void testProgram() {
+  std::fill(g_chip.mem.begin(), g_chip.mem.end(), 0xFF);
+  uint8_t page[FLASH_PAGE_SIZE];
+  std::vector<uint8_t> expect(CHIP_BYTES, 0xFF);
+
+  const uint32_t start = micros();
+  for (uint32_t p = 0; p < 32; p++) {
+    randomFill(page, sizeof(page));
+    const uint32_t addr = p * FLASH_PAGE_SIZE;
+    const size_t log0 = g_chip.log.size();
+    const uint32_t bytes0 = hostSpi.byteCalls;
+
+    assert(g_flash.writePage(addr, page, FLASH_PAGE_SIZE));
+    memcpy(&expect[addr], page, FLASH_PAGE_SIZE);
+
+    // WREN, PP (accepted), then RDSR polls until ready
+    assert(g_chip.log[log0].cmd == FLASH_CMD_WREN);
+    const Transaction &pp = g_chip.log[log0 + 1];
+    assert(pp.cmd == FLASH_CMD_PP && pp.bytes == 4 + FLASH_PAGE_SIZE && !pp.ignored);
+    assert(countCmd(log0, FLASH_CMD_RDSR) >= 1);
+    // the only single-byte calls are WREN and the RDSR polls
+    assert(hostSpi.byteCalls - bytes0 == 1 + 2 * countCmd(log0, FLASH_CMD_RDSR));
+    checkClocks(log0);
+  }
+  const uint32_t us = micros() - start;
+  assert(us >= 32 * CHIP_T_PP);
+
+  // A partial program clears bits only, inside its page
+  const uint8_t zeros[16] = {};
+  assert(g_flash.writePage(5 * FLASH_PAGE_SIZE + 100, zeros, sizeof(zeros)));
+  memset(&expect[5 * FLASH_PAGE_SIZE + 100], 0, sizeof(zeros));
+  assert(g_chip.mem == expect);
+
+  const FlashOpStats &st = g_flash.programStats();
+  printf("program: 33 pages, mean busy wait %lu us (chip %u us)\n", (unsigned long)st.avgUs(),
+         CHIP_T_PP);
+  assert(st.count == 33 && st.avgUs() >= CHIP_T_PP);
+}
+
+static void testErase() {
+  std::fill(g_chip.mem.begin(), g_chip.mem.end(), 0x00);
+
+  // An unaligned address erases the sector holding it
+  assert(g_flash.eraseSector(3 * FLASH_SECTOR_SIZE + 1234));
+  for (uint32_t a = 2 * FLASH_SECTOR_SIZE; a < 5 * FLASH_SECTOR_SIZE; a++) {
+    const bool inSector = a >= 3 * FLASH_SECTOR_SIZE && a < 4 * FLASH_SECTOR_SIZE;
+    assert(g_chip.mem[a] == (inSector ? 0xFF : 0x00));
+  }
+
+  assert(g_flash.eraseBlock(2 * FLASH_BLOCK_SIZE + 77));
+  for (uint32_t a = FLASH_BLOCK_SIZE; a < 4 * FLASH_BLOCK_SIZE; a += 512) {
+    const bool inBlock = a >= 2 * FLASH_BLOCK_SIZE && a < 3 * FLASH_BLOCK_SIZE;
+    assert(g_chip.mem[a] == (inBlock ? 0xFF : 0x00));
+  }
+  assert(g_flash.eraseStats().count == 1 && g_flash.blockEraseStats().count == 1);
+  puts("erase: sector and block at unaligned addresses");
+}
+
+static void testTimeout() {
+  uint8_t page[FLASH_PAGE_SIZE];
+  randomFill(page, sizeof(page));
+
+  g_chip.stuckBusy = true;
+  const uint32_t start = micros();
+  assert(!g_flash.writePage(40 * FLASH_PAGE_SIZE, page, sizeof(page)));
+  const uint32_t us = micros() - start;
+  g_chip.stuckBusy = false;
+
+  assert(us >= 10000 && us < 200000);  // writePage() gives up after 10 ms
+  printf("timeout: stuck chip released after %lu us\n", (unsigned long)us);
+}
+
+static void testCharacterize() {
+  std::fill(g_chip.mem.begin(), g_chip.mem.end(), 0x00);
+  const uint32_t sector = 7 * FLASH_SECTOR_SIZE;
+
+  FlashTimingProfile p;
+  assert(g_flash.characterize(sector + 100, 4 * FLASH_BLOCK_SIZE, p));
+  printf("characterize: tPP %lu us, tSE %lu us, tBE %lu us (chip %u / %u / %u)\n",
+         (unsigned long)p.tPPus, (unsigned long)p.tSEus, (unsigned long)p.tBEus, CHIP_T_PP,
+         CHIP_T_SE, CHIP_T_BE);
+
+  assert(p.tPPus >= CHIP_T_PP && p.tPPus < 4 * CHIP_T_PP + 200);
+  assert(p.tSEus >= CHIP_T_SE && p.tSEus < 4 * CHIP_T_SE);
+  assert(p.tBEus >= CHIP_T_BE && p.tBEus < 4 * CHIP_T_BE);
+  assert(g_flash.profile().tSEus == p.tSEus);
+
+  for (uint32_t a = sector; a < sector + FLASH_SECTOR_SIZE; a++) assert(g_chip.mem[a] == 0xFF);
+  assert(g_chip.mem[sector - 1] == 0x00 && g_chip.mem[sector + FLASH_SECTOR_SIZE] == 0x00);
+}
+
+static void testPowerDown() {
+  g_flash.sleep();
+  assert(g_chip.deepPowerDown);
+
+  uint8_t man = 0, type = 0, cap = 0;
+  g_flash.readID(man, type, cap);
+  assert(man == 0xFF && g_chip.log.back().ignored);
+
+  g_flash.wake();
+  assert(!g_chip.deepPowerDown);
+  assert(g_flash.readID(man, type, cap) && man == 0xEF);
+  puts("power-down: ok");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char **argv) {
+  const unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], nullptr, 0) : 1;
+  srand(seed);
+  setvbuf(stdout, nullptr, _IONBF, 0);  // keep the log if an assert aborts
+
+  testDetect();
+  testRead();
+  testProgram();
+  testErase();
+  testTimeout();
+  testCharacterize();
+  testPowerDown();
+
+  hostSpi.device = nullptr;
+  puts("OK");
+  return 0;
+}
@@ -0,0 +1,362 @@
+// =============================================================================
+// storage_powercut — power-loss test for the tail storage journal
+// =============================================================================
+//
+// Runs the real LoggerStorage over the NOR flash model in host/nor_flash.h
+// (erase sets 0xFF, a program can only clear bits) and cuts power at random
+// flash operations:
+//
+//   - a cut program leaves a random prefix of its bytes programmed
+//   - a cut erase leaves the sector half erased (random bytes back to 0xFF)
+//
+// After every cut the journal is remounted (startStorage(), as at boot) and
+// every slot is compared against a model: the slot being written must hold
+// either its old or its new value, every other slot its current value.
+//
+// Scenarios:
+//   1. migration of the old fixed layout (slot N at tail page N)
+//   2. many small writes (reclaim runs; erases per write reported)
+//   3. an unchanged write programs nothing
+//   4. filling to capacity, then replacing values while full
+//   5. power cuts during writes and reclaims
+//   6. power cuts during migration and during the first format
+//   7. erase_all: chip erase, remount, write, remount (no stale slots)
+//
+// Build (from this directory):
+//   g++ -std=c++17 -O2 -Ihost -I.. -o storage_powercut storage_powercut.cpp host/host_runtime.cpp host/nor_flash.cpp ../LoggerStorage.cpp ../LoggerCRC.cpp
+//
+// Usage:
+//   ./storage_powercut [seed] [cut_trials]      (defaults: 1, 40000)
+//
+// Exit status 0 when every check passes; the first failure aborts.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "LoggerCore.h"
+#include "LoggerStorage.h"
+#include "nor_flash.h"
+
+// ============================================================================
+// NOR FLASH MODEL
+// ============================================================================
+
+#define TOTAL_PAGES (HOST_NOR_BYTES / FLASH_PAGE_SIZE)  // storage at the reserved tail
+
+SPIFlash flash(0);
+bool flashPresent = true;
+uint32_t flashTotalPages = TOTAL_PAGES;
+uint32_t flashStorageBasePage = TOTAL_PAGES - FLASH_RESERVED_PAGES;
+
+// Storage must stay inside its slots; the checkpoint journal owns the rest.
+static void checkStorageRange(uint32_t addr, uint32_t len) {
+  const uint32_t lo = flashStorageBasePage * FLASH_PAGE_SIZE;
+  const uint32_t hi = lo + STORAGE_SLOT_LIMIT * FLASH_PAGE_SIZE;
+  assert(addr >= lo && addr + len <= hi);
+}
+
+// ============================================================================
+// MODEL
+// ============================================================================
+
+// Slot values are short strings padded with 0x00, or 256 raw bytes.
+typedef std::map<uint16_t, std::string> Model;
+
+static void encodeValue(const std::string &s, uint8_t *out256) {
+  memset(out256, 0, FLASH_PAGE_SIZE);
+  memcpy(out256, s.data(), std::min<size_t>(s.size(), FLASH_PAGE_SIZE));
+}
+
+static std::string randomString(int maxLen) {
+  const int n = rand() % maxLen;
+  std::string s;
+  for (int i = 0; i < n; i++) s += (char)('a' + rand() % 26);
+  return s;
+}
+
+static std::string randomBinary() {
+  std::string s(FLASH_PAGE_SIZE, '\0');
+  for (char &c : s) c = (char)rand();
+  return s;
+}
+
+static bool slotEquals(uint16_t slot, const Model &m) {
+  uint8_t got[FLASH_PAGE_SIZE], want[FLASH_PAGE_SIZE];
+  if (!readStorageElement(slot, got)) return false;
+
+  const Model::const_iterator it = m.find(slot);
+  if (it == m.end()) {
+    memset(want, 0xFF, sizeof(want));
+  } else {
+    encodeValue(it->second, want);
+  }
+  return memcmp(got, want, sizeof(want)) == 0;
+}
+
+static void checkAll(const Model &m, const char *what) {
+  for (uint16_t slot = 1; slot < STORAGE_SLOT_LIMIT; slot++) {
+    if (!slotEquals(slot, m)) {
+      printf("FAIL %s: slot %u\n", what, (unsigned)slot);
+      exit(1);
+    }
+  }
+}
+
+static void writeOldFixedSlot(uint16_t slot, const std::string &s) {
+  encodeValue(s, &hostNor.mem[(flashStorageBasePage + slot) * FLASH_PAGE_SIZE]);
+}
+
+
+// ============================================================================
+// SCENARIOS
+// ============================================================================
+
+static void testMigration(Model &m) {
+  norEraseAll();
+  m.clear();
+  m[1] = "MyWifi";
+  m[2] = "secret-pass";
+  m[40] = randomBinary();  // full 256 bytes, in the third sector
+  for (const Model::value_type &kv : m) writeOldFixedSlot(kv.first, kv.second);
+
+  assert(startStorage());
+  checkAll(m, "migration");
+
+  StorageStats st;
+  getStorageStats(st);
+  assert(st.slots == 3);
+
+  assert(startStorage());
+  checkAll(m, "remount after migration");
+  printf("migration: slots=%u live=%lu/%lu free sectors=%u\n", st.slots,
+         (unsigned long)st.liveBytes, (unsigned long)st.capacityBytes, st.freeSectors);
+}
+
+static void testWrites(Model &m) {
+  const uint32_t erases0 = hostNor.erases;
+  const int n = 20000;
+  uint8_t buf[FLASH_PAGE_SIZE];
+
+  for (int i = 0; i < n; i++) {
+    const uint16_t slot = (uint16_t)(1 + rand() % 30);
+    const std::string s = randomString(64);
+    encodeValue(s, buf);
+    assert(writeStorageElement(slot, buf));
+    m[slot] = s;
+  }
+  checkAll(m, "writes");
+
+  StorageStats st;
+  getStorageStats(st);
+  printf("%d writes: %lu erases (%.4f per write), %lu reclaims\n", n,
+         (unsigned long)(hostNor.erases - erases0), (double)(hostNor.erases - erases0) / n,
+         (unsigned long)st.reclaims);
+
+  // Writing the current value costs no program
+  const uint32_t programs0 = hostNor.programs;
+  encodeValue(m[1], buf);
+  assert(writeStorageElement(1, buf));
+  assert(hostNor.programs == programs0);
+
+  assert(startStorage());
+  checkAll(m, "remount after writes");
+}
+
+static void testCapacity(Model &m) {
+  uint8_t buf[FLASH_PAGE_SIZE];
+  uint16_t filled = 0;
+
+  for (uint16_t slot = 100; slot < STORAGE_SLOT_LIMIT; slot++) {
+    const std::string s = randomBinary();
+    encodeValue(s, buf);
+    if (!writeStorageElement(slot, buf)) break;
+    m[slot] = s;
+    filled++;
+  }
+
+  StorageStats st;
+  getStorageStats(st);
+  printf("capacity: %u full slots accepted, live=%lu/%lu\n", filled,
+         (unsigned long)st.liveBytes, (unsigned long)st.capacityBytes);
+
+  // Still writable when full: replacing a value does not grow the log
+  for (int i = 0; i < 500; i++) {
+    const uint16_t slot = (uint16_t)(100 + rand() % filled);
+    const std::string s = randomBinary();
+    encodeValue(s, buf);
+    assert(writeStorageElement(slot, buf));
+    m[slot] = s;
+  }
+  checkAll(m, "full");
+
+  // Shrink back to short values for the power-cut runs
+  for (uint16_t slot = 100; slot < 100 + filled; slot++) {
+    encodeValue("", buf);
+    assert(writeStorageElement(slot, buf));
+    m[slot] = "";
+  }
+}
+
+static void testWriteCuts(Model &m, int trials) {
+  uint8_t buf[FLASH_PAGE_SIZE];
+  int cuts = 0, keptOld = 0;
+
+  for (int t = 0; t < trials; t++) {
+    const uint16_t slot = (uint16_t)(1 + rand() % 110);
+    const std::string s = randomString(240);
+    encodeValue(s, buf);
+
+    norArmCut(rand() % 6);
+    bool ok = false;
+    try {
+      ok = writeStorageElement(slot, buf);
+    } catch (const PowerCut &) {
+    }
+    norDisarmCut();
+
+    if (!hostNor.cutHappened) {
+      assert(ok);
+      m[slot] = s;
+      continue;
+    }
+    cuts++;
+
+    // Reboot: the slot holds the old or the new value, nothing else moved
+    assert(startStorage());
+    Model next = m;
+    next[slot] = s;
+    if (slotEquals(slot, next)) {
+      m = next;
+    } else if (slotEquals(slot, m)) {
+      keptOld++;
+    } else {
+      printf("FAIL cut trial %d: slot %u holds neither value\n", t, (unsigned)slot);
+      exit(1);
+    }
+    checkAll(m, "after cut");
+  }
+
+  StorageStats st;
+  getStorageStats(st);
+  printf("write cuts: %d (old value kept %d), free sectors=%u\n", cuts, keptOld,
+         st.freeSectors);
+}
+
+static void testMigrationCuts() {
+  uint8_t buf[FLASH_PAGE_SIZE];
+  static const uint16_t kSlots[] = { 1, 2, 3, 40, 100 };
+
+  for (int t = 0; t < 300; t++) {
+    norEraseAll();
+    Model m;
+    for (uint16_t slot : kSlots) m[slot] = std::string(1, (char)('A' + slot % 26));
+    for (const Model::value_type &kv : m) writeOldFixedSlot(kv.first, kv.second);
+
+    norArmCut(rand() % 12);
+    try {
+      startStorage();
+    } catch (const PowerCut &) {
+    }
+    norDisarmCut();
+
+    assert(startStorage());
+    checkAll(m, "migration cut");
+  }
+
+  // A fresh part, cut during the first format
+  for (int t = 0; t < 50; t++) {
+    norEraseAll();
+    norArmCut(rand() % 3);
+    try {
+      startStorage();
+    } catch (const PowerCut &) {
+    }
+    norDisarmCut();
+
+    assert(startStorage());
+    StorageStats st;
+    getStorageStats(st);
+    assert(st.slots == 0);
+    checkAll(Model(), "format cut");
+  }
+
+  // Every old sector holds a slot: migration stages in place
+  norEraseAll();
+  Model m;
+  for (uint16_t slot = 1; slot < STORAGE_SLOT_LIMIT; slot += 7) {
+    m[slot] = std::string(1, (char)('A' + slot % 26));
+  }
+  m[8] = randomBinary();
+  for (const Model::value_type &kv : m) writeOldFixedSlot(kv.first, kv.second);
+  assert(startStorage());
+  checkAll(m, "all-sector migration");
+
+  for (int i = 0; i < 2000; i++) {
+    const uint16_t slot = (uint16_t)(1 + rand() % 200);
+    encodeValue("z", buf);
+    assert(writeStorageElement(slot, buf));
+    m[slot] = "z";
+  }
+  checkAll(m, "writes after all-sector migration");
+  puts("migration cuts: ok");
+}
+
+// The CLI's erase_all: the chip erase takes the journal with it, then the
+// journal is remounted before anything else writes.
+static void testEraseAll() {
+  uint8_t buf[FLASH_PAGE_SIZE];
+  Model m;
+
+  norEraseAll();
+  assert(startStorage());
+  for (int i = 0; i < 3000; i++) {
+    const uint16_t slot = (uint16_t)(1 + rand() % 50);
+    const std::string s = randomString(200);
+    encodeValue(s, buf);
+    assert(writeStorageElement(slot, buf));
+  }
+
+  norEraseAll();
+  assert(startStorage());
+  checkAll(Model(), "after erase_all");
+
+  m[1] = "NewWifi";
+  m[2] = "new-pass";
+  for (const Model::value_type &kv : m) {
+    encodeValue(kv.second, buf);
+    assert(writeStorageElement(kv.first, buf));
+  }
+  assert(startStorage());
+  checkAll(m, "remount after erase_all");
+
+  StorageStats st;
+  getStorageStats(st);
+  assert(st.slots == 2);
+  puts("erase_all: ok");
+}
+
+int main(int argc, char **argv) {
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  const unsigned seed = argc > 1 ? (unsigned)atoi(argv[1]) : 1;
+  const int trials = argc > 2 ? atoi(argv[2]) : 40000;
+  srand(seed);
+  hostNor.checkRange = checkStorageRange;
+
+  Model m;
+  testMigration(m);
+  testWrites(m);
+  testCapacity(m);
+  testWriteCuts(m, trials);
+  testMigrationCuts();
+  testEraseAll();
+
+  puts("OK");
+  return 0;
+}